@@ -69,6 +69,7 @@
 
 #include <Arduino.h>
 #include <user_interface.h>
+#include <coredecls.h>        // crc32()
 // #include <BacktraceLog.h>
 
 #define NOINLINE __attribute__((noinline))
@@ -86,6 +87,8 @@
 //
 #include <ModeDIO_ReclaimGPIOs.h>
 #include <SfdpRevInfo.h>
+#include <StatusRegisterUpdate.h>
+#include <FlashFingerprint.h>
 #include <TestFlashQE/FlashChipId.h>
 #include <TestFlashQE/SFDP.h>
 #include <TestFlashQE/WP_HOLD_Test.h>
@@ -111,6 +114,32 @@ struct FlashDiscovery {
   bool pass_HOLD = false;         // /HOLD disabled - Test results
 } fd_state;
 
+////////////////////////////////////////////////////////////////////////////////
+// AnalyzeCheckpoint - Script progress kept in RTC user memory. An expected
+// crash from the /HOLD test, or any other reset, resumes the script at the
+// next untested phase with the discovered results restored. See Checkpoint.ino
+//
+enum AnalyzePhase : uint8_t {
+  kPhaseAnalyze = 0,              // 'a', 'b', 'A', or 'B' from AnalyzeCheckpoint.key
+  kPhaseWP,                       // 'w'
+  kPhaseHOLD,                     // 'h'
+  kPhaseReport,                   // Print the suggested spi_flash_vendor_cases()
+  kPhaseDone
+};
+
+struct AnalyzeCheckpoint {
+  uint32_t magic;
+  uint8_t phase;                  // Phase to run next, AnalyzePhase
+  uint8_t running;                // Set while a phase runs, a reset will find it set
+  uint8_t key;                    // Analyze hotkey for kPhaseAnalyze
+  uint8_t resets;                 // Resets during this script
+  uint32_t sr321_start;           // Status Registers when the script started
+  uint32_t sr321;                 // Status Registers at the last checkpoint
+  FlashDiscovery fd;
+  experimental::SfdpRevInfo sfdp;
+  uint32_t crc;
+};
+
 static uint32_t get_qe_pos() {
   if (fd_state.S9) return 9u;
   if (fd_state.S6) return 6u;
@@ -198,6 +227,33 @@ void printReclaimFn() {
       "}\n");
 }
 
+/*
+  Print the discovered results as one "FFP1:" fingerprint line for
+  tools/fingerprint/fpstat.
+*/
+void printFingerprint() {
+  using namespace experimental;
+  uint16_t caps = kFpCapAnalyze;
+  if (fd_state.S9) caps |= kFpCapS9;
+  if (fd_state.S6) caps |= kFpCapS6;
+  if (fd_state.has_8bw_sr1) caps |= kFpCap8bwSR1;
+  if (fd_state.has_8bw_sr2) caps |= kFpCap8bwSR2;
+  if (fd_state.has_8bw_sr3) caps |= kFpCap8bwSR3;
+  if (fd_state.has_16bw_sr1) caps |= kFpCap16bwSR1;
+  if (fd_state.has_volatile) caps |= kFpCapVolatile;
+  if (fd_state.write_QE) caps |= kFpCapWriteQE;
+  if (fd_state.pass_SC) caps |= kFpCapPassSC;
+  if (fd_state.pass_WP) caps |= kFpCapPassWP;
+  if (fd_state.pass_HOLD) caps |= kFpCapPassHOLD;
+
+  FlashFingerprint fp;
+  flash_fingerprint_read(&fp, caps);
+  flash_fingerprint_seal(&fp);
+  char line[kFlashFingerprintHexSz];
+  flash_fingerprint_hex(&fp, line, sizeof(line));
+  Serial.PRINTF_LN("\n%s", line);
+}
+
 void suggestedReclaimFn() {
   // Check if device is already handled by 'spi_flash_vendor_cases()' and run
   // test to confirm that it works.
@@ -237,42 +293,25 @@ void runScript(int next_key) {
       * A failure is NOT expected to cause crash/reboot
     w) Use proposed settings from analyze to test /WP
       * A failure is NOT expected to cause crash/reboot
+      * On a failure with QE/S9, rerun analyze with hint QE/S6
     h) Use proposed settings from analyze to test /HOLD
       * expect a failure to cause a crash or reboot.
 
     Print the custom example
+
+    Each phase is checkpointed, after a reset the script continues from
+    setup() with the next untested phase. See Checkpoint.ino
   */
-  scripting = true;
-  Serial.PRINTF_LN("\nRun Script at 1ST boot");
   if ('a' == next_key || 'b' == next_key || 'A' == next_key || 'B' == next_key) {
-    if (processKey(next_key)) {
-      // At this point, we have a guess for QE bit either S9 or S6
-      // To be confident of the QE bit location S9 or S6 we need to fail and
-      // succeed with /WP tests, enable and disable write protect with QE.
-      if (processKey('w')) {
-        // Test /HOLD while QE=1 (or the final passing QE value from 'w' test) -
-        // this is a final confirmation that we have free-ed both GPIO9 and
-        // GPIO10 uses settings suggested by 'w'
-        if (processKey('h')) {
-          suggestedReclaimFn();
-        } else {
-          Serial.PRINTF_LN("\nUnable to disable pin function /HOLD using QE/S%X", (fd_state.S9) ? 9u : 6u);
-        }
-      } else {
-        Serial.PRINTF_LN("\nUnable to disable pin function /WP using QE/S%X", (fd_state.S9) ? 9u : 6u);
-        if (fd_state.S9) {
-          Serial.PRINTF_LN("  Suggest trying QE/S6. Use menu hotkeys 'b', 'w', 'h', 'p'");
-        }
-      }
-    } else {
-      Serial.PRINTF_LN("\nUnable to configure Flash Status Register to free GPIO9 and GPIO10");
-    }
-    last_key = '?'; // clear value to avoid confusion from a later unrelated crash.
+    scripting = true;
+    Serial.PRINTF_LN("\nRun Script at 1ST boot");
+    beginCheckpoint(next_key);
+    runPhases();
+    scripting = false;
   } else {
     Serial.PRINTF_LN("\nUnable to configure Flash Status Register to free GPIO9 and GPIO10");
     processKey('?');
   }
-  scripting = false;
 }
 
 extern "C" void patchEarlyCrashReason() {
@@ -294,9 +333,14 @@ extern "C" void patchEarlyCrashReason() {
 }
 
 bool run_once = false;
+bool run_resume = false;
 
 void setup() {
   patchEarlyCrashReason();
+#if SR_SHADOW
+  // Analyze probes the part, every Status Register read goes to the flash
+  experimental::sr_shadow_force_verify(true);
+#endif
 
   Serial.begin(115200);
   delay(200);
@@ -308,6 +352,11 @@ void setup() {
 
   Serial.PRINTF_LN("  Reset reason: %s", ESP.getResetReason().c_str());
   uint32_t reason = ESP.getResetInfoPtr()->reason;
+  if (loadCheckpoint()) {
+    // A script was running, pick up where it left off.
+    run_resume = resumeCheckpoint(reason);
+    return;
+  }
   switch (reason) {
     case REASON_WDT_RST:          // 1
     case REASON_EXCEPTION_RST:    // 2
@@ -351,5 +400,11 @@ void loop() {
     runScript('a');   // Start Analyze
 #endif
   }
+  if (run_resume) {
+    run_resume = false;
+    scripting = true;
+    runPhases();
+    scripting = false;
+  }
   serialClientLoop();
 }
@@ -0,0 +1,211 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Script checkpoint for runScript()
+
+  The /HOLD test is expected to crash the module when /HOLD is still active.
+  Before each phase, the phase and discovered results are saved to RTC user
+  memory with a CRC. RTC user memory survives a crash, a reset, and 'R', but
+  not a power cycle. After a reset, setup() finds the checkpoint and the script
+  continues. A phase that was running when the module crashed has failed, a
+  phase interrupted by an external reset or restart is run again.
+
+  The checkpoint uses 48 bytes at the start of RTC user memory, offsets 0 - 11
+  for `ESP.rtcUserMemoryWrite()`. Move it with `-DANALYZE_CHECKPOINT_RTC_BLOCK=`.
+*/
+
+#ifndef ANALYZE_CHECKPOINT_RTC_BLOCK
+#define ANALYZE_CHECKPOINT_RTC_BLOCK 64u
+#endif
+
+// Stop resuming after this many resets in one script
+#ifndef ANALYZE_CHECKPOINT_MAX_RESETS
+#define ANALYZE_CHECKPOINT_MAX_RESETS 4u
+#endif
+
+constexpr uint32_t kCheckpointMagic = 0x414E4C31u; // "ANL1"
+static_assert(48u == sizeof(AnalyzeCheckpoint), "AnalyzeCheckpoint size changed, check ANALYZE_CHECKPOINT_RTC_BLOCK");
+
+AnalyzeCheckpoint checkpoint;
+
+static const char *phaseName(const uint32_t phase) {
+  switch (phase) {
+    case kPhaseAnalyze: return "analyze";
+    case kPhaseWP:      return "/WP test";
+    case kPhaseHOLD:    return "/HOLD test";
+    case kPhaseReport:  return "report";
+    default:            return "done";
+  }
+}
+
+static uint32_t checkpointCrc() {
+  return crc32(&checkpoint, offsetof(AnalyzeCheckpoint, crc));
+}
+
+static uint32_t readSR321() {
+  uint32_t sr321 = 0u;
+  experimental::spi0_flash_read_status_registers_3B(&sr321);
+  return sr321;
+}
+
+static void saveCheckpoint() {
+  checkpoint.fd = fd_state;
+  checkpoint.sfdp = sfdpInfo;
+  checkpoint.sr321 = readSR321();
+  checkpoint.magic = kCheckpointMagic;
+  checkpoint.crc = checkpointCrc();
+  system_rtc_mem_write(ANALYZE_CHECKPOINT_RTC_BLOCK, &checkpoint, sizeof(checkpoint));
+}
+
+void clearCheckpoint() {
+  checkpoint = AnalyzeCheckpoint{};
+  system_rtc_mem_write(ANALYZE_CHECKPOINT_RTC_BLOCK, &checkpoint, sizeof(checkpoint));
+}
+
+// Returns true when an unfinished script was found
+bool loadCheckpoint() {
+  if (! system_rtc_mem_read(ANALYZE_CHECKPOINT_RTC_BLOCK, &checkpoint, sizeof(checkpoint))) return false;
+  if (kCheckpointMagic != checkpoint.magic || checkpointCrc() != checkpoint.crc) return false;
+  if (kPhaseDone <= checkpoint.phase) return false;
+  // Check that it was saved for this flash
+  return fd_state.device == checkpoint.fd.device;
+}
+
+void beginCheckpoint(const int key) {
+  checkpoint = AnalyzeCheckpoint{};
+  checkpoint.phase = kPhaseAnalyze;
+  checkpoint.key = key;
+  checkpoint.sr321_start = readSR321();
+  saveCheckpoint();
+}
+
+void printCheckpoint() {
+  Serial.PRINTF_LN("  Script checkpoint: phase %s%s, analyze '%c', resets %u",
+    phaseName(checkpoint.phase), (checkpoint.running) ? " (running)" : "",
+    (checkpoint.key) ? checkpoint.key : '-', checkpoint.resets);
+  Serial.PRINTF_LN("  Status Registers at start 0x%06X, at checkpoint 0x%06X, now 0x%06X",
+    checkpoint.sr321_start, checkpoint.sr321, readSR321());
+  Serial.PRINTF_LN("  Discovered: QE/%s, 8-bit SR1 %u, SR2 %u, SR3 %u, 16-bit SR1 %u, volatile %u",
+    (checkpoint.fd.S9) ? "S9" : (checkpoint.fd.S6) ? "S6" : "none",
+    checkpoint.fd.has_8bw_sr1, checkpoint.fd.has_8bw_sr2, checkpoint.fd.has_8bw_sr3,
+    checkpoint.fd.has_16bw_sr1, checkpoint.fd.has_volatile);
+  Serial.PRINTF_LN("  Passed: analyze %u, short circuit %u, /WP %u, /HOLD %u",
+    checkpoint.fd.pass_analyze, checkpoint.fd.pass_SC, checkpoint.fd.pass_WP, checkpoint.fd.pass_HOLD);
+}
+
+// Pick the phase after `phase` finished with `pass`.
+static uint32_t nextPhase(const uint32_t phase, const bool pass) {
+  switch (phase) {
+    case kPhaseAnalyze:
+      if (pass) return kPhaseWP;
+      Serial.PRINTF_LN("\nUnable to configure Flash Status Register to free GPIO9 and GPIO10");
+      return kPhaseDone;
+
+    case kPhaseWP:
+      if (pass) return kPhaseHOLD;
+      Serial.PRINTF_LN("\nUnable to disable pin function /WP using QE/S%X", (fd_state.S9) ? 9u : 6u);
+      if (fd_state.S9 && ('a' == checkpoint.key || 'A' == checkpoint.key)) {
+        // At this point, we know QE/S9 did not work. Same safety, hint QE/S6.
+        checkpoint.key = ('a' == checkpoint.key) ? 'b' : 'B';
+        Serial.PRINTF_LN("  Trying QE/S6 with hotkey '%c'", checkpoint.key);
+        return kPhaseAnalyze;
+      }
+      return kPhaseReport;
+
+    case kPhaseHOLD:
+      if (! pass) {
+        Serial.PRINTF_LN("\nUnable to disable pin function /HOLD using QE/S%X", (fd_state.S9) ? 9u : 6u);
+      }
+      return kPhaseReport;
+
+    default:
+      return kPhaseDone;
+  }
+}
+
+static bool runPhase(const uint32_t phase) {
+  switch (phase) {
+    case kPhaseAnalyze:
+      return processKey(checkpoint.key);
+
+    case kPhaseWP:
+      // At this point, we have a guess for QE bit either S9 or S6
+      // To be confident of the QE bit location S9 or S6 we need to fail and
+      // succeed with /WP tests, enable and disable write protect with QE.
+      return processKey('w');
+
+    case kPhaseHOLD:
+      // Test /HOLD while QE=1 (or the final passing QE value from 'w' test) -
+      // this is a final confirmation that we have free-ed both GPIO9 and
+      // GPIO10 uses settings suggested by 'w'
+      return processKey('h');
+
+    case kPhaseReport:
+      suggestedReclaimFn();
+      printFingerprint();
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+void runPhases() {
+  while (kPhaseDone > checkpoint.phase) {
+    const uint32_t phase = checkpoint.phase;
+    checkpoint.running = 1u;
+    saveCheckpoint();
+    const bool pass = runPhase(phase);
+    checkpoint.running = 0u;
+    checkpoint.phase = nextPhase(phase, pass);
+    saveCheckpoint();
+  }
+  last_key = '?'; // clear value to avoid confusion from a later unrelated crash.
+}
+
+// Called from setup() after loadCheckpoint() found an unfinished script.
+// Returns true when runPhases() should continue it.
+bool resumeCheckpoint(const uint32_t reason) {
+  fd_state = checkpoint.fd;
+  sfdpInfo = checkpoint.sfdp;
+  checkpoint.resets++;
+  Serial.PRINTF_LN("\nResume Script after reset");
+  printCheckpoint();
+
+  if (checkpoint.running) {
+    checkpoint.running = 0u;
+    const uint32_t phase = checkpoint.phase;
+    if (REASON_WDT_RST == reason || REASON_EXCEPTION_RST == reason || REASON_SOFT_WDT_RST == reason) {
+      if (kPhaseHOLD == phase) {
+        Serial.PRINTF_LN("unwanted but anticipated crash while testing `/HOLD`");
+        fd_state.pass_HOLD = false;
+      } else {
+        Serial.PRINTF_LN("unexpected crash while running %s", phaseName(phase));
+        if (kPhaseAnalyze == phase) fd_state.pass_analyze = false;
+        if (kPhaseWP == phase) fd_state.pass_WP = false;
+      }
+      checkpoint.phase = nextPhase(phase, false);
+    } else {
+      Serial.PRINTF_LN("%s was interrupted, running it again", phaseName(phase));
+    }
+  }
+  if (ANALYZE_CHECKPOINT_MAX_RESETS < checkpoint.resets) {
+    Serial.PRINTF_LN("\nToo many resets, script stopped. Use menu 'r' to start over.");
+    checkpoint.phase = kPhaseDone;
+  }
+  saveCheckpoint();
+  return kPhaseDone > checkpoint.phase;
+}
@@ -234,6 +234,22 @@ static bool clearSR21(bool _non_volatile) {
 }
 
 
+////////////////////////////////////////////////////////////////////////////////
+// Status Register write methods found so far, for sr_update(). An 8-bit SR1
+// write is only trusted on a part with 31h, on older 16-bit parts it clears
+// SR2. The volatile probe is how has_volatile gets found, so a volatile request
+// is always allowed.
+static uint8_t fd_sr_caps(const bool _non_volatile) {
+  using namespace experimental;
+  uint8_t caps = 0u;
+  if (fd_state.has_8bw_sr2 || fd_state.has_16bw_sr1) caps |= kSrCapSR2;
+  if (fd_state.has_8bw_sr2) caps |= kSrCap8bitSR2;
+  if (fd_state.has_16bw_sr1) caps |= kSrCap16bitSR1;
+  if (fd_state.has_8bw_sr2 || ! fd_state.has_16bw_sr1) caps |= kSrCap8bitSR1;
+  if (! _non_volatile) caps |= kSrCapVolatile;
+  return caps;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Generalized Flash Status Register modify bit in function
 //   bit_pos       bit position, 0 - 15
@@ -245,6 +261,9 @@ static bool clearSR21(bool _non_volatile) {
 //   fd_state.has_8bw_sr2
 //   fd_state.has_16bw_sr1
 //
+// sr_update() picks the write, verifies, and on a failed verify puts the
+// Status Registers back as they were.
+//
 // returns:
 //  1 - value changed, updated
 //  0 - value already up to date - nochange
@@ -252,57 +271,23 @@ static bool clearSR21(bool _non_volatile) {
 //
 int modifyBitSR(const uint32_t bit_pos, uint32_t val, const bool _non_volatile) {
   using namespace experimental;
-  SpiOpResult ok0;
 
   // BIT1 and BIT0 are WEL and WIP which cannot be directly changed.
   if (2 > bit_pos || 16 <= bit_pos) return false;
 
-  uint32_t _bit = 1u << bit_pos;
-
-  uint32_t sr21 = 0u, sr2 = 0u;
-  ok0 = spi0_flash_read_status_register_1(&sr21);
-  CHECK_OK0(ok0);
-  if (fd_state.has_8bw_sr2 || fd_state.has_16bw_sr1) {
-    spi0_flash_read_status_register_2(&sr2);
-    CHECK_OK0(ok0);
-    sr21 |= sr2 << 8u;
-  }
-
-  if (val) {
-    if (0 != (sr21 & _bit)) {
-      return 0;
-    }
-    sr21 |= _bit;
-  } else {
-    if (0 == (sr21 & _bit)) {
-      return 0;
-    }
-    sr21 &= ~_bit;
-  }
-
-  if (fd_state.has_16bw_sr1) {
-    ok0 = spi0_flash_write_status_register(/* SR1 */ 0u, sr21, _non_volatile, 16u);
-    CHECK_OK0(ok0);
-  } else {
-    if (8u > bit_pos) {
-      ok0 = spi0_flash_write_status_register(/* SR1 */ 0u, sr21 & 0xFFu, _non_volatile, 8u);
-      CHECK_OK0(ok0);
-    } else {
-      ok0 = spi0_flash_write_status_register(/* SR2 */ 1u, sr21 >> 8u, _non_volatile, 8u);
-      CHECK_OK0(ok0);
-    }
-  }
-
-  uint32_t verify_sr21 = 0u, verify_sr2 = 0u;
-  ok0 = spi0_flash_read_status_register_1(&verify_sr21);
-  CHECK_OK0(ok0);
-  if (fd_state.has_8bw_sr2 || fd_state.has_16bw_sr1) {
-    ok0 = spi0_flash_read_status_register_2(&verify_sr2);
-    CHECK_OK0(ok0);
-    verify_sr21 |= verify_sr2 << 8u;
+  const uint32_t _bit = 1u << bit_pos;
+  SrUpdate u = {};
+  u.value = (val) ? _bit : 0u;
+  u.mask = _bit;
+  u.caps = fd_sr_caps(_non_volatile);
+  u.non_volatile = _non_volatile;
+  u.rollback = true;
+  SpiOpResult ok0 = sr_update(&u);
+  if (SPI_RESULT_OK != ok0) {
+    if (u.rolled_back) Serial.PRINTF_LN("  Status Registers restored to 0x%04X", u.before & 0xFFFFu);
+    return -1;
   }
-
-  return (verify_sr21 == sr21) ? 1 : -1;
+  return (0u == u.nwrites) ? 0 : 1;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -761,6 +746,16 @@ bool processKey(const int key) {
       runScript('a');
       break;
 
+    case 'c':
+      if (loadCheckpoint()) {
+        Serial.PRINTF_LN();
+        printCheckpoint();
+      } else {
+        Serial.PRINTF_LN("\n  No unfinished script");
+      }
+      clearCheckpoint();
+      break;
+
     case 'a':   // Safer
     case 'A':   // more risk uses non-volatile Status Register
       pass = analyze_SR_QE(9u, ('a' == key));  // hint QE/S9
@@ -998,6 +993,7 @@ bool processKey(const int key) {
       Serial.PRINTF_LN("\nHot key help:");
       Serial.PRINTF_LN("\nAnalyze:");
       Serial.PRINTF_LN("  r - Run analyze script includes tests");
+      Serial.PRINTF_LN("  c - Print and clear the script checkpoint, stops a resume");
       Serial.PRINTF_LN("  a - Analyze Status Register Writes remembers discovered results. leans toward QE/S9");
       Serial.PRINTF_LN("  b - Analyze Status Register Writes remembers discovered results, uses hint QE/S6");
       Serial.PRINTF_LN("  A - Same as 'a' except less safe uses non-volatile Status Registers");
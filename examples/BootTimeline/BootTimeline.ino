@@ -0,0 +1,103 @@
+/*
+  Print the reclaim timeline recorded while reclaim_GPIO_9_10() ran from
+  preinit().
+
+  Each line shows the phase, its argument, the time since the start of
+  reclaim_GPIO_9_10(), and the time since the previous event. For
+  "SPI0Command" and "Sequence step", the argument is the flash instruction.
+  The first line also shows the CPU cycle count at the start, which counts
+  from the CPU reset. The BootROM runs at a different clock so that number is
+  only a rough guide.
+
+  Built with the debug messages deferred, they are printed after the
+  timeline, and the timeline shows what they cost.
+
+  See "BootTimeline.ino.globals.h" for build options.
+
+  This example code is in the public domain.
+*/
+#if ! RECLAIM_TIMELINE
+#error This build requires global define '-DRECLAIM_TIMELINE=1'
+#endif
+#if ! RECLAIM_GPIO_EARLY
+#error This build requires global define '-DRECLAIM_GPIO_EARLY=1'
+#endif
+
+#include <ModeDIO_ReclaimGPIOs.h>
+
+// Variable is used before C++ runtime init has started.
+bool gpio_9_10_available __attribute__((section(".noinit")));
+
+static const char *phase_name(const uint8_t phase) {
+  switch (phase) {
+    case kReclaimPhaseStart:          return "Start";
+    case kReclaimPhaseIdRead:         return "Chip ID read";
+    case kReclaimPhaseWelCheck:       return "WEL check";
+    case kReclaimPhaseQuadCheck:      return "Quad check";
+    case kReclaimPhaseVendorHandler:  return "Vendor handler";
+    case kReclaimPhaseVendorDone:     return "Vendor done";
+    case kReclaimPhaseSpi0Command:    return "  SPI0Command";
+    case kReclaimPhaseSequenceStep:   return "  Sequence step";
+    case kReclaimPhaseVerify:         return "  Verify";
+    case kReclaimPhasePinMode:        return "pinMode";
+    case kReclaimPhaseEnd:            return "End";
+    default:                          return "?";
+  }
+}
+
+void printTimeline() {
+  const ReclaimTimeline *tl = reclaim_timeline();
+  if (nullptr == tl) {
+    Serial.println("No reclaim timeline recorded.");
+    return;
+  }
+  const size_t n = (RECLAIM_TIMELINE_MAX < tl->count) ? RECLAIM_TIMELINE_MAX : tl->count;
+  if (0u == n) return;
+
+  const uint32_t mhz = clockCyclesPerMicrosecond();
+  const uint32_t t0 = tl->event[0].cycles;
+  uint32_t last = t0;
+  Serial.printf_P(PSTR("Reclaim timeline, %u events, start at cycle %u\n"), tl->count, t0);
+  Serial.printf_P(PSTR("  %-16s %6s %10s %10s\n"), "Phase", "Arg", "Total us", "Delta us");
+  for (size_t i = 0u; i < n; i++) {
+    const ReclaimTimelineEvent& ev = tl->event[i];
+    const uint32_t total = ev.cycles - t0;
+    const uint32_t delta = ev.cycles - last;
+    last = ev.cycles;
+    Serial.printf_P(PSTR("  %-16s  0x%02X %6u.%03u %6u.%03u\n"), phase_name(ev.phase), ev.arg,
+      total / mhz, (total % mhz) * 1000u / mhz, delta / mhz, (delta % mhz) * 1000u / mhz);
+  }
+  if (RECLAIM_TIMELINE_MAX < tl->count) {
+    Serial.printf_P(PSTR("  %u events dropped, increase RECLAIM_TIMELINE_MAX\n"), tl->count - RECLAIM_TIMELINE_MAX);
+  }
+}
+
+#if DEBUG_FLASH_QE && DEBUG_FLASH_QE_DEFERRED
+void printDeferredLog() {
+  using namespace experimental;
+  SfuLogDumpHdr hdr;
+  sfu_log_snapshot(&hdr);
+  Serial.printf_P(PSTR("\nDebug messages from preinit(), %u stored, %u dropped:"), hdr.entries, hdr.dropped);
+  char msg[160];
+  for (size_t i = 0u; sfu_log_format(i, msg, sizeof(msg)); i++) Serial.print(msg);
+}
+#endif
+
+void setup() {
+  Serial.begin(115200u);
+  delay(200u);
+  Serial.println("\n\n\nBoot timeline for 'reclaim_GPIO_9_10()'");
+  Serial.printf_P(PSTR("GPIO9 and GPIO10 are%s available.\n"), (gpio_9_10_available) ? "" : " NOT");
+  printTimeline();
+#if DEBUG_FLASH_QE && DEBUG_FLASH_QE_DEFERRED
+  printDeferredLog();
+#endif
+}
+
+void loop() {
+}
+
+extern "C"
+void preinit() {
+  gpio_9_10_available = reclaim_GPIO_9_10();
+}
@@ -0,0 +1,21 @@
+/*@create-file:build.opt@
+
+// Record CPU cycle timestamps for each phase of reclaim_GPIO_9_10() and each
+// flash instruction it sends. Adds a few cycles per event and about 270 bytes
+// of .noinit DRAM. Small enough to leave on in a field build.
+//
+-DRECLAIM_TIMELINE=1
+
+// Reclaim from preinit(). The timeline then shows the time spent from the
+// start of the boot to GPIO9 and GPIO10 being ready.
+//
+-DRECLAIM_GPIO_EARLY=1
+
+// The debug prints would be in the timeline. Leave off when measuring, or
+// defer them. Deferred, each message is stored in .noinit DRAM and printed
+// from setup(), a few cycles per message instead of a 12 ms wait.
+//
+// -DDEBUG_FLASH_QE=1
+// -DDEBUG_FLASH_QE_DEFERRED=1
+
+*/
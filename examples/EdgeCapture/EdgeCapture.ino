@@ -0,0 +1,158 @@
+/*
+  Edge capture latency and rate on GPIO10, with and without flash writes.
+
+  GPIO10 is an output toggled from a timer1 ISR, and captured by its own
+  edge interrupt, so no jumper or signal generator is needed. Leave GPIO10
+  free or on an LED with a series resistor. The timer ISR notes the cycle
+  count of each toggle, the capture stamp less that is the latency: the
+  GPIO interrupt dispatch, and any wait for the timer ISR to return.
+
+  Each run toggles kRunEdges times at one edge interval, then the stamps are
+  read in bulk. Prints the edges made and captured, the drops, the latency,
+  and the frequency and duty from edge_stats_*(). The highest rate is the
+  shortest interval that captures every edge.
+
+  The "flash" runs erase and write a scratch sector in a loop while the
+  edges are made, so many edges land while the iCache is off. The scratch
+  sector is in the free space after the Sketch, the OTA area; an update
+  stored there is lost.
+
+  This example code is in the public domain.
+*/
+#include <ESP8266WiFi.h>
+#include <ModeDIO_ReclaimGPIOs.h>
+#include <FastGPIO_9_10.h>
+#include <EdgeCapture_9_10.h>
+
+using namespace experimental;
+
+constexpr uint32_t kRunEdges = kEdgeCaptureSz;
+constexpr uint32_t kIntervalUs[] = { 100u, 50u, 20u, 10u, 5u, 3u, 2u };
+
+// Written by the timer1 ISR
+static volatile uint32_t gen_count;
+static uint32_t gen_stamp[kRunEdges];
+
+static uint32_t stamps[kRunEdges];
+static uint32_t scratch_sector;
+static uint32_t page[SPI_FLASH_SEC_SIZE / 16u / sizeof(uint32_t)];
+
+static void IRAM_ATTR gen_isr() {
+  const uint32_t n = gen_count;
+  if (kRunEdges <= n) {
+    timer1_disable();
+    return;
+  }
+  gen_stamp[n] = esp_get_cycle_count();
+  FastGPIO10::toggle();
+  gen_count = n + 1u;
+}
+
+// Flash operations while the run lasts. Returns the count.
+static uint32_t flash_load() {
+  uint32_t ops = 0u;
+  uint32_t offset = 0u;
+  const uint32_t start = millis();
+  while (kRunEdges > gen_count && 1000u > millis() - start) {
+    if (0u == offset) {
+      ESP.flashEraseSector(scratch_sector);
+      ops++;
+    }
+    ESP.flashWrite(scratch_sector * SPI_FLASH_SEC_SIZE + offset, page, sizeof(page));
+    offset = (offset + sizeof(page)) % SPI_FLASH_SEC_SIZE;
+    ops++;
+  }
+  return ops;
+}
+
+static void run(const uint32_t interval_us, const bool flash) {
+  FastGPIO10::clear();
+  gen_count = 0u;
+  edge_capture_begin(10u, CHANGE);
+
+  // timer1 counts at 80 MHz with TIM_DIV1, whatever the CPU clock
+  timer1_attachInterrupt(gen_isr);
+  timer1_enable(TIM_DIV1, TIM_EDGE, TIM_LOOP);
+  timer1_write(interval_us * 80u);
+
+  uint32_t ops = 0u;
+  if (flash) {
+    ops = flash_load();
+  } else {
+    const uint32_t start = millis();
+    while (kRunEdges > gen_count && 1000u > millis() - start) {
+      yield();
+    }
+  }
+  timer1_disable();
+  timer1_detachInterrupt();
+  delay(1u);    // Let the last edge in
+
+  const uint32_t made = gen_count;
+  const size_t n = edge_capture_read(10u, stamps, kRunEdges);
+  const uint32_t dropped = edge_capture_overflows(10u);
+  edge_capture_end(10u);
+
+  EdgeStats st;
+  edge_stats_reset(&st);
+  edge_stats_add(&st, stamps, n);
+
+  // Stamps pair with toggles while none are lost
+  uint32_t lat_min = ~0u, lat_max = 0u;
+  uint64_t lat_sum = 0u;
+  const size_t paired = (made == n && 0u == st.repeats) ? n : 0u;
+  for (size_t i = 0u; i < paired; i++) {
+    const uint32_t lat = edge_cycles(stamps[i]) - edge_cycles(gen_stamp[i]);
+    if (lat < lat_min) lat_min = lat;
+    if (lat > lat_max) lat_max = lat;
+    lat_sum += lat;
+  }
+
+  const uint32_t mhz = ESP.getCpuFreqMHz();
+  Serial.printf_P(PSTR("  %4u %5s %5u %5u %5u %5u %6u"), interval_us, (flash) ? "yes" : "no",
+    made, (uint32_t)n, dropped, st.repeats, ops);
+  if (paired) {
+    Serial.printf_P(PSTR(" %7u %7u %7u"), lat_min * 1000u / mhz,
+      (uint32_t)(lat_sum * 1000u / paired / mhz), lat_max * 1000u / mhz);
+  } else {
+    Serial.printf_P(PSTR(" %7s %7s %7s"), "-", "-", "-");
+  }
+  Serial.printf_P(PSTR(" %9.1f %5.3f\n"), (double)edge_stats_frequency(&st), (double)edge_stats_duty(&st));
+}
+
+void setup() {
+  WiFi.mode(WIFI_OFF);
+  const bool ok = reclaim_GPIO_9_10();
+
+  Serial.begin(115200u);
+  delay(200u);
+  Serial.println();
+  if (! ok) {
+    Serial.println("reclaim_GPIO_9_10() failed, GPIO9 and GPIO10 are not available.");
+    return;
+  }
+
+  const uint32_t sketch_end = (ESP.getSketchSize() + SPI_FLASH_SEC_SIZE - 1u) / SPI_FLASH_SEC_SIZE;
+  scratch_sector = sketch_end + 1u;
+  if ((scratch_sector + 1u) * SPI_FLASH_SEC_SIZE > sketch_end * SPI_FLASH_SEC_SIZE + ESP.getFreeSketchSpace()) {
+    Serial.println("No free sector after the Sketch for the flash runs.");
+    return;
+  }
+  memset(page, 0x5A, sizeof(page));
+
+  FastGPIO10::clear();
+  FastGPIO10::output();
+
+  Serial.printf_P(PSTR("CPU %u MHz, %u edges a run, scratch sector 0x%03X\n\n"), ESP.getCpuFreqMHz(), kRunEdges, scratch_sector);
+  Serial.printf_P(PSTR("  %4s %5s %5s %5s %5s %5s %6s %7s %7s %7s %9s %5s\n"),
+    "us", "flash", "made", "got", "drop", "rept", "ops", "lat min", "mean", "max", "Hz", "duty");
+  for (const uint32_t us : kIntervalUs) {
+    run(us, false);
+    run(us, true);
+  }
+  Serial.println();
+  Serial.println("Latency is in ns. Expect Hz = 500000 / us and duty 0.5 when nothing is lost.");
+}
+
+void loop() {
+}
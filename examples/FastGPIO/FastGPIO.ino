@@ -0,0 +1,149 @@
+/*
+  Compare FastGPIO with digitalWrite() and digitalRead() on GPIO9 and GPIO10.
+
+  After reclaim_GPIO_9_10(), each method drives GPIO10 for kLoops iterations
+  with interrupts off, timed with the CPU cycle count. The cost of the empty
+  loop is subtracted. Prints CPU cycles per call and the square wave each
+  gives, one period is two writes. GPIO9 is driven too by the dual-pin rows,
+  leave both pins free or on LEDs with series resistors.
+
+  The benchmark loops are IRAM_ATTR, so iCache misses do not skew the
+  numbers. The core's digitalWrite() and digitalRead() are in IRAM as well,
+  their cost is the pin checks and table lookups.
+
+  This example code is in the public domain.
+*/
+#include <ModeDIO_ReclaimGPIOs.h>
+#include <FastGPIO_9_10.h>
+
+using namespace experimental;
+
+constexpr uint32_t kLoops = 1000u;
+
+static volatile uint32_t sink;
+
+typedef uint32_t (*BenchFn)();
+
+static uint32_t IRAM_ATTR bench_empty() {
+  const uint32_t start = esp_get_cycle_count();
+  for (uint32_t i = 0u; i < kLoops; i++) {
+    __asm__ __volatile__ ("" ::: "memory");
+  }
+  return esp_get_cycle_count() - start;
+}
+
+static uint32_t IRAM_ATTR bench_digitalWrite() {
+  const uint32_t start = esp_get_cycle_count();
+  for (uint32_t i = 0u; i < kLoops; i++) {
+    digitalWrite(10u, i & 1u);
+  }
+  return esp_get_cycle_count() - start;
+}
+
+static uint32_t IRAM_ATTR bench_write() {
+  const uint32_t start = esp_get_cycle_count();
+  for (uint32_t i = 0u; i < kLoops; i++) {
+    FastGPIO10::write(i & 1u);
+  }
+  return esp_get_cycle_count() - start;
+}
+
+static uint32_t IRAM_ATTR bench_set_clear() {
+  const uint32_t start = esp_get_cycle_count();
+  for (uint32_t i = 0u; i < kLoops / 2u; i++) {
+    FastGPIO10::set();
+    FastGPIO10::clear();
+  }
+  return esp_get_cycle_count() - start;
+}
+
+static uint32_t IRAM_ATTR bench_toggle() {
+  const uint32_t start = esp_get_cycle_count();
+  for (uint32_t i = 0u; i < kLoops; i++) {
+    FastGPIO10::toggle();
+  }
+  return esp_get_cycle_count() - start;
+}
+
+static uint32_t IRAM_ATTR bench_dual_write() {
+  const uint32_t start = esp_get_cycle_count();
+  for (uint32_t i = 0u; i < kLoops; i++) {
+    fast_gpio_9_10_write(i & 1u, i & 1u);
+  }
+  return esp_get_cycle_count() - start;
+}
+
+static uint32_t IRAM_ATTR bench_digitalRead() {
+  uint32_t sum = 0u;
+  const uint32_t start = esp_get_cycle_count();
+  for (uint32_t i = 0u; i < kLoops; i++) {
+    sum += digitalRead(10u);
+  }
+  const uint32_t cycles = esp_get_cycle_count() - start;
+  sink = sum;
+  return cycles;
+}
+
+static uint32_t IRAM_ATTR bench_read() {
+  uint32_t sum = 0u;
+  const uint32_t start = esp_get_cycle_count();
+  for (uint32_t i = 0u; i < kLoops; i++) {
+    sum += FastGPIO10::read();
+  }
+  const uint32_t cycles = esp_get_cycle_count() - start;
+  sink = sum;
+  return cycles;
+}
+
+static uint32_t run(BenchFn fn) {
+  const uint32_t saved_ps = xt_rsil(15);
+  const uint32_t cycles = fn();
+  xt_wsr_ps(saved_ps);
+  return cycles;
+}
+
+static void row(const char *name, BenchFn fn, const uint32_t empty, const bool writes) {
+  const uint32_t cycles = run(fn);
+  const uint32_t net = (cycles > empty) ? cycles - empty : 0u;
+  const uint32_t centi = net * 100u / kLoops;     // cycles per call x 100
+  Serial.printf_P(PSTR("  %-28S %4u.%02u"), name, centi / 100u, centi % 100u);
+  if (writes) {
+    // With the loop overhead, what a Sketch would get
+    const uint32_t khz = (uint32_t)((uint64_t)ESP.getCpuFreqMHz() * 1000000u * kLoops / (2u * cycles) / 1000u);
+    Serial.printf_P(PSTR(" %10u"), khz);
+  }
+  Serial.println();
+}
+
+#define ROW(name, fn, writes) row(PSTR(name), fn, empty, writes)
+
+void setup() {
+  const bool ok = reclaim_GPIO_9_10();
+
+  Serial.begin(115200u);
+  delay(200u);
+  Serial.println();
+  if (! ok) {
+    Serial.println("reclaim_GPIO_9_10() failed, GPIO9 and GPIO10 are not available.");
+    return;
+  }
+
+  digitalWrite(9u, HIGH);
+  digitalWrite(10u, HIGH);
+  pinMode(9u, OUTPUT);
+  pinMode(10u, OUTPUT);
+
+  const uint32_t empty = run(bench_empty);
+  Serial.printf_P(PSTR("CPU %u MHz, %u calls each, empty loop %u cycles\n\n"), ESP.getCpuFreqMHz(), kLoops, empty);
+  Serial.printf_P(PSTR("  %-28s %7s %10s\n"), "call", "cycles", "wave kHz");
+  ROW("digitalWrite(10, v)", bench_digitalWrite, true);
+  ROW("FastGPIO10::write(v)", bench_write, true);
+  ROW("FastGPIO10::set() / clear()", bench_set_clear, true);
+  ROW("FastGPIO10::toggle()", bench_toggle, true);
+  ROW("fast_gpio_9_10_write(v, v)", bench_dual_write, true);
+  ROW("digitalRead(10)", bench_digitalRead, false);
+  ROW("FastGPIO10::read()", bench_read, false);
+}
+
+void loop() {
+}
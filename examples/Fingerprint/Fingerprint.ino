@@ -0,0 +1,50 @@
+/*
+  Print a flash fingerprint record for fleet statistics.
+
+  Runs reclaim_GPIO_9_10() from setup(), timing it with the CPU cycle count
+  and spi0_flash_xfer_count. Then reads the JEDEC ID, SFDP, Unique ID, and
+  Status Registers into a FlashFingerprint and prints it as one "FFP1:" line.
+
+  Capture the serial output of each module to a file, or many into one, and
+  run tools/fingerprint/fpstat on them. The line can be mixed with any other
+  output. Define FINGERPRINT_RAW to send the 64 byte record as raw bytes
+  instead.
+
+  This example code is in the public domain.
+*/
+#include <ModeDIO_ReclaimGPIOs.h>
+#include <FlashFingerprint.h>
+
+using namespace experimental;
+
+void setup() {
+  const uint32_t xfers = spi0_flash_xfer_count;
+  const uint32_t start = esp_get_cycle_count();
+  const bool ok = reclaim_GPIO_9_10();
+  const uint32_t cycles = esp_get_cycle_count() - start;
+
+  FlashFingerprintReclaim result = (ok) ? kFpReclaimOk : kFpReclaimFailed;
+#if RECLAIM_RECIPE_CACHE
+  ReclaimRecipeStats stats;
+  if (ok && reclaim_recipe_stats(&stats) && stats.cached) result = kFpReclaimCached;
+#endif
+
+  FlashFingerprint fp;
+  flash_fingerprint_read(&fp, 0u);
+  flash_fingerprint_reclaim(&fp, result, cycles, spi0_flash_xfer_count - xfers);
+  flash_fingerprint_seal(&fp);
+
+  Serial.begin(115200u);
+  delay(200u);
+  Serial.println();
+#ifdef FINGERPRINT_RAW
+  Serial.write((const uint8_t *)&fp, sizeof(fp));
+#else
+  char line[kFlashFingerprintHexSz];
+  flash_fingerprint_hex(&fp, line, sizeof(line));
+  Serial.println(line);
+#endif
+}
+
+void loop() {
+}
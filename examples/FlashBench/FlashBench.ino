@@ -0,0 +1,130 @@
+/*
+  Measure what the flash read mode costs a Sketch.
+
+  Build once in each mode and at each SPI clock of interest, eg. QIO and
+  DIO at 40 and 80 MHz, and run. Each run prints, in ns and KiB/s:
+
+    icache_cold     a call to a flash function not in the iCache
+    icache_hot      the same call again
+    icache_miss     cold less hot, the iCache miss latency
+    spi_read_N      spi_flash_read() of N bytes, 64 KB sequential
+    mapped_cold_N   N bytes of memory mapped flash, PROGMEM style, after
+                    the iCache is emptied
+    mapped_hot_N    the same bytes again
+
+  The "env" lines give the read mode from SPI0C, the SPI clock from the
+  image header, the CPU clock, and the wire time of one iCache line fill
+  for comparison with icache_miss. GPIO9 and GPIO10 are reclaimed first,
+  this fails in a QIO or QOUT build and is reported, the numbers are still
+  good.
+
+  All result lines start with "FB1". Capture the serial output of each run
+  to a file and compare them with tools/flashbench:
+
+    fbcmp qio_40.log dio_40.log dio_80.log
+
+  Hotkey 'r' runs it again.
+
+  This example code is in the public domain.
+*/
+#include <ModeDIO_ReclaimGPIOs.h>
+#include <FlashBench.h>
+
+using namespace experimental;
+
+constexpr uint32_t kRounds = 16u;
+constexpr uint32_t kReadAddr = 0x10000u;      // Flash offset for spi_flash_read()
+constexpr size_t kReadTotal = 64u * 1024u;
+constexpr size_t kMappedBytes = 4096u;
+
+static uint32_t buf[1024];                    // Largest spi_flash_read() chunk
+
+static const char *mode_name(const SpiIoMode mode) {
+  switch (mode) {
+    case kSpiIoSlow:  return "SLOW";
+    case kSpiIoFast:  return "FAST";
+    case kSpiIoDout:  return "DOUT";
+    case kSpiIoDio:   return "DIO";
+    case kSpiIoQout:  return "QOUT";
+    case kSpiIoQio:   return "QIO";
+    default:          return "?";
+  }
+}
+
+static void print_result(const char *name, const uint32_t size, const BenchStats& st, const uint32_t bytes) {
+  const uint32_t mhz = ESP.getCpuFreqMHz();
+  char label[24];
+  if (size) {
+    snprintf_P(label, sizeof(label), PSTR("%S_%u"), name, size);
+  } else {
+    snprintf_P(label, sizeof(label), PSTR("%S"), name);
+  }
+  const uint32_t mean = bench_stats_mean(&st);
+  Serial.printf_P(PSTR("FB1 %-16s %5u %9u %9u %9u %9u %7u\n"), label, st.n,
+    st.min * 1000u / mhz, mean * 1000u / mhz, st.max * 1000u / mhz,
+    bench_stats_stddev(&st) * 1000u / mhz, (bytes) ? flash_bench_kib_s(bytes, mean, mhz) : 0u);
+}
+
+void runBench() {
+  FlashBenchEnv env;
+  flash_bench_env(&env);
+  Serial.printf_P(PSTR("FB1 env mode %s\n"), mode_name(env.mode));
+  Serial.printf_P(PSTR("FB1 env spi_mhz %u\n"), env.spi_mhz);
+  Serial.printf_P(PSTR("FB1 env cpu_mhz %u\n"), env.cpu_mhz);
+  Serial.printf_P(PSTR("FB1 env quad %u\n"), env.quad);
+  Serial.printf_P(PSTR("FB1 env reclaimed %u\n"), env.reclaimed);
+  Serial.printf_P(PSTR("FB1 env line_fill_ns %u\n"), env.line_fill_ns);
+  Serial.printf_P(PSTR("FB1 %-16s %5s %9s %9s %9s %9s %7s\n"),
+    "#test", "n", "min_ns", "mean_ns", "max_ns", "sd_ns", "kib_s");
+
+  BenchStats cold, hot, miss;
+  bench_stats_reset(&cold);
+  bench_stats_reset(&hot);
+  bench_stats_reset(&miss);
+  flash_bench_icache_miss(&cold, &hot, &miss, kRounds);
+  print_result(PSTR("icache_cold"), 0u, cold, 0u);
+  print_result(PSTR("icache_hot"), 0u, hot, 0u);
+  print_result(PSTR("icache_miss"), 0u, miss, 0u);
+
+  for (size_t chunk = 32u; chunk <= sizeof(buf); chunk *= 4u) {
+    BenchStats st;
+    bench_stats_reset(&st);
+    if (! flash_bench_spi_read(&st, kReadAddr, buf, chunk, kReadTotal)) {
+      Serial.printf_P(PSTR("FB1 # spi_flash_read() failed, chunk %u\n"), chunk);
+      continue;
+    }
+    print_result(PSTR("spi_read"), chunk, st, chunk);
+  }
+
+  bench_stats_reset(&cold);
+  bench_stats_reset(&hot);
+  flash_bench_mapped_read(&cold, &hot, kMappedBytes, kRounds);
+  print_result(PSTR("mapped_cold"), kMappedBytes, cold, kMappedBytes);
+  print_result(PSTR("mapped_hot"), kMappedBytes, hot, kMappedBytes);
+  Serial.println("FB1 end");
+}
+
+void setup() {
+  Serial.begin(115200u);
+  delay(200u);
+  Serial.println("\n\n\nFlash read benchmark");
+  const bool reclaimed = reclaim_GPIO_9_10();
+  Serial.printf_P(PSTR("GPIO9 and GPIO10 are%s available.\n\n"), (reclaimed) ? "" : " NOT");
+  runBench();
+}
+
+void loop() {
+  int hotKey = Serial.read();
+  if (0 >= hotKey) return;
+  switch (hotKey) {
+    case 'r':
+      runBench();
+      break;
+    case '?':
+      Serial.println("Hotkeys:");
+      Serial.println("  r - run the benchmarks again");
+      break;
+    default:
+      break;
+  }
+}
@@ -0,0 +1,132 @@
+/*
+  Print the bus cost of the SpiFlashUtils helpers.
+
+  Each helper is run once. For each, the line shows the flash transactions,
+  SPI clocks, and iCache disable windows that spi0_flash_cost recorded, then
+  spi_flash_cost_report()'s wire time, controller overhead, and iCache off
+  time. The last column is the time the call took, measured with the CPU
+  cycle count. Use it to calibrate SPI_FLASH_COST_WINDOW_CYCLES and
+  SPI_FLASH_COST_XFER_CYCLES.
+
+  Only reads are run. Writes are estimated with the spi_flash_cost_*()
+  functions, without sending them. On some parts, like the XMC, even a
+  volatile Status Register write has side effects. A non-volatile write costs
+  the same as a volatile one, less the Write Disable, plus the part's write
+  time, tW, with the iCache off the whole time.
+
+  Also prints the wire time of one iCache line fill for each SPI0 read mode.
+
+  See "FlashCost.ino.globals.h" for build options.
+
+  This example code is in the public domain.
+*/
+#if ! SPI_FLASH_COST
+#error This build requires global define '-DSPI_FLASH_COST=1'
+#endif
+
+#include <ModeDIO_ReclaimGPIOs.h>
+#include <SpiFlashUtilsQE.h>
+
+using namespace experimental;
+
+static uint32_t sr1, sr2, sr3;
+static uint32_t buf[64];
+
+static const char *mode_name(const SpiIoMode mode) {
+  switch (mode) {
+    case kSpiIoSlow:  return "SLOW";
+    case kSpiIoFast:  return "FAST";
+    case kSpiIoDout:  return "DOUT";
+    case kSpiIoDio:   return "DIO";
+    case kSpiIoQout:  return "QOUT";
+    case kSpiIoQio:   return "QIO";
+    default:          return "?";
+  }
+}
+
+static void print_us(const uint32_t ns) {
+  Serial.printf_P(PSTR(" %5u.%02u"), ns / 1000u, (ns % 1000u) / 10u);
+}
+
+static void print_row(const char *name, const SpiFlashCost& c) {
+  const SpiCostReport r = spi_flash_cost_report(c);
+  Serial.printf_P(PSTR("  %-30S %4u %6u %3u"), name, r.xfers, c.clocks, r.windows);
+  print_us(r.bus_ns);
+  print_us(r.overhead_ns);
+  print_us(r.cache_off_ns);
+}
+
+static void row(const char *name, void (*fn)()) {
+  const SpiFlashCost mark = spi0_flash_cost;
+  const uint32_t start = esp_get_cycle_count();
+  fn();
+  const uint32_t cycles = esp_get_cycle_count() - start;
+  print_row(name, spi0_flash_cost_since(mark));
+  print_us(cycles * 1000u / clockCyclesPerMicrosecond());
+  Serial.println();
+}
+
+#define ROW(name, expr) row(PSTR(name), []() { expr; })
+
+void printCostReport() {
+  const uint32_t mhz = spi0_flash_mhz();
+  Serial.printf_P(PSTR("SPI0 clock %u MHz, read mode %s\n\n"), mhz, mode_name(spi0_io_mode()));
+  if (0u == mhz) {
+    Serial.println("Unknown SPI clock in the image header.");
+    return;
+  }
+
+  Serial.printf_P(PSTR("  %-30s %4s %6s %3s %8s %8s %8s %8s\n"),
+    "call", "txn", "clocks", "win", "bus us", "ovh us", "off us", "run us");
+  spi0_flash_read_status_register_1(&sr1);
+  spi0_flash_read_status_register_2(&sr2);
+  spi0_flash_read_status_register_3(&sr3);
+  ROW("read_status_register_1", spi0_flash_read_status_register_1(&sr1));
+  ROW("read_status_register_2", spi0_flash_read_status_register_2(&sr2));
+  ROW("read_status_registers_3B", spi0_flash_read_status_registers_3B(&sr3));
+  ROW("verify_status_register_1", verify_status_register_1(kWELBit));
+  ROW("is_QE", is_QE());
+  ROW("read_sfdp 16 bytes", spi0_flash_read_sfdp(0u, buf, 16u));
+  ROW("read_sfdp 256 bytes", spi0_flash_read_sfdp(0u, buf, 256u));
+  ROW("read_unique_id_128", spi0_flash_read_unique_id_128(buf));
+
+  // Estimates, not run. Volatile writes send 04h first, in its own window
+  // when not in a sequence.
+  SpiFlashCost est{};
+  spi_flash_cost_command(est, kWriteDisableCmd, 0u, 0u, SPI_FLASH_CMD_NOT_USED);
+  spi_flash_cost_command(est, kWriteStatusRegister2Cmd, 8u, 0u, kVolatileWriteEnableCmd);
+  print_row(PSTR("write_status_register_2 (v)"), est);
+  Serial.println(" estimate");
+
+  est = SpiFlashCost{};
+  spi_flash_cost_command(est, kWriteStatusRegister2Cmd, 8u, 0u, kWriteEnableCmd);
+  print_row(PSTR("write_status_register_2 (nv)"), est);
+  Serial.println(" estimate, + tW");
+
+  // spi0_flash_write_verify_status_register(), volatile: 04h, 50h 31h, 35h
+  est = SpiFlashCost{};
+  spi_flash_cost_window(est, 3u);
+  spi_flash_cost_xfer(est, 0u, 0u);
+  spi_flash_cost_prefix(est, kWriteStatusRegister2Cmd, kVolatileWriteEnableCmd);
+  spi_flash_cost_xfer(est, 8u, 0u);
+  spi_flash_cost_xfer(est, 0u, 8u);
+  print_row(PSTR("write_verify_status_reg (v)"), est);
+  Serial.println(" estimate");
+
+  Serial.printf_P(PSTR("\n  iCache line fill, %u bytes\n"), kICacheLineSz);
+  for (uint32_t m = kSpiIoSlow; m <= kSpiIoQio; m++) {
+    Serial.printf_P(PSTR("  %-4s"), mode_name((SpiIoMode)m));
+    print_us(spi_icache_line_ns((SpiIoMode)m, mhz));
+    Serial.println();
+  }
+}
+
+void setup() {
+  Serial.begin(115200u);
+  delay(200u);
+  Serial.println("\n\n\nSPI0 flash cost report");
+  printCostReport();
+}
+
+void loop() {
+}
@@ -0,0 +1,15 @@
+/*@create-file:build.opt@
+
+// Record the clocks, transactions, and iCache disable windows of each
+// library flash instruction in spi0_flash_cost. Adds a few instructions per
+// flash instruction and 20 bytes of .noinit DRAM.
+//
+-DSPI_FLASH_COST=1
+
+// Controller overhead estimates, in CPU cycles. Adjust until the "off us"
+// column matches the "run us" column for the reads on your module.
+//
+// -DSPI_FLASH_COST_WINDOW_CYCLES=400
+// -DSPI_FLASH_COST_XFER_CYCLES=40
+
+*/
@@ -0,0 +1,119 @@
+/*
+  Soak test with the SPI0 flash trace on.
+
+  reclaim_GPIO_9_10() runs from preinit(). Then, every kSoakMs, the loop reads
+  the Status Registers, SFDP, and the Unique ID through the library, and
+  prints the trace counters. A failure or a WEL left set prints a dump right
+  away. The trace is in .noinit, after a crash or a watchdog reset the
+  records leading up to it are dumped at boot.
+
+  Dumps are "SFT1:" and "SFR1:" lines in the serial log. Decode a captured
+  log on the host with tools/spitrace:
+
+    spitrace soak.log
+
+  Hotkeys:
+    d - dump the trace
+    z - reset the trace
+    ? - help
+
+  See "FlashTrace.ino.globals.h" for build options.
+
+  This example code is in the public domain.
+*/
+#if ! SPI_FLASH_TRACE
+#error This build requires global define '-DSPI_FLASH_TRACE=1'
+#endif
+#if ! RECLAIM_GPIO_EARLY
+#error This build requires global define '-DRECLAIM_GPIO_EARLY=1'
+#endif
+
+#include <ModeDIO_ReclaimGPIOs.h>
+#include <SfdpRevInfo.h>
+
+using namespace experimental;
+
+constexpr uint32_t kSoakMs = 10000u;
+
+// Variable is used before C++ runtime init has started.
+bool gpio_9_10_available __attribute__((section(".noinit")));
+
+static SpiTraceCounters last;
+static uint32_t last_soak;
+
+void printTraceDump() {
+  char line[kSpiTraceLineSz];
+  for (size_t i = 0u; spi_flash_trace_line(i, line, sizeof(line)); i++) {
+    Serial.println(line);
+  }
+}
+
+void printCounters(const SpiTraceCounters& c) {
+  const uint32_t off_us = (uint32_t)(c.cache_off_cycles / clockCyclesPerMicrosecond());
+  Serial.printf_P(PSTR("Trace: %u records, %u failures, %u WEL left set, %u windows, iCache off %u us\n"),
+    c.records, c.failures, c.wel_left_set, c.windows, off_us);
+}
+
+static void soak() {
+  uint32_t sr = 0u;
+  spi0_flash_read_status_registers_3B(&sr);
+  uint32_t uid[4];
+  spi0_flash_read_unique_id(0u, uid, sizeof(uid));
+  get_sfdp_revision();
+
+  SpiTraceDumpHdr hdr;
+  spi_flash_trace_snapshot(&hdr);
+  printCounters(hdr.counters);
+  if (hdr.counters.failures != last.failures || hdr.counters.wel_left_set != last.wel_left_set) {
+    printTraceDump();
+  }
+  last = hdr.counters;
+}
+
+void setup() {
+  Serial.begin(115200u);
+  delay(200u);
+  Serial.println("\n\n\nFlash trace soak test");
+  Serial.printf_P(PSTR("Reset reason: %s\n"), ESP.getResetReason().c_str());
+  Serial.printf_P(PSTR("GPIO9 and GPIO10 are%s available.\n"), (gpio_9_10_available) ? "" : " NOT");
+
+  // From preinit(), and after a crash the records before it
+  printTraceDump();
+  SpiTraceDumpHdr hdr;
+  spi_flash_trace_snapshot(&hdr);
+  last = hdr.counters;
+  printCounters(last);
+  last_soak = millis();
+}
+
+void loop() {
+  if (kSoakMs <= millis() - last_soak) {
+    last_soak = millis();
+    soak();
+  }
+
+  int hotKey = Serial.read();
+  if (0 >= hotKey) return;
+  switch (hotKey) {
+    case 'd':
+      printTraceDump();
+      break;
+    case 'z':
+      spi_flash_trace_reset();
+      last = SpiTraceCounters{};
+      Serial.println("Trace reset.");
+      break;
+    case '?':
+      Serial.println("Hotkeys:");
+      Serial.println("  d - dump the trace");
+      Serial.println("  z - reset the trace");
+      break;
+    default:
+      break;
+  }
+}
+
+extern "C"
+void preinit() {
+  gpio_9_10_available = reclaim_GPIO_9_10();
+}
@@ -0,0 +1,19 @@
+/*@create-file:build.opt@
+
+// Record each library flash instruction in a ring in .noinit DRAM, with
+// counters for failures, WEL left set, and iCache off time. About 40 cycles
+// per instruction and 1.6K of .noinit DRAM with the default 64 records.
+// Small enough to leave on in a soak build.
+//
+-DSPI_FLASH_TRACE=1
+
+// Records kept, a power of 2.
+//
+// -DSPI_FLASH_TRACE_MAX=64u
+
+// Reclaim from preinit(). The first dump after a power on then starts with
+// the instructions reclaim_GPIO_9_10() sent.
+//
+-DRECLAIM_GPIO_EARLY=1
+
+*/
@@ -0,0 +1,135 @@
+/*
+  Throughput and jitter of I2cBus_9_10 against the core's Wire library.
+
+  Needs an I2C device on GPIO10 (SDA) and GPIO9 (SCL) with pull-ups, 2.2K to
+  4.7K. Set kDeviceAddr, kReg, and kLen for the device; any register block
+  that can be read repeatedly will do, eg. a sensor's ID or data registers.
+
+  After reclaim_GPIO_9_10(), for each clock rate, the register block is read
+  kRuns times with I2cBus_9_10, then with Wire on the same pins. Each read is
+  timed with the CPU cycle count. Prints the mean, minimum, and maximum time
+  of a read, the spread (max - min) as the jitter, the payload rate, and the
+  errors. Interrupts stay on, as in a Sketch; WiFi is off.
+
+  For Fast-mode Plus, 1 MHz, set the CPU to 160 MHz. Wire may not reach the
+  rate asked for.
+
+  This example code is in the public domain.
+*/
+#include <ESP8266WiFi.h>
+#include <Wire.h>
+#include <ModeDIO_ReclaimGPIOs.h>
+#include <I2cBus_9_10.h>
+
+using namespace experimental;
+
+constexpr uint8_t kDeviceAddr = 0x76u;  // eg. BME280
+constexpr uint8_t kReg = 0xF7u;         // BME280 data registers
+constexpr size_t kLen = 8u;
+constexpr uint32_t kRuns = 200u;
+constexpr uint32_t kSdaPin = 10u;
+constexpr uint32_t kSclPin = 9u;
+
+struct Timing {
+  uint32_t min = ~0u;
+  uint32_t max = 0u;
+  uint64_t sum = 0u;
+  uint32_t n = 0u;
+  uint32_t errors = 0u;
+
+  void add(const uint32_t cycles) {
+    if (cycles < min) min = cycles;
+    if (cycles > max) max = cycles;
+    sum += cycles;
+    n++;
+  }
+};
+
+static uint8_t buf[kLen];
+
+static void print_row(const char *name, const uint32_t hz, const Timing& t) {
+  const uint32_t mhz = ESP.getCpuFreqMHz();
+  if (0u == t.n) {
+    Serial.printf_P(PSTR("  %-8s %5u  all %u reads failed\n"), name, hz / 1000u, t.errors);
+    return;
+  }
+  const uint32_t mean = t.sum / t.n;
+  const uint32_t bps = (uint32_t)((uint64_t)kLen * mhz * 1000000u / mean);
+  Serial.printf_P(PSTR("  %-8s %5u %8.1f %8.1f %8.1f %8.2f %8u %6u\n"), name, hz / 1000u,
+    (double)mean / mhz, (double)t.min / mhz, (double)t.max / mhz,
+    (double)(t.max - t.min) / mhz, bps, t.errors);
+}
+
+static void bench_bus(const uint32_t hz) {
+  I2cBus bus;
+  Timing t;
+  if (! i2c_bus_begin(&bus, kSdaPin, hz)) {
+    Serial.println("  i2c_bus_begin() failed");
+    return;
+  }
+  for (uint32_t i = 0u; i < kRuns; i++) {
+    const uint32_t start = esp_get_cycle_count();
+    const I2cResult r = i2c_bus_read_reg(&bus, kDeviceAddr, kReg, buf, kLen);
+    const uint32_t cycles = esp_get_cycle_count() - start;
+    if (kI2cOk == r) {
+      t.add(cycles);
+    } else {
+      t.errors++;
+      i2c_bus_recover(&bus);
+    }
+  }
+  i2c_bus_end(&bus);
+  print_row("I2cBus", hz, t);
+  if (bus.stats.late) {
+    Serial.printf_P(PSTR("  %-8s %5s  %u late edges, %u clock stretches\n"), "", "", bus.stats.late, bus.stats.stretches);
+  }
+}
+
+static void bench_wire(const uint32_t hz) {
+  Timing t;
+  Wire.begin(kSdaPin, kSclPin);
+  Wire.setClock(hz);
+  for (uint32_t i = 0u; i < kRuns; i++) {
+    const uint32_t start = esp_get_cycle_count();
+    Wire.beginTransmission(kDeviceAddr);
+    Wire.write(kReg);
+    bool ok = 0u == Wire.endTransmission(false);
+    ok = ok && kLen == Wire.requestFrom(kDeviceAddr, kLen);
+    for (size_t k = 0u; ok && k < kLen; k++) buf[k] = Wire.read();
+    const uint32_t cycles = esp_get_cycle_count() - start;
+    if (ok) {
+      t.add(cycles);
+    } else {
+      t.errors++;
+    }
+  }
+  // Wire has no end(), put the pins back as plain inputs
+  pinMode(kSdaPin, INPUT);
+  pinMode(kSclPin, INPUT);
+  print_row("Wire", hz, t);
+}
+
+void setup() {
+  const bool ok = reclaim_GPIO_9_10();
+
+  WiFi.mode(WIFI_OFF);
+  Serial.begin(115200u);
+  delay(200u);
+  Serial.println();
+  if (! ok) {
+    Serial.println("reclaim_GPIO_9_10() failed, GPIO9 and GPIO10 are not available.");
+    return;
+  }
+
+  Serial.printf_P(PSTR("CPU %u MHz, device 0x%02X, register 0x%02X, %u bytes, %u reads\n\n"),
+    ESP.getCpuFreqMHz(), kDeviceAddr, kReg, kLen, kRuns);
+  Serial.printf_P(PSTR("  %-8s %5s %8s %8s %8s %8s %8s %6s\n"),
+    "method", "kHz", "mean us", "min us", "max us", "jitter", "B/s", "errors");
+  for (const uint32_t hz : {kI2cStandardHz, kI2cFastHz, kI2cFastPlusHz}) {
+    bench_bus(hz);
+    bench_wire(hz);
+  }
+}
+
+void loop() {
+}
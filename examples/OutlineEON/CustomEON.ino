@@ -16,17 +16,18 @@ bool spi_flash_vendor_cases(uint32_t device) {
   using namespace experimental;
   bool success = false;
 
-  SfdpRevInfo sfdpInfo;
-  uint32_t* sfdp_dw = get_sfdp_basic(&sfdpInfo);  // uses malloc, must free
+  // Called from preinit(), no heap. The 9 DWs of a rev 1.00 table on the stack.
+  SfdpDwArray<9u> sfdp;
+  get_sfdp_table(&sfdp);
 
-  if (0x301C == (device & 0xFFFFu) && sfdp_dw) {
+  if (0x301C == (device & 0xFFFFu) && ! sfdp.empty()) {
     // Status: tested, sealed in ESP-12F module
     // EON EN25Q32C, identification based on datasheet and data matchup
     // SFDP Revision: 1.00, 1ST Parameter Table Revision: 1.00
     // SFDP Table Ptr: 0x30, Size: 9 DW
-    if (1u == sfdpInfo.parm_major &&
-      0u == sfdpInfo.parm_minor &&
-      0xE5u == (sfdp_dw[0] & 0xFFu)) {
+    if (1u == sfdp.rev.parm_major &&
+      0u == sfdp.rev.parm_minor &&
+      0xE5u == (sfdp[0] & 0xFFu)) {
       // These will match EN25Q32C pin 4 NC (DQ3) no /HOLD function and no
       // volatile bits. EON SPI Flash parts have a WPDis S6 bit in status
       // register-1 for disabling /WP (and /HOLD). This is similar to QE/S9 on
@@ -39,7 +40,6 @@ bool spi_flash_vendor_cases(uint32_t device) {
     // datasheets do not show SFDP support; however, RTOS_SDK sample code
     // implies they do.
   }
-  if (sfdp_dw) free(sfdp_dw);
 
   if (! success) {
     // then try built-in support
@@ -54,6 +54,7 @@ extern "C"
 bool spi_flash_vendor_cases(uint32_t device) {
   using namespace experimental;
   bool success = false;
+  // Stack only, no heap. Safe when called from preinit().
   SfdpRevInfo sfdpInfo = get_sfdp_revision();
 
   if (0x4020 == (device & 0xFFFFu)) {  // XMC
@@ -105,8 +106,13 @@ bool spi_flash_vendor_cases(uint32_t device) {
       }
       ok0 = spi0_flash_write_status_register_3(newSR3, volatile_bit);
       DBG_SFU_PRINTF("  XMC Anomaly: Copy Driver Strength values to volatile status register.\n");
-      if (SPI_RESULT_OK != ok0) {
+      if (SPI_RESULT_OK == ok0) {
+        // With -DRECLAIM_RECIPE_CACHE=1, a warm boot restores the same value.
+        qe_recipe_note_sr3(newSR3);
+      } else {
         DBG_SFU_PRINTF("* anomaly handling failed.\n");
+        // Don't cache a recipe that would repeat the QE write without SR3
+        qe_recipe.kind = kQeRecipeNotSet;
       }
     }
   }
@@ -13,4 +13,9 @@
 //
 -DRECLAIM_GPIO_EARLY=1
 
+// Save the QE recipe in RTC memory. Warm boots and deep-sleep wakes skip
+// vendor discovery, including this example's SFDP reads.
+//
+-DRECLAIM_RECIPE_CACHE=1
+
 */
@@ -66,19 +66,23 @@ constexpr uint32_t kSfdpSignature = 0x50444653u; //'SFDP'
 //
 bool dumpSfdp() {
   Serial.printf("Raw dump of SFDP");
-  uint32_t param[4];
+  // Read the SFDP space 64 bytes at a time, the most SPI0Command can return
+  // with one call. 256 bytes takes 4 reads.
+  uint32_t param[16];
   SpiOpResult ok0 = spi0_flash_read_sfdp(0, param, sizeof(param));
 
   if (SPI_RESULT_OK == ok0 && kSfdpSignature == param[0]) {
     for (size_t j = 0u; ; ) {
-      Serial.printf("\n  0x%02X  ", 0x10u * j);
-      for (size_t i = 0u; i < 4u; i++) {
+      for (size_t i = 0u; i < 16u; i++) {
+        if (0u == (i % 4u)) {
+          Serial.printf("\n  0x%02X  ", sizeof(param) * j + sizeof(uint32_t) * i);
+        }
         Serial.printf(" 0x%08X", param[i]);
       }
       j++;
-      if (16 <= j) break;
+      if (4u <= j) break;
 
-      if (SPI_RESULT_OK != spi0_flash_read_sfdp((j * 16u), param, sizeof(param))) {
+      if (SPI_RESULT_OK != spi0_flash_read_sfdp((j * sizeof(param)), param, sizeof(param))) {
         Serial.printf("\n  error reading SFDP.");
         break;
       }
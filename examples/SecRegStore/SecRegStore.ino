@@ -0,0 +1,65 @@
+/*
+  Keep the QE recipe for this module in a flash Security Register.
+
+  Runs reclaim_GPIO_9_10() from setup(), then saves the recipe it used, with
+  the Flash Chip ID, in Security Register 3. A later boot finds the recipe
+  with one 256 byte read. The save is skipped when the stored recipe is the
+  same, so the register is only written the first time, or after the part
+  changes.
+
+  The Security Registers are outside the flash map. Uploads, OTA, and
+  ESP.eraseConfig() do not touch them. A register that holds anything else
+  is left alone. Define SEC_REG_FORMAT to erase it and start a store.
+
+  Only for parts with Winbond style Security Registers, see the notes in
+  SecurityRegisterStore.h.
+
+  This example code is in the public domain.
+*/
+#include <ModeDIO_ReclaimGPIOs.h>
+#include <SecurityRegisterStore.h>
+
+using namespace experimental;
+
+constexpr uint32_t kStoreReg = 3u;
+
+SecRegStore store;
+
+void setup() {
+  const bool ok = reclaim_GPIO_9_10();
+
+  Serial.begin(115200u);
+  delay(200u);
+  Serial.println();
+
+  const uint32_t id = spi_flash_get_id();
+  bool open = sec_reg_store_open(&store, kStoreReg);
+#ifdef SEC_REG_FORMAT
+  if (! open && kSecRegStoreForeign == store.state) {
+    open = SPI_RESULT_OK == sec_reg_store_format(&store);
+  }
+#endif
+  if (! open) {
+    Serial.printf("Security Register %u, not a store, state %u\n", kStoreReg, store.state);
+    return;
+  }
+
+  SecRegRecipe rec;
+  if (sec_reg_store_get(&store, kSecRegTagRecipe, &rec, sizeof(rec))) {
+    Serial.printf("Stored recipe for 0x%06X: kind %u, %svolatile%s\n", rec.chip_id,
+      rec.recipe.kind, (rec.recipe.non_volatile) ? "non-" : "", (rec.recipe.restore_sr3) ? ", restore SR3" : "");
+  } else {
+    Serial.printf("No stored recipe\n");
+  }
+
+  if (ok) {
+    const SpiOpResult ok0 = sec_reg_store_save_recipe(&store, id);
+    Serial.printf("Save recipe for 0x%06X: %s\n", id, (SPI_RESULT_OK == ok0) ? "OK" : "failed");
+  } else {
+    Serial.printf("reclaim_GPIO_9_10() failed, nothing to save\n");
+  }
+  Serial.printf("Free: %u bytes\n", sec_reg_store_free(&store));
+}
+
+void loop() {
+}
@@ -0,0 +1,172 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+////////////////////////////////////////////////////////////////////////////////
+// Edge capture on GPIO9 and GPIO10, see EdgeCapture_9_10.h
+//
+#include <Arduino.h>
+#include <user_interface.h>   // system_get_cpu_freq()
+#include "ModeDIO_ReclaimGPIOs.h"
+#include "FastGPIO_9_10.h"
+#include "EdgeCapture_9_10.h"
+
+namespace experimental {
+
+// Free running counts, the difference is the fill. The ISR writes head and
+// overflows, the Sketch writes tail.
+struct EdgeRing {
+  volatile uint32_t head;
+  volatile uint32_t tail;
+  volatile uint32_t overflows;
+  uint32_t mask;
+  uint32_t stamp[kEdgeCaptureSz];
+};
+
+static EdgeRing edge_ring[2];
+
+static inline EdgeRing *ring_for(const uint32_t pin) {
+  return (9u == pin || 10u == pin) ? &edge_ring[pin - 9u] : nullptr;
+}
+
+// Called by the core's GPIO dispatch, with interrupts held off
+static void IRAM_ATTR edge_isr(void *arg) {
+  const uint32_t now = esp_get_cycle_count();
+  EdgeRing *ring = (EdgeRing *)arg;
+  const uint32_t level = (0u != (GPI & ring->mask)) ? kEdgeLevel : 0u;
+  const uint32_t head = ring->head;
+  if (kEdgeCaptureSz <= head - ring->tail) {
+    ring->overflows = ring->overflows + 1u;
+    return;
+  }
+  ring->stamp[head & (kEdgeCaptureSz - 1u)] = edge_cycles(now) | level;
+  // The stamp is in place before the head moves past it
+  __asm__ __volatile__ ("" ::: "memory");
+  ring->head = head + 1u;
+}
+
+bool edge_capture_begin(const uint32_t pin, const int mode, const bool pullup) {
+  EdgeRing *ring = ring_for(pin);
+  if (nullptr == ring || ! is_GPIO_9_10_reclaimed()) return false;
+  if (RISING != mode && FALLING != mode && CHANGE != mode) return false;
+
+  detachInterrupt(pin);
+  ring->mask = 1u << pin;
+  ring->head = 0u;
+  ring->tail = 0u;
+  ring->overflows = 0u;
+  if (0u == (GPE & ring->mask)) {
+    if (9u == pin) {
+      FastGPIO9::input(pullup);
+    } else {
+      FastGPIO10::input(pullup);
+    }
+  }
+  attachInterruptArg(pin, edge_isr, ring, mode);
+  return true;
+}
+
+void edge_capture_end(const uint32_t pin) {
+  if (nullptr == ring_for(pin)) return;
+  detachInterrupt(pin);
+}
+
+size_t edge_capture_available(const uint32_t pin) {
+  const EdgeRing *ring = ring_for(pin);
+  if (nullptr == ring) return 0u;
+  return ring->head - ring->tail;
+}
+
+size_t edge_capture_read(const uint32_t pin, uint32_t *p, const size_t max) {
+  EdgeRing *ring = ring_for(pin);
+  if (nullptr == ring || nullptr == p) return 0u;
+
+  const uint32_t head = ring->head;
+  // No stamp is read before the head that covers it
+  __asm__ __volatile__ ("" ::: "memory");
+  const uint32_t tail = ring->tail;
+  size_t n = head - tail;
+  if (n > max) n = max;
+  for (size_t i = 0u; i < n; i++) {
+    p[i] = ring->stamp[(tail + i) & (kEdgeCaptureSz - 1u)];
+  }
+  // All copied before the ISR may reuse the slots
+  __asm__ __volatile__ ("" ::: "memory");
+  ring->tail = tail + n;
+  return n;
+}
+
+uint32_t edge_capture_overflows(const uint32_t pin) {
+  const EdgeRing *ring = ring_for(pin);
+  return (ring) ? ring->overflows : 0u;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Statistics, from the Sketch
+void edge_stats_reset(EdgeStats *st) {
+  if (nullptr == st) return;
+  memset(st, 0, sizeof(EdgeStats));
+  st->period_min = ~0u;
+}
+
+void edge_stats_add(EdgeStats *st, const uint32_t *p, const size_t n) {
+  if (nullptr == st || nullptr == p) return;
+
+  for (size_t i = 0u; i < n; i++) {
+    const uint32_t level = (edge_level(p[i])) ? 1u : 0u;
+    const uint32_t t = edge_cycles(p[i]);
+    if (st->have & (1u << level)) {
+      const uint32_t period = t - st->last[level];
+      st->periods++;
+      st->period_sum += period;
+      if (period < st->period_min) st->period_min = period;
+      if (period > st->period_max) st->period_max = period;
+    }
+    if (0u != st->edges) {
+      if (level == st->prev_level) {
+        st->repeats++;
+      } else if (level) {
+        st->low_sum += t - st->last[0];
+        st->lows++;
+      } else {
+        st->high_sum += t - st->last[1];
+        st->highs++;
+      }
+    }
+    st->last[level] = t;
+    st->have |= 1u << level;
+    st->prev_level = level;
+    st->edges++;
+  }
+}
+
+float edge_stats_frequency(const EdgeStats *st) {
+  if (nullptr == st || 0u == st->period_sum) return 0.0f;
+  return (float)((double)st->periods * system_get_cpu_freq() * 1000000.0 / (double)st->period_sum);
+}
+
+float edge_stats_period_us(const EdgeStats *st) {
+  if (nullptr == st || 0u == st->periods) return 0.0f;
+  return (float)((double)st->period_sum / st->periods / system_get_cpu_freq());
+}
+
+float edge_stats_duty(const EdgeStats *st) {
+  if (nullptr == st || 0u == st->highs || 0u == st->lows) return 0.0f;
+  // From the mean high and low times, a run may hold one more of either
+  const double high = (double)st->high_sum / st->highs;
+  const double low = (double)st->low_sum / st->lows;
+  return (float)(high / (high + low));
+}
+
+};  // namespace experimental
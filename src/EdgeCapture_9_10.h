@@ -0,0 +1,122 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Edge capture on the reclaimed GPIO9 and GPIO10
+
+  Timestamps pin edges with the CPU cycle count, for pulse counting and
+  frequency, period, and duty measurement, eg. a flow meter. The ISR is
+  IRAM_ATTR and touches only DRAM, so edges are still captured while the
+  SDK has the iCache off for a flash erase or write.
+
+  Each pin has its own ring of stamps. The ISR is the only writer of the
+  head, the Sketch the only writer of the tail, so neither side takes a
+  lock or holds off interrupts. A stamp is the cycle count with bit 0
+  replaced by the pin level read in the ISR, a resolution of 2 CPU cycles.
+  When the ring is full, new edges are dropped and counted.
+
+    edge_capture_begin(10u, CHANGE);
+    ...
+    uint32_t stamps[32];
+    size_t n = edge_capture_read(10u, stamps, 32u);
+    edge_stats_add(&stats, stamps, n);
+    float hz = edge_stats_frequency(&stats);
+
+  The stamp is taken when the handler runs, after the core's GPIO dispatch.
+  That delay is mostly constant and cancels out of periods, what is left is
+  jitter, eg. from another ISR running at the edge. The EdgeCapture example
+  measures the latency and the highest edge rate, with and without flash
+  writes running.
+
+  The cycle count wraps every 53 s at 80 MHz, 26 s at 160 MHz. Periods
+  longer than that are not measured.
+
+  Requires reclaim_GPIO_9_10() to have succeeded, edge_capture_begin()
+  checks.
+*/
+#ifndef EXPERIMENTAL_EDGE_CAPTURE_9_10_H
+#define EXPERIMENTAL_EDGE_CAPTURE_9_10_H
+
+#include <Arduino.h>
+
+// Stamps held for each pin, a power of 2
+#ifndef EDGE_CAPTURE_SZ
+#define EDGE_CAPTURE_SZ 128
+#endif
+
+namespace experimental {
+
+constexpr uint32_t kEdgeCaptureSz = EDGE_CAPTURE_SZ;
+static_assert(0u == (kEdgeCaptureSz & (kEdgeCaptureSz - 1u)), "EDGE_CAPTURE_SZ must be a power of 2");
+
+constexpr uint32_t kEdgeLevel = 1u;     // Stamp bit 0, the pin level
+
+inline __attribute__((always_inline))
+bool edge_level(const uint32_t stamp) { return 0u != (stamp & kEdgeLevel); }
+
+inline __attribute__((always_inline))
+uint32_t edge_cycles(const uint32_t stamp) { return stamp & ~kEdgeLevel; }
+
+// Capture edges on pin, 9 or 10, with mode RISING, FALLING, or CHANGE. The
+// pin is left an input with the pull-up as given, any stamps still held are
+// dropped. Returns false when reclaim_GPIO_9_10() has not succeeded.
+//
+// A pin already an output stays one, its own edges are captured. The
+// example uses this to time itself without a jumper.
+bool edge_capture_begin(const uint32_t pin, const int mode, const bool pullup = false);
+void edge_capture_end(const uint32_t pin);
+
+// Stamps waiting to be read
+size_t edge_capture_available(const uint32_t pin);
+
+// Move up to max stamps, oldest first, into p. Returns the count.
+size_t edge_capture_read(const uint32_t pin, uint32_t *p, const size_t max);
+
+// Edges dropped because the ring was full. A gap in the stamps, start the
+// statistics over when this changes.
+uint32_t edge_capture_overflows(const uint32_t pin);
+
+// Totals from a run of stamps, added to in bulk from the Sketch. Periods are
+// between edges of the same level, duty is from rising to falling edges, so
+// CHANGE gives both and RISING or FALLING give periods only. Times are CPU
+// cycles.
+struct EdgeStats {
+  uint32_t edges;
+  uint32_t periods;
+  uint32_t period_min;
+  uint32_t period_max;
+  uint64_t period_sum;
+  uint64_t high_sum;
+  uint64_t low_sum;
+  uint32_t highs;         // Counts in high_sum and low_sum
+  uint32_t lows;
+  uint32_t repeats;       // Same level twice in a row, with CHANGE a lost edge
+  uint32_t last[2];       // Last stamp for each level
+  uint8_t  have;          // BIT0 last[0] is set, BIT1 last[1] is set
+  uint8_t  prev_level;
+};
+
+void edge_stats_reset(EdgeStats *st);
+void edge_stats_add(EdgeStats *st, const uint32_t *p, const size_t n);
+
+// Mean over the stamps added so far, using the CPU clock at the time of the
+// call. 0 when there are no periods, or no high and low times for the duty.
+float edge_stats_frequency(const EdgeStats *st);      // Hz
+float edge_stats_period_us(const EdgeStats *st);
+float edge_stats_duty(const EdgeStats *st);           // 0.0 - 1.0 high
+
+};  // namespace experimental
+
+#endif // EXPERIMENTAL_EDGE_CAPTURE_9_10_H
@@ -0,0 +1,134 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Fast GPIO for the reclaimed GPIO9 and GPIO10
+
+  After reclaim_GPIO_9_10() succeeds, these replace pinMode(), digitalWrite(),
+  and digitalRead() for pins 9 and 10. The pin is a template argument, so the
+  register addresses and masks are resolved at compile time, and each call
+  inlines to one or two register accesses. There is no pin table lookup and
+  no flash access; the core's GPF(p) table is in PROGMEM.
+
+  Everything is inline. Called from an IRAM_ATTR function, they are safe in
+  an ISR or with the iCache off, eg. while the flash is busy with a write.
+
+    FastGPIO10::output();
+    FastGPIO10::set();
+    FastGPIO10::toggle();
+    bool level = FastGPIO9::read();
+    fast_gpio_9_10_write(true, false);    // both pins change on one store
+
+  Do not use them on GPIO9 and GPIO10 before reclaim_GPIO_9_10() succeeds,
+  /HOLD low stops the flash and the next iCache miss hangs.
+*/
+#ifndef EXPERIMENTAL_FAST_GPIO_9_10_H
+#define EXPERIMENTAL_FAST_GPIO_9_10_H
+
+#include <Arduino.h>
+
+namespace experimental {
+
+template<uint32_t kPin>
+struct FastGPIO {
+  static_assert(9u == kPin || 10u == kPin, "FastGPIO is for GPIO9 and GPIO10");
+  static constexpr uint32_t kMask = 1u << kPin;
+
+  // Pin function register, GPF9 or GPF10
+  static inline __attribute__((always_inline))
+  void set_fn(const uint32_t fn) {
+    if (9u == kPin) {
+      GPF9 = fn;
+    } else {
+      GPF10 = fn;
+    }
+  }
+
+  static inline __attribute__((always_inline))
+  void set() { GPOS = kMask; }
+
+  static inline __attribute__((always_inline))
+  void clear() { GPOC = kMask; }
+
+  static inline __attribute__((always_inline))
+  void write(const bool level) {
+    if (level) {
+      GPOS = kMask;
+    } else {
+      GPOC = kMask;
+    }
+  }
+
+  // The set and clear registers leave other pins alone. An ISR changing
+  // this same pin between the read and the write can be lost.
+  static inline __attribute__((always_inline))
+  void toggle() { write(0u == (GPO & kMask)); }
+
+  static inline __attribute__((always_inline))
+  bool read() { return 0u != (GPI & kMask); }
+
+  // Level of the output latch, not the pin
+  static inline __attribute__((always_inline))
+  bool latch() { return 0u != (GPO & kMask); }
+
+  // From pinMode() in core_esp8266_wiring_digital.cpp, without the GPF(p)
+  // table.
+  static inline __attribute__((always_inline))
+  void output() {
+    set_fn(GPFFS(GPFFS_GPIO(kPin)));
+    GPC(kPin) = (GPC(kPin) & (0xFu << GPCI));   // SOURCE(GPIO) | DRIVER(NORMAL) | INT_TYPE(UNCHANGED) | WAKEUP_ENABLE(DISABLED)
+    GPES = kMask;
+  }
+
+  static inline __attribute__((always_inline))
+  void input(const bool pullup = false) {
+    set_fn(GPFFS(GPFFS_GPIO(kPin)) | ((pullup) ? (1u << GPFPU) : 0u));
+    GPEC = kMask;
+    GPC(kPin) = (GPC(kPin) & (0xFu << GPCI)) | (1u << GPCD);  // SOURCE(GPIO) | DRIVER(OPEN_DRAIN) | INT_TYPE(UNCHANGED) | WAKEUP_ENABLE(DISABLED)
+  }
+
+  // Back to the SPI bus function, /HOLD or /WP
+  static inline __attribute__((always_inline))
+  void special() {
+    GPC(kPin) = (GPC(kPin) & (0xFu << GPCI));
+    GPEC = kMask;
+    set_fn(GPFFS(GPFFS_BUS(kPin)));
+  }
+};
+
+using FastGPIO9 = FastGPIO<9u>;
+using FastGPIO10 = FastGPIO<10u>;
+
+constexpr uint32_t kFastGPIO_9_10_Mask = FastGPIO9::kMask | FastGPIO10::kMask;
+
+// Both pins change on the same store to GPO. Interrupts are held off for the
+// read-modify-write, so an ISR's change to another pin is not lost.
+inline __attribute__((always_inline))
+void fast_gpio_9_10_write(const bool level9, const bool level10) {
+  const uint32_t bits = ((level9) ? FastGPIO9::kMask : 0u) | ((level10) ? FastGPIO10::kMask : 0u);
+  const uint32_t saved_ps = xt_rsil(15);
+  GPO = (GPO & ~kFastGPIO_9_10_Mask) | bits;
+  xt_wsr_ps(saved_ps);
+}
+
+// Both inputs from one read of GPI, BIT0 GPIO9, BIT1 GPIO10
+inline __attribute__((always_inline))
+uint32_t fast_gpio_9_10_read() {
+  return (GPI & kFastGPIO_9_10_Mask) >> 9u;
+}
+
+};  // namespace experimental
+
+#endif // EXPERIMENTAL_FAST_GPIO_9_10_H
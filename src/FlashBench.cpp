@@ -0,0 +1,176 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+////////////////////////////////////////////////////////////////////////////////
+// Flash read benchmarks, see FlashBench.h
+//
+#include <Arduino.h>
+#include <math.h>             // sqrt()
+#include <user_interface.h>   // system_get_cpu_freq()
+#include "ModeDIO_ReclaimGPIOs.h"
+#include "SpiFlashUtilsQE.h"
+#include "FlashBench.h"
+
+namespace experimental {
+
+constexpr uint32_t kMappedBase = 0x40200000u;
+
+// Keeps the results, so the reads and calls are not optimized away
+static volatile uint32_t bench_sink;
+
+////////////////////////////////////////////////////////////////////////////////
+// Statistics
+void bench_stats_reset(BenchStats *st) {
+  if (nullptr == st) return;
+  memset(st, 0, sizeof(BenchStats));
+  st->min = ~0u;
+}
+
+void bench_stats_add(BenchStats *st, const uint32_t cycles) {
+  if (nullptr == st) return;
+  st->n++;
+  st->sum += cycles;
+  st->sum_sq += (uint64_t)cycles * cycles;
+  if (cycles < st->min) st->min = cycles;
+  if (cycles > st->max) st->max = cycles;
+}
+
+uint32_t bench_stats_mean(const BenchStats *st) {
+  if (nullptr == st || 0u == st->n) return 0u;
+  return (uint32_t)((st->sum + st->n / 2u) / st->n);
+}
+
+uint32_t bench_stats_stddev(const BenchStats *st) {
+  if (nullptr == st || 2u > st->n) return 0u;
+  const double mean = (double)st->sum / st->n;
+  const double var = (double)st->sum_sq / st->n - mean * mean;
+  return (0.0 < var) ? (uint32_t)(sqrt(var) + 0.5) : 0u;
+}
+
+uint32_t flash_bench_kib_s(const uint64_t bytes, const uint64_t cycles, const uint32_t cpu_mhz) {
+  if (0u == cycles) return 0u;
+  return (uint32_t)(bytes * cpu_mhz * 1000000u / 1024u / cycles);
+}
+
+void flash_bench_env(FlashBenchEnv *env) {
+  if (nullptr == env) return;
+  env->cpu_mhz = system_get_cpu_freq();
+  env->spi_mhz = spi0_flash_mhz();
+  env->mode = spi0_io_mode();
+  env->quad = is_spi0_quad();
+  env->reclaimed = is_GPIO_9_10_reclaimed();
+  env->line_fill_ns = (env->spi_mhz) ? spi_icache_line_ns(env->mode, env->spi_mhz) : 0u;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Timed from IRAM with interrupts off, only the flash access misses
+typedef uint32_t (*BenchFn)(uint32_t);
+
+static uint32_t IRAM_ATTR time_call(const BenchFn fn) {
+  const uint32_t ps = xt_rsil(15);
+  const uint32_t start = esp_get_cycle_count();
+  const uint32_t r = fn(start);
+  const uint32_t cycles = esp_get_cycle_count() - start;
+  xt_wsr_ps(ps);
+  bench_sink = r;
+  return cycles;
+}
+
+static uint32_t IRAM_ATTR time_mapped(const volatile uint32_t *p, const uint32_t words) {
+  uint32_t sum = 0u;
+  const uint32_t ps = xt_rsil(15);
+  const uint32_t start = esp_get_cycle_count();
+  for (uint32_t i = 0u; i < words; i++) sum += p[i];
+  const uint32_t cycles = esp_get_cycle_count() - start;
+  xt_wsr_ps(ps);
+  bench_sink = sum;
+  return cycles;
+}
+
+void flash_bench_evict() {
+  const volatile uint32_t *p = (const volatile uint32_t *)(kMappedBase + kFlashBenchEvictOffset);
+  uint32_t sum = 0u;
+  // One load every 16 bytes, every line is touched
+  for (uint32_t i = 0u; i < kFlashBenchEvictSz / 4u; i += 4u) sum += p[i];
+  bench_sink = sum;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// iCache miss
+//
+// Flash resident, the default for code. Each is a few instructions without
+// literals, aligned so no two share an iCache line.
+#define BENCH_FN(n) \
+  static uint32_t __attribute__((noinline, aligned(2u * kICacheLineSz))) bench_fn_##n(uint32_t x) { \
+    return x * (n + 3u) + n; \
+  }
+
+BENCH_FN(0)  BENCH_FN(1)  BENCH_FN(2)  BENCH_FN(3)
+BENCH_FN(4)  BENCH_FN(5)  BENCH_FN(6)  BENCH_FN(7)
+BENCH_FN(8)  BENCH_FN(9)  BENCH_FN(10) BENCH_FN(11)
+BENCH_FN(12) BENCH_FN(13) BENCH_FN(14) BENCH_FN(15)
+
+// In DRAM, the table is not read through the iCache
+static BenchFn const bench_fn[kFlashBenchFuncs] = {
+  bench_fn_0,  bench_fn_1,  bench_fn_2,  bench_fn_3,
+  bench_fn_4,  bench_fn_5,  bench_fn_6,  bench_fn_7,
+  bench_fn_8,  bench_fn_9,  bench_fn_10, bench_fn_11,
+  bench_fn_12, bench_fn_13, bench_fn_14, bench_fn_15,
+};
+
+void flash_bench_icache_miss(BenchStats *cold, BenchStats *hot, BenchStats *miss, const uint32_t rounds) {
+  for (uint32_t r = 0u; r < rounds; r++) {
+    flash_bench_evict();
+    // After one eviction each function is still cold until it is called
+    for (uint32_t i = 0u; i < kFlashBenchFuncs; i++) {
+      const uint32_t c = time_call(bench_fn[i]);
+      const uint32_t h = time_call(bench_fn[i]);
+      bench_stats_add(cold, c);
+      bench_stats_add(hot, h);
+      bench_stats_add(miss, (c > h) ? c - h : 0u);
+    }
+    yield();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Reads
+bool flash_bench_spi_read(BenchStats *st, const uint32_t addr, uint32_t *buf, const size_t chunk, const size_t total) {
+  if (nullptr == buf || 0u == chunk || 0u != ((chunk | total) & 3u)) return false;
+  for (size_t done = 0u; done < total; done += chunk) {
+    // The last call reads only what is left
+    const size_t len = (chunk < total - done) ? chunk : total - done;
+    const uint32_t start = esp_get_cycle_count();
+    const SpiFlashOpResult ok = spi_flash_read(addr + done, buf, len);
+    const uint32_t cycles = esp_get_cycle_count() - start;
+    if (SPI_FLASH_RESULT_OK != ok) return false;
+    bench_stats_add(st, cycles);
+    yield();
+  }
+  return true;
+}
+
+void flash_bench_mapped_read(BenchStats *cold, BenchStats *hot, const uint32_t bytes, const uint32_t rounds) {
+  const volatile uint32_t *p = (const volatile uint32_t *)(kMappedBase + kFlashBenchMappedOffset);
+  const uint32_t words = ((kFlashBenchMappedMax < bytes) ? kFlashBenchMappedMax : bytes) / 4u;
+  for (uint32_t r = 0u; r < rounds; r++) {
+    flash_bench_evict();
+    bench_stats_add(cold, time_mapped(p, words));
+    bench_stats_add(hot, time_mapped(p, words));
+    yield();
+  }
+}
+
+};  // namespace experimental
@@ -0,0 +1,105 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Flash read benchmarks - what DIO or DOUT costs against QIO
+
+  Reclaiming GPIO9 and GPIO10 needs a DIO or DOUT build. These measure the
+  flash reads a Sketch depends on, in CPU cycles, so builds in each mode and
+  at each SPI clock can be compared:
+
+    iCache miss   A call to a flash function that is not in the iCache, less
+                  the same call when it is. kFlashBenchFuncs small functions,
+                  each in its own iCache line.
+    spi_flash_read()
+                  Sequential reads into DRAM, one sample per call. Each call
+                  is an iCache disable window.
+    Mapped read   32-bit loads from memory mapped flash, as PROGMEM data is
+                  read. Cold after an eviction, and hot, with the same bytes
+                  again.
+
+  The iCache is emptied by reading kFlashBenchEvictSz of memory mapped flash,
+  twice the largest iCache. Each timed sample runs from IRAM with interrupts
+  off. The eviction and spi_flash_read() run with interrupts on.
+
+  flash_bench_env() reports what the numbers depend on: the read mode from
+  SPI0C, the SPI clock from the image header, and the CPU clock.
+
+  For the host tools, see tools/flashbench.
+*/
+#ifndef EXPERIMENTAL_FLASHBENCH_H
+#define EXPERIMENTAL_FLASHBENCH_H
+
+#include <Arduino.h>
+#include "SpiFlashCost.h"       // SpiIoMode, spi0_io_mode()
+
+namespace experimental {
+
+constexpr uint32_t kFlashBenchFuncs = 16u;
+constexpr uint32_t kFlashBenchEvictSz = 64u * 1024u;
+
+// Offsets into the 1 MB memory mapped window, within the first 512 KB of
+// flash. Any flash will do, code or erased, only the time is kept.
+constexpr uint32_t kFlashBenchEvictOffset = 0x10000u;
+constexpr uint32_t kFlashBenchMappedOffset = 0x30000u;
+constexpr uint32_t kFlashBenchMappedMax = 16u * 1024u;     // Must fit the iCache to measure hot
+
+// Cycle counts from a run of samples
+struct BenchStats {
+  uint32_t n;
+  uint32_t min;
+  uint32_t max;
+  uint64_t sum;
+  uint64_t sum_sq;
+};
+
+void bench_stats_reset(BenchStats *st);
+void bench_stats_add(BenchStats *st, const uint32_t cycles);
+uint32_t bench_stats_mean(const BenchStats *st);
+uint32_t bench_stats_stddev(const BenchStats *st);
+
+struct FlashBenchEnv {
+  uint32_t cpu_mhz;
+  uint32_t spi_mhz;         // From the image header, 0 unknown
+  SpiIoMode mode;           // From SPI0C
+  bool quad;                // is_spi0_quad()
+  bool reclaimed;           // is_GPIO_9_10_reclaimed()
+  uint32_t line_fill_ns;    // spi_icache_line_ns(), the wire time of a miss
+};
+
+void flash_bench_env(FlashBenchEnv *env);
+
+// Empty the iCache
+void flash_bench_evict();
+
+// For each round, each function is called cold, then hot. miss gets cold
+// less hot for each call. Any may be nullptr.
+void flash_bench_icache_miss(BenchStats *cold, BenchStats *hot, BenchStats *miss, const uint32_t rounds);
+
+// spi_flash_read() of total bytes from flash address addr, chunk bytes a call,
+// into buf. chunk and total a multiple of 4, the last call reads what is left
+// of total. Returns false for other sizes or on a read error.
+bool flash_bench_spi_read(BenchStats *st, const uint32_t addr, uint32_t *buf, const size_t chunk, const size_t total);
+
+// Read bytes, a multiple of 4, at most kFlashBenchMappedMax, from memory
+// mapped flash. One cold and one hot sample a round.
+void flash_bench_mapped_read(BenchStats *cold, BenchStats *hot, const uint32_t bytes, const uint32_t rounds);
+
+// Bytes moved in cycles, as KiB/s
+uint32_t flash_bench_kib_s(const uint64_t bytes, const uint64_t cycles, const uint32_t cpu_mhz);
+
+};  // namespace experimental
+
+#endif // EXPERIMENTAL_FLASHBENCH_H
@@ -0,0 +1,87 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+////////////////////////////////////////////////////////////////////////////////
+// Flash fingerprint record, see FlashFingerprint.h
+//
+#include <Arduino.h>
+#include <coredecls.h>        // crc32()
+#include <spi_flash.h>        // spi_flash_get_id()
+#include "SpiFlashUtils.h"
+#include "SfdpRevInfo.h"
+#include "FlashFingerprint.h"
+
+namespace experimental {
+
+static_assert(kFlashFingerprintSfdpSz == sizeof(SfdpImage), "sfdp_hash covers the SFDP image");
+
+bool flash_fingerprint_read(FlashFingerprint *fp, const uint16_t caps) {
+  if (nullptr == fp) return false;
+
+  memset(fp, 0, sizeof(FlashFingerprint));
+  fp->magic = kFlashFingerprintMagic;
+  fp->version = kFlashFingerprintVersion;
+  fp->size = sizeof(FlashFingerprint);
+  fp->caps = caps;
+  fp->jedec_id = spi_flash_get_id() & 0xFFFFFFu;
+
+  // Without SFDP, some parts return the last value on the bus. The headers
+  // and hash are kept only when the signature is there. One read of the image
+  // gives both.
+  {
+    SfdpImage img;
+    if (sfdp_image_read(&img)) {
+      memcpy(&fp->sfdp_hdr[0], &img.dw[0], sizeof(fp->sfdp_hdr));
+      fp->sfdp_hash = crc32(&img.dw[0], sizeof(img));
+      fp->caps |= kFpCapSfdp;
+    }
+  }
+
+  SpiOpResult ok0 = spi0_flash_read_unique_id_128(&fp->unique_id[0]);
+  if (SPI_RESULT_OK == ok0) {
+    const uint32_t all_or = fp->unique_id[0] | fp->unique_id[1] | fp->unique_id[2] | fp->unique_id[3];
+    const uint32_t all_and = fp->unique_id[0] & fp->unique_id[1] & fp->unique_id[2] & fp->unique_id[3];
+    if (0u != all_or && ~0u != all_and) fp->caps |= kFpCapUniqueId;
+  } else {
+    memset(&fp->unique_id[0], 0, sizeof(fp->unique_id));
+  }
+
+  uint32_t sr321 = 0u;
+  spi0_flash_read_status_registers_3B(&sr321);
+  fp->sr[0] = sr321 & 0xFFu;
+  fp->sr[1] = (sr321 >> 8u) & 0xFFu;
+  fp->sr[2] = (sr321 >> 16u) & 0xFFu;
+  fp->reclaim = kFpReclaimNotRun;
+  return true;
+}
+
+void flash_fingerprint_reclaim(FlashFingerprint *fp, const FlashFingerprintReclaim result, const uint32_t cycles, const uint32_t xfers) {
+  if (nullptr == fp) return;
+  fp->reclaim = result;
+  fp->reclaim_cycles = cycles;
+  fp->reclaim_xfers = xfers;
+}
+
+void flash_fingerprint_seal(FlashFingerprint *fp) {
+  if (nullptr == fp) return;
+  fp->crc = crc32(fp, offsetof(FlashFingerprint, crc));
+}
+
+size_t flash_fingerprint_hex(const FlashFingerprint *fp, char *buf, const size_t sz) {
+  if (nullptr == fp || nullptr == buf || kFlashFingerprintHexSz > sz) return 0u;
+  return spi_flash_hex_line("FFP1:", fp, sizeof(FlashFingerprint), buf);
+}
+
+};  // namespace experimental
@@ -0,0 +1,100 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+////////////////////////////////////////////////////////////////////////////////
+// Flash fingerprint - a compact, versioned record of one module's flash
+//
+// One 64 byte record holds what printFlashChipID(), printSR321(), and the SFDP
+// report print as text: the JEDEC ID, a hash and the raw headers of SFDP, the
+// 128-bit Unique ID, Status Registers 1 - 3, discovered capabilities, and the
+// result and cost of reclaim_GPIO_9_10().
+//
+// The record is little-endian, as the ESP8266 stores it. Send it as raw bytes,
+// or as one text line, "FFP1:" and 128 hex digits. tools/fingerprint/fpstat
+// reads both. The tools there build with this header, no SDK includes.
+#ifndef FLASH_FINGERPRINT_H
+#define FLASH_FINGERPRINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace experimental {
+
+constexpr uint32_t kFlashFingerprintMagic = 0x31504646u;  // "FFP1"
+constexpr uint8_t kFlashFingerprintVersion = 1u;
+
+// Capability bits. The Analyze bits are from its FlashDiscovery results, the
+// others are found by flash_fingerprint_read().
+enum : uint16_t {
+  kFpCapS9           = 0x0001u,   // QE at S9
+  kFpCapS6           = 0x0002u,   // QE at S6
+  kFpCap8bwSR1       = 0x0004u,   // 8-bit Write Status Register-1
+  kFpCap8bwSR2       = 0x0008u,   // 8-bit Write Status Register-2
+  kFpCap8bwSR3       = 0x0010u,   // 8-bit Write Status Register-3
+  kFpCap16bwSR1      = 0x0020u,   // 16-bit Write Status Register-1
+  kFpCapVolatile     = 0x0040u,   // Volatile Status Register bits
+  kFpCapWriteQE      = 0x0080u,   // QE bit is writable
+  kFpCapPassSC       = 0x0100u,   // GPIO9 and GPIO10 short circuit tests passed
+  kFpCapPassWP       = 0x0200u,   // /WP disabled
+  kFpCapPassHOLD     = 0x0400u,   // /HOLD disabled
+  kFpCapAnalyze      = 0x0800u,   // The bits above are valid, Analyze ran
+  kFpCapSfdp         = 0x1000u,   // SFDP signature found
+  kFpCapUniqueId     = 0x2000u,   // Unique ID is not all 0 or all 1 bits
+};
+
+enum FlashFingerprintReclaim : uint8_t {
+  kFpReclaimNotRun = 0u,
+  kFpReclaimFailed,
+  kFpReclaimOk,
+  kFpReclaimCached,               // RECLAIM_RECIPE_CACHE replayed a recipe
+};
+
+struct FlashFingerprint {
+  uint32_t magic;                 // kFlashFingerprintMagic
+  uint8_t  version;               // kFlashFingerprintVersion
+  uint8_t  size;                  // sizeof(FlashFingerprint)
+  uint16_t caps;                  // kFpCap bits
+  uint32_t jedec_id;              // spi_flash_get_id(), vendor in the LSB
+  uint32_t sfdp_hash;             // crc32() of SFDP 0 - 255, 0 without SFDP
+  uint32_t sfdp_hdr[4];           // SFDP header, then the 1st parameter header
+  uint32_t unique_id[4];          // Read Unique ID 4Bh, 128 bits
+  uint8_t  sr[3];                 // Status Registers 1, 2, 3
+  uint8_t  reclaim;               // FlashFingerprintReclaim
+  uint32_t reclaim_cycles;        // CPU cycles in reclaim_GPIO_9_10(), 0 unknown
+  uint32_t reclaim_xfers;         // Flash transactions in reclaim_GPIO_9_10()
+  uint32_t crc;                   // crc32() of the bytes above
+};
+static_assert(64u == sizeof(FlashFingerprint), "FlashFingerprint is a wire format, bump the version to change it");
+
+constexpr size_t kFlashFingerprintSfdpSz = 256u;
+// "FFP1:", two hex digits per byte, and a '\0'
+constexpr size_t kFlashFingerprintHexSz = 5u + 2u * sizeof(FlashFingerprint) + 1u;
+
+// Fill in *fp from the flash. caps adds bits the caller knows, eg. from
+// Analyze. The reclaim result starts as kFpReclaimNotRun.
+bool flash_fingerprint_read(FlashFingerprint *fp, const uint16_t caps);
+
+void flash_fingerprint_reclaim(FlashFingerprint *fp, const FlashFingerprintReclaim result, const uint32_t cycles, const uint32_t xfers);
+
+// Sets the CRC, call last before sending.
+void flash_fingerprint_seal(FlashFingerprint *fp);
+
+// Writes the "FFP1:" text line to buf, sz must be at least
+// kFlashFingerprintHexSz. Returns the length, 0 when buf is too small.
+size_t flash_fingerprint_hex(const FlashFingerprint *fp, char *buf, const size_t sz);
+
+};  // namespace experimental
+
+#endif // FLASH_FINGERPRINT_H
@@ -0,0 +1,337 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+////////////////////////////////////////////////////////////////////////////////
+// I2C master on GPIO9 and GPIO10, see I2cBus_9_10.h
+//
+#include <Arduino.h>
+#include <user_interface.h>   // system_get_cpu_freq()
+#include "ModeDIO_ReclaimGPIOs.h"
+#include "FastGPIO_9_10.h"
+#include "I2cBus_9_10.h"
+
+namespace experimental {
+
+// An edge more than this past its cycle count is late, the next phase is
+// timed from when it happened.
+constexpr uint32_t kLateCycles = 16u;
+
+////////////////////////////////////////////////////////////////////////////////
+// Lines and edges. The output latch stays at 0, the enable does the work.
+static inline __attribute__((always_inline))
+void line_low(const uint32_t mask) { GPES = mask; }
+
+static inline __attribute__((always_inline))
+void line_release(const uint32_t mask) { GPEC = mask; }
+
+static inline __attribute__((always_inline))
+bool line_is_high(const uint32_t mask) { return 0u != (GPI & mask); }
+
+// Wait for cycles past the last edge. Returns the time of the edge about to
+// be made.
+static inline __attribute__((always_inline))
+uint32_t edge_at(I2cBus *bus, const uint32_t cycles) {
+  const uint32_t target = bus->t + cycles;
+  uint32_t now;
+  do {
+    now = esp_get_cycle_count();
+  } while ((int32_t)(now - target) < 0);
+  if (kLateCycles < now - target) {
+    bus->stats.late++;
+    return now;
+  }
+  return target;
+}
+
+// SCL low for bus->low, then release it and wait out any clock stretching.
+// bus->t becomes the time SCL went high.
+static bool IRAM_ATTR scl_rise(I2cBus *bus) {
+  bus->t = edge_at(bus, bus->low);
+  line_release(bus->scl);
+  if (line_is_high(bus->scl)) return true;
+
+  const uint32_t start = bus->t;
+  uint32_t now;
+  do {
+    now = esp_get_cycle_count();
+    if (bus->stretch < now - start) return false;
+  } while (! line_is_high(bus->scl));
+  const uint32_t held = now - start;
+  bus->stats.stretches++;
+  if (held > bus->stats.stretch_max) bus->stats.stretch_max = held;
+  bus->t = now;
+  return true;
+}
+
+// SCL high for bus->high, then pull it low
+static inline __attribute__((always_inline))
+void scl_fall(I2cBus *bus) {
+  bus->t = edge_at(bus, bus->high);
+  line_low(bus->scl);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Bus conditions. Each starts and ends with SCL low, except START, which
+// starts from an idle bus, and STOP, which leaves it idle.
+static I2cResult IRAM_ATTR start(I2cBus *bus) {
+  if (! line_is_high(bus->sda) || ! line_is_high(bus->scl)) return kI2cBusError;
+  // tBUF, a low time since the last STOP, it is the longer. After a long
+  // idle, no wait.
+  const uint32_t now = esp_get_cycle_count();
+  if (bus->low < now - bus->t) bus->t = now - bus->low;
+  bus->t = edge_at(bus, bus->low);
+  line_low(bus->sda);
+  scl_fall(bus);    // tHD;STA
+  return kI2cOk;
+}
+
+static I2cResult IRAM_ATTR restart(I2cBus *bus) {
+  line_release(bus->sda);
+  if (! scl_rise(bus)) return kI2cTimeout;
+  bus->t = edge_at(bus, bus->high);   // tSU;STA
+  if (! line_is_high(bus->sda)) return kI2cBusError;
+  line_low(bus->sda);
+  scl_fall(bus);    // tHD;STA
+  return kI2cOk;
+}
+
+static I2cResult IRAM_ATTR stop(I2cBus *bus) {
+  line_low(bus->sda);
+  if (! scl_rise(bus)) return kI2cTimeout;
+  bus->t = edge_at(bus, bus->high);   // tSU;STO
+  line_release(bus->sda);
+  return (line_is_high(bus->sda)) ? kI2cOk : kI2cBusError;
+}
+
+// Eight bits out, then the ACK bit in. SDA changes right after SCL falls.
+static I2cResult IRAM_ATTR write_byte(I2cBus *bus, const uint32_t data) {
+  const uint32_t saved_ps = (bus->irq_off) ? xt_rsil(15) : 0u;
+  I2cResult result = kI2cOk;
+  for (uint32_t bit = 0x80u; bit; bit >>= 1u) {
+    if (data & bit) {
+      line_release(bus->sda);
+    } else {
+      line_low(bus->sda);
+    }
+    if (! scl_rise(bus)) {
+      result = kI2cTimeout;
+      break;
+    }
+    if ((data & bit) && ! line_is_high(bus->sda)) {
+      result = kI2cBusError;  // Someone else holds SDA low
+      break;
+    }
+    scl_fall(bus);
+  }
+  if (kI2cOk == result) {
+    line_release(bus->sda);
+    if (! scl_rise(bus)) {
+      result = kI2cTimeout;
+    } else {
+      result = (line_is_high(bus->sda)) ? kI2cNackData : kI2cOk;
+      scl_fall(bus);
+    }
+  }
+  if (bus->irq_off) xt_wsr_ps(saved_ps);
+  return result;
+}
+
+// Eight bits in, sampled just before SCL falls, then ACK, or NACK for the
+// last byte.
+static I2cResult IRAM_ATTR read_byte(I2cBus *bus, uint8_t *data, const bool ack) {
+  const uint32_t saved_ps = (bus->irq_off) ? xt_rsil(15) : 0u;
+  I2cResult result = kI2cOk;
+  uint32_t v = 0u;
+  line_release(bus->sda);
+  for (uint32_t i = 0u; i < 8u; i++) {
+    if (! scl_rise(bus)) {
+      result = kI2cTimeout;
+      break;
+    }
+    bus->t = edge_at(bus, bus->high);
+    v = (v << 1u) | ((line_is_high(bus->sda)) ? 1u : 0u);
+    line_low(bus->scl);
+  }
+  if (kI2cOk == result) {
+    if (ack) line_low(bus->sda);
+    if (! scl_rise(bus)) {
+      result = kI2cTimeout;
+    } else {
+      scl_fall(bus);
+      line_release(bus->sda);
+    }
+  }
+  if (bus->irq_off) xt_wsr_ps(saved_ps);
+  *data = v;
+  return result;
+}
+
+static I2cResult IRAM_ATTR address(I2cBus *bus, const uint8_t addr, const bool read) {
+  const I2cResult result = write_byte(bus, ((uint32_t)addr << 1u) | ((read) ? 1u : 0u));
+  return (kI2cNackData == result) ? kI2cNackAddr : result;
+}
+
+// One I2cXfer, the START or repeated START already sent
+static I2cResult IRAM_ATTR run_xfer(I2cBus *bus, const I2cXfer& x) {
+  const bool read = 0u != (x.flags & kI2cXferRead);
+  I2cResult result;
+  if (x.flags & kI2cXferNoReg) {
+    result = address(bus, x.addr, read);
+  } else {
+    result = address(bus, x.addr, false);
+    if (kI2cOk == result) result = write_byte(bus, x.reg);
+    if (kI2cOk == result && read) {
+      result = restart(bus);
+      if (kI2cOk == result) result = address(bus, x.addr, true);
+    }
+  }
+  for (size_t i = 0u; kI2cOk == result && i < x.len; i++) {
+    if (read) {
+      result = read_byte(bus, &x.data[i], i + 1u < x.len);
+    } else {
+      result = write_byte(bus, x.data[i]);
+    }
+  }
+  return result;
+}
+
+// Finish a transaction, STOP unless the bus is stuck
+static I2cResult IRAM_ATTR finish(I2cBus *bus, const I2cResult result) {
+  if (kI2cTimeout == result) {
+    line_release(bus->sda);
+    line_release(bus->scl);
+    return result;
+  }
+  const I2cResult result_stop = stop(bus);
+  return (kI2cOk == result) ? result_stop : result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void i2c_bus_set_clock(I2cBus *bus, uint32_t hz) {
+  if (kI2cFastPlusHz < hz) hz = kI2cFastPlusHz;
+  if (1000u > hz) hz = 1000u;
+  const uint32_t period = (uint32_t)system_get_cpu_freq() * 1000000u / hz;
+  // Fast modes need a longer low than high, tLOW 1.3 us, tHIGH 0.6 us at
+  // 400 kHz
+  bus->low = (kI2cStandardHz < hz) ? period * 9u / 16u : period / 2u;
+  bus->high = period - bus->low;
+}
+
+void i2c_bus_set_stretch_limit(I2cBus *bus, const uint32_t us) {
+  bus->stretch = (uint32_t)system_get_cpu_freq() * us;
+}
+
+bool i2c_bus_begin(I2cBus *bus, const uint32_t sda_pin, const uint32_t hz, const bool pullup) {
+  memset(bus, 0, sizeof(I2cBus));
+  if ((9u != sda_pin && 10u != sda_pin) || ! is_GPIO_9_10_reclaimed()) return false;
+
+  bus->sda = 1u << sda_pin;
+  bus->scl = kFastGPIO_9_10_Mask & ~bus->sda;
+  i2c_bus_set_clock(bus, hz);
+  i2c_bus_set_stretch_limit(bus, kI2cStretchLimitUs);
+
+  // Released, with the latch at 0 for when the output is enabled
+  FastGPIO9::input(pullup);
+  FastGPIO10::input(pullup);
+  GPOC = kFastGPIO_9_10_Mask;
+  bus->t = esp_get_cycle_count();
+  bus->ready = true;
+  return true;
+}
+
+void i2c_bus_end(I2cBus *bus) {
+  if (! bus->ready) return;
+  line_release(bus->sda | bus->scl);
+  FastGPIO9::input();
+  FastGPIO10::input();
+  bus->ready = false;
+}
+
+bool IRAM_ATTR i2c_bus_recover(I2cBus *bus) {
+  if (! bus->ready) return false;
+  line_release(bus->sda);
+  bus->t = esp_get_cycle_count();
+  for (size_t i = 0u; i < 9u && ! line_is_high(bus->sda); i++) {
+    line_low(bus->scl);
+    if (! scl_rise(bus)) break;
+    bus->t = edge_at(bus, bus->high);
+  }
+  if (line_is_high(bus->scl)) {
+    line_low(bus->scl);
+    bus->t = esp_get_cycle_count();
+    stop(bus);
+  }
+  return line_is_high(bus->sda) && line_is_high(bus->scl);
+}
+
+I2cResult IRAM_ATTR i2c_bus_xfer(I2cBus *bus, I2cXfer *xfer, const size_t count, size_t *done) {
+  if (done) *done = 0u;
+  if (! bus->ready) return kI2cNotReady;
+  if (0u == count) return kI2cOk;
+
+  I2cResult result = start(bus);
+  if (kI2cOk != result) return result;
+  for (size_t i = 0u; i < count; i++) {
+    if (0u != i) {
+      result = restart(bus);
+      if (kI2cOk != result) break;
+    }
+    result = run_xfer(bus, xfer[i]);
+    if (kI2cOk != result) break;
+    if (done) *done = i + 1u;
+  }
+  return finish(bus, result);
+}
+
+I2cResult i2c_bus_probe(I2cBus *bus, const uint8_t addr) {
+  if (! bus->ready) return kI2cNotReady;
+  I2cResult result = start(bus);
+  if (kI2cOk != result) return result;
+  return finish(bus, address(bus, addr, false));
+}
+
+I2cResult IRAM_ATTR i2c_bus_write(I2cBus *bus, const uint8_t addr, const uint8_t *p, const size_t sz) {
+  if (! bus->ready) return kI2cNotReady;
+  I2cResult result = start(bus);
+  if (kI2cOk != result) return result;
+  result = address(bus, addr, false);
+  for (size_t i = 0u; kI2cOk == result && i < sz; i++) {
+    result = write_byte(bus, p[i]);
+  }
+  return finish(bus, result);
+}
+
+I2cResult IRAM_ATTR i2c_bus_read(I2cBus *bus, const uint8_t addr, uint8_t *p, const size_t sz) {
+  if (! bus->ready) return kI2cNotReady;
+  I2cResult result = start(bus);
+  if (kI2cOk != result) return result;
+  result = address(bus, addr, true);
+  for (size_t i = 0u; kI2cOk == result && i < sz; i++) {
+    result = read_byte(bus, &p[i], i + 1u < sz);
+  }
+  return finish(bus, result);
+}
+
+I2cResult i2c_bus_write_reg(I2cBus *bus, const uint8_t addr, const uint8_t reg, const uint8_t *p, const size_t sz) {
+  I2cXfer x = {addr, reg, kI2cXferWrite, sz, const_cast<uint8_t *>(p)};
+  return i2c_bus_xfer(bus, &x, 1u);
+}
+
+I2cResult i2c_bus_read_reg(I2cBus *bus, const uint8_t addr, const uint8_t reg, uint8_t *p, const size_t sz) {
+  I2cXfer x = {addr, reg, kI2cXferRead, sz, p};
+  return i2c_bus_xfer(bus, &x, 1u);
+}
+
+};  // namespace experimental
@@ -0,0 +1,122 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  I2C master on the reclaimed GPIO9 and GPIO10
+
+  A bit-banged I2C master for Standard mode (100 kHz), Fast mode (400 kHz),
+  and Fast-mode Plus (1 MHz). Each SCL and SDA edge is placed at a CPU cycle
+  count computed from the last edge, not after a delay loop, so code paths of
+  different length do not change the bit timing. When an edge is late, eg.
+  after an ISR, timing restarts from that edge, a phase is never cut short.
+  The bus engine is IRAM_ATTR.
+
+  Lines are open-drain. A line is pulled low by enabling its output with the
+  latch at 0, and released by disabling the output. External pull-ups are
+  needed, the internal ones are too weak above 100 kHz.
+
+  Clock stretching is supported on every SCL rising edge, up to a limit,
+  25 ms by default. Writes and reads to several registers, or devices, run
+  as one transaction with repeated STARTs, see i2c_bus_xfer().
+
+  Fast-mode Plus is tight at 80 MHz, a phase is about 20 CPU cycles. Run the
+  CPU at 160 MHz for it. The I2cBench example measures the rates reached.
+
+  Requires reclaim_GPIO_9_10() to have succeeded, i2c_bus_begin() checks.
+*/
+#ifndef EXPERIMENTAL_I2C_BUS_9_10_H
+#define EXPERIMENTAL_I2C_BUS_9_10_H
+
+#include <Arduino.h>
+
+namespace experimental {
+
+enum I2cResult : uint8_t {
+  kI2cOk = 0u,
+  kI2cNackAddr,           // No device answered the address
+  kI2cNackData,           // The device refused a data byte
+  kI2cTimeout,            // Clock stretching went past the limit
+  kI2cBusError,           // SDA low at START or STOP, or lost a bit
+  kI2cNotReady,           // i2c_bus_begin() did not succeed
+};
+
+constexpr uint32_t kI2cStandardHz = 100000u;
+constexpr uint32_t kI2cFastHz = 400000u;
+constexpr uint32_t kI2cFastPlusHz = 1000000u;
+constexpr uint32_t kI2cStretchLimitUs = 25000u;   // SMBus tTIMEOUT min
+
+struct I2cBusStats {
+  uint32_t stretches;     // SCL rising edges a device held off
+  uint32_t stretch_max;   // CPU cycles, longest
+  uint32_t late;          // Edges later than their cycle count, eg. an ISR
+};
+
+struct I2cBus {
+  uint32_t sda;           // GPIO mask
+  uint32_t scl;           // GPIO mask
+  uint32_t low;           // SCL low time, CPU cycles
+  uint32_t high;          // SCL high time, CPU cycles
+  uint32_t stretch;       // Clock stretch limit, CPU cycles
+  uint32_t t;             // CPU cycle count of the last edge
+  bool     irq_off;       // Hold interrupts off for each byte
+  bool     ready;
+  I2cBusStats stats;
+};
+
+// Flags for I2cXfer
+enum : uint8_t {
+  kI2cXferWrite = 0x00u,
+  kI2cXferRead  = 0x01u,
+  kI2cXferNoReg = 0x02u,  // No register address, data only
+};
+
+// One step of a batched transaction. A read with a register address writes
+// the register address, then reads after a repeated START.
+struct I2cXfer {
+  uint8_t  addr;          // 7-bit device address
+  uint8_t  reg;           // Register address, unless kI2cXferNoReg
+  uint8_t  flags;
+  size_t   len;
+  uint8_t *data;
+};
+
+// Set up GPIO sda_pin, 9 or 10, for SDA and the other for SCL. Returns false
+// when reclaim_GPIO_9_10() has not succeeded.
+bool i2c_bus_begin(I2cBus *bus, const uint32_t sda_pin, const uint32_t hz, const bool pullup = false);
+
+// Release both lines and leave them as inputs
+void i2c_bus_end(I2cBus *bus);
+
+// Changes the SCL clock. Uses the CPU clock at the time of the call.
+void i2c_bus_set_clock(I2cBus *bus, const uint32_t hz);
+void i2c_bus_set_stretch_limit(I2cBus *bus, const uint32_t us);
+
+// Clock SCL until a device holding SDA low lets go, then STOP. Returns true
+// when both lines are high.
+bool i2c_bus_recover(I2cBus *bus);
+
+// Run count steps with a repeated START between them and one STOP at the
+// end. *done gets the number of steps completed.
+I2cResult i2c_bus_xfer(I2cBus *bus, I2cXfer *xfer, const size_t count, size_t *done = nullptr);
+
+I2cResult i2c_bus_probe(I2cBus *bus, const uint8_t addr);
+I2cResult i2c_bus_write(I2cBus *bus, const uint8_t addr, const uint8_t *p, const size_t sz);
+I2cResult i2c_bus_read(I2cBus *bus, const uint8_t addr, uint8_t *p, const size_t sz);
+I2cResult i2c_bus_write_reg(I2cBus *bus, const uint8_t addr, const uint8_t reg, const uint8_t *p, const size_t sz);
+I2cResult i2c_bus_read_reg(I2cBus *bus, const uint8_t addr, const uint8_t reg, uint8_t *p, const size_t sz);
+
+};  // namespace experimental
+
+#endif // EXPERIMENTAL_I2C_BUS_9_10_H
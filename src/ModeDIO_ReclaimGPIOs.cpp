@@ -115,17 +115,17 @@ EON
 #include "FlashChipId_D8.h"
 #endif
 
+#include "SfdpRevInfo.h"
+#include "StatusRegisterUpdate.h"
+
+#if RECLAIM_RECIPE_CACHE
+#include <user_interface.h>   // system_rtc_mem_read(), system_rtc_mem_write()
+#include <coredecls.h>        // crc32()
+#endif
+
 /*//////////////////////////////////////////////////////////////////////////////
-  To have a larger pool of Flash vendors to test against, I tested with devices
-  that did not expose GPIO9 and GPIO10. These did not work well. Let us hope
-  that modules makers that expose GPIO9 and GPIO10 made an effort to pair the
-  ESP8266EX with a SPI Flash that can disable /WP and /HOLD.
-*/
-bool __spi_flash_vendor_cases(const uint32_t _id) {
-  using namespace experimental;
+  Built-in Flash parts
 
-  bool success = false;
-  /*
   0xCCTTVV = _id = alt_spi_flash_get_id();
      | | |
      | | +--- Vendor   - manufacturer ID
@@ -140,143 +140,218 @@ bool __spi_flash_vendor_cases(const uint32_t _id) {
   "Parameter ID" that maps to "Bank Number":"Manufacturer ID". I do not have any
   devices that provide this.
 
-  */
-  uint32_t vendor = 0xFFu & _id;
-  uint32_t type = (_id >> 8u) & 0xFFu;
-
-  switch (vendor) {
-    case SPI_FLASH_VENDOR_BERGMICRO:
-      // Status: hardware tested
-      // Logo XTX BN25F08
-      // SFDP none
-
-      // I have a Sonoff SV with flash part BN25F08 with an XTX logo mark
-      // the JEDEC MFG ID matches BergMicro as does the part number.
-    case SPI_FLASH_VENDOR_WINBOND_NEX:
-      // Winbond 25Q32FVSIG
-      // SFDP Revision: 1.00, 1ST Parameter Table Revision: 1.00
-      // SFDP Table Ptr: 0x80, Size: 36 Bytes
-      if (0x40u == type) {
-        // 16-bit status register writes is what the ESP8266 BootROM is
-        // expecting the flash to support. "Legacy method" is what I often see
-        // used to descibe the 16-bit status register-1 writes in newer SPI
-        // Flash datasheets. I expect this to work with modules that are
-        // compatibile with SPI Flash Mode: "QIO" or "QOUT".
-        success = set_S9_QE_bit__16_bit_sr1_write(volatile_bit);
-      }
-      break;
-
-    case SPI_FLASH_VENDOR_PUYA:
-      // Status: tested
-      // Puya P25Q80H
-      // SFDP Revision: 1.00, 1ST Parameter Table Revision: 1.00
-      // SFDP Table Ptr: 0x30, Size: 36 Bytes
-    case SPI_FLASH_VENDOR_ZBIT:
-      // Status: tested
-      // Zbit 25VQ80AT
-      // SFDP Revision: 1.06, 1ST Parameter Table Revision: 1.06
-      // SFDP Table Ptr: 0x30, Size: 64 Bytes
-      if (0x60u == type) {
-        success = set_S9_QE_bit__16_bit_sr1_write(volatile_bit);
-      }
-      // I have two parts with Zbit vendor ID that are not compatible
-      // TODO - recheck datasheet for device values for 4MB part
-      break;
-
-    case SPI_FLASH_VENDOR_MYSTERY_D8: // 0xD8
-      // "Mystery Vendor" - an obfuscated GigaDevice part?
-      // The SFDP table says the MFG is 0xC8
-      //
-      // Status: tested, sealed in ESP-12F module
-      // "Mystery Vendor" 25Q32ET, No logo
-      // SFDP Revision: 1.06, 1ST Parameter Table Revision: 1.06
-      // SFDP Table Ptr: 0x30, Size: 64 Bytes
-    case SPI_FLASH_VENDOR_GIGADEVICE: // 0xC8
-      // Based on my read of the GigaDevice datasheet
-      // Only supports 8-bit status register writes just like "Mystery Vendor"
-      // Status: no hardware testing
-      if (0x40u == type) {
-        success = set_S9_QE_bit__8_bit_sr2_write(volatile_bit);
-      }
-      // For this part, non-volatile could be used w/o concern of write fatgue.
-      // Once non-volatile set, no attempts by the BootROM or SDK to change will
-      // work. 16-bit Status Register-1 writes will always fail.
-      // volatile_bit is safe and faster write time.
-      break;
-
-    case SPI_FLASH_VENDOR_XMC: // 0x20
-      // Special handling for XMC anomaly where driver strength value is lost
-      // when switching from non-volatile to volatile.
-      // Status: tested, sealed in ESP-12F module
-      // SFDP Revision: 1.00, 1ST Parameter Table Revision: 1.00
-      // SFDP Table Ptr: 0x30, Size: 36 Bytes
-      if (0x40u == type) {
-        // Backup Status Register-3
-        uint32_t status3 = 0u;
-        SpiOpResult ok0 = spi0_flash_read_status_register_3(&status3);
-        // success = set_S9_QE_bit__8_bit_sr2_write(volatile_bit);
-        success = set_S9_QE_bit__16_bit_sr1_write(volatile_bit);
-        if (SPI_RESULT_OK == ok0) {
-          uint32_t newSR3 = 0u;
-          spi0_flash_read_status_register_3(&newSR3);
-          if (status3 != newSR3) {
-            // Copy Driver Strength value from non-volatile to volatile
-            ok0 = spi0_flash_write_status_register_3(status3, volatile_bit);
-            DBG_SFU_PRINTF("  XMC Anomaly: Copy Driver Strength values to volatile status register.\n");
-            if (SPI_RESULT_OK != ok0) {
-              DBG_SFU_PRINTF("* anomaly handling failed.\n");
-            }
-          }
-        }
-      }
-      break;
+  To have a larger pool of Flash vendors to test against, I tested with devices
+  that did not expose GPIO9 and GPIO10. These did not work well. Let us hope
+  that modules makers that expose GPIO9 and GPIO10 made an effort to pair the
+  ESP8266EX with a SPI Flash that can disable /WP and /HOLD.
 
+  Keep sorted by vendor, then type. Checked at compile time.
+*/
+static constexpr SpiFlashVendorPart kBuiltinParts[] PROGMEM = {
 #if 0
-    // Not tested, block for now
-    // These are two QE/S6 Flash vendors the NONOS_SDK checks for.
-    // Tests are based on RTOS_SDK code
-    //   https://github.com/espressif/esp-idf/blob/bdb9f972c6a1f1c5ca50b1be2e7211ec7c24e881/components/bootloader_support/bootloader_flash/src/flash_qio_mode.c#L37-L54
-    case SPI_FLASH_VENDOR_ISSI_2:     // 0x9D (confusable with PMC) - Does not support volatile
-      if (0x40u == (0xCFu & type)) {
-        // Status: no hardware testing
-        success = set_S6_QE_bit__8_bit_sr1_write(non_volatile_bit);
-      }
-      break;
-
-    case SPI_FLASH_VENDOR_MACRONIX:   // 0xC2
-      if (0x20u == type) {
-        // Status: no hardware testing
-        success = set_S6_QE_bit__8_bit_sr1_write(non_volatile_bit);
-      }
-      break;
+  // The sample code found in RTOS_SDK does not agree with my observations.
+  // Oddly, the NONOS_SDK does not include it. I think it is safer to leave it
+  // out as a built-in handler. Its properties can always be analyzed and
+  // added later as a custom reclaim handler.
+  // EON EN25Q32C, identification based on datasheet and data matchup
+  // Status: tested, sealed in ESP-12F module
+  // SFDP Revision: 1.00, 1ST Parameter Table Revision: 1.00
+  // SFDP Table Ptr: 0x30, Size: 36 Bytes
+  // These will match EN25Q32A, EN25Q32B, EN25Q32C pin 4 NC (DQ3) no /HOLD
+  // function. EON SPI Flash parts have a WPDis S6 bit in status register-1 for
+  // disabling /WP (and /HOLD). This is similar to QE/S9 on other vendor parts.
+  // 0x331Cu - Not supported, EN25Q32 no S6 bit
+  // 0x701Cu - EN25QH128A might work
+  SPI_FLASH_VENDOR_PART(SPI_FLASH_VENDOR_EON, 0x30u, S6_8bitSR1, kVendorPartNonVolatile),
 #endif
 
+  // XMC - Special handling for XMC anomaly where driver strength value is lost
+  // when switching from non-volatile to volatile.
+  // Status: tested, sealed in ESP-12F module
+  // SFDP Revision: 1.00, 1ST Parameter Table Revision: 1.00
+  // SFDP Table Ptr: 0x30, Size: 36 Bytes
+  // 8-bit write register-2 also works.
+  SPI_FLASH_VENDOR_PART(SPI_FLASH_VENDOR_XMC, 0x40u, S9_16bitSR1, kVendorPartPreserveSR3),
+
+  // Zbit 25VQ80AT
+  // Status: tested
+  // SFDP Revision: 1.06, 1ST Parameter Table Revision: 1.06
+  // SFDP Table Ptr: 0x30, Size: 64 Bytes
+  // I have two parts with Zbit vendor ID that are not compatible
+  // TODO - recheck datasheet for device values for 4MB part
+  SPI_FLASH_VENDOR_PART(SPI_FLASH_VENDOR_ZBIT, 0x60u, S9_16bitSR1, 0u),
+
+  // Puya P25Q80H
+  // Status: tested
+  // SFDP Revision: 1.00, 1ST Parameter Table Revision: 1.00
+  // SFDP Table Ptr: 0x30, Size: 36 Bytes
+  SPI_FLASH_VENDOR_PART(SPI_FLASH_VENDOR_PUYA, 0x60u, S9_16bitSR1, 0u),
+
 #if 0
-    // The sample code found in RTOS_SDK does not agree with my observations.
-    // Oddly, the NONOS_SDK does not include it. I think it is safer to leave it
-    // out as a built-in handler. Its properties can always be analyzed and
-    // added later as a custom reclaim handler.
-    case SPI_FLASH_VENDOR_EON:        // 0x1C
-      // Status: tested, sealed in ESP-12F module
-      // EON EN25Q32C, identification based on datasheet and data matchup
-      // SFDP Revision: 1.00, 1ST Parameter Table Revision: 1.00
-      // SFDP Table Ptr: 0x30, Size: 36 Bytes
-      if (0x30u == type) {
-        // These will match EN25Q32A, EN25Q32B, EN25Q32C pin 4 NC (DQ3) no /HOLD function
-        // EON SPI Flash parts have a WPDis S6 bit in status register-1 for
-        // disabling /WP (and /HOLD). This is similar to QE/S9 on other vendor parts.
-        success = set_S6_QE_bit__8_bit_sr1_write(non_volatile_bit);
-      }
-      // 0x331Cu - Not supported, EN25Q32 no S6 bit
-      // 0x701Cu - EN25QH128A might work
-      break;
+  // Not tested, block for now
+  // These are two QE/S6 Flash vendors the NONOS_SDK checks for.
+  // Tests are based on RTOS_SDK code
+  //   https://github.com/espressif/esp-idf/blob/bdb9f972c6a1f1c5ca50b1be2e7211ec7c24e881/components/bootloader_support/bootloader_flash/src/flash_qio_mode.c#L37-L54
+  // ISSI 0x9D (confusable with PMC) - Does not support volatile
+  SPI_FLASH_VENDOR_PART_MASKED(SPI_FLASH_VENDOR_ISSI_2, 0x40u, 0xCFu, S6_8bitSR1, kVendorPartNonVolatile),
+  // Macronix 0xC2
+  SPI_FLASH_VENDOR_PART(SPI_FLASH_VENDOR_MACRONIX, 0x20u, S6_8bitSR1, kVendorPartNonVolatile),
 #endif
 
+  // GigaDevice 0xC8
+  // Based on my read of the GigaDevice datasheet
+  // Only supports 8-bit status register writes just like "Mystery Vendor"
+  // Status: no hardware testing
+  // For this part, non-volatile could be used w/o concern of write fatgue.
+  // Once non-volatile set, no attempts by the BootROM or SDK to change will
+  // work. 16-bit Status Register-1 writes will always fail.
+  // volatile_bit is safe and faster write time.
+  SPI_FLASH_VENDOR_PART(SPI_FLASH_VENDOR_GIGADEVICE, 0x40u, S9_8bitSR2, 0u),
+
+  // "Mystery Vendor" 0xD8 - an obfuscated GigaDevice part?
+  // The SFDP table says the MFG is 0xC8
+  // Status: tested, sealed in ESP-12F module
+  // "Mystery Vendor" 25Q32ET, No logo
+  // SFDP Revision: 1.06, 1ST Parameter Table Revision: 1.06
+  // SFDP Table Ptr: 0x30, Size: 64 Bytes
+  SPI_FLASH_VENDOR_PART(SPI_FLASH_VENDOR_MYSTERY_D8, 0x40u, S9_8bitSR2, 0u),
+
+  // BergMicro
+  // Status: hardware tested
+  // Logo XTX BN25F08
+  // SFDP none
+  // I have a Sonoff SV with flash part BN25F08 with an XTX logo mark
+  // the JEDEC MFG ID matches BergMicro as does the part number.
+  SPI_FLASH_VENDOR_PART(SPI_FLASH_VENDOR_BERGMICRO, 0x40u, S9_16bitSR1, 0u),
+
+  // Winbond 25Q32FVSIG
+  // SFDP Revision: 1.00, 1ST Parameter Table Revision: 1.00
+  // SFDP Table Ptr: 0x80, Size: 36 Bytes
+  // 16-bit status register writes is what the ESP8266 BootROM is expecting
+  // the flash to support. "Legacy method" is what I often see used to descibe
+  // the 16-bit status register-1 writes in newer SPI Flash datasheets. I
+  // expect this to work with modules that are compatibile with SPI Flash Mode:
+  // "QIO" or "QOUT".
+  SPI_FLASH_VENDOR_PART(SPI_FLASH_VENDOR_WINBOND_NEX, 0x40u, S9_16bitSR1, 0u),
+};
+
+static constexpr bool is_sorted_parts(const SpiFlashVendorPart *t, const size_t n) {
+  for (size_t i = 1u; i < n; i++) {
+    if (spi_flash_vendor_part_key(t[i]) < spi_flash_vendor_part_key(t[i - 1u])) return false;
+  }
+  return true;
+}
+static_assert(is_sorted_parts(kBuiltinParts, sizeof(kBuiltinParts) / sizeof(kBuiltinParts[0])), "kBuiltinParts must be sorted by vendor, then type");
+
+// XMC anomaly, a volatile write to register-2 clears register-3.
+static void restore_sr3(const uint32_t status3) {
+  using namespace experimental;
+
+  // Copy Driver Strength value from non-volatile to volatile, when it changed
+  SrUpdate u = {};
+  u.value = status3 << 16u;
+  u.mask = 0xFF0000u;
+  u.caps = kSrCapSR3 | kSrCapVolatile;
+  u.non_volatile = volatile_bit;
+  SpiOpResult ok0 = sr_update(&u);
+  if (0u != u.nwrites) {
+    DBG_SFU_PRINTF("  XMC Anomaly: Copy Driver Strength values to volatile status register.\n");
+  }
+  if (SPI_RESULT_OK == ok0) {
+    // Noted even when QE was already set and nothing was written. A recipe
+    // that writes QE on a later boot clears SR3 again.
+    qe_recipe_note_sr3(status3);
+  } else {
+    DBG_SFU_PRINTF("* anomaly handling failed.\n");
+    // Don't cache a recipe that would repeat the QE write without SR3
+    qe_recipe.kind = kQeRecipeNotSet;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Run the QE recipe for one part
+bool spi_flash_vendor_part_run(const SpiFlashVendorPart& part) {
+  using namespace experimental;
+
+  const bool non_volatile = (0u != (part.flags & kVendorPartNonVolatile));
+  uint32_t status3 = 0u;
+  SpiOpResult ok0 = SPI_RESULT_ERR;
+  if (part.flags & kVendorPartPreserveSR3) {
+    // Backup Status Register-3
+    ok0 = spi0_flash_read_status_register_3(&status3);
+  }
+
+  bool success = false;
+  switch (part.kind) {
+    case kQeRecipeNone:
+      qe_recipe.kind = kQeRecipeNone;
+      success = true;
+      break;
+    case kQeRecipeS6_8bitSR1:
+      success = set_S6_QE_bit__8_bit_sr1_write(non_volatile);
+      break;
+    case kQeRecipeS9_8bitSR2:
+      success = set_S9_QE_bit__8_bit_sr2_write(non_volatile);
+      break;
+    case kQeRecipeS9_16bitSR1:
+      success = set_S9_QE_bit__16_bit_sr1_write(non_volatile);
+      break;
     default:
-      success = false;
       break;
   }
 
+  if (SPI_RESULT_OK == ok0) restore_sr3(status3);
+  return success;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Binary search for the first part with a matching vendor, then check that
+// vendor's few parts in order. The SFDP revision is read at most once, and
+// only when a part asks for it.
+const SpiFlashVendorPart *spi_flash_vendor_part_find(const SpiFlashVendorPart *table, const size_t count, const uint32_t _id, SpiFlashVendorPart *part) {
+  using namespace experimental;
+
+  const uint32_t vendor = 0xFFu & _id;
+  const uint32_t type = (_id >> 8u) & 0xFFu;
+  size_t lo = 0u;
+  size_t hi = count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2u;
+    memcpy_P(part, &table[mid], sizeof(SpiFlashVendorPart));
+    if ((0xFFu & part->id) < vendor) {
+      lo = mid + 1u;
+    } else {
+      hi = mid;
+    }
+  }
+
+  bool have_sfdp = false;
+  SfdpRevInfo sfdp;
+  for (; lo < count; lo++) {
+    memcpy_P(part, &table[lo], sizeof(SpiFlashVendorPart));
+    if ((0xFFu & part->id) != vendor) break;
+    if ((type & part->type_mask) != (part->id >> 8u)) continue;
+    if (part->flags & kVendorPartSfdpGuard) {
+      if (! have_sfdp) {
+        sfdp = get_sfdp_revision();
+        have_sfdp = true;
+      }
+      if (part->sfdp_rev != ((sfdp.parm_major << 4u) | (0x0Fu & sfdp.parm_minor)) ||
+          part->sfdp_sz_dw != sfdp.sz_dw) continue;
+    }
+    return &table[lo];
+  }
+  return nullptr;
+}
+
+bool spi_flash_vendor_table_cases(const SpiFlashVendorPart *table, const size_t count, const uint32_t _id) {
+  SpiFlashVendorPart part;
+  if (nullptr == spi_flash_vendor_part_find(table, count, _id, &part)) return false;
+  return spi_flash_vendor_part_run(part);
+}
+
+bool __spi_flash_vendor_cases(const uint32_t _id) {
+  bool success = spi_flash_vendor_table_cases(kBuiltinParts, sizeof(kBuiltinParts) / sizeof(kBuiltinParts[0]), _id);
   if (! success) {
     DBG_SFU_PRINTF("* No built-in flash QE bit handler.\n");
   }
@@ -285,6 +360,202 @@ bool __spi_flash_vendor_cases(const uint32_t _id) {
 
 bool spi_flash_vendor_cases(uint32_t _id) __attribute__ ((weak, alias("__spi_flash_vendor_cases")));
 
+#if RECLAIM_RECIPE_CACHE
+/*//////////////////////////////////////////////////////////////////////////////
+  Reclaim recipe cache, build with -DRECLAIM_RECIPE_CACHE=1
+
+  Each boot, reclaim_GPIO_9_10() runs vendor discovery: the vendor lookup, any
+  SFDP reads the handler does, and the QE handler's read before write. After a
+  success, we save what the handler did (see QeRecipe in SpiFlashUtilsQE.h)
+  with the Flash Chip ID to RTC user memory. At a warm boot
+  or deep-sleep wake, a valid record with a matching Chip ID is applied
+  directly - a read of QE and, only when it is clear, the minimum writes and
+  one verify read in a second sequence.
+
+  RTC memory survives a reset or deep sleep, not a power cycle. A different
+  Flash part requires a power cycle, which fails the record's CRC, so the
+  Chip ID is all the record needs to match.
+
+  When a handler does something the recipe cannot describe, it leaves
+  qe_recipe.kind at kQeRecipeNotSet, and nothing is saved. A failed verify
+  discards the record and falls back to vendor discovery.
+*/
+constexpr uint32_t kReclaimRecipeMagic = 0x52435032u; // "RCP2"
+
+struct ReclaimRecipeRecord {
+  uint32_t magic;
+  uint32_t chip_id;
+  experimental::QeRecipe recipe;
+  uint32_t cold_cycles;
+  uint32_t cold_xfers;
+  uint32_t crc;
+};
+static_assert(24u == sizeof(ReclaimRecipeRecord), "Record size changed, check RECLAIM_RECIPE_RTC_BLOCK");
+
+// Filled in by reclaim_GPIO_9_10(), which may run from preinit(). Keep out of .bss.
+static ReclaimRecipeStats recipe_stats __attribute__((section(".noinit")));
+static uint32_t recipe_stats_magic __attribute__((section(".noinit")));
+
+static uint32_t recipe_crc(const ReclaimRecipeRecord& rec) {
+  return crc32(&rec, offsetof(ReclaimRecipeRecord, crc));
+}
+
+static bool read_recipe_record(ReclaimRecipeRecord *rec) {
+  if (! system_rtc_mem_read(RECLAIM_RECIPE_RTC_BLOCK, rec, sizeof(ReclaimRecipeRecord))) return false;
+  return (kReclaimRecipeMagic == rec->magic && recipe_crc(*rec) == rec->crc);
+}
+
+void reclaim_recipe_discard() {
+  ReclaimRecipeRecord rec;
+  memset(&rec, 0, sizeof(rec));
+  system_rtc_mem_write(RECLAIM_RECIPE_RTC_BLOCK, &rec, sizeof(rec));
+}
+
+bool reclaim_recipe_stats(ReclaimRecipeStats *stats) {
+  if (kReclaimRecipeMagic != recipe_stats_magic) return false;
+  *stats = recipe_stats;
+  return true;
+}
+
+static bool apply_reclaim_recipe(const uint32_t _id) {
+  using namespace experimental;
+
+  ReclaimRecipeRecord rec;
+  if (! read_recipe_record(&rec)) return false;
+  if (_id != rec.chip_id) {
+    DBG_SFU_PRINTF("  Cached recipe is for Flash Chip ID: 0x%06X\n", rec.chip_id);
+    return false;
+  }
+
+  DBG_SFU_PRINTF("  Apply cached recipe: kind %u, %svolatile%s\n",
+    rec.recipe.kind, (rec.recipe.non_volatile) ? "non-" : "", (rec.recipe.restore_sr3) ? ", restore SR3" : "");
+  if (! apply_qe_recipe(rec.recipe)) {
+    DBG_SFU_PRINTF("* Cached recipe failed verify, discarded.\n");
+    reclaim_recipe_discard();
+    return false;
+  }
+  recipe_stats.cold_cycles = rec.cold_cycles;
+  recipe_stats.cold_xfers = rec.cold_xfers;
+  recipe_stats.cached = true;
+  return true;
+}
+
+static void save_reclaim_recipe(const uint32_t _id) {
+  using namespace experimental;
+
+  // This boot is the cold boot
+  recipe_stats.cold_cycles = recipe_stats.cycles;
+  recipe_stats.cold_xfers = recipe_stats.xfers;
+  if (kQeRecipeNotSet == qe_recipe.kind) {
+    DBG_SFU_PRINTF("  No recipe noted by the vendor handler, nothing cached.\n");
+    return;
+  }
+
+  ReclaimRecipeRecord rec;
+  rec.magic = kReclaimRecipeMagic;
+  rec.chip_id = _id;
+  rec.recipe = qe_recipe;
+  rec.cold_cycles = recipe_stats.cycles;
+  rec.cold_xfers = recipe_stats.xfers;
+  rec.crc = recipe_crc(rec);
+  system_rtc_mem_write(RECLAIM_RECIPE_RTC_BLOCK, &rec, sizeof(rec));
+}
+#endif
+
+#if defined(SPI_FLASH_RECLAIM_PART)
+/*//////////////////////////////////////////////////////////////////////////////
+  Single part builds, -DSPI_FLASH_RECLAIM_PART=0xTTVV
+
+  For a product with one known Flash part. The part's row is selected from
+  kBuiltinParts at compile time, or given with SPI_FLASH_RECLAIM_KIND and
+  SPI_FLASH_RECLAIM_FLAGS for parts not in the table. reclaim_GPIO_9_10()
+  becomes a straight-line call to one set_*_QE_bit__* function. The table,
+  the search, and the other QE functions are left for the linker to drop.
+
+  The Flash Chip ID is still read, a mismatch returns false with no writes.
+*/
+static constexpr bool reclaim_part_match(const SpiFlashVendorPart& part, const uint32_t id16) {
+  return (0xFFu & part.id) == (0xFFu & id16) && (part.id >> 8u) == (part.type_mask & (id16 >> 8u));
+}
+
+static constexpr SpiFlashVendorPart find_reclaim_part(const uint32_t id16) {
+  for (const SpiFlashVendorPart& part : kBuiltinParts) {
+    if (reclaim_part_match(part, id16)) return part;
+  }
+  return SpiFlashVendorPart{0u, 0u, experimental::kQeRecipeNotSet, 0u, 0u, 0u, 0u};
+}
+
+#if defined(SPI_FLASH_RECLAIM_KIND)
+#ifndef SPI_FLASH_RECLAIM_FLAGS
+#define SPI_FLASH_RECLAIM_FLAGS 0u
+#endif
+// Expand SPI_FLASH_RECLAIM_KIND before pasting
+#define RECLAIM_PART_KIND__(kind) experimental::kQeRecipe##kind
+#define RECLAIM_PART_KIND_(kind) RECLAIM_PART_KIND__(kind)
+static constexpr SpiFlashVendorPart kReclaimPart = {
+  (uint16_t)(0xFFFFu & (SPI_FLASH_RECLAIM_PART)), 0xFFu, RECLAIM_PART_KIND_(SPI_FLASH_RECLAIM_KIND), (uint8_t)(SPI_FLASH_RECLAIM_FLAGS), 0u, 0u, 0u
+};
+#else
+static constexpr SpiFlashVendorPart kReclaimPart = find_reclaim_part(SPI_FLASH_RECLAIM_PART);
+static_assert(experimental::kQeRecipeNotSet != kReclaimPart.kind,
+  "SPI_FLASH_RECLAIM_PART is not a built-in part, also define SPI_FLASH_RECLAIM_KIND");
+static_assert(0u == (kReclaimPart.flags & kVendorPartSfdpGuard),
+  "SPI_FLASH_RECLAIM_PART has an SFDP guard, define SPI_FLASH_RECLAIM_KIND for the revision on board");
+#endif
+
+template <uint8_t kind, uint8_t flags>
+static bool reclaim_part() {
+  using namespace experimental;
+
+  constexpr bool non_volatile = (0u != (flags & kVendorPartNonVolatile));
+  uint32_t status3 = 0u;
+  SpiOpResult ok0 = SPI_RESULT_ERR;
+  if constexpr (0u != (flags & kVendorPartPreserveSR3)) {
+    ok0 = spi0_flash_read_status_register_3(&status3);
+  }
+
+  bool success;
+  if constexpr (kQeRecipeNone == kind) {
+    qe_recipe.kind = kQeRecipeNone;
+    success = true;
+  } else if constexpr (kQeRecipeS6_8bitSR1 == kind) {
+    success = set_S6_QE_bit__8_bit_sr1_write(non_volatile);
+  } else if constexpr (kQeRecipeS9_8bitSR2 == kind) {
+    success = set_S9_QE_bit__8_bit_sr2_write(non_volatile);
+  } else {
+    static_assert(kQeRecipeS9_16bitSR1 == kind, "Unknown QE recipe kind");
+    success = set_S9_QE_bit__16_bit_sr1_write(non_volatile);
+  }
+
+  if constexpr (0u != (flags & kVendorPartPreserveSR3)) {
+    if (SPI_RESULT_OK == ok0) restore_sr3(status3);
+  }
+  return success;
+}
+
+static bool reclaim_single_part(const uint32_t _id) {
+  if (! reclaim_part_match(kReclaimPart, _id)) {
+    DBG_SFU_PRINTF("* Built for Flash Chip ID 0x%04X, found 0x%06X\n", (uint32_t)(SPI_FLASH_RECLAIM_PART), _id);
+    return false;
+  }
+  return reclaim_part<kReclaimPart.kind, kReclaimPart.flags>();
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Set by reclaim_GPIO_9_10(), which may run from preinit(). Keep out of .bss.
+// It survives a reset, the pin function check catches that; after a reset,
+// GPIO9 and GPIO10 are back on the SPI bus.
+constexpr uint32_t kReclaimedMagic = 0x30314F47u; // "GO10"
+static uint32_t reclaimed_magic __attribute__((section(".noinit")));
+
+bool is_GPIO_9_10_reclaimed() {
+  constexpr uint32_t kFnMask = GPFFS(7u);
+  return kReclaimedMagic == reclaimed_magic &&
+         GPFFS(GPFFS_GPIO(9u)) == (GPF9 & kFnMask) &&
+         GPFFS(GPFFS_GPIO(10u)) == (GPF10 & kFnMask);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Handle Freeing up GPIO pins 9 and 10 for various Flash memory chips.
 //
@@ -295,18 +566,35 @@ bool spi_flash_vendor_cases(uint32_t _id) __attribute__ ((weak, alias("__spi_fla
 bool reclaim_GPIO_9_10() {
   using namespace experimental;
   bool success = false;
+  reclaimed_magic = 0u;
+  // The BootROM and SDK have written the Status Registers, start over
+  sr_shadow_invalidate();
+#if RECLAIM_TIMELINE
+  reclaim_timeline_reset();
+#endif
+  RECLAIM_TIMELINE_MARK(kReclaimPhaseStart, 0u);
 
-#if RECLAIM_GPIO_EARLY && DEBUG_FLASH_QE
+#if DEBUG_FLASH_QE && DEBUG_FLASH_QE_DEFERRED
+  sfu_log_reset();
+#elif RECLAIM_GPIO_EARLY && DEBUG_FLASH_QE
   pinMode(1u, SPECIAL);
   uart_buff_switch(0u);
 #endif
   DBG_SFU_PRINTF("\n\n\nRun reclaim_GPIO_9_10()\n");
+#if RECLAIM_RECIPE_CACHE
+  const uint32_t start_cycles = esp_get_cycle_count();
+  spi0_flash_xfer_count = 1u;   // count the Chip ID read
+  recipe_stats.cold_cycles = 0u;
+  recipe_stats.cold_xfers = 0u;
+  recipe_stats.cached = false;
+#endif
 
 #if (RECLAIM_GPIO_EARLY == 2)
   uint32_t _id = alt_spi_flash_get_id();
 #else
   uint32_t _id = spi_flash_get_id();
 #endif
+  RECLAIM_TIMELINE_MARK(kReclaimPhaseIdRead, _id);
   DBG_SFU_PRINTF("  Flash Chip ID: 0x%06X\n", _id);
 
 #if DEBUG_FLASH_QE
@@ -323,17 +611,43 @@ bool reclaim_GPIO_9_10() {
   // against WEL bit left on in order to prevent volatile writes from turning
   // into non-volatile.
 #endif
+  RECLAIM_TIMELINE_MARK(kReclaimPhaseWelCheck, 0u);
 
   // Expand to read SFDP Parameter Version. Use result to differentiate parts.
 
   // SPI0 must be in DIO or DOUT mode to continue.
   if (is_spi0_quad()) {
     DBG_SFU_PRINTF("  GPIO pins 9 and 10 are not available when configured for SPI Flash Modes: \"QIO\" or \"QOUT\"\n");
+    RECLAIM_TIMELINE_MARK(kReclaimPhaseEnd, false);
     return false;
   }
+  RECLAIM_TIMELINE_MARK(kReclaimPhaseQuadCheck, 0u);
 
-  success = spi_flash_vendor_cases(_id);
-  spi0_flash_write_disable();
+  RECLAIM_TIMELINE_MARK(kReclaimPhaseVendorHandler, 0u);
+#if RECLAIM_RECIPE_CACHE
+  success = apply_reclaim_recipe(_id);
+#endif
+  if (! success) {
+    qe_recipe.u32 = 0u;
+#if defined(SPI_FLASH_RECLAIM_PART)
+    success = reclaim_single_part(_id);
+#else
+    success = spi_flash_vendor_cases(_id);
+#endif
+    spi0_flash_write_disable();
+  }
+  RECLAIM_TIMELINE_MARK(kReclaimPhaseVendorDone, success);
+#if RECLAIM_RECIPE_CACHE
+  recipe_stats.cycles = esp_get_cycle_count() - start_cycles;
+  recipe_stats.xfers = spi0_flash_xfer_count;
+  recipe_stats_magic = kReclaimRecipeMagic;
+  if (recipe_stats.cached) {
+    DBG_SFU_PRINTF("  Cached recipe saved %d flash transactions and %d CPU cycles.\n",
+      (int)(recipe_stats.cold_xfers - recipe_stats.xfers), (int)(recipe_stats.cold_cycles - recipe_stats.cycles));
+  } else if (success) {
+    save_reclaim_recipe(_id);
+  }
+#endif
   DBG_SFU_PRINTF("%sSPI0 signals '/WP' and '/HOLD' are%s disabled.\n", (success) ? "  " : "** ", (success) ? "" : " NOT");
   DBG_SFU_PRINTF("%sGPIO9 and GPIO10 are%s available.\n", (success) ? "  " : "** ", (success) ? "" : " NOT");
 
@@ -341,10 +655,13 @@ bool reclaim_GPIO_9_10() {
   if (success) {
     pinMode(9u, INPUT);
     pinMode(10u, INPUT);
+    reclaimed_magic = kReclaimedMagic;
   }
-#if RECLAIM_GPIO_EARLY && DEBUG_FLASH_QE
+  RECLAIM_TIMELINE_MARK(kReclaimPhasePinMode, 0u);
+#if RECLAIM_GPIO_EARLY && DEBUG_FLASH_QE && ! DEBUG_FLASH_QE_DEFERRED
   ets_delay_us(12000u);   // Give the TX FIFO a moment to clear
   pinMode(1u, INPUT);     // restore back to default
 #endif
+  RECLAIM_TIMELINE_MARK(kReclaimPhaseEnd, success);
   return success;
 }
@@ -22,14 +22,80 @@
 
 #include "SpiFlashUtilsQE.h"
 
+////////////////////////////////////////////////////////////////////////////////
+// Table driven vendor cases
+//
+// A part matches on the JEDEC vendor byte and a masked type byte, and
+// optionally the 1st SFDP parameter table revision and size. The match selects
+// one of the QE recipes, see QeRecipeKind in SpiFlashUtilsQE.h. Tables live in
+// PROGMEM and must be sorted by vendor, then type. Lookup is a binary search on
+// the vendor byte.
+//
+// A custom spi_flash_vendor_cases() can search its own table with
+// spi_flash_vendor_table_cases(), then fall back to __spi_flash_vendor_cases().
+enum : uint8_t {
+  kVendorPartNonVolatile = 0x01u,   // Write the non-volatile QE bit
+  kVendorPartPreserveSR3 = 0x02u,   // Restore SR3 when the QE write changes it, XMC
+  kVendorPartSfdpGuard   = 0x04u,   // Also match sfdp_rev and sfdp_sz_dw
+};
+
+struct SpiFlashVendorPart {
+  uint16_t id;                      // (type << 8) | vendor
+  uint8_t  type_mask;
+  uint8_t  kind;                    // experimental::QeRecipeKind
+  uint8_t  flags;
+  uint8_t  sfdp_rev;                // (parm_major << 4) | parm_minor
+  uint8_t  sfdp_sz_dw;
+  uint8_t  reserved;
+};
+
+#define SPI_FLASH_VENDOR_PART_ID(vendor, type) ((uint16_t)(((type) << 8u) | (vendor)))
+
+// kind is the QeRecipeKind name without the kQeRecipe prefix, eg. S9_16bitSR1
+#define SPI_FLASH_VENDOR_PART(vendor, type, kind, flags) \
+  {SPI_FLASH_VENDOR_PART_ID(vendor, type), 0xFFu, experimental::kQeRecipe##kind, (flags), 0u, 0u, 0u}
+#define SPI_FLASH_VENDOR_PART_MASKED(vendor, type, type_mask, kind, flags) \
+  {SPI_FLASH_VENDOR_PART_ID(vendor, type), (type_mask), experimental::kQeRecipe##kind, (flags), 0u, 0u, 0u}
+#define SPI_FLASH_VENDOR_PART_SFDP(vendor, type, kind, flags, parm_major, parm_minor, sz_dw) \
+  {SPI_FLASH_VENDOR_PART_ID(vendor, type), 0xFFu, experimental::kQeRecipe##kind, \
+   (uint8_t)((flags) | kVendorPartSfdpGuard), (uint8_t)(((parm_major) << 4u) | (parm_minor)), (sz_dw), 0u}
+
+// Sort key, vendor then type
+constexpr uint32_t spi_flash_vendor_part_key(const SpiFlashVendorPart& part) {
+  return ((0xFFu & part.id) << 8u) | (part.id >> 8u);
+}
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+bool spi_flash_vendor_table_cases(const SpiFlashVendorPart *table, const size_t count, const uint32_t _id);
+// Returns the matching table entry and a RAM copy in *part, or nullptr.
+const SpiFlashVendorPart *spi_flash_vendor_part_find(const SpiFlashVendorPart *table, const size_t count, const uint32_t _id, SpiFlashVendorPart *part);
+bool spi_flash_vendor_part_run(const SpiFlashVendorPart& part);
+
 bool reclaim_GPIO_9_10();
+// True after reclaim_GPIO_9_10() succeeded this boot, and GPIO9 and GPIO10
+// are still GPIO pins.
+bool is_GPIO_9_10_reclaimed();
 bool spi_flash_vendor_cases(uint32_t _id);    // weak - replacement with custom
 bool __spi_flash_vendor_cases(uint32_t _id);
 
+#if RECLAIM_RECIPE_CACHE
+// Cost of reclaim_GPIO_9_10() in CPU cycles and flash transactions. "cold" is
+// the boot that ran vendor discovery and saved the recipe, when known.
+struct ReclaimRecipeStats {
+  uint32_t cold_cycles;
+  uint32_t cold_xfers;
+  uint32_t cycles;          // This boot
+  uint32_t xfers;           // This boot
+  bool     cached;          // This boot applied the cached recipe
+};
+
+bool reclaim_recipe_stats(ReclaimRecipeStats *stats);
+void reclaim_recipe_discard();  // Next boot runs vendor discovery
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -45,4 +111,11 @@ bool __spi_flash_vendor_cases(uint32_t _id);
 #define SPI_FLASH_VENDOR_ISSI_2    0x9Du
 #endif
 
+#if RECLAIM_RECIPE_CACHE && !defined(RECLAIM_RECIPE_RTC_BLOCK)
+// RTC user memory is 4-byte blocks 64 - 191, the record uses 6 blocks at the
+// end. eboot's OTA command uses blocks 128 - 159. With ESP.rtcUserMemoryWrite,
+// this is offsets 122 - 127.
+#define RECLAIM_RECIPE_RTC_BLOCK 186u
+#endif
+
 #endif // EXPERIMENTAL_MODE_DIO_RECLAIM_GPIOS_H
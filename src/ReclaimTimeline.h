@@ -0,0 +1,118 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Reclaim timeline - CPU cycle timestamps for each phase of reclaim_GPIO_9_10()
+
+  Build with -DRECLAIM_TIMELINE=1. Each phase and each flash instruction adds
+  an event with the CPU cycle count to a small .noinit buffer. Unlike
+  DBG_SFU_PRINTF, recording does not change the timing much, a few cycles per
+  event. Recording starts with reclaim_GPIO_9_10() and stops at its
+  kReclaimPhaseEnd, later flash instructions are not added. The buffer
+  survives until the next reclaim_GPIO_9_10() call, so it can be read from
+  setup() after reclaiming from preinit(). See the "BootTimeline" example.
+
+  Without RECLAIM_TIMELINE, RECLAIM_TIMELINE_MARK() compiles to nothing.
+*/
+#ifndef EXPERIMENTAL_RECLAIM_TIMELINE_H
+#define EXPERIMENTAL_RECLAIM_TIMELINE_H
+
+#include <stdint.h>
+
+#if ((1 - RECLAIM_TIMELINE - 1) == 2)
+#undef RECLAIM_TIMELINE
+#define RECLAIM_TIMELINE 1
+#endif
+
+#ifndef RECLAIM_TIMELINE_MAX
+#define RECLAIM_TIMELINE_MAX 32u
+#endif
+
+enum ReclaimPhase : uint8_t {
+  kReclaimPhaseStart = 0u,
+  kReclaimPhaseIdRead,          // arg: low byte of the Flash Chip ID
+  kReclaimPhaseWelCheck,
+  kReclaimPhaseQuadCheck,
+  kReclaimPhaseVendorHandler,   // Entering the vendor handler or cached recipe
+  kReclaimPhaseVendorDone,      // arg: 1 success
+  kReclaimPhaseSpi0Command,     // arg: instruction, one SPI0Command
+  kReclaimPhaseSequenceStep,    // arg: instruction, one step in spi0_flash_sequence
+  kReclaimPhaseVerify,          // arg: 1 QE confirmed
+  kReclaimPhasePinMode,
+  kReclaimPhaseEnd,             // arg: 1 success
+  kReclaimPhaseCount
+};
+
+struct ReclaimTimelineEvent {
+  uint32_t cycles;              // esp_get_cycle_count()
+  uint8_t  phase;               // ReclaimPhase
+  uint8_t  arg;
+  uint16_t reserved;
+};
+
+struct ReclaimTimeline {
+  uint32_t magic;
+  uint32_t count;               // events recorded, may exceed RECLAIM_TIMELINE_MAX
+  uint32_t armed;               // Recording, from reclaim_timeline_reset() to kReclaimPhaseEnd
+  ReclaimTimelineEvent event[RECLAIM_TIMELINE_MAX];
+};
+
+constexpr uint32_t kReclaimTimelineMagic = 0x544C4E32u; // "TLN2"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if RECLAIM_TIMELINE
+extern ReclaimTimeline reclaim_timeline_buf;
+
+// Also marks each step of spi0_flash_sequence(), with the iCache off.
+inline __attribute__((always_inline))
+void reclaim_timeline_mark(const uint8_t phase, const uint32_t arg) {
+  ReclaimTimeline& tl = reclaim_timeline_buf;
+  if (kReclaimTimelineMagic != tl.magic || 0u == tl.armed) return;
+  uint32_t n = tl.count++;
+  if (RECLAIM_TIMELINE_MAX > n) {
+    tl.event[n].cycles = esp_get_cycle_count();
+    tl.event[n].phase = phase;
+    tl.event[n].arg = arg;
+  }
+  if (kReclaimPhaseEnd == phase) tl.armed = 0u;
+}
+
+inline
+void reclaim_timeline_reset() {
+  reclaim_timeline_buf.magic = kReclaimTimelineMagic;
+  reclaim_timeline_buf.count = 0u;
+  reclaim_timeline_buf.armed = 1u;
+}
+
+// Returns nullptr when reclaim_GPIO_9_10() has not run since the last cold
+// boot. The .noinit buffer, and its magic, survive a warm reset.
+inline
+const ReclaimTimeline *reclaim_timeline() {
+  return (kReclaimTimelineMagic == reclaim_timeline_buf.magic) ? &reclaim_timeline_buf : nullptr;
+}
+
+#define RECLAIM_TIMELINE_MARK(phase, arg) reclaim_timeline_mark((phase), (arg))
+#else
+#define RECLAIM_TIMELINE_MARK(phase, arg) do {} while (false)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EXPERIMENTAL_RECLAIM_TIMELINE_H
@@ -0,0 +1,270 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+////////////////////////////////////////////////////////////////////////////////
+// Security Register store, see SecurityRegisterStore.h
+//
+#include <Arduino.h>
+#include <coredecls.h>        // crc32()
+#include "SecurityRegisterStore.h"
+
+namespace experimental {
+
+constexpr size_t kRegDw = kSecurityRegisterSz / sizeof(uint32_t);
+
+union SecRegRecordHdr {
+  struct {
+    uint8_t  tag;
+    uint8_t  len;
+    uint16_t rsvd;
+  };
+  uint32_t u32;
+};
+
+static constexpr size_t padded(const size_t len) {
+  return (len + 3u) & ~3u;
+}
+
+// Whole record, header and crc included
+static constexpr size_t record_sz(const size_t len) {
+  return sizeof(SecRegRecordHdr) + padded(len) + sizeof(uint32_t);
+}
+
+static inline const uint8_t *image_bytes(const SecRegStore *st) {
+  return (const uint8_t *)&st->image[0];
+}
+
+// Returns the header at pos when a whole record fits there. The CRC is
+// checked separately, a bad record still has a usable length.
+static bool record_at(const SecRegStore *st, const size_t pos, SecRegRecordHdr *hdr) {
+  if (pos + sizeof(SecRegRecordHdr) > kSecurityRegisterSz) return false;
+  hdr->u32 = st->image[pos / sizeof(uint32_t)];
+  if (kSecRegTagFree == hdr->tag || 0u == hdr->len || 0xFFFFu != hdr->rsvd) return false;
+  return pos + record_sz(hdr->len) <= kSecurityRegisterSz;
+}
+
+static bool record_crc_ok(const SecRegStore *st, const size_t pos, const SecRegRecordHdr& hdr) {
+  const size_t crc_pos = pos + sizeof(SecRegRecordHdr) + padded(hdr.len);
+  return crc32(&image_bytes(st)[pos], crc_pos - pos) == st->image[crc_pos / sizeof(uint32_t)];
+}
+
+// Position of the current record for tag, 0 for none. 0 is the magic, never
+// a record.
+static size_t find_record(const SecRegStore *st, const uint8_t tag) {
+  size_t found = 0u;
+  SecRegRecordHdr hdr;
+  for (size_t pos = kSecRegStoreHdrSz; record_at(st, pos, &hdr); pos += record_sz(hdr.len)) {
+    if (tag == hdr.tag && record_crc_ok(st, pos, hdr)) found = pos;
+  }
+  return found;
+}
+
+// The end of the records. Anything after them that is not erased, eg. a torn
+// write, leaves no room to append.
+static size_t find_used(const SecRegStore *st) {
+  size_t pos = kSecRegStoreHdrSz;
+  SecRegRecordHdr hdr;
+  while (record_at(st, pos, &hdr)) pos += record_sz(hdr.len);
+  for (size_t i = pos / sizeof(uint32_t); i < kRegDw; i++) {
+    if (~0u != st->image[i]) return kSecurityRegisterSz;
+  }
+  return pos;
+}
+
+bool sec_reg_store_open(SecRegStore *st, const uint32_t reg) {
+  if (nullptr == st) return false;
+
+  memset(st, 0, sizeof(SecRegStore));
+  st->reg = reg;
+  st->state = kSecRegStoreClosed;
+  if (SPI_RESULT_OK != spi0_flash_read_secure_register(reg, 0u, &st->image[0], kSecurityRegisterSz)) return false;
+
+  if (kSecRegStoreMagic == st->image[0]) {
+    st->state = kSecRegStoreReady;
+    st->used = find_used(st);
+    return true;
+  }
+  for (size_t i = 0u; i < kRegDw; i++) {
+    if (~0u != st->image[i]) {
+      st->state = kSecRegStoreForeign;
+      return false;
+    }
+  }
+  st->state = kSecRegStoreBlank;
+  st->used = kSecRegStoreHdrSz;
+  return true;
+}
+
+const void *sec_reg_store_find(const SecRegStore *st, const uint8_t tag, size_t *sz) {
+  if (sz) *sz = 0u;
+  if (nullptr == st || kSecRegStoreReady != st->state) return nullptr;
+
+  const size_t pos = find_record(st, tag);
+  if (0u == pos) return nullptr;
+  SecRegRecordHdr hdr;
+  hdr.u32 = st->image[pos / sizeof(uint32_t)];
+  if (sz) *sz = hdr.len;
+  return &image_bytes(st)[pos + sizeof(SecRegRecordHdr)];
+}
+
+bool sec_reg_store_get(const SecRegStore *st, const uint8_t tag, void *p, const size_t sz) {
+  size_t len = 0u;
+  const void *rec = sec_reg_store_find(st, tag, &len);
+  if (nullptr == rec || nullptr == p || sz != len) return false;
+  memcpy(p, rec, sz);
+  return true;
+}
+
+size_t sec_reg_store_free(const SecRegStore *st) {
+  if (nullptr == st || (kSecRegStoreReady != st->state && kSecRegStoreBlank != st->state)) return 0u;
+  const size_t overhead = record_sz(0u);
+  if (st->used + overhead > kSecurityRegisterSz) return 0u;
+  return (kSecurityRegisterSz - st->used - overhead) & ~3u;
+}
+
+// Write the record for tag into the image at st->used
+static void image_append(SecRegStore *st, const uint8_t tag, const void *p, const size_t sz) {
+  uint8_t *img = (uint8_t *)&st->image[0];
+  const size_t pos = st->used;
+  SecRegRecordHdr hdr;
+  hdr.tag = tag;
+  hdr.len = sz;
+  hdr.rsvd = 0xFFFFu;
+  st->image[pos / sizeof(uint32_t)] = hdr.u32;
+  memset(&img[pos + sizeof(SecRegRecordHdr)], 0xFF, padded(sz));
+  memcpy(&img[pos + sizeof(SecRegRecordHdr)], p, sz);
+  const size_t crc_pos = pos + sizeof(SecRegRecordHdr) + padded(sz);
+  st->image[crc_pos / sizeof(uint32_t)] = crc32(&img[pos], crc_pos - pos);
+  st->used = crc_pos + sizeof(uint32_t);
+}
+
+// Keep the current record of each tag, except skip_tag, and drop the rest.
+// Kept records are found first, with the image intact, then moved down in
+// place.
+static void image_compact(SecRegStore *st, const uint8_t skip_tag) {
+  constexpr size_t kMaxRecords = (kSecurityRegisterSz - kSecRegStoreHdrSz) / record_sz(1u);
+  uint16_t keep_pos[kMaxRecords];
+  uint16_t keep_sz[kMaxRecords];
+  size_t n = 0u;
+  SecRegRecordHdr hdr;
+  for (size_t pos = kSecRegStoreHdrSz; record_at(st, pos, &hdr); pos += record_sz(hdr.len)) {
+    if (skip_tag != hdr.tag && find_record(st, hdr.tag) == pos && n < kMaxRecords) {
+      keep_pos[n] = pos;
+      keep_sz[n] = record_sz(hdr.len);
+      n++;
+    }
+  }
+
+  uint8_t *img = (uint8_t *)&st->image[0];
+  size_t out = kSecRegStoreHdrSz;
+  for (size_t i = 0u; i < n; i++) {
+    if (out != keep_pos[i]) memmove(&img[out], &img[keep_pos[i]], keep_sz[i]);
+    out += keep_sz[i];
+  }
+  memset(&img[out], 0xFF, kSecurityRegisterSz - out);
+  st->used = out;
+}
+
+static SpiOpResult program_verify(SecRegStore *st, const size_t pos, const size_t sz) {
+  const uint8_t *img = image_bytes(st);
+  SpiOpResult ok0 = spi0_flash_program_security_register(st->reg, pos, &img[pos], sz, NULL, NULL);
+  if (SPI_RESULT_OK != ok0) return ok0;
+  return spi0_flash_verify_security_register(st->reg, pos, &img[pos], sz);
+}
+
+static SpiOpResult check_unlocked(const SecRegStore *st) {
+  uint32_t locks = 0u;
+  SpiOpResult ok0 = spi0_flash_read_security_register_locks(&locks);
+  if (SPI_RESULT_OK != ok0) return ok0;
+  return (locks & (1u << (st->reg - 1u))) ? SPI_RESULT_ERR : SPI_RESULT_OK;
+}
+
+SpiOpResult sec_reg_store_format(SecRegStore *st) {
+  if (nullptr == st || 1u > st->reg || 3u < st->reg) return SPI_RESULT_ERR;
+  SpiOpResult ok0 = check_unlocked(st);
+  if (SPI_RESULT_OK != ok0) return ok0;
+
+  ok0 = spi0_flash_erase_security_register(st->reg, NULL, NULL);
+  memset(&st->image[0], 0xFF, sizeof(st->image));
+  st->used = 0u;
+  st->state = kSecRegStoreClosed;
+  if (SPI_RESULT_OK != ok0) return ok0;
+
+  st->image[0] = kSecRegStoreMagic;
+  st->used = kSecRegStoreHdrSz;
+  ok0 = program_verify(st, 0u, kSecRegStoreHdrSz);
+  if (SPI_RESULT_OK == ok0) st->state = kSecRegStoreReady;
+  return ok0;
+}
+
+SpiOpResult sec_reg_store_put(SecRegStore *st, const uint8_t tag, const void *p, const size_t sz) {
+  if (nullptr == st || nullptr == p || 0u == sz || kSecRegStoreMaxPayload < sz || kSecRegTagFree == tag) return SPI_RESULT_ERR;
+  if (kSecRegStoreReady != st->state && kSecRegStoreBlank != st->state) return SPI_RESULT_ERR;
+
+  // Unchanged, save the wear
+  size_t len = 0u;
+  const void *cur = sec_reg_store_find(st, tag, &len);
+  if (cur && sz == len && 0 == memcmp(cur, p, sz)) return SPI_RESULT_OK;
+
+  SpiOpResult ok0 = check_unlocked(st);
+  if (SPI_RESULT_OK != ok0) return ok0;
+
+  if (kSecRegStoreBlank == st->state) {
+    st->image[0] = kSecRegStoreMagic;
+    ok0 = program_verify(st, 0u, kSecRegStoreHdrSz);
+    if (SPI_RESULT_OK == ok0) st->state = kSecRegStoreReady;
+  }
+
+  if (SPI_RESULT_OK == ok0) {
+    if (st->used + record_sz(sz) <= kSecurityRegisterSz) {
+      const size_t pos = st->used;
+      image_append(st, tag, p, sz);
+      ok0 = program_verify(st, pos, st->used - pos);
+    } else {
+      // Full. Rewrite the current records and the new one after an erase.
+      image_compact(st, tag);
+      if (st->used + record_sz(sz) <= kSecurityRegisterSz) {
+        image_append(st, tag, p, sz);
+        ok0 = spi0_flash_erase_security_register(st->reg, NULL, NULL);
+        if (SPI_RESULT_OK == ok0) ok0 = program_verify(st, 0u, st->used);
+      } else {
+        ok0 = SPI_RESULT_ERR;
+      }
+    }
+  }
+  if (SPI_RESULT_OK != ok0) {
+    // The image is ahead of the register, read it again
+    sec_reg_store_open(st, st->reg);
+  }
+  return ok0;
+}
+
+bool sec_reg_store_apply_recipe(const SecRegStore *st, const uint32_t chip_id) {
+  SecRegRecipe rec;
+  if (! sec_reg_store_get(st, kSecRegTagRecipe, &rec, sizeof(rec))) return false;
+  if (chip_id != rec.chip_id || kQeRecipeNotSet == rec.recipe.kind) return false;
+  return apply_qe_recipe(rec.recipe);
+}
+
+SpiOpResult sec_reg_store_save_recipe(SecRegStore *st, const uint32_t chip_id) {
+  if (kQeRecipeNotSet == qe_recipe.kind) return SPI_RESULT_ERR;
+  SecRegRecipe rec;
+  memset(&rec, 0, sizeof(rec));
+  rec.chip_id = chip_id;
+  rec.recipe = qe_recipe;
+  return sec_reg_store_put(st, kSecRegTagRecipe, &rec, sizeof(rec));
+}
+
+};  // namespace experimental
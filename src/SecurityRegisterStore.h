@@ -0,0 +1,125 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+////////////////////////////////////////////////////////////////////////////////
+// Security Register store - small tagged records in one Security Register
+//
+// Per-device data kept outside the flash map: OTA, SPIFFS/LittleFS, and
+// ESP.eraseConfig() never touch the Security Registers. A lookup at boot is one
+// 256 byte read, 4 transfers, and no filesystem mount.
+//
+// Register layout, all little-endian:
+//
+//   0    "SRS1" magic
+//   4    records, back to back, then erased space (0xFF)
+//
+// Record:
+//
+//   tag:8 len:8 rsvd:16    rsvd is 0xFFFF
+//   payload                len bytes, padded to a whole word with 0xFF
+//   crc32                  of the header and padded payload
+//
+// Records are only appended. The last record with a good CRC for a tag is
+// the current one. When a record does not fit, the current records are kept,
+// the register is erased and written again. An erase is 45 - 400 ms with the
+// iCache off, and a register is good for about 100K erases. Keep records small
+// and write them when they change, not every boot.
+//
+// A register holding anything other than a store is left alone, until
+// sec_reg_store_format() is called on it. Power loss during the erase and
+// rewrite loses the store.
+#ifndef SECURITY_REGISTER_STORE_H
+#define SECURITY_REGISTER_STORE_H
+
+#include "SpiFlashUtils.h"
+#include "SpiFlashUtilsQE.h"
+
+namespace experimental {
+
+constexpr uint32_t kSecRegStoreMagic = 0x31535253u;  // "SRS1"
+constexpr size_t kSecRegStoreHdrSz = sizeof(uint32_t);
+// Magic, one record header, and its crc
+constexpr size_t kSecRegStoreMaxPayload = kSecurityRegisterSz - 3u * sizeof(uint32_t);
+
+enum SecRegTag : uint8_t {
+  kSecRegTagRecipe    = 0x01u,    // SecRegRecipe
+  kSecRegTagIdentity  = 0x02u,    // Device identity, format is the Sketch's
+  kSecRegTagBootStats = 0x03u,    // SecRegBootStats
+  kSecRegTagUser      = 0x80u,    // 0x80 - 0xFE for the Sketch
+  kSecRegTagFree      = 0xFFu,    // Erased space
+};
+
+enum SecRegStoreState : uint8_t {
+  kSecRegStoreClosed = 0u,
+  kSecRegStoreBlank,              // Erased, the first put formats it
+  kSecRegStoreReady,
+  kSecRegStoreForeign,            // Not a store, put() refuses to write
+};
+
+// A calibrated QE recipe for apply_qe_recipe(), kept with the part it was
+// found on.
+struct SecRegRecipe {
+  uint32_t chip_id;               // spi_flash_get_id()
+  QeRecipe recipe;
+};
+
+struct SecRegBootStats {
+  uint32_t boots;
+  uint32_t reclaim_ok;
+  uint32_t reclaim_failed;
+  uint32_t reclaim_cycles;        // Last reclaim_GPIO_9_10(), CPU cycles
+};
+
+// The register image lives here, lookups return pointers into it.
+struct SecRegStore {
+  uint32_t image[kSecurityRegisterSz / sizeof(uint32_t)];
+  uint16_t used;                  // bytes, the next record goes here
+  uint8_t  reg;                   // 1 - 3
+  uint8_t  state;                 // SecRegStoreState
+};
+
+// Read Security Register reg into st. Returns true for a store or an erased
+// register. Records with a bad CRC are skipped.
+bool sec_reg_store_open(SecRegStore *st, const uint32_t reg);
+
+// The current record for tag, in st->image. *sz gets its length. nullptr when
+// there is none.
+const void *sec_reg_store_find(const SecRegStore *st, const uint8_t tag, size_t *sz);
+
+// Copy the current record for tag into p. False when there is none or its
+// length is not sz.
+bool sec_reg_store_get(const SecRegStore *st, const uint8_t tag, void *p, const size_t sz);
+
+// Append a record, or erase and rewrite the register when it is full. Each
+// write is read back. Nothing is written when the current record already
+// holds the same data. SPI_RESULT_ERR for a foreign or locked register. After
+// a failure, st is read again from the register.
+SpiOpResult sec_reg_store_put(SecRegStore *st, const uint8_t tag, const void *p, const size_t sz);
+
+// Erase the register and write an empty store, whatever it held.
+SpiOpResult sec_reg_store_format(SecRegStore *st);
+
+// Payload bytes the next put() can take without an erase
+size_t sec_reg_store_free(const SecRegStore *st);
+
+// Apply the stored recipe when it is for chip_id. See apply_qe_recipe().
+bool sec_reg_store_apply_recipe(const SecRegStore *st, const uint32_t chip_id);
+
+// Store qe_recipe, as noted by the last vendor handler, for chip_id.
+SpiOpResult sec_reg_store_save_recipe(SecRegStore *st, const uint32_t chip_id);
+
+};  // namespace experimental
+
+#endif // SECURITY_REGISTER_STORE_H
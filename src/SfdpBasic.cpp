@@ -0,0 +1,209 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+////////////////////////////////////////////////////////////////////////////////
+// SFDP - JEDEC Basic Flash Parameter Table (BFPT) decoder
+//
+// Bit positions are from JESD216F. Earlier revisions of the table are shorter,
+// not different. DW numbers in comments are 1-based like the standard, dw[]
+// indexes are 0-based.
+#include <Arduino.h>
+#include "SpiFlashUtils.h"
+#include "SfdpBasic.h"
+
+namespace experimental {
+
+static inline uint32_t field(const uint32_t v, const uint32_t lsb, const uint32_t width) {
+  return (v >> lsb) & ((1u << width) - 1u);
+}
+
+// 5-bit dummy, 3-bit mode, 8-bit instruction - the fast read field layout
+static void decode_fast_read(const uint32_t v, const uint32_t lsb, const bool supported, SfdpFastRead *fr) {
+  if (! supported) return;
+  fr->dummy = field(v, lsb, 5u);
+  fr->mode = field(v, lsb + 5u, 3u);
+  fr->cmd = field(v, lsb + 8u, 8u);
+}
+
+// count:5 units:2, typical erase time for DW10
+static uint32_t erase_time_ms(const uint32_t v) {
+  constexpr uint32_t units[] = {1u, 16u, 128u, 1000u};
+  return (field(v, 0u, 5u) + 1u) * units[field(v, 5u, 2u)];
+}
+
+// count:5 units:2, suspend latency and deep power-down delay
+static uint32_t latency_ns(const uint32_t v) {
+  constexpr uint32_t units[] = {128u, 1000u, 8000u, 64000u};
+  return (field(v, 0u, 5u) + 1u) * units[field(v, 5u, 2u)];
+}
+
+bool decode_sfdp_basic(const uint32_t *dw, const size_t num_dw, SfdpBasicParams *params) {
+  if (nullptr == dw || nullptr == params || 9u > num_dw) return false;
+
+  // dw may be params->dw, hold on to the table before clearing.
+  uint32_t raw[kSfdpBasicMaxDw];
+  const size_t n = (kSfdpBasicMaxDw < num_dw) ? kSfdpBasicMaxDw : num_dw;
+  memset(raw, 0, sizeof(raw));
+  memcpy(raw, dw, n * sizeof(uint32_t));
+
+  SfdpRevInfo rev = params->rev;
+  memset(params, 0, sizeof(SfdpBasicParams));
+  params->rev = rev;
+  params->num_dw = n;
+  memcpy(params->dw, raw, sizeof(raw));
+
+  // DW1
+  uint32_t v = raw[0];
+  if (1u == field(v, 0u, 2u)) params->erase_4k_cmd = field(v, 8u, 8u);
+  params->wr_granularity_64 = field(v, 2u, 1u);
+  params->volatile_sr_protect = field(v, 3u, 1u);
+  params->volatile_wren_cmd = (field(v, 4u, 1u)) ? kWriteEnableCmd : kVolatileWriteEnableCmd;
+  params->address_bytes = field(v, 17u, 2u);
+  params->dtr = field(v, 19u, 1u);
+  const bool has_1_1_2 = field(v, 16u, 1u);
+  const bool has_1_2_2 = field(v, 20u, 1u);
+  const bool has_1_4_4 = field(v, 21u, 1u);
+  const bool has_1_1_4 = field(v, 22u, 1u);
+
+  // DW2
+  v = raw[1];
+  if (v & BIT31) {
+    // 2^N bits
+    const uint32_t n_bits = field(v, 0u, 31u);
+    if (35u <= n_bits) {
+      params->capacity = 0xFFFFFFFFu;
+    } else if (3u <= n_bits) {
+      params->capacity = 1u << (n_bits - 3u);
+    }
+  } else {
+    params->capacity = (v >> 3u) + 1u;
+  }
+
+  // DW3 - DW7
+  decode_fast_read(raw[2], 0u, has_1_4_4, &params->read_1_4_4);
+  decode_fast_read(raw[2], 16u, has_1_1_4, &params->read_1_1_4);
+  decode_fast_read(raw[3], 0u, has_1_1_2, &params->read_1_1_2);
+  decode_fast_read(raw[3], 16u, has_1_2_2, &params->read_1_2_2);
+  decode_fast_read(raw[5], 16u, field(raw[4], 0u, 1u), &params->read_2_2_2);
+  decode_fast_read(raw[6], 16u, field(raw[4], 4u, 1u), &params->read_4_4_4);
+
+  // DW8 - DW9, size is 2^N bytes, N == 0 not defined
+  for (size_t i = 0u; i < 4u; i++) {
+    v = raw[7u + i / 2u] >> ((i & 1u) * 16u);
+    const uint32_t n_size = field(v, 0u, 8u);
+    if (n_size) {
+      params->erase[i].size = 1u << n_size;
+      params->erase[i].cmd = field(v, 8u, 8u);
+    }
+  }
+
+  if (16u <= n) {
+    // DW10, max = 2 * (multiplier + 1) * typical
+    v = raw[9];
+    const uint32_t erase_mult = 2u * (field(v, 0u, 4u) + 1u);
+    for (size_t i = 0u; i < 4u; i++) {
+      if (0u == params->erase[i].size) continue;
+      params->erase[i].typ_ms = erase_time_ms(field(v, 4u + i * 7u, 7u));
+      params->erase[i].max_ms = erase_mult * params->erase[i].typ_ms;
+    }
+
+    // DW11
+    v = raw[10];
+    const uint32_t program_mult = 2u * (field(v, 0u, 4u) + 1u);
+    params->page_size = 1u << field(v, 4u, 4u);
+    params->page_program_typ_us = (field(v, 8u, 5u) + 1u) * ((field(v, 13u, 1u)) ? 64u : 8u);
+    params->page_program_max_us = program_mult * params->page_program_typ_us;
+    params->byte_program_first_typ_us = (field(v, 14u, 4u) + 1u) * ((field(v, 18u, 1u)) ? 8u : 1u);
+    params->byte_program_next_typ_us = (field(v, 19u, 4u) + 1u) * ((field(v, 23u, 1u)) ? 8u : 1u);
+    constexpr uint32_t chip_units[] = {16u, 256u, 4000u, 64000u};
+    params->chip_erase_typ_ms = (field(v, 24u, 5u) + 1u) * chip_units[field(v, 29u, 2u)];
+    params->chip_erase_max_ms = erase_mult * params->chip_erase_typ_ms;
+
+    // DW12 - DW13, bit 31 clear when supported
+    v = raw[11];
+    params->suspend_resume = (0u == field(v, 31u, 1u));
+    if (params->suspend_resume) {
+      params->program_suspend_prohibit = field(v, 0u, 4u);
+      params->erase_suspend_prohibit = field(v, 4u, 4u);
+      params->program_resume_to_suspend_us = (field(v, 9u, 4u) + 1u) * 64u;
+      params->program_suspend_latency_ns = latency_ns(field(v, 13u, 7u));
+      params->erase_resume_to_suspend_us = (field(v, 20u, 4u) + 1u) * 64u;
+      params->erase_suspend_latency_ns = latency_ns(field(v, 24u, 7u));
+      v = raw[12];
+      params->program_resume_cmd = field(v, 0u, 8u);
+      params->program_suspend_cmd = field(v, 8u, 8u);
+      params->resume_cmd = field(v, 16u, 8u);
+      params->suspend_cmd = field(v, 24u, 8u);
+    }
+
+    // DW14, bit 31 clear when supported
+    v = raw[13];
+    params->poll_flag_status = field(v, 2u, 1u);
+    params->poll_legacy_wip = field(v, 3u, 1u);
+    params->deep_power_down = (0u == field(v, 31u, 1u));
+    if (params->deep_power_down) {
+      params->dpd_exit_delay_ns = latency_ns(field(v, 8u, 7u));
+      params->dpd_exit_cmd = field(v, 15u, 8u);
+      params->dpd_enter_cmd = field(v, 23u, 8u);
+    }
+
+    // DW15
+    v = raw[14];
+    params->mode_4_4_4_disable = field(v, 0u, 4u);
+    params->mode_4_4_4_enable = field(v, 4u, 5u);
+    params->mode_0_4_4 = field(v, 9u, 1u);
+    params->mode_0_4_4_exit = field(v, 10u, 6u);
+    params->mode_0_4_4_entry = field(v, 16u, 4u);
+    params->qe_requirement = field(v, 20u, 3u);
+    params->hold_reset_disable = field(v, 23u, 1u);
+
+    // DW16
+    v = raw[15];
+    params->sr1_write_enable = field(v, 0u, 7u);
+    params->soft_reset = field(v, 8u, 6u);
+    params->exit_4b_addr = field(v, 14u, 10u);
+    params->enter_4b_addr = field(v, 24u, 8u);
+  }
+
+  if (20u <= n) {
+    // DW17, instruction 0 when not supported
+    decode_fast_read(raw[16], 0u, true, &params->read_1_1_8);
+    decode_fast_read(raw[16], 16u, true, &params->read_1_8_8);
+    // DW19
+    params->octal_enable_requirement = field(raw[18], 20u, 3u);
+    // DW20
+    params->max_speed_codes = raw[19];
+  }
+
+  if (23u <= n) {
+    // DW21 support bits, DW22 - DW23 DTR fast reads
+    v = raw[20];
+    decode_fast_read(raw[21], 0u, field(v, 0u, 1u), &params->read_1s_1d_1d);
+    decode_fast_read(raw[21], 16u, field(v, 1u, 1u), &params->read_1s_2d_2d);
+    decode_fast_read(raw[22], 0u, field(v, 2u, 1u), &params->read_1s_4d_4d);
+    decode_fast_read(raw[22], 16u, field(v, 3u, 1u), &params->read_4s_4d_4d);
+  }
+  return true;
+}
+
+bool get_sfdp_basic_params(SfdpBasicParams *params) {
+  if (nullptr == params) return false;
+
+  memset(params, 0, sizeof(SfdpBasicParams));
+  const size_t n = get_sfdp_basic_buf(&params->rev, params->dw, kSfdpBasicMaxDw);
+  return decode_sfdp_basic(params->dw, n, params);
+}
+
+};
@@ -0,0 +1,150 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  SFDP - JEDEC Basic Flash Parameter Table (BFPT) decoder
+
+  Decodes DW1 - DW23 of the Basic Flash Parameter Table, JESD216 through
+  JESD216F, into a caller-owned SfdpBasicParams. No heap allocation. The table
+  length, not the revision number, decides which DWs are decoded. Fields from
+  DWs beyond the table's length are left zero.
+
+  Conventions:
+    * An instruction value of 0 means not supported.
+    * Times are converted to plain units: ms for erase, us for program, and
+      ns for suspend and deep power-down latencies.
+    * Fields that are a JEDEC selection code, like qe_requirement, are kept
+      as the code. See the comment at each field.
+*/
+#ifndef SFDPBASIC_H
+#define SFDPBASIC_H
+
+#include "SfdpRevInfo.h"
+
+namespace experimental {
+
+constexpr size_t kSfdpBasicMaxDw = 23u;
+
+struct SfdpFastRead {
+  uint8_t cmd;                  // 0 = not supported
+  uint8_t dummy;                // wait state clocks
+  uint8_t mode;                 // mode bit clocks
+};
+
+struct SfdpEraseType {
+  uint32_t size;                // bytes, 0 = erase type not defined
+  uint32_t typ_ms;              // 0 when not given (JESD216 rev 1.0)
+  uint32_t max_ms;
+  uint8_t  cmd;
+};
+
+struct SfdpBasicParams {
+  SfdpRevInfo rev;
+  uint8_t  num_dw;              // DWs decoded, min(table size, kSfdpBasicMaxDw)
+
+  // DW1
+  uint8_t  erase_4k_cmd;        // 0 = no uniform 4KB erase
+  bool     wr_granularity_64;   // false = 1 byte, true = 64 bytes or larger
+  bool     volatile_sr_protect; // Block protect bits are volatile
+  uint8_t  volatile_wren_cmd;   // Write enable for volatile SR, 50h or 06h
+  uint8_t  address_bytes;       // 0 = 3-Byte only, 1 = 3 or 4-Byte, 2 = 4-Byte only
+  bool     dtr;                 // Some DTR clocking supported
+
+  // DW2
+  uint32_t capacity;            // bytes, saturates at 0xFFFFFFFF
+
+  // DW1, DW3 - DW7, DW17, DW21 - DW23
+  SfdpFastRead read_1_1_2;
+  SfdpFastRead read_1_2_2;
+  SfdpFastRead read_2_2_2;
+  SfdpFastRead read_1_1_4;
+  SfdpFastRead read_1_4_4;
+  SfdpFastRead read_4_4_4;
+  SfdpFastRead read_1_1_8;
+  SfdpFastRead read_1_8_8;
+  SfdpFastRead read_1s_1d_1d;
+  SfdpFastRead read_1s_2d_2d;
+  SfdpFastRead read_1s_4d_4d;
+  SfdpFastRead read_4s_4d_4d;
+
+  // DW8 - DW10, sizes and instructions, typical and max times
+  SfdpEraseType erase[4];
+
+  // DW10 - DW11
+  uint32_t page_size;           // bytes
+  uint32_t page_program_typ_us;
+  uint32_t page_program_max_us;
+  uint32_t byte_program_first_typ_us;
+  uint32_t byte_program_next_typ_us;
+  uint32_t chip_erase_typ_ms;
+  uint32_t chip_erase_max_ms;
+
+  // DW12 - DW13
+  bool     suspend_resume;
+  uint8_t  program_suspend_prohibit;  // bit mask, see JESD216 DW12
+  uint8_t  erase_suspend_prohibit;
+  uint32_t program_resume_to_suspend_us;
+  uint32_t program_suspend_latency_ns;
+  uint32_t erase_resume_to_suspend_us;
+  uint32_t erase_suspend_latency_ns;
+  uint8_t  program_resume_cmd;
+  uint8_t  program_suspend_cmd;
+  uint8_t  resume_cmd;
+  uint8_t  suspend_cmd;
+
+  // DW14
+  bool     poll_legacy_wip;     // Busy from Read Status 05h, bit 0
+  bool     poll_flag_status;    // Busy from Read Flag Status 70h, bit 7
+  bool     deep_power_down;
+  uint8_t  dpd_enter_cmd;
+  uint8_t  dpd_exit_cmd;
+  uint32_t dpd_exit_delay_ns;
+
+  // DW15
+  uint8_t  qe_requirement;      // QER, 0 = no QE bit, 1 - 6 QE bit location and write method
+  bool     hold_reset_disable;  // HOLD or RESET disable bit in a Status Register
+  uint8_t  mode_4_4_4_enable;   // bit mask of enable methods
+  uint8_t  mode_4_4_4_disable;  // bit mask of disable methods
+  bool     mode_0_4_4;          // Continuous read mode supported
+  uint8_t  mode_0_4_4_entry;
+  uint8_t  mode_0_4_4_exit;
+
+  // DW16
+  uint8_t  sr1_write_enable;    // bit mask, volatile/non-volatile SR1 methods
+  uint8_t  soft_reset;          // bit mask, 0x10 = 66h 99h sequence
+  uint16_t exit_4b_addr;        // bit mask of methods
+  uint8_t  enter_4b_addr;       // bit mask of methods
+
+  // DW19
+  uint8_t  octal_enable_requirement;
+
+  // DW20, maximum operation speed codes, 0xF = not supported
+  uint32_t max_speed_codes;
+
+  // Raw table, DW1 is dw[0]
+  uint32_t dw[kSfdpBasicMaxDw];
+};
+
+extern "C" {
+  // Decode num_dw words of a BFPT in dw. dw may point to params->dw.
+  // Returns false when num_dw is less than the 9 DWs of JESD216 rev 1.0.
+  bool decode_sfdp_basic(const uint32_t *dw, const size_t num_dw, SfdpBasicParams *params);
+
+  // Read the SFDP header, the first Parameter Header, and BFPT into
+  // params->dw, then decode. Returns false when SFDP is not supported.
+  bool get_sfdp_basic_params(SfdpBasicParams *params);
+}
+};
+#endif // SFDPBASIC_H
@@ -34,7 +34,7 @@ SfdpRevInfo get_sfdp_revision() {
   size_t sz = sizeof(sfdp_hdr);
   size_t addr = 0u;
   SpiOpResult ok0 = spi0_flash_read_sfdp(addr, &sfdp_hdr.u32[0], sz);
-  if (SPI_RESULT_OK == ok0 && 0x50444653 == sfdp_hdr.signature) {
+  if (SPI_RESULT_OK == ok0 && kSfdpSignature == sfdp_hdr.signature) {
     rev.hdr_major = sfdp_hdr.rev_major;
     rev.hdr_minor = sfdp_hdr.rev_minor;
     rev.num_parm_hdrs = sfdp_hdr.num_parm_hdrs;
@@ -55,19 +55,39 @@ SfdpRevInfo get_sfdp_revision() {
   return rev;
 }
 
+// Read up to dw_cnt DWs of a sz_dw table, zero the rest of dw
+static size_t read_param_table(const uint32_t tbl_ptr, const size_t sz_dw, uint32_t *dw, const size_t dw_cnt) {
+  if (nullptr == dw || 0u == dw_cnt) return 0u;
+
+  memset(dw, 0, dw_cnt * sizeof(uint32_t));
+  const size_t n = (sz_dw < dw_cnt) ? sz_dw : dw_cnt;
+  if (0u == tbl_ptr || 0u == n) return 0u;
+
+  if (SPI_RESULT_OK == spi0_flash_read_sfdp(tbl_ptr, dw, n * sizeof(uint32_t))) {
+    return n;
+  }
+  memset(dw, 0, n * sizeof(uint32_t));
+  return 0u;
+}
+
+size_t get_sfdp_basic_buf(SfdpRevInfo *rev, uint32_t *dw, const size_t dw_cnt) {
+  SfdpRevInfo local;
+  if (nullptr == rev) rev = &local;
+
+  *rev = get_sfdp_revision();
+  return read_param_table(rev->tbl_ptr, rev->sz_dw, dw, dw_cnt);
+}
+
 uint32_t* get_sfdp_basic(SfdpRevInfo *rev) {
   if (nullptr == rev) return nullptr;
 
   *rev = get_sfdp_revision();
   if (0u == rev->tbl_ptr) return nullptr;
 
-  size_t addr = rev->tbl_ptr;
-  size_t sz = rev->sz_dw * 4u;
-  uint32_t* dw = (uint32_t*)malloc(sz);
+  uint32_t* dw = (uint32_t*)malloc(rev->sz_dw * 4u);
   if (nullptr == dw) return nullptr;
 
-  memset(dw, 0, sz);
-  if (SPI_RESULT_OK == spi0_flash_read_sfdp(addr, dw, sz)) {
+  if (read_param_table(rev->tbl_ptr, rev->sz_dw, dw, rev->sz_dw)) {
     return dw;
   }
 
@@ -75,4 +95,63 @@ uint32_t* get_sfdp_basic(SfdpRevInfo *rev) {
   return nullptr;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Parameter Header walk
+//
+// Headers follow the 8 byte SFDP header, 8 bytes each. Only the ones inside
+// kSfdpMaxSz are visited.
+
+static bool read_param_header(SfdpParamIter *it) {
+  if (it->index >= it->count) return false;
+
+  const uint32_t addr = sizeof(SfdpHdr) + it->index * sizeof(SfdpParam);
+  return SPI_RESULT_OK == spi0_flash_read_sfdp(addr, &it->param.u32[0], sizeof(SfdpParam));
+}
+
+bool sfdp_param_first(SfdpParamIter *it) {
+  if (nullptr == it) return false;
+
+  memset(it, 0, sizeof(SfdpParamIter));
+  SfdpHdr sfdp_hdr;
+  SpiOpResult ok0 = spi0_flash_read_sfdp(0u, &sfdp_hdr.u32[0], sizeof(sfdp_hdr));
+  if (SPI_RESULT_OK != ok0 || kSfdpSignature != sfdp_hdr.signature) return false;
+
+  const size_t count = sfdp_hdr.num_parm_hdrs + 1u;  // zero-based field
+  it->count = (kSfdpMaxParamHdrs < count) ? kSfdpMaxParamHdrs : count;
+  if (read_param_header(it)) return true;
+
+  it->count = 0u;
+  return false;
+}
+
+bool sfdp_param_next(SfdpParamIter *it) {
+  if (nullptr == it || it->index >= it->count) return false;
+
+  it->index++;
+  if (read_param_header(it)) return true;
+
+  it->index = it->count;
+  return false;
+}
+
+size_t sfdp_param_read(const SfdpParamIter *it, uint32_t *dw, const size_t dw_cnt) {
+  if (nullptr == it || it->index >= it->count) {
+    if (dw && dw_cnt) memset(dw, 0, dw_cnt * sizeof(uint32_t));
+    return 0u;
+  }
+  return read_param_table(it->param.tbl_ptr, it->param.sz_dw, dw, dw_cnt);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// SFDP image
+bool sfdp_image_read(SfdpImage *img) {
+  if (nullptr == img) return false;
+
+  SpiOpResult ok0 = spi0_flash_read_sfdp(0u, &img->dw[0], sizeof(SfdpImage));
+  if (SPI_RESULT_OK == ok0 && img->valid()) return true;
+
+  memset(img, 0, sizeof(SfdpImage));
+  return false;
+}
+
 };
@@ -80,9 +80,114 @@ union SFDP_Basic_2dw {
   uint32_t u32[2];
 };
 
+// The parameter tables this library reads are in the first 256 bytes of the
+// SFDP space.
+constexpr size_t kSfdpMaxSz = 256u;
+constexpr size_t kSfdpMaxDw = kSfdpMaxSz / sizeof(uint32_t);
+constexpr uint16_t kSfdpBasicParamId = 0xFF00u;  // JEDEC Basic Flash Parameter Table
+constexpr uint32_t kSfdpSignature = 0x50444653u;  // "SFDP"
+// Parameter Headers that fit after the SFDP header
+constexpr size_t kSfdpMaxParamHdrs = (kSfdpMaxSz - sizeof(SfdpHdr)) / sizeof(SfdpParam);
+
+// The SFDP space, read once. The accessors return pointers into the image,
+// nothing is copied or read from the flash again.
+union SfdpImage {
+  struct {
+    SfdpHdr hdr;
+    SfdpParam param[kSfdpMaxParamHdrs];
+  };
+  uint32_t dw[kSfdpMaxDw];
+
+  bool valid() const { return kSfdpSignature == hdr.signature; }
+  // Parameter Headers in the image, 0 without SFDP
+  size_t num_params() const {
+    if (! valid()) return 0u;
+    const size_t n = hdr.num_parm_hdrs + 1u;  // zero-based field
+    return (kSfdpMaxParamHdrs < n) ? kSfdpMaxParamHdrs : n;
+  }
+  // Parameter table i, clipped to the image. *num_dw is set to the DWs
+  // available. nullptr when i is out of range or the table is not in the image.
+  const uint32_t* table(const size_t i, size_t *num_dw) const {
+    if (num_dw) *num_dw = 0u;
+    if (i >= num_params()) return nullptr;
+    const uint32_t ptr = param[i].tbl_ptr;
+    if ((ptr & 3u) || kSfdpMaxSz <= ptr) return nullptr;
+    const size_t avail = (kSfdpMaxSz - ptr) / sizeof(uint32_t);
+    if (num_dw) *num_dw = (param[i].sz_dw < avail) ? param[i].sz_dw : avail;
+    return &dw[ptr / sizeof(uint32_t)];
+  }
+};
+static_assert(kSfdpMaxSz == sizeof(SfdpImage), "SfdpImage is the SFDP space");
+
+// Parameter Header walk, one 8 byte header is read per step. Lives on the
+// caller's stack, safe from preinit().
+struct SfdpParamIter {
+  SfdpParam param;              // current Parameter Header
+  uint8_t index;                // 0 is the BFPT header
+  uint8_t count;                // Parameter Headers, 0 without SFDP
+  uint16_t id() const { return ((uint16_t)param.id_msb << 8u) | param.id_lsb; }
+};
+
 extern "C" {
   SfdpRevInfo get_sfdp_revision();
+
+  // Read the first parameter table into dw, at most dw_cnt DWs. Unused DWs of
+  // dw are zeroed. *rev is filled in as get_sfdp_revision(). Returns the DWs
+  // read, 0 when SFDP is not supported. No heap.
+  size_t get_sfdp_basic_buf(SfdpRevInfo *rev, uint32_t *dw, const size_t dw_cnt);
+
+  // Uses malloc, the caller must free the result. Not for preinit(), use
+  // get_sfdp_basic_buf() or get_sfdp_table().
   uint32_t* get_sfdp_basic(SfdpRevInfo *rev);
+
+  // Start at the first Parameter Header. Returns false without SFDP.
+  bool sfdp_param_first(SfdpParamIter *it);
+  // Step to the next Parameter Header. Returns false past the last one.
+  bool sfdp_param_next(SfdpParamIter *it);
+  // Read the current header's table into dw, as get_sfdp_basic_buf().
+  size_t sfdp_param_read(const SfdpParamIter *it, uint32_t *dw, const size_t dw_cnt);
+
+  // Read the SFDP space into *img, kSpi0ReadMaxSz bytes per transfer. Returns
+  // false, with *img zeroed, without SFDP.
+  bool sfdp_image_read(SfdpImage *img);
+}
+
+// Templates, kept C++ for includers inside an extern "C" block, eg. TestFlashQE
+extern "C++" {
+
+// Fixed capacity DW table in the style of std::array. N is checked at compile
+// time against the SFDP maximum. Reads past the table return 0, the value
+// JESD216 gives a field the part does not report.
+template <size_t N = kSfdpMaxDw>
+struct SfdpDwArray {
+  static_assert(0u < N && N <= kSfdpMaxDw, "SfdpDwArray is limited to the 256 byte SFDP space");
+
+  SfdpRevInfo rev;
+  size_t count;                 // DWs read, 0 without SFDP
+  uint32_t dw[N];               // DW1 is dw[0]
+
+  static constexpr size_t capacity() { return N; }
+  size_t size() const { return count; }
+  bool empty() const { return 0u == count; }
+  const uint32_t* data() const { return dw; }
+  const uint32_t* begin() const { return dw; }
+  const uint32_t* end() const { return dw + count; }
+  uint32_t operator[](const size_t i) const { return (i < count) ? dw[i] : 0u; }
+};
+
+// The whole 1st parameter table, 268 bytes on the ESP8266. Keep it on the
+// stack or static.
+using SfdpTable = SfdpDwArray<kSfdpMaxDw>;
+static_assert(sizeof(SfdpRevInfo) + sizeof(size_t) + kSfdpMaxSz == sizeof(SfdpTable), "SfdpTable size changed, check its comment");
+
+// Fill table from the first parameter table. Returns false without SFDP.
+template <size_t N>
+inline bool get_sfdp_table(SfdpDwArray<N> *table) {
+  if (nullptr == table) return false;
+  table->count = get_sfdp_basic_buf(&table->rev, table->dw, N);
+  return ! table->empty();
 }
+
+}  // extern "C++"
 };
 #endif // FLASH_CHIP_ID_H
@@ -0,0 +1,68 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  SPI0 wire-time cost model
+*/
+#include <Arduino.h>
+
+extern "C" {
+
+#include "SpiFlashUtils.h"
+
+namespace experimental {
+
+#if SPI_FLASH_COST
+SpiFlashCost spi0_flash_cost __attribute__((section(".noinit")));
+#endif
+
+uint32_t spi0_flash_mhz() {
+  // Load the first 4 byte from flash (magic byte + flash config)
+  uint32_t data = *(uint32_t *)0x42000000u;
+  // 32-bit reference to trick compiler out of optimizing 32-bit access to 8-bit
+  asm volatile ( "" : "+ar"(data) ::);
+  return spi_flash_mhz_from_header(data);
+}
+
+SpiIoMode spi0_io_mode() {
+  const uint32_t spic = SPI0C;
+  if (spic & SPICQIO) return kSpiIoQio;
+  if (spic & SPICDIO) return kSpiIoDio;
+  if (spic & SPICQOUT) return kSpiIoQout;
+  if (spic & SPICDOUT) return kSpiIoDout;
+  if (spic & SPICFASTRD) return kSpiIoFast;
+  return kSpiIoSlow;
+}
+
+SpiCostReport spi_flash_cost_report(const SpiFlashCost& c, uint32_t mhz, const uint32_t nv_write_us) {
+  if (0u == mhz) mhz = spi0_flash_mhz();
+  constexpr uint32_t cpu_mhz = F_CPU / 1000000u;
+  const uint64_t overhead_cycles =
+    (uint64_t)c.windows * SPI_FLASH_COST_WINDOW_CYCLES +
+    (uint64_t)c.xfers * SPI_FLASH_COST_XFER_CYCLES;
+
+  SpiCostReport r;
+  r.xfers = c.xfers;
+  r.windows = c.windows;
+  r.bus_ns = (mhz) ? (uint32_t)(((uint64_t)c.clocks * 1000u + mhz - 1u) / mhz) : 0u;
+  r.overhead_ns = (uint32_t)(overhead_cycles * 1000u / cpu_mhz);
+  r.cache_off_ns = r.bus_ns + r.overhead_ns +
+    (uint32_t)(((uint64_t)c.nv_writes * nv_write_us + c.wait_us) * 1000u);
+  return r;
+}
+
+};  // namespace experimental
+
+};
@@ -0,0 +1,269 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  SPI0 wire-time cost model
+
+  Each helper in SpiFlashUtils.h hides some bus traffic. Every SPI0Command
+  call is its own iCache disabled window with a Wait_SPI_Idle() status read
+  before and an SPI_read_status() after. A volatile Status Register write
+  sends a Write Disable first. A non-volatile write holds the window open
+  while the part is busy. This puts numbers on it, so flash traffic can be
+  budgeted against a real-time loop.
+
+  Two parts:
+
+  1. Wire time. spi_wire_clocks() counts the SPI clocks for an instruction,
+     address, dummy, and data phase in a given I/O mode. Library flash
+     instructions always run 1-1-1, SPI0Command and spi0_flash_sequence()
+     clear the mode bits. The iCache uses the mode in SPI0C, see
+     spi0_io_mode() and spi_icache_line_ns().
+
+  2. Recording. Build with -DSPI_FLASH_COST=1 and the library instructions
+     add their clocks, transactions, and windows to spi0_flash_cost. Take a
+     copy before a call sequence, and pass it to spi0_flash_cost_since()
+     after. spi_flash_cost_report() turns the counts into bus time,
+     controller overhead, and cache-disabled time. Without SPI_FLASH_COST the
+     SPI_FLASH_COST_* hooks compile to nothing. The spi_flash_cost_*()
+     functions still work on a caller's SpiFlashCost, to estimate a sequence
+     without running it.
+
+  Status reads assume WIP is clear. A BootROM status read that spins on WIP
+  is one transaction here. Non-volatile writes are counted separately, the
+  report adds the part's write time, tW, for each one.
+
+  The controller overhead is an estimate in CPU cycles, see
+  SPI_FLASH_COST_WINDOW_CYCLES and SPI_FLASH_COST_XFER_CYCLES. Calibrate them
+  against the "BootTimeline" example on the part in hand.
+*/
+#ifndef EXPERIMENTAL_SPIFLASHCOST_H
+#define EXPERIMENTAL_SPIFLASHCOST_H
+
+#if ((1 - SPI_FLASH_COST - 1) == 2)
+#undef SPI_FLASH_COST
+#define SPI_FLASH_COST 1
+#endif
+
+// Per iCache disable window: Cache_Read_Disable_2/Cache_Read_Enable_2, the
+// interrupt disable, and saving and restoring the SPI0 registers.
+#ifndef SPI_FLASH_COST_WINDOW_CYCLES
+#define SPI_FLASH_COST_WINDOW_CYCLES 400u
+#endif
+
+// Per transaction: loading SPI0U, SPI0U1, SPI0U2, starting SPI0CMD, and the
+// chip select setup and hold.
+#ifndef SPI_FLASH_COST_XFER_CYCLES
+#define SPI_FLASH_COST_XFER_CYCLES 40u
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+namespace experimental {
+
+////////////////////////////////////////////////////////////////////////////////
+// Wire time
+//
+// Flash read modes, as selected in SPI0C. Named by lanes used for
+// instruction-address-data.
+enum SpiIoMode : uint8_t {
+  kSpiIoSlow = 0u,  // 1-1-1, 03h, no dummy
+  kSpiIoFast,       // 1-1-1, 0Bh
+  kSpiIoDout,       // 1-1-2, 3Bh
+  kSpiIoDio,        // 1-2-2, BBh
+  kSpiIoQout,       // 1-1-4, 6Bh
+  kSpiIoQio,        // 1-4-4, EBh
+};
+
+struct SpiWireShape {
+  uint16_t cmd_bits;        // Instruction, always one lane
+  uint16_t addr_bits;
+  uint16_t dummy_clocks;    // Clocks, not bits. Includes mode bits.
+  uint16_t mosi_bits;       // Data out
+  uint16_t miso_bits;       // Data in
+};
+
+constexpr uint32_t spi_addr_lanes(const SpiIoMode mode) {
+  return (kSpiIoQio == mode) ? 4u : (kSpiIoDio == mode) ? 2u : 1u;
+}
+
+constexpr uint32_t spi_data_lanes(const SpiIoMode mode) {
+  return (kSpiIoQio == mode || kSpiIoQout == mode) ? 4u
+       : (kSpiIoDio == mode || kSpiIoDout == mode) ? 2u : 1u;
+}
+
+// SPI clocks for one transaction, chip select overhead not included
+constexpr uint32_t spi_wire_clocks(const SpiWireShape& s, const SpiIoMode mode) {
+  return s.cmd_bits
+       + (s.addr_bits + spi_addr_lanes(mode) - 1u) / spi_addr_lanes(mode)
+       + s.dummy_clocks
+       + (s.mosi_bits + spi_data_lanes(mode) - 1u) / spi_data_lanes(mode)
+       + (s.miso_bits + spi_data_lanes(mode) - 1u) / spi_data_lanes(mode);
+}
+
+constexpr uint32_t spi_clocks_to_ns(const uint32_t clocks, const uint32_t mhz) {
+  return (mhz) ? (clocks * 1000u + mhz - 1u) / mhz : 0u;
+}
+
+constexpr uint32_t spi_wire_ns(const SpiWireShape& s, const SpiIoMode mode, const uint32_t mhz) {
+  return spi_clocks_to_ns(spi_wire_clocks(s, mode), mhz);
+}
+
+// Memory mapped read as the flash controller issues it for each mode. Dummy
+// clocks are the common defaults: 8 for 0Bh, 3Bh, and 6Bh, 4 for BBh (mode
+// bits included), 6 for EBh (mode bits included).
+constexpr SpiWireShape spi_read_shape(const SpiIoMode mode, const uint32_t bytes) {
+  return SpiWireShape{
+    8u, 24u,
+    (uint16_t)((kSpiIoSlow == mode) ? 0u : (kSpiIoDio == mode) ? 4u : (kSpiIoQio == mode) ? 6u : 8u),
+    0u, (uint16_t)(bytes * 8u)
+  };
+}
+
+// An iCache miss fills one 32 byte line
+constexpr uint32_t kICacheLineSz = 32u;
+
+constexpr uint32_t spi_icache_line_ns(const SpiIoMode mode, const uint32_t mhz) {
+  return spi_wire_ns(spi_read_shape(mode, kICacheLineSz), mode, mhz);
+}
+
+// Decode the SPI speed field of the image header, the first 32 bits of flash.
+// Returns MHz, 0 for an unknown setting.
+constexpr uint32_t spi_flash_mhz_from_header(const uint32_t word0) {
+  return (0x00u == ((word0 >> 24u) & 0x0Fu)) ? 40u
+       : (0x01u == ((word0 >> 24u) & 0x0Fu)) ? 26u
+       : (0x02u == ((word0 >> 24u) & 0x0Fu)) ? 20u
+       : (0x0Fu == ((word0 >> 24u) & 0x0Fu)) ? 80u : 0u;
+}
+
+// SPI clock from the image header, same as get_flash_mhz() in the
+// "OutlineXMC" example.
+uint32_t spi0_flash_mhz();
+
+// Read mode the iCache uses, from SPI0C
+SpiIoMode spi0_io_mode();
+
+////////////////////////////////////////////////////////////////////////////////
+// Recording
+//
+// Counts for a call sequence. Clocks are 1-1-1 user command clocks, the
+// BootROM status reads included.
+struct SpiFlashCost {
+  uint32_t xfers;           // Chip selects, prefix instructions and status reads included
+  uint32_t clocks;          // SPI clocks
+  uint32_t windows;         // iCache disable windows
+  uint32_t nv_writes;       // Status Register writes prefixed by 06h, each holds its window open for tW
+  uint32_t wait_us;         // Fixed delays inside a window, eg. tRST after 66h 99h
+};
+
+// BootROM SPI_read_status(): 05h and 8 bits back, WIP clear
+constexpr uint32_t kSpiRdsrClocks = 16u;
+
+inline __attribute__((always_inline))
+void spi_flash_cost_xfer(SpiFlashCost& c, const uint32_t mosi_bits, const uint32_t miso_bits) {
+  c.xfers++;
+  c.clocks += 8u + mosi_bits + miso_bits;
+}
+
+// A window and the BootROM status reads around it
+inline __attribute__((always_inline))
+void spi_flash_cost_window(SpiFlashCost& c, const uint32_t status_reads) {
+  c.windows++;
+  c.xfers += status_reads;
+  c.clocks += status_reads * kSpiRdsrClocks;
+}
+
+inline __attribute__((always_inline))
+void spi_flash_cost_status_read(SpiFlashCost& c) {
+  c.xfers++;
+  c.clocks += kSpiRdsrClocks;
+}
+
+// A prefix instruction for cmd. 06h before a Status Register write, 01h, 31h,
+// or 11h, counts as a non-volatile write. Program and erase, eg. 42h 44h, poll
+// WIP instead.
+inline __attribute__((always_inline))
+void spi_flash_cost_prefix(SpiFlashCost& c, const uint32_t cmd, const uint32_t pre_cmd) {
+  spi_flash_cost_xfer(c, 0u, 0u);
+  if (0x06u == pre_cmd && (0x01u == cmd || 0x31u == cmd || 0x11u == cmd)) c.nv_writes++;
+}
+
+// One SPI0Command call: Wait_SPI_Idle, optional prefix, the instruction, and
+// the trailing SPI_read_status. pre_cmd is SPI_FLASH_CMD_NOT_USED or 0 for
+// none.
+inline __attribute__((always_inline))
+void spi_flash_cost_command(SpiFlashCost& c, const uint32_t cmd, const uint32_t mosi_bits, const uint32_t miso_bits, const uint32_t pre_cmd) {
+  spi_flash_cost_window(c, 2u);
+  if (pre_cmd && 0xFFFFFFFFu != pre_cmd) spi_flash_cost_prefix(c, cmd, pre_cmd);
+  spi_flash_cost_xfer(c, mosi_bits, miso_bits);
+}
+
+struct SpiCostReport {
+  uint32_t xfers;
+  uint32_t windows;
+  uint32_t bus_ns;          // Wire time, all clocks at the SPI clock
+  uint32_t overhead_ns;     // Controller and window overhead, estimated
+  uint32_t cache_off_ns;    // bus_ns + overhead_ns + WIP waits and fixed delays
+};
+
+// mhz - SPI clock, 0 uses spi0_flash_mhz()
+// nv_write_us - the part's Status Register write time, tW, per non-volatile write
+SpiCostReport spi_flash_cost_report(const SpiFlashCost& c, uint32_t mhz = 0u, const uint32_t nv_write_us = 0u);
+
+#if SPI_FLASH_COST
+// Counts since power on. Lives in .noinit, used from preinit(). Zero with
+// spi0_flash_cost_reset().
+extern SpiFlashCost spi0_flash_cost;
+
+inline
+void spi0_flash_cost_reset() {
+  spi0_flash_cost = SpiFlashCost{};
+}
+
+// Counts since a copy of spi0_flash_cost taken before the call sequence
+inline
+SpiFlashCost spi0_flash_cost_since(const SpiFlashCost& mark) {
+  SpiFlashCost d;
+  d.xfers     = spi0_flash_cost.xfers     - mark.xfers;
+  d.clocks    = spi0_flash_cost.clocks    - mark.clocks;
+  d.windows   = spi0_flash_cost.windows   - mark.windows;
+  d.nv_writes = spi0_flash_cost.nv_writes - mark.nv_writes;
+  d.wait_us   = spi0_flash_cost.wait_us   - mark.wait_us;
+  return d;
+}
+
+#define SPI_FLASH_COST_COMMAND(cmd, mosi, miso, pre) spi_flash_cost_command(spi0_flash_cost, (cmd), (mosi), (miso), (pre))
+#define SPI_FLASH_COST_WINDOW(reads) spi_flash_cost_window(spi0_flash_cost, (reads))
+#define SPI_FLASH_COST_STATUS_READ() spi_flash_cost_status_read(spi0_flash_cost)
+#define SPI_FLASH_COST_PREFIX(cmd, pre) spi_flash_cost_prefix(spi0_flash_cost, (cmd), (pre))
+#define SPI_FLASH_COST_XFER(mosi, miso) spi_flash_cost_xfer(spi0_flash_cost, (mosi), (miso))
+#define SPI_FLASH_COST_WAIT_US(us) (spi0_flash_cost.wait_us += (us))
+#else
+#define SPI_FLASH_COST_COMMAND(cmd, mosi, miso, pre) do {} while (false)
+#define SPI_FLASH_COST_WINDOW(reads) do {} while (false)
+#define SPI_FLASH_COST_STATUS_READ() do {} while (false)
+#define SPI_FLASH_COST_PREFIX(cmd, pre) do {} while (false)
+#define SPI_FLASH_COST_XFER(mosi, miso) do {} while (false)
+#define SPI_FLASH_COST_WAIT_US(us) do {} while (false)
+#endif
+
+};  // namespace experimental
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EXPERIMENTAL_SPIFLASHCOST_H
@@ -0,0 +1,116 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+////////////////////////////////////////////////////////////////////////////////
+// Deferred debug log, see SpiFlashLog.h
+//
+#include <Arduino.h>
+#include <coredecls.h>        // crc32()
+#include <user_interface.h>   // system_get_cpu_freq()
+#include "SpiFlashUtils.h"    // spi_flash_hex_line()
+#include "SpiFlashLog.h"
+
+namespace experimental {
+
+#if DEBUG_FLASH_QE_DEFERRED
+// Used from preinit() with RECLAIM_GPIO_EARLY, keep out of .bss
+SfuLog sfu_log_buf __attribute__((section(".noinit")));
+
+void sfu_log_reset() {
+  sfu_log_buf.magic = kSfuLogMagic;
+  sfu_log_buf.entries = 0u;
+  sfu_log_buf.words = 0u;
+  sfu_log_buf.dropped = 0u;
+}
+
+void sfu_log_words(const char *fmt, const SfuLogWord *args, size_t n) {
+  const uint32_t now = esp_get_cycle_count();
+  if (kSfuLogArgsMax < n) n = kSfuLogArgsMax;
+  if (kSfuLogMagic != sfu_log_buf.magic) sfu_log_reset();
+
+  const uint32_t at = sfu_log_buf.words;
+  if (kSfuLogWords - at < kSfuLogEntryHdr + n) {
+    sfu_log_buf.dropped++;
+    return;
+  }
+  SfuLogWord *w = &sfu_log_buf.w[at];
+  w[kSfuLogFmt] = (SfuLogWord)fmt;
+  w[kSfuLogCycles] = now;
+  w[kSfuLogNargs] = n;
+  for (size_t i = 0u; i < n; i++) w[kSfuLogEntryHdr + i] = args[i];
+  sfu_log_buf.words = at + kSfuLogEntryHdr + n;
+  sfu_log_buf.entries++;
+}
+
+// Entry i, nullptr past the end
+static const SfuLogWord *entry(const size_t i) {
+  if (kSfuLogMagic != sfu_log_buf.magic || i >= sfu_log_buf.entries) return nullptr;
+  uint32_t at = 0u;
+  for (size_t k = 0u; k < i && at < sfu_log_buf.words; k++) {
+    at += kSfuLogEntryHdr + sfu_log_buf.w[at + kSfuLogNargs];
+  }
+  return (at < sfu_log_buf.words) ? &sfu_log_buf.w[at] : nullptr;
+}
+
+static size_t entry_words(const SfuLogWord *w) {
+  return kSfuLogEntryHdr + w[kSfuLogNargs];
+}
+
+size_t sfu_log_snapshot(SfuLogDumpHdr *hdr) {
+  if (nullptr == hdr) return 0u;
+  memset(hdr, 0, sizeof(SfuLogDumpHdr));
+  hdr->magic = kSfuLogMagic;
+  hdr->version = kSfuLogVersion;
+  hdr->size = sizeof(SfuLogDumpHdr);
+  hdr->word_size = sizeof(SfuLogWord);
+  hdr->cpu_mhz = system_get_cpu_freq();
+  if (kSfuLogMagic == sfu_log_buf.magic) {
+    hdr->entries = sfu_log_buf.entries;
+    hdr->words = sfu_log_buf.words;
+    hdr->dropped = sfu_log_buf.dropped;
+  }
+  uint32_t crc = crc32(hdr, offsetof(SfuLogDumpHdr, crc));
+  if (hdr->words) crc = crc32(sfu_log_buf.w, hdr->words * sizeof(SfuLogWord), crc);
+  hdr->crc = crc;
+  return hdr->entries;
+}
+
+size_t sfu_log_format(const size_t i, char *buf, const size_t sz) {
+  const SfuLogWord *w = entry(i);
+  if (nullptr == w || nullptr == buf || 0u == sz) return 0u;
+
+  // Unused arguments are passed and ignored, as printf allows
+  SfuLogWord a[kSfuLogArgsMax] = {};
+  const size_t n = w[kSfuLogNargs];
+  for (size_t k = 0u; k < n && k < kSfuLogArgsMax; k++) a[k] = w[kSfuLogEntryHdr + k];
+  int len = snprintf_P(buf, sz, (const char *)w[kSfuLogFmt], a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]);
+  if (0 > len) return 0u;
+  return ((size_t)len < sz) ? len : sz - 1u;
+}
+
+size_t sfu_log_line(const size_t i, char *buf, const size_t sz) {
+  if (nullptr == buf || kSfuLogLineSz > sz) return 0u;
+  if (0u == i) {
+    SfuLogDumpHdr hdr;
+    sfu_log_snapshot(&hdr);
+    return spi_flash_hex_line("SFL1:", &hdr, sizeof(hdr), buf);
+  }
+  const SfuLogWord *w = entry(i - 1u);
+  if (nullptr == w) return 0u;
+  return spi_flash_hex_line("SFE1:", w, entry_words(w) * sizeof(SfuLogWord), buf);
+}
+#endif
+
+};  // namespace experimental
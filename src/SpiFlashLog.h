@@ -0,0 +1,148 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Deferred debug log - DBG_SFU_PRINTF without the UART
+
+  Build with -DDEBUG_FLASH_QE=1 -DDEBUG_FLASH_QE_DEFERRED=1. Each
+  DBG_SFU_PRINTF stores its format string address, the CPU cycle count, and
+  its arguments as raw words in a .noinit buffer. Nothing is formatted or
+  printed. With RECLAIM_GPIO_EARLY, reclaim_GPIO_9_10() also skips the UART
+  switch and the 12 ms wait for the TX FIFO, so a debug build reclaims from
+  preinit() in about the time a release build does.
+
+  reclaim_GPIO_9_10() starts the log over. Print it later from setup(), or
+  whenever, with sfu_log_format(). The format strings are read from flash
+  when printed, so the log must be printed by the build that recorded it.
+
+  A %s argument is stored as its address, the same as a printf call would
+  get. The library only passes string literals.
+
+  When the buffer is full, later messages are dropped and counted. At about
+  4 words a message, the default holds 60 or so, enough for one reclaim.
+
+  A dump is a header and the raw entries, little-endian. As text, the header
+  is a line "SFL1:" and each entry a line "SFE1:", in hex. tools/sfulog
+  decodes them with the .elf of the build, the format string addresses are
+  the message IDs. It includes this header for the layout.
+*/
+#ifndef EXPERIMENTAL_SPIFLASHLOG_H
+#define EXPERIMENTAL_SPIFLASHLOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if ((1 - DEBUG_FLASH_QE_DEFERRED - 1) == 2)
+#undef DEBUG_FLASH_QE_DEFERRED
+#define DEBUG_FLASH_QE_DEFERRED 1
+#endif
+
+// Buffer size in words, 4 bytes each on the ESP8266
+#ifndef DEBUG_FLASH_QE_LOG_WORDS
+#define DEBUG_FLASH_QE_LOG_WORDS 256u
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+namespace experimental {
+
+constexpr uint32_t kSfuLogMagic = 0x314C4653u;    // "SFL1"
+constexpr uint8_t kSfuLogVersion = 1u;
+constexpr uint32_t kSfuLogWords = DEBUG_FLASH_QE_LOG_WORDS;
+constexpr size_t kSfuLogArgsMax = 8u;
+
+// A pointer or an int, 32 bits on the ESP8266. The host tools run 64 bit.
+typedef uintptr_t SfuLogWord;
+
+// An entry is kSfuLogEntryHdr words, then the arguments
+enum SfuLogEntryWord : uint8_t {
+  kSfuLogFmt = 0u,        // Format string address
+  kSfuLogCycles,          // esp_get_cycle_count()
+  kSfuLogNargs,
+  kSfuLogEntryHdr
+};
+
+// The buffer, in .noinit
+struct SfuLog {
+  uint32_t magic;         // kSfuLogMagic
+  uint32_t entries;
+  uint32_t words;         // Used
+  uint32_t dropped;       // Messages that did not fit
+  SfuLogWord w[kSfuLogWords];
+};
+
+struct SfuLogDumpHdr {
+  uint32_t magic;         // kSfuLogMagic
+  uint8_t  version;       // kSfuLogVersion
+  uint8_t  size;          // sizeof(SfuLogDumpHdr)
+  uint8_t  word_size;     // sizeof(SfuLogWord)
+  uint8_t  cpu_mhz;       // For the cycle counts
+  uint32_t entries;
+  uint32_t words;
+  uint32_t dropped;
+  uint32_t crc;           // crc32() of the bytes above, then the words
+};
+static_assert(24u == sizeof(SfuLogDumpHdr), "SfuLogDumpHdr is a wire format, bump the version to change it");
+
+// "SFL1:" or "SFE1:", two hex digits per byte, and a '\0'
+constexpr size_t kSfuLogEntryMaxSz = (kSfuLogEntryHdr + kSfuLogArgsMax) * sizeof(SfuLogWord);
+constexpr size_t kSfuLogLineSz = 5u + 2u * ((kSfuLogEntryMaxSz > sizeof(SfuLogDumpHdr)) ? kSfuLogEntryMaxSz : sizeof(SfuLogDumpHdr)) + 1u;
+
+#if DEBUG_FLASH_QE_DEFERRED
+void sfu_log_reset();
+
+// Store one message, at most kSfuLogArgsMax arguments. fmt must stay valid,
+// a PSTR() or a literal.
+void sfu_log_words(const char *fmt, const SfuLogWord *args, size_t n);
+
+// Fill in *hdr for the entries held now. Returns the entry count.
+size_t sfu_log_snapshot(SfuLogDumpHdr *hdr);
+
+// Message i, 0 the oldest, formatted into buf. Returns the length, 0 past the
+// end. Longer messages are cut to fit.
+size_t sfu_log_format(const size_t i, char *buf, const size_t sz);
+
+// Line i of a text dump, 0 the header, then one for each entry. sz must be at
+// least kSfuLogLineSz. Returns the length, 0 past the end.
+size_t sfu_log_line(const size_t i, char *buf, const size_t sz);
+#endif
+
+};  // namespace experimental
+
+#ifdef __cplusplus
+}
+#endif
+
+#if DEBUG_FLASH_QE_DEFERRED
+// Often included from inside an extern "C" block
+extern "C++" {
+namespace experimental {
+
+// Each argument is cast to a word, a pointer keeps its address
+template<typename... Args>
+inline __attribute__((always_inline))
+void sfu_log(const char *fmt, Args... args) {
+  static_assert(kSfuLogArgsMax >= sizeof...(Args), "DBG_SFU_PRINTF takes at most kSfuLogArgsMax arguments");
+  const SfuLogWord w[sizeof...(Args) + 1u] = {(SfuLogWord)(args)..., 0u};
+  sfu_log_words(fmt, w, sizeof...(Args));
+}
+
+};  // namespace experimental
+}
+#endif
+
+#endif // EXPERIMENTAL_SPIFLASHLOG_H
@@ -0,0 +1,241 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Status Register shadow - skip reads and Write Disables the library can answer
+
+  Build with -DSR_SHADOW=1. The library keeps a copy of SR1 - SR3 and what it
+  knows of WEL and WIP, from the flash instructions it sends:
+
+    05h, 35h, 15h     a read fills in the register. SR1 also gives WEL, WIP.
+    01h, 31h, 11h     a write forgets the register written, the next read
+                      goes to the flash. 01h forgets SR2, a part may take 16
+                      bits or clear it. A write reaching SR2 forgets SR3, the
+                      XMC anomaly. With 06h, WEL and WIP are unknown.
+    04h               WEL is clear
+    06h               WEL is set
+    50h               WEL is unchanged
+    06h + other       program, erase: WEL and WIP are unknown
+    03h, 48h, 4Bh,    reads, nothing changes
+    5Ah, 9Fh
+    anything else     everything is forgotten, eg. 66h 99h reset, 3Ah OTP
+
+  The end of each window, the BootROM's status read spinning on WIP, makes
+  WIP known clear. A split-phase write's polls are not used, the write is in
+  progress.
+
+  With the shadow:
+
+    spi0_flash_read_status_register*() return a known register without a
+    flash instruction. SR1 needs WEL and WIP known as well.
+    spi0_flash_write_disable() is skipped while WEL is known clear, as is the
+    Write Disable step before a volatile write in a sequence or split-phase
+    write.
+
+  Write paths always end with a read of the register written, so a verify is
+  never answered from the shadow.
+
+  The shadow only sees the library's own instructions. After an SDK or
+  BootROM flash call that can change a register or WEL, eg. spi_flash_write(),
+  spi_flash_erase_sector(), or a SPI0Command() sent directly, call
+  sr_shadow_invalidate(). reclaim_GPIO_9_10() does at its start.
+
+  Force verify, sr_shadow_force_verify(true) or -DSR_SHADOW_FORCE_VERIFY=1,
+  skips nothing. Every read goes to the flash and is compared with a known
+  register, a difference counts as a mismatch. Zero mismatches over a run
+  says the write paths keep the shadow in step.
+
+  The shadow lives in .data, loaded from the image at each boot, so it starts
+  empty in preinit() and after any reset. Not .noinit: a register copy from
+  before a reset is not a copy of anything.
+
+  The hooks run inside the flash instruction windows, with the iCache off, so
+  updates are inline and touch DRAM only. Without SR_SHADOW, the SR_SHADOW_*
+  hooks compile to nothing.
+*/
+#ifndef EXPERIMENTAL_SPIFLASHSHADOW_H
+#define EXPERIMENTAL_SPIFLASHSHADOW_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if ((1 - SR_SHADOW - 1) == 2)
+#undef SR_SHADOW
+#define SR_SHADOW 1
+#endif
+
+#ifndef SR_SHADOW_FORCE_VERIFY
+#define SR_SHADOW_FORCE_VERIFY 0
+#elif ((1 - SR_SHADOW_FORCE_VERIFY - 1) == 2)
+#undef SR_SHADOW_FORCE_VERIFY
+#define SR_SHADOW_FORCE_VERIFY 1
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+namespace experimental {
+
+// What the shadow knows
+enum SrShadowKnown : uint8_t {
+  kSrShadowSR1  = 0x01u,
+  kSrShadowSR2  = 0x02u,
+  kSrShadowSR3  = 0x04u,
+  kSrShadowWEL  = 0x08u,
+  kSrShadowWIP  = 0x10u,
+};
+
+struct SrShadowCounters {
+  uint32_t reads_elided;      // Status Register reads answered by the shadow
+  uint32_t wrdi_elided;       // Write Disables not sent, WEL known clear
+  uint32_t reads;             // Status Register reads sent
+  uint32_t mismatches;        // A read differed from a known register
+  uint32_t invalidations;     // sr_shadow_invalidate(), and unknown instructions
+};
+
+struct SrShadow {
+  uint8_t sr[3];              // SR1 - SR3 as read, SR1 without WEL and WIP
+  uint8_t known;              // SrShadowKnown
+  uint8_t wel;
+  uint8_t wip;
+  bool    force_verify;
+  uint8_t rsvd;
+  SrShadowCounters counters;
+};
+
+#if SR_SHADOW
+extern SrShadow sr_shadow;
+
+inline __attribute__((always_inline))
+void sr_shadow_invalidate() {
+  sr_shadow.known = 0u;
+  sr_shadow.counters.invalidations++;
+}
+
+inline __attribute__((always_inline))
+void sr_shadow_force_verify(const bool on) {
+  sr_shadow.force_verify = on;
+}
+
+inline __attribute__((always_inline))
+const SrShadowCounters *sr_shadow_counters() {
+  return &sr_shadow.counters;
+}
+
+inline __attribute__((always_inline))
+void sr_shadow_counters_reset() {
+  sr_shadow.counters = SrShadowCounters{};
+}
+
+// A flash instruction went out, pre_cmd 0 or 0xFFFFFFFF for none. For a read,
+// in is the reply.
+inline __attribute__((always_inline))
+void sr_shadow_note(const uint32_t result, const uint32_t cmd, const uint32_t pre_cmd, const uint32_t miso_bits, const uint32_t in) {
+  SrShadow& s = sr_shadow;
+  if (result) {
+    sr_shadow_invalidate();
+    return;
+  }
+  const uint32_t idx0 = (0x05u == cmd) ? 0u : (0x35u == cmd) ? 1u : (0x15u == cmd) ? 2u : 3u;
+  if (3u > idx0 && miso_bits) {
+    const uint8_t bit = 1u << idx0;
+    const uint8_t value = (0u == idx0) ? (in & 0xFCu) : (in & 0xFFu);
+    s.counters.reads++;
+    if ((s.known & bit) && s.sr[idx0] != value) s.counters.mismatches++;
+    s.sr[idx0] = value;
+    s.known |= bit;
+    if (0u == idx0) {
+      const uint8_t wel = (in >> 1u) & 1u;
+      const uint8_t wip = in & 1u;
+      if ((s.known & kSrShadowWEL) && s.wel != wel) s.counters.mismatches++;
+      s.wel = wel;
+      s.wip = wip;
+      s.known |= kSrShadowWEL | kSrShadowWIP;
+    }
+  } else if (0x04u == cmd) {
+    s.wel = 0u;
+    s.known |= kSrShadowWEL;
+  } else if (0x06u == cmd) {
+    s.wel = 1u;
+    s.known |= kSrShadowWEL;
+  } else if (0x50u == cmd) {
+    // WEL is unchanged
+  } else if (0x01u == cmd) {
+    s.known &= ~(kSrShadowSR1 | kSrShadowSR2 | kSrShadowSR3);
+  } else if (0x31u == cmd) {
+    s.known &= ~(kSrShadowSR2 | kSrShadowSR3);
+  } else if (0x11u == cmd) {
+    s.known &= ~kSrShadowSR3;
+  } else if (0x06u == pre_cmd) {
+    // Program or erase, the registers stay
+  } else if (0x03u == cmd || 0x48u == cmd || 0x4Bu == cmd || 0x5Au == cmd || 0x9Fu == cmd) {
+    // Reads
+  } else {
+    sr_shadow_invalidate();
+  }
+  if (0x06u == pre_cmd) s.known &= ~(kSrShadowWEL | kSrShadowWIP);
+}
+
+// The window closed, the BootROM spun until WIP cleared
+inline __attribute__((always_inline))
+void sr_shadow_idle() {
+  sr_shadow.wip = 0u;
+  sr_shadow.known |= kSrShadowWIP;
+}
+
+// Register idx0 from the shadow. false when it has to be read.
+inline __attribute__((always_inline))
+bool sr_shadow_read(const uint32_t idx0, uint32_t *pStatus) {
+  const SrShadow& s = sr_shadow;
+  if (s.force_verify || 2u < idx0) return false;
+  const uint8_t need = (0u == idx0) ? (kSrShadowSR1 | kSrShadowWEL | kSrShadowWIP) : (1u << idx0);
+  if (need != (s.known & need)) return false;
+  *pStatus = (0u == idx0) ? (s.sr[0] | (s.wel << 1u) | s.wip) : s.sr[idx0];
+  sr_shadow.counters.reads_elided++;
+  return true;
+}
+
+// true when a Write Disable can be skipped
+inline __attribute__((always_inline))
+bool sr_shadow_skip_wrdi() {
+  const SrShadow& s = sr_shadow;
+  if (s.force_verify || 0u == (s.known & kSrShadowWEL) || s.wel) return false;
+  sr_shadow.counters.wrdi_elided++;
+  return true;
+}
+
+#define SR_SHADOW_NOTE(result, cmd, pre, miso, in) sr_shadow_note((result), (cmd), (pre), (miso), (in))
+#define SR_SHADOW_IDLE() sr_shadow_idle()
+#define SR_SHADOW_READ(idx0, p) sr_shadow_read((idx0), (p))
+#define SR_SHADOW_SKIP_WRDI() sr_shadow_skip_wrdi()
+#else
+// Callers may clear the shadow after SDK calls without checking the build
+inline __attribute__((always_inline))
+void sr_shadow_invalidate() {}
+
+#define SR_SHADOW_NOTE(result, cmd, pre, miso, in) do {} while (false)
+#define SR_SHADOW_IDLE() do {} while (false)
+#define SR_SHADOW_READ(idx0, p) (false)
+#define SR_SHADOW_SKIP_WRDI() (false)
+#endif
+
+};  // namespace experimental
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EXPERIMENTAL_SPIFLASHSHADOW_H
@@ -0,0 +1,78 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+////////////////////////////////////////////////////////////////////////////////
+// SPI0 flash trace, see SpiFlashTrace.h
+//
+#include <Arduino.h>
+#include <coredecls.h>        // crc32()
+#include <user_interface.h>   // system_get_cpu_freq()
+#include "SpiFlashUtils.h"    // spi_flash_hex_line()
+#include "SpiFlashTrace.h"
+
+namespace experimental {
+
+#if SPI_FLASH_TRACE
+SpiFlashTrace spi0_flash_trace __attribute__((section(".noinit")));
+
+static size_t held() {
+  if (kSpiTraceMagic != spi0_flash_trace.magic) return 0u;
+  const uint32_t n = spi0_flash_trace.counters.records;
+  return (kSpiTraceMax < n) ? kSpiTraceMax : n;
+}
+
+const SpiTraceRecord *spi_flash_trace_record(const size_t i) {
+  const size_t n = held();
+  if (i >= n) return nullptr;
+  const uint32_t first = spi0_flash_trace.counters.records - n;
+  return &spi0_flash_trace.rec[(first + i) & (kSpiTraceMax - 1u)];
+}
+
+size_t spi_flash_trace_snapshot(SpiTraceDumpHdr *hdr) {
+  if (nullptr == hdr) return 0u;
+  const size_t n = held();
+  memset(hdr, 0, sizeof(SpiTraceDumpHdr));
+  hdr->magic = kSpiTraceMagic;
+  hdr->version = kSpiTraceVersion;
+  hdr->size = sizeof(SpiTraceDumpHdr);
+  hdr->rec_size = sizeof(SpiTraceRecord);
+  hdr->cpu_mhz = system_get_cpu_freq();
+  if (n) {
+    hdr->counters = spi0_flash_trace.counters;
+    hdr->first = hdr->counters.records - n;
+  }
+  hdr->count = n;
+  uint32_t crc = crc32(hdr, offsetof(SpiTraceDumpHdr, crc));
+  for (size_t i = 0u; i < n; i++) {
+    crc = crc32(spi_flash_trace_record(i), sizeof(SpiTraceRecord), crc);
+  }
+  hdr->crc = crc;
+  return n;
+}
+
+size_t spi_flash_trace_line(const size_t i, char *buf, const size_t sz) {
+  if (nullptr == buf || kSpiTraceLineSz > sz) return 0u;
+  if (0u == i) {
+    SpiTraceDumpHdr hdr;
+    spi_flash_trace_snapshot(&hdr);
+    return spi_flash_hex_line("SFT1:", &hdr, sizeof(hdr), buf);
+  }
+  const SpiTraceRecord *r = spi_flash_trace_record(i - 1u);
+  if (nullptr == r) return 0u;
+  return spi_flash_hex_line("SFR1:", r, sizeof(SpiTraceRecord), buf);
+}
+#endif
+
+};  // namespace experimental
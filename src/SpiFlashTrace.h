@@ -0,0 +1,214 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  SPI0 flash trace - the last flash instructions sent by the library
+
+  Build with -DSPI_FLASH_TRACE=1. Each library flash instruction adds a
+  record to a ring in .noinit: the instruction, prefix instruction, bit
+  counts, the first data word out and back, the SpiOpResult, and the CPU
+  cycle count at start and end. Counters since the trace was reset are kept
+  with it: records, failures, WEL left set, iCache disable windows, and the
+  time the iCache was off.
+
+  Recording is inline and DRAM only, about 40 cycles a record, so it works
+  from preinit() and with the iCache off, and can stay on in soak builds.
+  The ring survives a crash and a warm reset, the records leading up to it
+  can be read after the reboot. At power on, the first record resets it.
+
+  One record for each:
+
+    kSpiTraceCommand    _spi0_command(), one SPI0Command window
+    kSpiTraceStatus     spi0_flash_read_status_register_1(), SDK read
+    kSpiTraceStep       a step of spi0_flash_sequence(), the sequence window
+                        is counted, not recorded
+    kSpiTracePair       spi0_flash_command_pair(), cmd1 is the prefix
+    kSpiTraceWipBegin   a split-phase write sent, the window stays open
+    kSpiTraceWipEnd     the write finished, the window closed. Starts when
+                        the write went out, "out" holds the polls.
+
+  WEL left set counts Read Status Register-1 replies with WEL set and WIP
+  clear that do not follow a Write Enable, 06h. A write that did not finish
+  its job, or a part that ignored it.
+
+  A dump is a header and the records, oldest first, little-endian. As text,
+  the header is a line "SFT1:" and each record a line "SFR1:", in hex.
+  tools/spitrace decodes them into a timeline, it includes this header for
+  the record layout. The header CRC covers the records.
+
+  Without SPI_FLASH_TRACE, the SPI_FLASH_TRACE_* hooks compile to nothing.
+*/
+#ifndef EXPERIMENTAL_SPIFLASHTRACE_H
+#define EXPERIMENTAL_SPIFLASHTRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if ((1 - SPI_FLASH_TRACE - 1) == 2)
+#undef SPI_FLASH_TRACE
+#define SPI_FLASH_TRACE 1
+#endif
+
+// Records kept, a power of 2. 24 bytes each.
+#ifndef SPI_FLASH_TRACE_MAX
+#define SPI_FLASH_TRACE_MAX 64u
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+namespace experimental {
+
+constexpr uint32_t kSpiTraceMagic = 0x31544653u;  // "SFT1"
+constexpr uint8_t kSpiTraceVersion = 1u;
+constexpr uint32_t kSpiTraceMax = SPI_FLASH_TRACE_MAX;
+static_assert(0u == (kSpiTraceMax & (kSpiTraceMax - 1u)), "SPI_FLASH_TRACE_MAX must be a power of 2");
+
+enum SpiTraceKind : uint8_t {
+  kSpiTraceCommand = 0u,
+  kSpiTraceStatus,
+  kSpiTraceStep,
+  kSpiTracePair,
+  kSpiTraceWipBegin,
+  kSpiTraceWipEnd,
+  kSpiTraceKinds
+};
+
+struct SpiTraceRecord {
+  uint32_t start;         // esp_get_cycle_count()
+  uint32_t end;
+  uint32_t out;           // First data word sent, eg. the address of a read
+  uint32_t in;            // First data word back
+  uint8_t  cmd;
+  uint8_t  pre_cmd;       // 0 for none
+  uint8_t  kind;          // SpiTraceKind
+  uint8_t  result;        // SpiOpResult
+  uint16_t mosi_bits;
+  uint16_t miso_bits;
+};
+static_assert(24u == sizeof(SpiTraceRecord), "SpiTraceRecord is a wire format, bump the version to change it");
+
+struct SpiTraceCounters {
+  uint32_t records;       // Since the reset, the ring holds the last kSpiTraceMax
+  uint32_t failures;      // Result not SPI_RESULT_OK
+  uint32_t wel_left_set;
+  uint32_t windows;       // iCache disable windows
+  uint64_t cache_off_cycles;
+};
+
+// The ring, in .noinit
+struct SpiFlashTrace {
+  uint32_t magic;         // kSpiTraceMagic
+  uint8_t  last_cmd;
+  uint8_t  rsvd[3];
+  SpiTraceCounters counters;
+  SpiTraceRecord rec[kSpiTraceMax];
+};
+
+struct SpiTraceDumpHdr {
+  uint32_t magic;         // kSpiTraceMagic
+  uint8_t  version;       // kSpiTraceVersion
+  uint8_t  size;          // sizeof(SpiTraceDumpHdr)
+  uint8_t  rec_size;      // sizeof(SpiTraceRecord)
+  uint8_t  cpu_mhz;       // For the cycle counts
+  uint32_t first;         // Record number of the first record in the dump
+  uint32_t count;         // Records in the dump
+  SpiTraceCounters counters;
+  uint32_t rsvd;
+  uint32_t crc;           // crc32() of the bytes above, then the records
+};
+static_assert(48u == sizeof(SpiTraceDumpHdr), "SpiTraceDumpHdr is a wire format, bump the version to change it");
+
+// "SFT1:" or "SFR1:", two hex digits per byte, and a '\0'
+constexpr size_t kSpiTraceLineSz = 5u + 2u * sizeof(SpiTraceDumpHdr) + 1u;
+
+#if SPI_FLASH_TRACE
+extern SpiFlashTrace spi0_flash_trace;
+
+inline __attribute__((always_inline))
+void spi_flash_trace_reset() {
+  spi0_flash_trace.magic = kSpiTraceMagic;
+  spi0_flash_trace.last_cmd = 0u;
+  spi0_flash_trace.counters = SpiTraceCounters{};
+}
+
+inline __attribute__((always_inline))
+void spi_flash_trace_begin(SpiTraceRecord& r, const uint8_t cmd, const uint32_t pre_cmd, const uint32_t mosi_bits, const uint32_t miso_bits, const uint32_t *out) {
+  r.cmd = cmd;
+  r.pre_cmd = (0xFFFFFFFFu == pre_cmd) ? 0u : pre_cmd;
+  r.mosi_bits = mosi_bits;
+  r.miso_bits = miso_bits;
+  r.out = (mosi_bits && out) ? out[0] : 0u;
+  r.start = esp_get_cycle_count();
+}
+
+inline __attribute__((always_inline))
+void spi_flash_trace_count_window(const uint32_t start) {
+  spi0_flash_trace.counters.windows++;
+  spi0_flash_trace.counters.cache_off_cycles += esp_get_cycle_count() - start;
+}
+
+inline __attribute__((always_inline))
+void spi_flash_trace_end(SpiTraceRecord& r, const uint8_t kind, const uint32_t result, const uint32_t in) {
+  r.end = esp_get_cycle_count();
+  r.kind = kind;
+  r.result = result;
+  r.in = in;
+  if (kSpiTraceMagic != spi0_flash_trace.magic) spi_flash_trace_reset();
+
+  SpiTraceCounters& c = spi0_flash_trace.counters;
+  if (result) c.failures++;
+  if (0x05u == r.cmd && r.miso_bits && 0x02u == (in & 0x03u) && 0x06u != spi0_flash_trace.last_cmd) c.wel_left_set++;
+  if (kSpiTraceStep != kind) {
+    c.cache_off_cycles += r.end - r.start;
+    if (kSpiTraceWipEnd != kind) c.windows++;
+  }
+  spi0_flash_trace.last_cmd = r.cmd;
+  spi0_flash_trace.rec[c.records & (kSpiTraceMax - 1u)] = r;
+  c.records++;
+}
+
+// Fill in *hdr for the records held now, oldest first. Returns the count.
+size_t spi_flash_trace_snapshot(SpiTraceDumpHdr *hdr);
+
+// Record i of the ones held, 0 the oldest. nullptr past the end.
+const SpiTraceRecord *spi_flash_trace_record(const size_t i);
+
+// Line i of a text dump, 0 the header, then one for each record. Take them
+// in order without flash calls between, the header CRC checks the records.
+// sz must be at least kSpiTraceLineSz. Returns the length, 0 past the end.
+size_t spi_flash_trace_line(const size_t i, char *buf, const size_t sz);
+
+#define SPI_FLASH_TRACE_BEGIN(r, cmd, pre, mosi, miso, out) SpiTraceRecord r; spi_flash_trace_begin(r, (cmd), (pre), (mosi), (miso), (out))
+#define SPI_FLASH_TRACE_END(r, kind, result, in) spi_flash_trace_end(r, (kind), (result), (in))
+#define SPI_FLASH_TRACE_MARK(t) const uint32_t t = esp_get_cycle_count()
+#define SPI_FLASH_TRACE_WINDOW(t) spi_flash_trace_count_window(t)
+#define SPI_FLASH_TRACE_WIP(r, w) ((r).start = (w)->start, (r).out = (w)->polls)
+#else
+#define SPI_FLASH_TRACE_BEGIN(r, cmd, pre, mosi, miso, out) do {} while (false)
+#define SPI_FLASH_TRACE_END(r, kind, result, in) do {} while (false)
+#define SPI_FLASH_TRACE_MARK(t) do {} while (false)
+#define SPI_FLASH_TRACE_WINDOW(t) do {} while (false)
+#define SPI_FLASH_TRACE_WIP(r, w) do {} while (false)
+#endif
+
+};  // namespace experimental
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EXPERIMENTAL_SPIFLASHTRACE_H
@@ -25,13 +25,28 @@ extern "C" {
 #include "SpiFlashUtils.h"
 using experimental::SPI0Command;
 
+#if RECLAIM_TIMELINE
+ReclaimTimeline reclaim_timeline_buf __attribute__((section(".noinit")));
+#endif
+
 namespace experimental {
 
+uint32_t spi0_flash_xfer_count __attribute__((section(".noinit")));
+
+#if SR_WEAR_POLICY
+uint32_t sr_wear_uncommitted[3] __attribute__((section(".noinit")));
+#endif
+
+uint32_t spi0_flash_sr_write_timeout_us = kSpi0SrWriteTimeoutMaxUs;
+
+#if SR_SHADOW
+// Loaded from the image at each boot, starts empty in preinit(). See .h
+SrShadow sr_shadow __attribute__((section(".data"))) = {{0u, 0u, 0u}, 0u, 0u, 0u, (0 != SR_SHADOW_FORCE_VERIFY), 0u, {}};
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
-// base function see .h
-// common logic, 24 bit address reads with one dummpy byte.
-SpiOpResult _spi0_flash_read_common(const uint32_t offset, uint32_t *p, const size_t sz, const uint8_t cmd) {
-  if (sz > 64 || (sz % sizeof(uint32_t))) return SPI_RESULT_ERR;
+// One transfer, sz <= kSpi0ReadMaxSz
+static SpiOpResult _spi0_flash_read_one(const uint32_t offset, uint32_t *p, const size_t sz, const uint8_t cmd) {
   FlashAddr24 addr24bit;
 
   // MSB goes on wire first. It comes out of the LSB of a 32-bit word.
@@ -42,36 +57,237 @@ SpiOpResult _spi0_flash_read_common(const uint32_t offset, uint32_t *p, const si
 #if DEBUG_FLASH_QE
   // Is there any reason to do this other than it looks pretty when debugging?
   // SPI0Command will clear to the bit length, sz * 8.
-  size_t sz_dw = sz / sizeof(uint32_t);
+  size_t sz_dw = (sz + sizeof(uint32_t) - 1u) / sizeof(uint32_t);
   for (size_t i = 1; i < sz_dw; i++) p[i] = 0u;
 #endif
   // SPI0Command sends a read opcode, like SFDP Read (5Ah) with 32 bits of data
   // containing the 24 bit address followed by a dummy byte of zeros. The
   // responce is copied back into pData starting at pData[0].
-  return SPI0Command(cmd, p, 32u, sz * 8u);
+  return _spi0_command(cmd, p, 32u, sz * 8u);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// base function see .h
+// common logic, 24 bit address reads with one dummpy byte.
+SpiOpResult _spi0_flash_read_common(const uint32_t offset, uint32_t *p, const size_t sz, const uint8_t cmd) {
+  if (0u == sz) return _spi0_flash_read_one(offset, p, sz, cmd);
+
+  SpiOpResult ok0 = SPI_RESULT_OK;
+  uint32_t addr = offset;
+  size_t remaining = sz;
+  while (remaining && SPI_RESULT_OK == ok0) {
+    size_t chunk = (kSpi0ReadMaxSz < remaining) ? kSpi0ReadMaxSz : remaining;
+    ok0 = _spi0_flash_read_one(addr, p, chunk, cmd);
+    // Only the last chunk can be less than kSpi0ReadMaxSz
+    p += kSpi0ReadMaxSz / sizeof(uint32_t);
+    addr += chunk;
+    remaining -= chunk;
+  }
+  return ok0;
+}
+
+SpiOpResult _spi0_flash_read_stream(const uint32_t offset, const size_t sz, const uint8_t cmd, Spi0ReadSink sink, void *ctx) {
+  if (nullptr == sink) return SPI_RESULT_ERR;
+
+  uint32_t buf[kSpi0ReadMaxSz / sizeof(uint32_t)];
+  SpiOpResult ok0 = SPI_RESULT_OK;
+  uint32_t addr = offset;
+  size_t remaining = sz;
+  while (remaining) {
+    size_t chunk = (kSpi0ReadMaxSz < remaining) ? kSpi0ReadMaxSz : remaining;
+    ok0 = _spi0_flash_read_one(addr, buf, chunk, cmd);
+    if (SPI_RESULT_OK != ok0) break;
+    if (! sink(ctx, addr, buf, chunk)) break;
+    addr += chunk;
+    remaining -= chunk;
+  }
+  return ok0;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //// Some Flash Status Register functions
-SpiOpResult spi0_flash_read_status_registers_2B(uint32_t *pStatus) {
+// All registers asked for are read in one sequence. The sequence clears unused
+// bits in each reply word. Registers the shadow knows are not sent.
+SpiOpResult spi0_flash_read_status_registers(const uint32_t regs, uint32_t *pStatus) {
+  constexpr uint8_t read_cmds[] = {kReadStatusRegister1Cmd, kReadStatusRegister2Cmd, kReadStatusRegister3Cmd};
   *pStatus = 0u;
-  SpiOpResult ok0 = spi0_flash_read_status_register_1(pStatus);
-  if (SPI_RESULT_OK == ok0) {
-    uint32_t statusR2 = 0u;
-    ok0 = spi0_flash_read_status_register_2(&statusR2);
-    // SPI0Command clears unused bits in 32-bit word.
-    if (SPI_RESULT_OK == ok0) *pStatus |= (statusR2 << 8u);
+  Spi0Step steps[3];
+  size_t n = 0u;
+  uint32_t sent = 0u;
+  for (size_t i = 0u; i < 3u; i++) {
+    if (0u == (regs & (1u << i))) continue;
+    uint32_t status;
+    if (SR_SHADOW_READ(i, &status)) {
+      *pStatus |= status << (8u * i);
+    } else {
+      steps[n++] = {read_cmds[i], 0u, 0u, 8u, 0u};
+      sent |= 1u << i;
+    }
+  }
+  if (0u == n) return SPI_RESULT_OK;
+  SpiOpResult ok0 = spi0_flash_sequence(steps, n);
+  if (SPI_RESULT_OK != ok0) {
+    *pStatus = 0u;
+    return ok0;
+  }
+  n = 0u;
+  for (size_t i = 0u; i < 3u; i++) {
+    if (sent & (1u << i)) *pStatus |= (steps[n++].data & 0xFFu) << (8u * i);
   }
   return ok0;
 }
 
+SpiOpResult spi0_flash_read_status_registers_2B(uint32_t *pStatus) {
+  return spi0_flash_read_status_registers(3u, pStatus);
+}
+
 SpiOpResult spi0_flash_read_status_registers_3B(uint32_t *pStatus) {
-  SpiOpResult ok0 = spi0_flash_read_status_registers_2B(pStatus);
-  if (SPI_RESULT_OK == ok0) {
-    uint32_t statusR3 = 0u;
-    ok0 = spi0_flash_read_status_register_3(&statusR3);
-    if (SPI_RESULT_OK == ok0) *pStatus |= (statusR3 << 16u);
+  return spi0_flash_read_status_registers(7u, pStatus);
+}
+
+SpiOpResult spi0_flash_write_verify_status_register(const uint32_t idx0, const uint32_t status, const bool non_volatile, const uint32_t numbits, const uint32_t verify_idx0, uint32_t *pVerify) {
+  constexpr uint8_t write_cmds[] = {kWriteStatusRegister1Cmd, kWriteStatusRegister2Cmd, kWriteStatusRegister3Cmd};
+  constexpr uint8_t read_cmds[] = {kReadStatusRegister1Cmd, kReadStatusRegister2Cmd, kReadStatusRegister3Cmd};
+  *pVerify = 0u;
+  if (2u < idx0 || 2u < verify_idx0 || 32u < numbits) {
+    // panic();
+    return SPI_RESULT_ERR;
   }
+  if (non_volatile) {
+    // Don't spin through tW with interrupts off
+    return spi0_flash_write_verify_status_register_wip(idx0, status, non_volatile, numbits, verify_idx0, pVerify, spi0_flash_sr_write_timeout_us, NULL, NULL);
+  }
+
+  Spi0Step steps[3];
+  size_t n = 0u;
+  uint8_t prefix = kWriteEnableCmd;
+  if (! non_volatile) {
+    if (! SR_SHADOW_SKIP_WRDI()) steps[n++] = {kWriteDisableCmd, 0u, 0u, 0u, 0u};
+    prefix = kVolatileWriteEnableCmd;
+  }
+  steps[n++] = {write_cmds[idx0], prefix, (uint8_t)numbits, 0u, status};
+  steps[n++] = {read_cmds[verify_idx0], 0u, 0u, 8u, 0u};
+  SpiOpResult ok0 = spi0_flash_sequence(steps, n);
+  if (SPI_RESULT_OK == ok0) *pVerify = steps[n - 1u].data;
+  return ok0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Run a list of flash instructions in one iCache disabled window. See .h
+SpiOpResult IRAM_ATTR spi0_flash_sequence(Spi0Step *steps, const size_t count) {
+  if (0u == count || kSpi0SeqMaxSteps < count) return SPI_RESULT_ERR;
+  for (size_t i = 0u; i < count; i++) {
+    if (32u < steps[i].mosi_bits || 32u < steps[i].miso_bits) return SPI_RESULT_ERR;
+  }
+  system_soft_wdt_feed();
+
+  SPI_FLASH_TRACE_MARK(window_start);
+  Cache_Read_Disable_2();
+  Wait_SPI_Idle(flashchip);
+  // Wait_SPI_Idle before, SPI_read_status and Wait_SPI_Idle after
+  SPI_FLASH_COST_WINDOW(3u);
+  uint32_t saved_ps = xt_rsil(15);
+  // preserve essential controller state such as incoming/outgoing
+  // data lengths and IO mode.
+  uint32_t oldSPI0C = SPI0C;
+  uint32_t oldSPI0U = SPI0U;
+  uint32_t oldSPI0U2= SPI0U2;
+
+  // Select the most basic IO mode for maximum compatibility
+  // Some flash commands are only available in this mode.
+  uint32_t spic = oldSPI0C;
+  spic &= ~(SPICQIO | SPICDIO | SPICQOUT | SPICDOUT | SPICAHB | SPICFASTRD);
+  spic |= (SPICRESANDRES | SPICSHARE | SPICWPR | SPIC2BSE);
+  const uint32_t spiu2 = ((7 & SPIMCOMMAND)<<SPILCOMMAND); // command length minus one
+
+  SpiOpResult ok0 = SPI_RESULT_OK;
+  SPI0C = spic;
+  for (size_t i = 0u; i < count; i++) {
+    Spi0Step& step = steps[i];
+    spi0_flash_xfer_count += (step.pre_cmd) ? 2u : 1u;
+    RECLAIM_TIMELINE_MARK(kReclaimPhaseSequenceStep, step.cmd);
+    SPI_FLASH_COST_XFER(step.mosi_bits, step.miso_bits);
+    SPI_FLASH_TRACE_BEGIN(trace, step.cmd, step.pre_cmd, step.mosi_bits, step.miso_bits, &step.data);
+    if (step.pre_cmd) {
+      SPI_FLASH_COST_PREFIX(step.cmd, step.pre_cmd);
+      SR_WEAR_NOTE(step.cmd, step.pre_cmd);
+      // Send prefix cmd w/o data - eg. Volatile SR Write Enable, 0x50
+      SPI0U  = SPIUCOMMAND;
+      SPI0U1 = 0u;
+      SPI0U2 = spiu2 | step.pre_cmd;
+      SPI0CMD = SPICMDUSR;
+      uint32_t timeout = 1000u;
+      while ((SPI0CMD & SPICMDUSR) && --timeout);
+      if (0u == timeout) {
+        ok0 = SPI_RESULT_TIMEOUT;
+        SR_SHADOW_NOTE(ok0, step.cmd, step.pre_cmd, step.miso_bits, 0u);
+        SPI_FLASH_TRACE_END(trace, kSpiTraceStep, ok0, 0u);
+        break;
+      }
+    }
+
+    uint32_t spiu = SPIUCOMMAND;
+    uint32_t spiu1 = 0u;
+    if (step.mosi_bits) {
+      spiu |= SPIUMOSI;
+      spiu1 |= ((step.mosi_bits - 1u) & SPIMMOSI) << SPILMOSI;
+      SPI0W0 = step.data;
+    }
+    if (step.miso_bits) {
+      spiu |= SPIUMISO;
+      spiu1 |= ((step.miso_bits - 1u) & SPIMMISO) << SPILMISO;
+    }
+    SPI0U  = spiu;
+    SPI0U1 = spiu1;
+    SPI0U2 = spiu2 | step.cmd;
+    SPI0CMD = SPICMDUSR;
+
+    // typically only 1-3 iterations
+    uint32_t timeout = 1000u;
+    while ((SPI0CMD & SPICMDUSR) && --timeout);
+    if (0u == timeout) {
+      ok0 = SPI_RESULT_TIMEOUT;
+      SR_SHADOW_NOTE(ok0, step.cmd, step.pre_cmd, step.miso_bits, 0u);
+      SPI_FLASH_TRACE_END(trace, kSpiTraceStep, ok0, 0u);
+      break;
+    }
+
+    if (step.miso_bits) {
+      uint32_t reply = SPI0W0;
+      if (32u > step.miso_bits) reply &= ~(0xFFFFFFFFu << step.miso_bits);
+      step.data = reply;
+    }
+    SR_SHADOW_NOTE(ok0, step.cmd, step.pre_cmd, step.miso_bits, step.data);
+    SPI_FLASH_TRACE_END(trace, kSpiTraceStep, ok0, (step.miso_bits) ? step.data : 0u);
+
+    if (step.pre_cmd && (i + 1u) < count) {
+      // A write, wait for WIP to clear before running the next step. The
+      // BootROM's status read uses the controller's built-in command, give it
+      // back the registers it expects.
+      uint32_t status;
+      SPI0U  = oldSPI0U;
+      SPI0U2 = oldSPI0U2;
+      SPI0C  = oldSPI0C;
+      SPI_read_status(flashchip, &status);  // function will spin while WIP is set
+      SPI_FLASH_COST_STATUS_READ();
+      SPI0C = spic;
+    }
+  }
+
+  // Restore saved registers
+  SPI0U  = oldSPI0U;
+  SPI0U2 = oldSPI0U2;
+  SPI0C  = oldSPI0C;
+
+  // Same as SPI0Command, w/o a call to SPI_read_status the WIP/busy from a
+  // flash write, can be skipped over.
+  uint32_t status;
+  SPI_read_status(flashchip, &status);
+  Wait_SPI_Idle(flashchip);
+  SR_SHADOW_IDLE();
+  xt_wsr_ps(saved_ps);
+  Cache_Read_Enable_2();
+  SPI_FLASH_TRACE_WINDOW(window_start);
   return ok0;
 }
 
@@ -79,6 +295,7 @@ SpiOpResult spi0_flash_read_status_registers_3B(uint32_t *pStatus) {
 //  spi0_flash_command_pair(kEnableResetCmd, kResetCmd);
 void IRAM_ATTR spi0_flash_command_pair(const uint8_t cmd1, const uint8_t cmd2, const uint32_t us) {
   system_soft_wdt_feed();
+  SPI_FLASH_TRACE_BEGIN(trace, cmd2, cmd1, 0u, 0u, NULL);
 
   Cache_Read_Disable_2();
   Wait_SPI_Idle(flashchip);
@@ -110,6 +327,13 @@ void IRAM_ATTR spi0_flash_command_pair(const uint8_t cmd1, const uint8_t cmd2, c
   SPI0U2 = spiu2 | cmd2;
   SPI0CMD = SPICMDUSR;   //Send cmd
   while ((SPI0CMD & SPICMDUSR));
+  spi0_flash_xfer_count += 2u;
+  SR_SHADOW_NOTE(SPI_RESULT_OK, cmd2, cmd1, 0u, 0u);
+  RECLAIM_TIMELINE_MARK(kReclaimPhaseSequenceStep, cmd2);
+  SPI_FLASH_COST_WINDOW(3u);
+  SPI_FLASH_COST_XFER(0u, 0u);
+  SPI_FLASH_COST_XFER(0u, 0u);
+  SPI_FLASH_COST_WAIT_US(us);
 
   // Restore saved registers
   SPI0U  = oldSPI0U;
@@ -125,9 +349,314 @@ void IRAM_ATTR spi0_flash_command_pair(const uint8_t cmd1, const uint8_t cmd2, c
   uint32_t status;
   SPI_read_status(flashchip, &status);  // function will spin while WIP is set
   Wait_SPI_Idle(flashchip);
+  SR_SHADOW_IDLE();
   WDT_FEED();
   xt_wsr_ps(saved_ps);
   Cache_Read_Enable_2();
+  SPI_FLASH_TRACE_END(trace, kSpiTracePair, SPI_RESULT_OK, 0u);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Split-phase Status Register write. See .h
+//
+// One user command with SPI0 already in the basic IO mode. Data in and out
+// use W0.
+static inline __attribute__((always_inline))
+uint32_t spi0_user_command(const uint8_t cmd, const uint32_t data, const uint32_t mosi_bits, const uint32_t miso_bits) {
+  uint32_t spiu = SPIUCOMMAND;
+  uint32_t spiu1 = 0u;
+  if (mosi_bits) {
+    spiu |= SPIUMOSI;
+    spiu1 |= ((mosi_bits - 1u) & SPIMMOSI) << SPILMOSI;
+    SPI0W0 = data;
+  }
+  if (miso_bits) {
+    spiu |= SPIUMISO;
+    spiu1 |= ((miso_bits - 1u) & SPIMMISO) << SPILMISO;
+  }
+  SPI0U  = spiu;
+  SPI0U1 = spiu1;
+  SPI0U2 = ((7 & SPIMCOMMAND)<<SPILCOMMAND) | cmd;
+  SPI0CMD = SPICMDUSR;
+  while ((SPI0CMD & SPICMDUSR));
+  if (0u == miso_bits) return 0u;
+  uint32_t reply = SPI0W0;
+  if (32u > miso_bits) reply &= ~(0xFFFFFFFFu << miso_bits);
+  return reply;
+}
+
+// Opens the iCache disabled window with interrupts off and SPI0 in the same
+// basic IO mode as spi0_flash_sequence(), kept until end. Returns the PS to
+// restore.
+static inline __attribute__((always_inline))
+uint32_t wip_window_open(Spi0SrWrite *w) {
+  system_soft_wdt_feed();
+
+  Cache_Read_Disable_2();
+  Wait_SPI_Idle(flashchip);
+  // Wait_SPI_Idle before, SPI_read_status and Wait_SPI_Idle at end
+  SPI_FLASH_COST_WINDOW(3u);
+  uint32_t saved_ps = xt_rsil(15);
+  w->saved_spi0c  = SPI0C;
+  w->saved_spi0u  = SPI0U;
+  w->saved_spi0u2 = SPI0U2;
+
+  uint32_t spic = w->saved_spi0c;
+  spic &= ~(SPICQIO | SPICDIO | SPICQOUT | SPICDOUT | SPICAHB | SPICFASTRD);
+  spic |= (SPICRESANDRES | SPICSHARE | SPICWPR | SPIC2BSE);
+  SPI0C = spic;
+  SPI0U1 = 0u;
+  return saved_ps;
+}
+
+// The write is out, start the timeout and turn interrupts back on
+static inline __attribute__((always_inline))
+void wip_window_busy(Spi0SrWrite *w, const uint32_t timeout_us, const uint32_t saved_ps) {
+  w->start = esp_get_cycle_count();
+  w->timeout_cycles = timeout_us * clockCyclesPerMicrosecond();
+  w->polls = 0u;
+  w->status = 0u;
+  w->state = kSpi0SrWriteBusy;
+  // The iCache stays off. Only IRAM ISRs can run from here to end.
+  xt_wsr_ps(saved_ps);
+}
+
+SpiOpResult IRAM_ATTR spi0_flash_sr_write_begin(Spi0SrWrite *w, const uint32_t idx0, const uint32_t status, const bool non_volatile, const uint32_t numbits, const uint32_t timeout_us) {
+  constexpr uint8_t write_cmds[] = {kWriteStatusRegister1Cmd, kWriteStatusRegister2Cmd, kWriteStatusRegister3Cmd};
+  w->state = kSpi0SrWriteIdle;
+  if (2u < idx0 || 0u == numbits || 32u < numbits) return SPI_RESULT_ERR;
+  SPI_FLASH_TRACE_BEGIN(trace, write_cmds[idx0], (non_volatile) ? kWriteEnableCmd : kVolatileWriteEnableCmd, numbits, 0u, &status);
+  uint32_t saved_ps = wip_window_open(w);
+  w->cost_polls = false;
+
+  uint8_t prefix = kWriteEnableCmd;
+  if (! non_volatile) {
+    // Clear a WEL left set from a failed write, see spi0_flash_write_status_register()
+    if (! SR_SHADOW_SKIP_WRDI()) {
+      spi0_user_command(kWriteDisableCmd, 0u, 0u, 0u);
+      spi0_flash_xfer_count++;
+      SR_SHADOW_NOTE(SPI_RESULT_OK, kWriteDisableCmd, 0u, 0u, 0u);
+      SPI_FLASH_COST_XFER(0u, 0u);
+    }
+    prefix = kVolatileWriteEnableCmd;
+  }
+  spi0_user_command(prefix, 0u, 0u, 0u);
+  spi0_user_command(write_cmds[idx0], status, numbits, 0u);
+  spi0_flash_xfer_count += 2u;
+  SR_SHADOW_NOTE(SPI_RESULT_OK, write_cmds[idx0], prefix, 0u, 0u);
+  RECLAIM_TIMELINE_MARK(kReclaimPhaseSequenceStep, write_cmds[idx0]);
+  SPI_FLASH_COST_PREFIX(write_cmds[idx0], prefix);
+  SR_WEAR_NOTE(write_cmds[idx0], prefix);
+  SPI_FLASH_COST_XFER(numbits, 0u);
+
+  wip_window_busy(w, timeout_us, saved_ps);
+  SPI_FLASH_TRACE_END(trace, kSpiTraceWipBegin, SPI_RESULT_OK, 0u);
+  return SPI_RESULT_OK;
+}
+
+SpiOpResult IRAM_ATTR spi0_flash_wip_write_begin(Spi0SrWrite *w, const uint8_t cmd, const uint32_t *data, const uint32_t mosi_bits, const uint32_t timeout_us) {
+  w->state = kSpi0SrWriteIdle;
+  if (kSpi0ReadMaxSz * 8u < mosi_bits || (mosi_bits && nullptr == data)) return SPI_RESULT_ERR;
+  SPI_FLASH_TRACE_BEGIN(trace, cmd, kWriteEnableCmd, mosi_bits, 0u, data);
+  uint32_t saved_ps = wip_window_open(w);
+  w->cost_polls = true;
+
+  spi0_user_command(kWriteEnableCmd, 0u, 0u, 0u);
+  // W0 is loaded by spi0_user_command
+  for (size_t i = 1u; i < (mosi_bits + 31u) / 32u; i++) SPI0W(i) = data[i];
+  spi0_user_command(cmd, (mosi_bits) ? data[0] : 0u, mosi_bits, 0u);
+  spi0_flash_xfer_count += 2u;
+  SR_SHADOW_NOTE(SPI_RESULT_OK, cmd, kWriteEnableCmd, 0u, 0u);
+  SPI_FLASH_COST_PREFIX(cmd, kWriteEnableCmd);
+  SPI_FLASH_COST_XFER(mosi_bits, 0u);
+
+  wip_window_busy(w, timeout_us, saved_ps);
+  SPI_FLASH_TRACE_END(trace, kSpiTraceWipBegin, SPI_RESULT_OK, 0u);
+  return SPI_RESULT_OK;
+}
+
+bool IRAM_ATTR spi0_flash_sr_write_poll(Spi0SrWrite *w) {
+  if (kSpi0SrWriteBusy != w->state) return true;
+  uint32_t saved_ps = xt_rsil(15);
+  w->status = spi0_user_command(kReadStatusRegister1Cmd, 0u, 0u, 8u);
+  xt_wsr_ps(saved_ps);
+  w->polls++;
+  // A Status Register write's polls are not added, the cost model counts tW
+  if (w->cost_polls) SPI_FLASH_COST_STATUS_READ();
+  spi0_flash_xfer_count++;
+  if (0u == (w->status & 1u)) {       // WIP
+    w->state = kSpi0SrWriteDone;
+  } else if ((esp_get_cycle_count() - w->start) > w->timeout_cycles) {
+    w->state = kSpi0SrWriteTimedOut;
+  }
+  return kSpi0SrWriteBusy != w->state;
+}
+
+SpiOpResult IRAM_ATTR spi0_flash_sr_write_wait(Spi0SrWrite *w, Spi0IdleFn idle, void *ctx) {
+  while (! spi0_flash_sr_write_poll(w)) {
+    if (idle) {
+      idle(ctx);
+    } else {
+      ets_delay_us(kSpi0SrWritePollUs);
+    }
+  }
+  return (kSpi0SrWriteDone == w->state) ? SPI_RESULT_OK : SPI_RESULT_TIMEOUT;
+}
+
+SpiOpResult IRAM_ATTR spi0_flash_sr_write_end(Spi0SrWrite *w, const uint32_t verify_idx0, uint32_t *pVerify) {
+  constexpr uint8_t read_cmds[] = {kReadStatusRegister1Cmd, kReadStatusRegister2Cmd, kReadStatusRegister3Cmd};
+  if (pVerify) *pVerify = 0u;
+  if (kSpi0SrWriteIdle == w->state) return SPI_RESULT_ERR;
+
+  SPI_FLASH_TRACE_BEGIN(trace, (2u >= verify_idx0) ? read_cmds[verify_idx0] : 0u, 0u, 0u, 8u, NULL);
+  SPI_FLASH_TRACE_WIP(trace, w);
+  uint32_t saved_ps = xt_rsil(15);
+  uint32_t status;
+  uint32_t verify = 0u;
+  SpiOpResult ok0 = SPI_RESULT_OK;
+  if (kSpi0SrWriteDone != w->state) {
+    // Still busy or timed out. The iCache can't run until WIP clears, the
+    // BootROM spins on it.
+    SPI0U  = w->saved_spi0u;
+    SPI0U2 = w->saved_spi0u2;
+    SPI0C  = w->saved_spi0c;
+    SPI_read_status(flashchip, &status);
+    SPI_FLASH_COST_STATUS_READ();
+    SPI0U1 = 0u;
+    SPI0C = (w->saved_spi0c & ~(SPICQIO | SPICDIO | SPICQOUT | SPICDOUT | SPICAHB | SPICFASTRD)) |
+            (SPICRESANDRES | SPICSHARE | SPICWPR | SPIC2BSE);
+    if (kSpi0SrWriteTimedOut == w->state) ok0 = SPI_RESULT_TIMEOUT;
+  }
+  if (2u >= verify_idx0) {
+    verify = spi0_user_command(read_cmds[verify_idx0], 0u, 0u, 8u);
+    spi0_flash_xfer_count++;
+    SR_SHADOW_NOTE(SPI_RESULT_OK, read_cmds[verify_idx0], 0u, 8u, verify);
+    SPI_FLASH_COST_XFER(0u, 8u);
+    if (pVerify) *pVerify = verify;
+  } else {
+    ok0 = SPI_RESULT_ERR;
+  }
+
+  // Restore saved registers
+  SPI0U  = w->saved_spi0u;
+  SPI0U2 = w->saved_spi0u2;
+  SPI0C  = w->saved_spi0c;
+  w->state = kSpi0SrWriteIdle;
+
+  SPI_read_status(flashchip, &status);
+  Wait_SPI_Idle(flashchip);
+  SR_SHADOW_IDLE();
+  xt_wsr_ps(saved_ps);
+  Cache_Read_Enable_2();
+  SPI_FLASH_TRACE_END(trace, kSpiTraceWipEnd, ok0, verify);
+  return ok0;
+}
+
+SpiOpResult IRAM_ATTR spi0_flash_write_verify_status_register_wip(const uint32_t idx0, const uint32_t status, const bool non_volatile, const uint32_t numbits, const uint32_t verify_idx0, uint32_t *pVerify, const uint32_t timeout_us, Spi0IdleFn idle, void *ctx) {
+  if (2u < verify_idx0) return SPI_RESULT_ERR;
+  Spi0SrWrite w;
+  SpiOpResult ok0 = spi0_flash_sr_write_begin(&w, idx0, status, non_volatile, numbits, timeout_us);
+  if (SPI_RESULT_OK != ok0) return ok0;
+  spi0_flash_sr_write_wait(&w, idle, ctx);
+  return spi0_flash_sr_write_end(&w, verify_idx0, pVerify);
+}
+
+SpiOpResult IRAM_ATTR spi0_flash_wip_write(const uint8_t cmd, const uint32_t *data, const uint32_t mosi_bits, const uint32_t timeout_us, Spi0IdleFn idle, void *ctx, uint32_t *pStatus) {
+  Spi0SrWrite w;
+  SpiOpResult ok0 = spi0_flash_wip_write_begin(&w, cmd, data, mosi_bits, timeout_us);
+  if (SPI_RESULT_OK != ok0) return ok0;
+  spi0_flash_sr_write_wait(&w, idle, ctx);
+  return spi0_flash_sr_write_end(&w, 0u, pStatus);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Security Registers, see .h
+static inline bool is_security_register(const uint32_t reg) {
+  return 1u <= reg && 3u >= reg;
+}
+
+// Write Enable is still set after the write, the part ignored it. Clear it so
+// a later Status Register write is not made non-volatile by accident.
+static SpiOpResult check_wel_after_write(const SpiOpResult ok0, const uint32_t status) {
+  if (SPI_RESULT_OK != ok0) return ok0;
+  if (0u == (status & BIT1)) return SPI_RESULT_OK;  // WEL
+  spi0_flash_write_disable();
+  return SPI_RESULT_ERR;
+}
+
+SpiOpResult spi0_flash_erase_security_register(const uint32_t reg, Spi0IdleFn idle, void *ctx) {
+  if (! is_security_register(reg)) return SPI_RESULT_ERR;
+
+  FlashAddr24 addr24bit;
+  addr24bit.u32 = 0u;
+  spi_set_addr(addr24bit.u8, reg << 12u);
+  uint32_t status = 0u;
+  SpiOpResult ok0 = spi0_flash_wip_write(kEraseSecurityRegisterCmd, &addr24bit.u32, 24u, kSecurityRegisterEraseTimeoutUs, idle, ctx, &status);
+  return check_wel_after_write(ok0, status);
+}
+
+SpiOpResult spi0_flash_program_security_register(const uint32_t reg, const uint32_t offset, const void *p, const size_t sz, Spi0IdleFn idle, void *ctx) {
+  if (! is_security_register(reg) || nullptr == p || kSecurityRegisterSz < offset || kSecurityRegisterSz - offset < sz) return SPI_RESULT_ERR;
+
+  const uint8_t *src = (const uint8_t *)p;
+  uint32_t buf[kSpi0ReadMaxSz / sizeof(uint32_t)];
+  uint8_t *b = (uint8_t *)buf;
+  SpiOpResult ok0 = SPI_RESULT_OK;
+  for (size_t done = 0u; done < sz && SPI_RESULT_OK == ok0; ) {
+    const size_t chunk = (kSpi0ProgramMaxSz < sz - done) ? kSpi0ProgramMaxSz : sz - done;
+    // MSB of the address goes on the wire first, data follows
+    spi_set_addr(b, (reg << 12u) + offset + done);
+    memcpy(&b[3], &src[done], chunk);
+    uint32_t status = 0u;
+    ok0 = spi0_flash_wip_write(kProgramSecurityRegisterCmd, buf, (3u + chunk) * 8u, kSecurityRegisterProgramTimeoutUs, idle, ctx, &status);
+    ok0 = check_wel_after_write(ok0, status);
+    done += chunk;
+  }
+  return ok0;
+}
+
+struct VerifyCtx {
+  const uint8_t *p;
+  uint32_t base;
+  bool match;
+};
+
+static bool verify_sink(void *ctx, const uint32_t offset, const uint32_t *p, const size_t sz) {
+  VerifyCtx *v = (VerifyCtx *)ctx;
+  v->match = (0 == memcmp(&v->p[offset - v->base], p, sz));
+  return v->match;
+}
+
+SpiOpResult spi0_flash_verify_security_register(const uint32_t reg, const uint32_t offset, const void *p, const size_t sz) {
+  if (! is_security_register(reg) || nullptr == p || kSecurityRegisterSz < offset || kSecurityRegisterSz - offset < sz) return SPI_RESULT_ERR;
+
+  VerifyCtx v = {(const uint8_t *)p, (reg << 12u) + offset, true};
+  SpiOpResult ok0 = spi0_flash_read_secure_register_stream(reg, offset, sz, verify_sink, &v);
+  if (SPI_RESULT_OK != ok0) return ok0;
+  return (v.match) ? SPI_RESULT_OK : SPI_RESULT_ERR;
+}
+
+SpiOpResult spi0_flash_read_security_register_locks(uint32_t *pLocks) {
+  uint32_t status2 = 0u;
+  SpiOpResult ok0 = spi0_flash_read_status_register_2(&status2);
+  *pLocks = (SPI_RESULT_OK == ok0) ? (status2 >> kSecurityRegisterLockShift) & 7u : 0u;
+  return ok0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Serial dump lines, see .h
+size_t spi_flash_hex_line(const char *tag, const void *p, const size_t len, char *buf) {
+  static const char hex[] = "0123456789ABCDEF";
+  const uint8_t *b = (const uint8_t *)p;
+  char *s = buf;
+  memcpy(s, tag, 5u);
+  s += 5u;
+  for (size_t i = 0u; i < len; i++) {
+    *s++ = hex[b[i] >> 4u];
+    *s++ = hex[b[i] & 0x0Fu];
+  }
+  *s = '\0';
+  return s - buf;
 }
 
 };  // namespace experimental {
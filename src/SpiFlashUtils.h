@@ -29,12 +29,32 @@
 #define RECLAIM_GPIO_EARLY 1
 #endif
 
+#if ((1 - RECLAIM_RECIPE_CACHE - 1) == 2)
+#undef RECLAIM_RECIPE_CACHE
+#define RECLAIM_RECIPE_CACHE 1
+#endif
+
+#if ((1 - SR_WEAR_POLICY - 1) == 2)
+#undef SR_WEAR_POLICY
+#define SR_WEAR_POLICY 1
+#endif
+
+#include "ReclaimTimeline.h"    // RECLAIM_TIMELINE_MARK()
+#include "SpiFlashCost.h"       // SPI_FLASH_COST_*()
+#include "SpiFlashTrace.h"      // SPI_FLASH_TRACE_*()
+#include "SpiFlashLog.h"        // DEBUG_FLASH_QE_DEFERRED
+#include "SpiFlashShadow.h"     // SR_SHADOW_*()
+
 /*
   The debug printing could be controled/overriden by the module that includes
   this file; however, it is less confusing if we do it all in one place - this
   core include file.
 */
-#if !defined(DBG_SFU_PRINTF) && DEBUG_FLASH_QE && RECLAIM_GPIO_EARLY
+#if !defined(DBG_SFU_PRINTF) && DEBUG_FLASH_QE && DEBUG_FLASH_QE_DEFERRED
+// Store the format string address and arguments, print later. No UART needed,
+// see SpiFlashLog.h.
+#define DBG_SFU_PRINTF(fmt, ...) experimental::sfu_log(PSTR(fmt), ##__VA_ARGS__)
+#elif !defined(DBG_SFU_PRINTF) && DEBUG_FLASH_QE && RECLAIM_GPIO_EARLY
 // Use lower level print functions when printing before "C++" runtime has
 // initialized. Since no ISRs are involved we can save on DRAM strings by using
 // umm_info_safe_printf_P().
@@ -106,19 +126,65 @@ constexpr uint8_t kReadSecurityRegisterCmd    = 0x48u;
 // operation and is combined with spi0_flash_write_volatile_enable(), the subsequent
 // write status register operation may save to the non-volatile register.
 
+////////////////////////////////////////////////////////////////////////////////
+// Library flash instructions go through _spi0_command() which keeps a count of
+// the transactions sent. A prefix instruction, like 06h or 50h, is a
+// transaction. To measure an operation's cost, zero the count before and read
+// it after. The count lives in .noinit since it is used in preinit() before
+// the C++ runtime has initialized.
+extern uint32_t spi0_flash_xfer_count;
+
+#if SR_WEAR_POLICY
+// Non-volatile Status Register writes sent since the last sr_wear_commit(),
+// SR1 - SR3. Counted inline, safe with the iCache off. The wear policy in
+// SpiFlashUtilsQE.h folds these into its persistent counters.
+extern uint32_t sr_wear_uncommitted[3];
+
+inline __attribute__((always_inline))
+void sr_wear_note(const uint32_t cmd, const uint32_t pre_cmd) {
+  if (kWriteEnableCmd != pre_cmd) return;
+  if (kWriteStatusRegister1Cmd == cmd) {
+    sr_wear_uncommitted[0]++;
+  } else if (kWriteStatusRegister2Cmd == cmd) {
+    sr_wear_uncommitted[1]++;
+  } else if (kWriteStatusRegister3Cmd == cmd) {
+    sr_wear_uncommitted[2]++;
+  }
+}
+#define SR_WEAR_NOTE(cmd, pre_cmd) sr_wear_note((cmd), (pre_cmd))
+#else
+#define SR_WEAR_NOTE(cmd, pre_cmd) do {} while (false)
+#endif
+
+inline
+SpiOpResult _spi0_command(uint8_t cmd, uint32_t *data, uint32_t mosi_bits, uint32_t miso_bits, uint32_t pre_cmd = SPI_FLASH_CMD_NOT_USED) {
+  spi0_flash_xfer_count += (SPI_FLASH_CMD_NOT_USED == pre_cmd) ? 1u : 2u;
+  RECLAIM_TIMELINE_MARK(kReclaimPhaseSpi0Command, cmd);
+  SPI_FLASH_COST_COMMAND(cmd, mosi_bits, miso_bits, pre_cmd);
+  SR_WEAR_NOTE(cmd, pre_cmd);
+  SPI_FLASH_TRACE_BEGIN(trace, cmd, pre_cmd, mosi_bits, miso_bits, data);
+  SpiOpResult ok0 = SPI0Command(cmd, data, mosi_bits, miso_bits, pre_cmd);
+  SR_SHADOW_NOTE(ok0, cmd, pre_cmd, miso_bits, (miso_bits && data) ? data[0] : 0u);
+  SR_SHADOW_IDLE();
+  SPI_FLASH_TRACE_END(trace, kSpiTraceCommand, ok0, (miso_bits && data) ? data[0] : 0u);
+  return ok0;
+}
+
 // These two are seldom needed when using SPI0Command's pre_cmd argument
 inline
 SpiOpResult spi0_flash_write_volatile_enable(void) {
-  return SPI0Command(kVolatileWriteEnableCmd, NULL, 0u, 0);
+  return _spi0_command(kVolatileWriteEnableCmd, NULL, 0u, 0);
 }
 inline
 SpiOpResult spi0_flash_write_enable(void) {
-  return SPI0Command(kWriteEnableCmd, NULL, 0u, 0);
+  return _spi0_command(kWriteEnableCmd, NULL, 0u, 0);
 }
 
+// Not sent while the Status Register shadow knows WEL is clear, see SpiFlashShadow.h
 inline
 SpiOpResult spi0_flash_write_disable() {
-  return SPI0Command(kWriteDisableCmd, NULL, 0u, 0);
+  if (SR_SHADOW_SKIP_WRDI()) return SPI_RESULT_OK;
+  return _spi0_command(kWriteDisableCmd, NULL, 0u, 0);
 }
 
 inline
@@ -135,7 +201,8 @@ SpiOpResult spi0_flash_read_status_register(const size_t idx0, uint32_t *pStatus
     // panic();
     return SPI_RESULT_ERR;
   }
-  return SPI0Command(cmd, pStatus, 0u, 8u);
+  if (SR_SHADOW_READ(idx0, pStatus)) return SPI_RESULT_OK;
+  return _spi0_command(cmd, pStatus, 0u, 8u);
 }
 
 #if 0
@@ -152,8 +219,17 @@ SpiOpResult spi0_flash_read_status_register_1(uint32_t *pStatus) {
 inline
 SpiOpResult spi0_flash_read_status_register_1(uint32_t *pStatus) {
   *pStatus = 0u;
+  if (SR_SHADOW_READ(0u, pStatus)) return SPI_RESULT_OK;
+  spi0_flash_xfer_count++;
+  RECLAIM_TIMELINE_MARK(kReclaimPhaseSpi0Command, kReadStatusRegister1Cmd);
+  // Wait_SPI_Idle and the read, both BootROM status reads
+  SPI_FLASH_COST_WINDOW(2u);
+  SPI_FLASH_TRACE_BEGIN(trace, kReadStatusRegister1Cmd, 0u, 0u, 8u, NULL);
   // Use the version provided by the SDK - return enums are the same
-  return (SpiOpResult)spi_flash_read_status(pStatus);
+  SpiOpResult ok0 = (SpiOpResult)spi_flash_read_status(pStatus);
+  SR_SHADOW_NOTE(ok0, kReadStatusRegister1Cmd, 0u, 8u, *pStatus);
+  SPI_FLASH_TRACE_END(trace, kSpiTraceStatus, ok0, *pStatus);
+  return ok0;
 }
 #endif
 
@@ -185,7 +261,7 @@ SpiOpResult spi0_flash_write_status_register(const uint32_t idx0, uint32_t statu
     spi0_flash_write_disable();
     prefix = kVolatileWriteEnableCmd;
   }
-  return SPI0Command(cmd, &status, numbits, 0u, prefix);
+  return _spi0_command(cmd, &status, numbits, 0u, prefix);
 }
 
 inline
@@ -195,7 +271,7 @@ SpiOpResult spi0_flash_write_status_register_1(uint32_t status, const bool non_v
     spi0_flash_write_disable();
     prefix = kVolatileWriteEnableCmd;
   }
-  return SPI0Command(kWriteStatusRegister1Cmd, &status, numbits, 0u, prefix);
+  return _spi0_command(kWriteStatusRegister1Cmd, &status, numbits, 0u, prefix);
 }
 
 inline
@@ -205,7 +281,7 @@ SpiOpResult spi0_flash_write_status_register_2(uint32_t status, const bool non_v
     spi0_flash_write_disable();
     prefix = kVolatileWriteEnableCmd;
   }
-  return SPI0Command(kWriteStatusRegister2Cmd, &status, 8u, 0u, prefix);
+  return _spi0_command(kWriteStatusRegister2Cmd, &status, 8u, 0u, prefix);
 }
 
 inline
@@ -215,7 +291,7 @@ SpiOpResult spi0_flash_write_status_register_3(uint32_t status, const bool non_v
     spi0_flash_write_disable();
     prefix = kVolatileWriteEnableCmd;
   }
-  return SPI0Command(kWriteStatusRegister3Cmd, &status, 8u, 0u, prefix);
+  return _spi0_command(kWriteStatusRegister3Cmd, &status, 8u, 0u, prefix);
 }
 
 struct FlashAddr24 {
@@ -233,6 +309,9 @@ void spi_set_addr(uint8_t *buf, const uint32_t addr) {
 }
 
 
+// Read the registers in regs, bit per register SR1 - SR3, one sequence, into a
+// 24-bit value. SR1 in bits 7:0.
+SpiOpResult spi0_flash_read_status_registers(const uint32_t regs, uint32_t *pStatus);
 SpiOpResult spi0_flash_read_status_registers_2B(uint32_t *pStatus);
 SpiOpResult spi0_flash_read_status_registers_3B(uint32_t *pStatus);
 
@@ -263,6 +342,142 @@ SpiOpResult spi0_flash_write_status_registers_2B(uint32_t status16, const bool n
 // between them.
 void spi0_flash_command_pair(const uint8_t cmd1, const uint8_t cmd2, const uint32_t us = 0);
 
+////////////////////////////////////////////////////////////////////////////////
+// SPI0 Flash micro-sequence
+//
+// Run a short program of flash instructions inside one iCache disabled,
+// interrupts off, window. Each SPI0Command call pays for its own
+// Cache_Read_Disable_2/Cache_Read_Enable_2, Wait_SPI_Idle, and trailing
+// SPI_read_status. A read-write-verify of a Status Register is three or four of
+// those. As a sequence, it is one.
+//
+// Each step is an instruction with an optional prefix instruction, like 06h or
+// 50h, and up to 32 bits of data out and/or back. Data out is taken from
+// `data`. On return, `data` holds the reply for steps with miso_bits. Unused
+// reply bits are cleared, same as SPI0Command.
+//
+// A step with a prefix instruction is treated as a write. Before the next step
+// runs, we spin on WIP. Interrupts stay off for the whole sequence. Keep
+// sequences short, especially with non-volatile writes.
+//
+// Returns SPI_RESULT_OK when all steps ran. On error, steps after the failing
+// step are not run.
+//
+struct Spi0Step {
+  uint8_t  cmd;             // Flash instruction
+  uint8_t  pre_cmd;         // Prefix instruction, 0 for none
+  uint8_t  mosi_bits;       // 0 - 32, bits sent from data, LSB goes first
+  uint8_t  miso_bits;       // 0 - 32, bits returned in data
+  uint32_t data;
+};
+
+constexpr size_t kSpi0SeqMaxSteps = 8u;
+
+SpiOpResult spi0_flash_sequence(Spi0Step *steps, const size_t count);
+
+// Write a Status Register then read back a Status Register, as one sequence.
+// idx0 and verify_idx0 are zero-based {0, 1, 2} for SR1, SR2, and SR3.
+// Like spi0_flash_write_status_register(), a volatile write is lead by a Write
+// Disable to clear a WEL bit left set from a failed write.
+// A non-volatile write goes through spi0_flash_write_verify_status_register_wip()
+// below, interrupts stay on while the part is busy.
+SpiOpResult spi0_flash_write_verify_status_register(const uint32_t idx0, const uint32_t status, const bool non_volatile, const uint32_t numbits, const uint32_t verify_idx0, uint32_t *pVerify);
+
+////////////////////////////////////////////////////////////////////////////////
+// Split-phase Status Register write
+//
+// A non-volatile Status Register write keeps the part busy, WIP set, for its
+// write time, tW, often 5 - 15 ms. Until WIP clears, the iCache cannot read
+// the flash. SPI0Command and spi0_flash_sequence() leave that wait to the
+// BootROM's SPI_read_status() spin, with no upper bound, and for a sequence
+// with interrupts off.
+//
+// Here the write is split in three:
+//
+//   spi0_flash_sr_write_begin() - opens an iCache disabled window, sends the
+//     write, and returns with the window still open and interrupts on.
+//   spi0_flash_sr_write_poll() - one Read Status Register-1, a few us. Returns
+//     true when WIP is clear or the timeout has passed.
+//   spi0_flash_sr_write_end() - reads back a Status Register to verify,
+//     restores SPI0, and closes the window.
+//
+// Between begin and end the iCache is off. The caller, and anything it calls,
+// must be in IRAM with its data in DRAM. IRAM ISRs keep running. An ISR in
+// flash, which the core does not allow anyway, would crash.
+//
+// spi0_flash_sr_write_wait() is the polling loop. It calls an optional IRAM
+// idle function between polls, or without one, waits kSpi0SrWritePollUs.
+//
+// When the timeout passes with WIP still set, end() has no choice but to wait
+// for the part, with the BootROM spin, before the iCache can run again. It
+// returns SPI_RESULT_TIMEOUT so the caller knows the bound was missed.
+//
+enum Spi0SrWriteState : uint8_t {
+  kSpi0SrWriteIdle = 0u,
+  kSpi0SrWriteBusy,         // Written, WIP set at the last poll
+  kSpi0SrWriteDone,         // WIP clear
+  kSpi0SrWriteTimedOut,     // WIP still set after timeout_us
+};
+
+struct Spi0SrWrite {
+  uint32_t start;           // esp_get_cycle_count() after the write went out
+  uint32_t timeout_cycles;
+  uint32_t polls;           // Read Status Register-1 polls, including the last
+  uint32_t status;          // Status Register-1 at the last poll
+  uint32_t saved_spi0c;     // SPI0 state to restore at end
+  uint32_t saved_spi0u;
+  uint32_t saved_spi0u2;
+  uint8_t  state;           // Spi0SrWriteState
+  bool     cost_polls;      // Program, erase: polls go to spi0_flash_cost, there is no tW
+};
+
+// Called between polls, with the iCache off. Must be IRAM_ATTR.
+typedef void (*Spi0IdleFn)(void *ctx);
+
+constexpr uint32_t kSpi0SrWritePollUs = 50u;
+
+// SFDP has no Status Register write time. Base it on the page program time,
+// eg. the W25Q32 has a tW max of 15 ms against 3 ms for a page program. Allow
+// 10 times, kept within 10 ms and 100 ms. With no SFDP value,
+// page_program_max_us = 0, use the max.
+constexpr uint32_t kSpi0SrWriteTimeoutMinUs = 10000u;
+constexpr uint32_t kSpi0SrWriteTimeoutMaxUs = 100000u;
+
+constexpr uint32_t spi0_sr_write_timeout_us(const uint32_t page_program_max_us) {
+  return (0u == page_program_max_us) ? kSpi0SrWriteTimeoutMaxUs
+       : (kSpi0SrWriteTimeoutMinUs > page_program_max_us * 10u) ? kSpi0SrWriteTimeoutMinUs
+       : (kSpi0SrWriteTimeoutMaxUs < page_program_max_us * 10u) ? kSpi0SrWriteTimeoutMaxUs
+       : page_program_max_us * 10u;
+}
+
+// Timeout used by spi0_flash_write_verify_status_register(). Set it from
+// SfdpBasicParams::page_program_max_us with spi0_sr_write_timeout_us().
+extern uint32_t spi0_flash_sr_write_timeout_us;
+
+// Returns SPI_RESULT_ERR, with no window opened, for a bad idx0 or numbits.
+// On SPI_RESULT_OK the window is open, end() must follow.
+SpiOpResult spi0_flash_sr_write_begin(Spi0SrWrite *w, const uint32_t idx0, const uint32_t status, const bool non_volatile, const uint32_t numbits, const uint32_t timeout_us);
+bool spi0_flash_sr_write_poll(Spi0SrWrite *w);
+// Polls until WIP clears or the timeout passes. Returns SPI_RESULT_OK or
+// SPI_RESULT_TIMEOUT. The window is still open.
+SpiOpResult spi0_flash_sr_write_wait(Spi0SrWrite *w, Spi0IdleFn idle, void *ctx);
+// verify_idx0 {0, 1, 2} for SR1, SR2, and SR3. pVerify may be NULL.
+SpiOpResult spi0_flash_sr_write_end(Spi0SrWrite *w, const uint32_t verify_idx0, uint32_t *pVerify);
+
+// begin, wait, and end in one IRAM call, callable from flash.
+SpiOpResult spi0_flash_write_verify_status_register_wip(const uint32_t idx0, const uint32_t status, const bool non_volatile, const uint32_t numbits, const uint32_t verify_idx0, uint32_t *pVerify, const uint32_t timeout_us, Spi0IdleFn idle, void *ctx);
+
+// Split-phase program and erase. The same window as the Status Register write:
+// begin sends Write Enable, then cmd with mosi_bits from data, eg. a 24-bit
+// address and program data, up to the 64 bytes of W0 - W15. Poll, wait, and
+// end as above. End with verify_idx0 = 0 to read back Status Register-1; WEL
+// still set means the part ignored cmd.
+SpiOpResult spi0_flash_wip_write_begin(Spi0SrWrite *w, const uint8_t cmd, const uint32_t *data, const uint32_t mosi_bits, const uint32_t timeout_us);
+
+// begin, wait, and end in one IRAM call. pStatus, may be NULL, gets Status
+// Register-1 after.
+SpiOpResult spi0_flash_wip_write(const uint8_t cmd, const uint32_t *data, const uint32_t mosi_bits, const uint32_t timeout_us, Spi0IdleFn idle, void *ctx, uint32_t *pStatus);
+
 inline
 SpiOpResult spi0_flash_software_reset(uint32_t delay_us) {
   spi0_flash_command_pair(kEnableResetCmd, kResetCmd, delay_us);
@@ -271,7 +486,7 @@ SpiOpResult spi0_flash_software_reset(uint32_t delay_us) {
 
 inline
 SpiOpResult spi0_flash_chip_erase() {
-  SpiOpResult ok0 = SPI0Command(kChipEraseCmd, NULL, 0u, 0u, kWriteEnableCmd);
+  SpiOpResult ok0 = _spi0_command(kChipEraseCmd, NULL, 0u, 0u, kWriteEnableCmd);
   // On success - At return, all is unstable. Running on code cached before the
   // Flash was erased. When that runs out we crash.
   if (SPI_RESULT_OK == ok0) while(true);
@@ -280,13 +495,34 @@ SpiOpResult spi0_flash_chip_erase() {
 
 ////////////////////////////////////////////////////////////////////////////////
 // common 24 bit address reads with one dummpy byte.
+//
+// SPI0Command limits a transfer to the 64 bytes held in W0 - W15. Larger reads
+// are split into as few 64 byte transfers as possible, each is read directly
+// into the caller's buffer. eg. a 256 byte SFDP read is 4 transfers.
+// The buffer at p must hold (sz + 3) / 4 words. Unused bytes in the last word
+// are cleared.
+constexpr size_t kSpi0ReadMaxSz = 64u;
+
 SpiOpResult _spi0_flash_read_common(const uint32_t offset, uint32_t *p, const size_t sz, const uint8_t cmd);
 
+// Streaming version of the above. For each transfer, sink is called with the
+// offset, data, and byte count for that transfer. The data is only valid for
+// the duration of the call. Return false from sink to stop early. Stopping
+// early is not an error.
+typedef bool (*Spi0ReadSink)(void *ctx, const uint32_t offset, const uint32_t *p, const size_t sz);
+
+SpiOpResult _spi0_flash_read_stream(const uint32_t offset, const size_t sz, const uint8_t cmd, Spi0ReadSink sink, void *ctx);
+
 inline
 SpiOpResult spi0_flash_read_sfdp(const uint32_t addr, uint32_t *p, const size_t sz) {
   return _spi0_flash_read_common(addr, p, sz, kReadSFDPCmd);
 }
 
+inline
+SpiOpResult spi0_flash_read_sfdp_stream(const uint32_t addr, const size_t sz, Spi0ReadSink sink, void *ctx) {
+  return _spi0_flash_read_stream(addr, sz, kReadSFDPCmd, sink, ctx);
+}
+
 #if 1
 // Extra flash commands - not all flash support these or support them in the
 // same way. While this is true in general with SPI Flash, it may be more
@@ -316,8 +552,55 @@ SpiOpResult spi0_flash_read_secure_register(const uint32_t reg, const uint32_t o
   // reg range {1, 2, 3}
   return _spi0_flash_read_common((reg << 12u) + offset, p, sz, kReadSecurityRegisterCmd);
 }
+
+inline
+SpiOpResult spi0_flash_read_secure_register_stream(const uint32_t reg, const uint32_t offset, const size_t sz, Spi0ReadSink sink, void *ctx) {
+  // reg range {1, 2, 3}
+  return _spi0_flash_read_stream((reg << 12u) + offset, sz, kReadSecurityRegisterCmd, sink, ctx);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Security Registers
+//
+// Three 256 byte registers, reg {1, 2, 3}, at address reg << 12. This is the
+// Winbond layout, GigaDevice, XMC and others follow it. Each register is one
+// page: erase is per register and a program must not run past its end. Lock
+// bits LB1 - LB3 are OTP, Status Register-2 bits 3 - 5. Once set, that
+// register is read-only for good.
+//
+// Program and erase keep the iCache off until WIP clears, up to
+// kSecurityRegisterEraseTimeoutUs for an erase. Interrupts stay on, only IRAM
+// ISRs run. An idle function must be IRAM_ATTR. Best done before WiFi starts.
+constexpr size_t kSecurityRegisterSz = 256u;
+constexpr uint32_t kSecurityRegisterLockShift = 3u;  // LB1 in Status Register-2
+// W0 - W15 less the 24-bit address, in whole words
+constexpr size_t kSpi0ProgramMaxSz = kSpi0ReadMaxSz - sizeof(uint32_t);
+// tPP is 3 ms max or less. Security Register erase is a sector erase, tSE max
+// is 400 ms on the W25Q32.
+constexpr uint32_t kSecurityRegisterProgramTimeoutUs = 5000u;
+constexpr uint32_t kSecurityRegisterEraseTimeoutUs = 500000u;
+
+SpiOpResult spi0_flash_erase_security_register(const uint32_t reg, Spi0IdleFn idle, void *ctx);
+// Program sz bytes at offset, in kSpi0ProgramMaxSz pieces. Bits only go from
+// 1 to 0, erase first to write over old data. SPI_RESULT_ERR when the part
+// ignores the program, eg. the register is locked.
+SpiOpResult spi0_flash_program_security_register(const uint32_t reg, const uint32_t offset, const void *p, const size_t sz, Spi0IdleFn idle, void *ctx);
+// Read back and compare. SPI_RESULT_ERR on a mismatch.
+SpiOpResult spi0_flash_verify_security_register(const uint32_t reg, const uint32_t offset, const void *p, const size_t sz);
+// *pLocks bit 0 is LB1 for reg 1, and so on.
+SpiOpResult spi0_flash_read_security_register_locks(uint32_t *pLocks);
+
+inline
+SpiOpResult spi0_flash_read_unique_id_stream(const uint32_t offset, const size_t sz, Spi0ReadSink sink, void *ctx) {
+  return _spi0_flash_read_stream(offset, sz, kReadUniqueIdCmd, sink, ctx);
+}
 #endif
 
+////////////////////////////////////////////////////////////////////////////////
+// Serial dump lines, a 4 character tag and ':', then len bytes as upper case
+// hex. buf needs 5 + 2 * len + 1 bytes. Returns the length.
+size_t spi_flash_hex_line(const char *tag, const void *p, const size_t len, char *buf);
+
 #if (RECLAIM_GPIO_EARLY == 2)
 // Use when Flash ID is needed before the NONOS_SDK has initialized; however,
 // with the current implementation of this library, the earliest we run is
@@ -327,7 +610,7 @@ SpiOpResult spi0_flash_read_secure_register(const uint32_t reg, const uint32_t o
 inline
 uint32_t alt_spi_flash_get_id(void) {
   uint32_t _id = 0u;
-  SpiOpResult ok0 = SPI0Command(kJedecId, &_id, 0u, 24u);
+  SpiOpResult ok0 = _spi0_command(kJedecId, &_id, 0u, 24u);
   return (SPI_RESULT_OK == ok0) ? _id : 0xFFFFFFFFu;
 }
 #endif
@@ -17,6 +17,8 @@
   QE bit - SPI0 Flash Utilities
 */
 #include <Arduino.h>
+#include <user_interface.h>   // system_rtc_mem_read(), system_rtc_mem_write()
+#include <coredecls.h>        // crc32()
 #include <SpiFlashUtilsQE.h>
 
 #ifdef __cplusplus
@@ -70,10 +72,149 @@ bool set_S6_QE_bit__8_bit_sr1_write_EN25Q32B_volatile(void) {
 }
 #endif
 
+// Set from preinit() with RECLAIM_GPIO_EARLY, keep out of .bss
+QeRecipe qe_recipe __attribute__((section(".noinit")));
+
+static inline void note_qe_recipe(const QeRecipeKind kind, const bool non_volatile) {
+  qe_recipe.kind = kind;
+  qe_recipe.non_volatile = (non_volatile) ? 1u : 0u;
+}
+
+#if SR_WEAR_POLICY
+////////////////////////////////////////////////////////////////////////////////
+// Status Register wear policy. See .h
+constexpr uint32_t kSrWearMagic = 0x53525731u; // "SRW1"
+
+struct SrWearRecord {
+  uint32_t magic;
+  SrWearCounters c;
+  uint32_t crc;
+};
+static_assert(36u == sizeof(SrWearRecord), "Record size changed, check SR_WEAR_RTC_BLOCK");
+
+// Used from preinit() with RECLAIM_GPIO_EARLY, keep out of .bss. Like
+// sr_wear_uncommitted, both survive a reset in DRAM.
+static SrWearCounters sr_wear __attribute__((section(".noinit")));
+static uint32_t sr_wear_magic __attribute__((section(".noinit")));
+
+bool __sr_wear_mirror_load(SrWearCounters *c) {
+  (void)c;
+  return false;
+}
+void __sr_wear_mirror_save(const SrWearCounters *c) {
+  (void)c;
+}
+bool sr_wear_mirror_load(SrWearCounters *c) __attribute__ ((weak, alias("__sr_wear_mirror_load")));
+void sr_wear_mirror_save(const SrWearCounters *c) __attribute__ ((weak, alias("__sr_wear_mirror_save")));
+
+static uint32_t sr_wear_crc(const SrWearRecord& rec) {
+  return crc32(&rec, offsetof(SrWearRecord, crc));
+}
+
+static void sr_wear_save(const bool mirror) {
+  SrWearRecord rec;
+  rec.magic = kSrWearMagic;
+  rec.c = sr_wear;
+  rec.crc = sr_wear_crc(rec);
+  system_rtc_mem_write(SR_WEAR_RTC_BLOCK, &rec, sizeof(rec));
+  if (mirror) sr_wear_mirror_save(&sr_wear);
+}
+
+static void sr_wear_load() {
+  if (kSrWearMagic == sr_wear_magic) return;
+  SrWearRecord rec;
+  if (system_rtc_mem_read(SR_WEAR_RTC_BLOCK, &rec, sizeof(rec)) &&
+      kSrWearMagic == rec.magic && sr_wear_crc(rec) == rec.crc) {
+    // Deep sleep wake
+    sr_wear = rec.c;
+  } else {
+    // Power on
+    memset(&sr_wear, 0, sizeof(sr_wear));
+    if (sr_wear_mirror_load(&sr_wear)) sr_wear.nv_since_power_on = 0u;
+  }
+  // DRAM was lost, so was any count in sr_wear_uncommitted. A write sent
+  // before this first load is not counted.
+  memset(sr_wear_uncommitted, 0, sizeof(sr_wear_uncommitted));
+  sr_wear_magic = kSrWearMagic;
+}
+
+static void sr_wear_update(const bool changed) {
+  sr_wear_load();
+  uint32_t n = 0u;
+  for (size_t i = 0u; i < 3u; i++) {
+    sr_wear.nv_writes[i] += sr_wear_uncommitted[i];
+    n += sr_wear_uncommitted[i];
+    sr_wear_uncommitted[i] = 0u;
+  }
+  sr_wear.nv_since_power_on += n;
+  if (n || changed) sr_wear_save(0u != n);
+}
+
+void sr_wear_commit() {
+  sr_wear_update(false);
+}
+
+const SrWearCounters *sr_wear_counters() {
+  sr_wear_update(false);
+  return &sr_wear;
+}
+
+bool sr_wear_nv_write_allowed(const uint32_t idx0) {
+  if (2u < idx0) return false;
+  sr_wear_update(false);
+  return SR_WEAR_NV_BUDGET > sr_wear.nv_writes[idx0] &&
+         SR_WEAR_NV_PER_POWER_ON > sr_wear.nv_since_power_on;
+}
+
+void sr_wear_reset() {
+  memset(sr_wear_uncommitted, 0, sizeof(sr_wear_uncommitted));
+  memset(&sr_wear, 0, sizeof(sr_wear));
+  sr_wear_magic = kSrWearMagic;
+  sr_wear_save(true);
+}
+#endif
+
+// All QE bit writes go through here. Returns the non-volatile write flag as
+// written, false when the wear policy substituted a volatile write. mask
+// selects the bits of the verify register that must match.
+static bool qe_write_verify(const uint32_t idx0, const uint32_t status, const bool non_volatile, const uint32_t numbits, const uint32_t verify_idx0, const uint32_t mask, uint32_t *pVerify) {
+#if SR_WEAR_POLICY
+  if (non_volatile) {
+    sr_wear_load();
+    const uint32_t expect = status >> (8u * (verify_idx0 - idx0));
+    if (SR_WEAR_VOLATILE_FIRST && 0u == (sr_wear.volatile_failed & (1u << idx0))) {
+      spi0_flash_write_verify_status_register(idx0, status, volatile_bit, numbits, verify_idx0, pVerify);
+      if (0u == ((*pVerify ^ expect) & mask)) {
+        DBG_SFU_PRINTF("  Wear policy: volatile write used for SR%u.\n", idx0 + 1u);
+        sr_wear.substituted++;
+        sr_wear_update(true);
+        return volatile_bit;
+      }
+      sr_wear.volatile_failed |= 1u << idx0;
+    }
+    if (! sr_wear_nv_write_allowed(idx0)) {
+      DBG_SFU_PRINTF("* Wear policy: non-volatile write to SR%u refused.\n", idx0 + 1u);
+      sr_wear.refused++;
+      sr_wear_update(true);
+      spi0_flash_read_status_register(verify_idx0, pVerify);
+      return non_volatile;
+    }
+    spi0_flash_write_verify_status_register(idx0, status, non_volatile, numbits, verify_idx0, pVerify);
+    sr_wear_update(true);
+    return non_volatile;
+  }
+#else
+  (void)mask;
+#endif
+  spi0_flash_write_verify_status_register(idx0, status, non_volatile, numbits, verify_idx0, pVerify);
+  return non_volatile;
+}
+
 // For the EON EN25Q32C flash, the S6 bit is refered to as Write Protect Disable
 // (WPDis)
 //C renamed set_S6_QE_bit_WPDis to set_S6_QE_bit__8_bit_sr1_write
 bool set_S6_QE_bit__8_bit_sr1_write(const bool non_volatile) {
+  note_qe_recipe(kQeRecipeS6_8bitSR1, non_volatile);
   uint32_t status = 0u;
   spi0_flash_read_status_register_1(&status);
   bool is_set = (0u != (status & kQES6Bit));
@@ -89,8 +230,13 @@ bool set_S6_QE_bit__8_bit_sr1_write(const bool non_volatile) {
 #endif
   // All changes made to the volatile copies of the Status Register-1.
   DBG_SFU_PRINTF("  Setting %svolatile %s bit.\n", (non_volatile) ? "non-" : "", "S6/QE/WPDis");
-  spi0_flash_write_status_register_1(status, non_volatile);
-  return is_S6_QE();
+  uint32_t verify = 0u;
+  const bool wrote_nv = qe_write_verify(/* SR1 */ 0u, status, non_volatile, 8u, /* SR1 */ 0u, kQES6Bit, &verify);
+  note_qe_recipe(kQeRecipeS6_8bitSR1, wrote_nv);
+  is_set = (0u != (verify & kQES6Bit));
+  RECLAIM_TIMELINE_MARK(kReclaimPhaseVerify, is_set);
+  DBG_SFU_PRINTF("  %s bit %s set.\n", "S6/QE/WPDis", (is_set) ? "confirmed" : "NOT");
+  return is_set;
 }
 
 //C renamed clear_S6_QE_bit_WPDis to clear_S6_QE_bit__8_bit_sr1_write
@@ -110,11 +256,15 @@ bool clear_S6_QE_bit__8_bit_sr1_write(const bool non_volatile) {
 #endif
   // All changes made to the volatile copies of the Status Register-1.
   DBG_SFU_PRINTF("  Clearing %svolatile S6/QE/WPDis bit - 8-bit write.\n", non_volatile ? "non-" : "");
-  spi0_flash_write_status_register_1(status, non_volatile);
-  return (false == is_S6_QE());
+  uint32_t verify = 0u;
+  qe_write_verify(/* SR1 */ 0u, status, non_volatile, 8u, /* SR1 */ 0u, kQES6Bit, &verify);
+  not_set = (0u == (verify & kQES6Bit));
+  DBG_SFU_PRINTF("  %s bit %s set.\n", "S6/QE/WPDis", (not_set) ? "NOT" : "confirmed");
+  return not_set;
 }
 
 bool set_S9_QE_bit__8_bit_sr2_write(const bool non_volatile) {
+  note_qe_recipe(kQeRecipeS9_8bitSR2, non_volatile);
   uint32_t status2 = 0u;
   spi0_flash_read_status_register_2(&status2);
   bool is_set = (0u != (status2 & kQES9Bit1B));
@@ -129,11 +279,17 @@ bool set_S9_QE_bit__8_bit_sr2_write(const bool non_volatile) {
   status2 = kQES9Bit1B;
 #endif
   DBG_SFU_PRINTF("  Setting %svolatile %s bit - %u-bit write.\n", (non_volatile) ? "non-" : "", "QE", 8u);
-  spi0_flash_write_status_register_2(status2, non_volatile);
-  return is_QE();
+  uint32_t verify = 0u;
+  const bool wrote_nv = qe_write_verify(/* SR2 */ 1u, status2, non_volatile, 8u, /* SR2 */ 1u, kQES9Bit1B, &verify);
+  note_qe_recipe(kQeRecipeS9_8bitSR2, wrote_nv);
+  is_set = (0u != (verify & kQES9Bit1B));
+  RECLAIM_TIMELINE_MARK(kReclaimPhaseVerify, is_set);
+  DBG_SFU_PRINTF("  %s bit %s set.\n", "QE", (is_set) ? "confirmed" : "NOT");
+  return is_set;
 }
 
 bool set_S9_QE_bit__16_bit_sr1_write(const bool non_volatile) {
+  note_qe_recipe(kQeRecipeS9_16bitSR1, non_volatile);
   uint32_t status = 0u;
   spi0_flash_read_status_registers_2B(&status);
   bool is_set = (0u != (status & kQES9Bit2B));
@@ -148,8 +304,13 @@ bool set_S9_QE_bit__16_bit_sr1_write(const bool non_volatile) {
   status = kQES9Bit2B;
 #endif
   DBG_SFU_PRINTF("  Setting %svolatile %s bit - %u-bit write.\n", (non_volatile) ? "non-" : "", "QE", 16u);
-  spi0_flash_write_status_registers_2B(status, non_volatile);
-  return is_QE();
+  uint32_t verify = 0u;
+  const bool wrote_nv = qe_write_verify(/* SR1 */ 0u, status, non_volatile, 16u, /* SR2 */ 1u, kQES9Bit1B, &verify);
+  note_qe_recipe(kQeRecipeS9_16bitSR1, wrote_nv);
+  is_set = (0u != (verify & kQES9Bit1B));
+  RECLAIM_TIMELINE_MARK(kReclaimPhaseVerify, is_set);
+  DBG_SFU_PRINTF("  %s bit %s set.\n", "QE", (is_set) ? "confirmed" : "NOT");
+  return is_set;
 }
 
 
@@ -168,8 +329,12 @@ bool clear_S9_QE_bit__8_bit_sr2_write(const bool non_volatile) {
   status2 = 0u;
 #endif
   DBG_SFU_PRINTF("  Clear %svolatile %s bit - %u-bit write.\n", (non_volatile) ? "non-" : "", "QE", 8u);
-  spi0_flash_write_status_register_2(status2, non_volatile);
-  return (false == is_QE());
+  uint32_t verify = 0u;
+  qe_write_verify(/* SR2 */ 1u, status2, non_volatile, 8u, /* SR2 */ 1u, kQES9Bit1B, &verify);
+  is_set = (0u != (verify & kQES9Bit1B));
+  RECLAIM_TIMELINE_MARK(kReclaimPhaseVerify, is_set);
+  DBG_SFU_PRINTF("  %s bit %s set.\n", "QE", (is_set) ? "confirmed" : "NOT");
+  return (false == is_set);
 }
 
 bool clear_S9_QE_bit__16_bit_sr1_write(const bool non_volatile) {
@@ -187,11 +352,91 @@ bool clear_S9_QE_bit__16_bit_sr1_write(const bool non_volatile) {
   status = 0u;
 #endif
   DBG_SFU_PRINTF("  Setting %svolatile %s bit - %u-bit write.\n", (non_volatile) ? "non-" : "", "QE", 16u);
-  spi0_flash_write_status_registers_2B(status, non_volatile);
-  return (false == is_QE());
+  uint32_t verify = 0u;
+  qe_write_verify(/* SR1 */ 0u, status, non_volatile, 16u, /* SR2 */ 1u, kQES9Bit1B, &verify);
+  is_set = (0u != (verify & kQES9Bit1B));
+  RECLAIM_TIMELINE_MARK(kReclaimPhaseVerify, is_set);
+  DBG_SFU_PRINTF("  %s bit %s set.\n", "QE", (is_set) ? "confirmed" : "NOT");
+  return (false == is_set);
 }
 
 
+////////////////////////////////////////////////////////////////////////////////
+// Repeat a noted QE recipe. A Write Disable and a read of QE go first, and
+// nothing is written when QE is already set. A write can clear Status
+// Register-3 on an XMC part, and the recipe only restores it when the handler
+// noted it. Otherwise, the write and any Status Register-3 restore, then the
+// verify read, are a second sequence. A non-volatile write goes first on its
+// own, through the split-phase write, so tW is not spent with interrupts off.
+bool apply_qe_recipe(const QeRecipe recipe) {
+  uint8_t write_cmd;
+  uint8_t read_cmd;
+  uint32_t numbits = 8u;
+  uint32_t status;
+  uint32_t qe_mask;
+  switch (recipe.kind) {
+    case kQeRecipeNone:
+      return true;
+    case kQeRecipeS6_8bitSR1:
+      write_cmd = kWriteStatusRegister1Cmd;
+      read_cmd = kReadStatusRegister1Cmd;
+      status = qe_mask = kQES6Bit;
+      break;
+    case kQeRecipeS9_8bitSR2:
+      write_cmd = kWriteStatusRegister2Cmd;
+      read_cmd = kReadStatusRegister2Cmd;
+      status = qe_mask = kQES9Bit1B;
+      break;
+    case kQeRecipeS9_16bitSR1:
+      write_cmd = kWriteStatusRegister1Cmd;
+      read_cmd = kReadStatusRegister2Cmd;
+      numbits = 16u;
+      status = kQES9Bit2B;
+      qe_mask = kQES9Bit1B;
+      break;
+    default:
+      return false;
+  }
+
+  // A WEL left set by the BootROM is cleared here, also when nothing is
+  // written. It would make the volatile write below non-volatile on some parts.
+  Spi0Step steps[4];
+  size_t n = 0u;
+  if (! SR_SHADOW_SKIP_WRDI()) steps[n++] = {kWriteDisableCmd, 0u, 0u, 0u, 0u};
+  steps[n++] = {read_cmd, 0u, 0u, 8u, 0u};
+  if (SPI_RESULT_OK != spi0_flash_sequence(steps, n)) return false;
+  // Already set, nothing was written so Status Register-3 is untouched.
+  if (0u != (qe_mask & steps[n - 1u].data)) return true;
+
+  SpiOpResult ok0 = SPI_RESULT_OK;
+  uint32_t verify = 0u;
+  n = 0u;
+  if (recipe.non_volatile) {
+    const uint32_t idx0 = (kWriteStatusRegister1Cmd == write_cmd) ? 0u : 1u;
+#if SR_WEAR_POLICY
+    if (! sr_wear_nv_write_allowed(idx0)) return false;
+#endif
+    const uint32_t verify_idx0 = (kReadStatusRegister1Cmd == read_cmd) ? 0u : 1u;
+    ok0 = spi0_flash_write_verify_status_register_wip(idx0, status, non_volatile_bit, numbits, verify_idx0, &verify, spi0_flash_sr_write_timeout_us, NULL, NULL);
+  } else {
+    steps[n++] = {write_cmd, kVolatileWriteEnableCmd, (uint8_t)numbits, 0u, status};
+  }
+  if (recipe.restore_sr3) {
+    steps[n++] = {kWriteStatusRegister3Cmd, kVolatileWriteEnableCmd, 8u, 0u, recipe.sr3};
+  }
+  if (SPI_RESULT_OK == ok0 && 0u != n) {
+    steps[n++] = {read_cmd, 0u, 0u, 8u, 0u};
+    ok0 = spi0_flash_sequence(steps, n);
+    verify = steps[n - 1u].data;
+  }
+  const bool is_set = (SPI_RESULT_OK == ok0 && 0u != (qe_mask & verify));
+#if SR_WEAR_POLICY
+  if (recipe.non_volatile) sr_wear_commit();
+#endif
+  RECLAIM_TIMELINE_MARK(kReclaimPhaseVerify, is_set);
+  return is_set;
+}
+
 
 #if 0
 // I don't think these are needed anymore
@@ -152,6 +152,122 @@ bool clear_S6_QE_bit__8_bit_sr1_write(const bool non_volatile);
 bool clear_S9_QE_bit__8_bit_sr2_write(const bool non_volatile);
 bool clear_S9_QE_bit__16_bit_sr1_write(const bool non_volatile);
 
+////////////////////////////////////////////////////////////////////////////////
+// QE recipe
+//
+// Each set_*_QE_bit__* function notes in qe_recipe which method it used and
+// whether the write was volatile. Zero qe_recipe before calling a vendor
+// handler, and after a success, it describes how to set QE for this part. A
+// later apply_qe_recipe() repeats it without the vendor lookup. See the reclaim
+// recipe cache in ModeDIO_ReclaimGPIOs.h.
+//
+// A handler that also restores Status Register-3, like for the XMC anomaly,
+// calls qe_recipe_note_sr3() with the value to keep, even when nothing needed
+// writing this time. A later QE write from the recipe puts it back. A handler that does
+// anything else the recipe cannot describe should leave qe_recipe.kind as
+// kQeRecipeNotSet.
+enum QeRecipeKind : uint8_t {
+  kQeRecipeNotSet = 0u,
+  kQeRecipeS6_8bitSR1,        // set_S6_QE_bit__8_bit_sr1_write
+  kQeRecipeS9_8bitSR2,        // set_S9_QE_bit__8_bit_sr2_write
+  kQeRecipeS9_16bitSR1,       // set_S9_QE_bit__16_bit_sr1_write
+  kQeRecipeNone,              // No /WP or /HOLD pin function, nothing to write
+};
+
+union QeRecipe {
+  struct {
+    uint8_t kind;             // QeRecipeKind
+    uint8_t non_volatile;
+    uint8_t restore_sr3;      // After QE, write sr3 to volatile Status Register-3
+    uint8_t sr3;
+  };
+  uint32_t u32;
+};
+
+extern QeRecipe qe_recipe;
+
+inline
+void qe_recipe_note_sr3(const uint32_t status3) {
+  qe_recipe.restore_sr3 = 1u;
+  qe_recipe.sr3 = status3;
+}
+
+bool apply_qe_recipe(const QeRecipe recipe);
+
+#if SR_WEAR_POLICY
+////////////////////////////////////////////////////////////////////////////////
+// Status Register wear policy, build with -DSR_WEAR_POLICY=1
+//
+// A non-volatile Status Register write takes milliseconds and uses up some
+// of the part's write endurance. With a recipe applied every boot, these add
+// up unnoticed. The policy counts them and keeps them in check:
+//
+//  * Every non-volatile Status Register write the library sends is counted,
+//    per register. That includes direct calls like the ones in the Analyze
+//    example. See sr_wear_note() in SpiFlashUtils.h.
+//  * The set_*_QE_bit__* and clear_*_QE_bit__* functions try a volatile write
+//    first when asked for a non-volatile one. If the volatile write verifies,
+//    no non-volatile write is sent. A register whose volatile write did not
+//    verify is remembered and not tried again.
+//  * A non-volatile write is refused when the register has used its budget,
+//    SR_WEAR_NV_BUDGET, or this power on has used SR_WEAR_NV_PER_POWER_ON.
+//    The set_*/clear_* function then fails its verify.
+//
+// The counters live in RTC memory. They survive a reset or deep sleep, not a
+// power cycle. To keep them across a power cycle, supply a mirror, replace
+// the weak sr_wear_mirror_load() and sr_wear_mirror_save(). Both may be
+// called from preinit() with RECLAIM_GPIO_EARLY, before the C++ runtime and
+// the file systems are up. The save only happens after a non-volatile write
+// or a reset of the counters.
+//
+#ifndef SR_WEAR_NV_BUDGET
+#define SR_WEAR_NV_BUDGET 16u
+#endif
+
+#ifndef SR_WEAR_NV_PER_POWER_ON
+#define SR_WEAR_NV_PER_POWER_ON 2u
+#endif
+
+// Set to 0 when a non-volatile request must be written non-volatile, eg. QE
+// has to be set before the BootROM runs.
+#ifndef SR_WEAR_VOLATILE_FIRST
+#define SR_WEAR_VOLATILE_FIRST 1
+#endif
+
+#ifndef SR_WEAR_RTC_BLOCK
+// RTC user memory, 9 blocks below the reclaim recipe record. With
+// ESP.rtcUserMemoryWrite, this is offsets 111 - 119.
+#define SR_WEAR_RTC_BLOCK 175u
+#endif
+
+struct SrWearCounters {
+  uint32_t nv_writes[3];        // Non-volatile writes, SR1 - SR3. Since power on without a mirror.
+  uint32_t nv_since_power_on;   // Non-volatile writes, all registers
+  uint32_t substituted;         // Non-volatile requests done with a volatile write
+  uint32_t refused;             // Non-volatile writes refused by the budget
+  uint8_t  volatile_failed;     // Bit per register, a volatile write did not verify
+  uint8_t  reserved[3];
+};
+
+// Loads the counters on first use, from RTC memory or the mirror, and folds
+// in writes sent since the last call. Returns the current counters.
+const SrWearCounters *sr_wear_counters();
+
+// true when a non-volatile write to register idx0 {0, 1, 2} is in budget
+bool sr_wear_nv_write_allowed(const uint32_t idx0);
+
+// Fold sr_wear_uncommitted into the counters and save them
+void sr_wear_commit();
+
+// Zero the counters, and the mirror
+void sr_wear_reset();
+
+// Mirror, weak. The default load returns false and the default save does
+// nothing. load returns false when it has no saved counters.
+bool sr_wear_mirror_load(SrWearCounters *c);
+void sr_wear_mirror_save(const SrWearCounters *c);
+#endif
+
 
 #if 0
 // I don't think these are needed anymore
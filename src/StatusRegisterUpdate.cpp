@@ -0,0 +1,290 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+////////////////////////////////////////////////////////////////////////////////
+// Status Register update planner, see StatusRegisterUpdate.h
+//
+#include <Arduino.h>
+#include "SpiFlashUtilsQE.h"      // sr_wear_nv_write_allowed()
+#include "StatusRegisterUpdate.h"
+
+namespace experimental {
+
+constexpr uint8_t kSrWriteCmds[] = {kWriteStatusRegister1Cmd, kWriteStatusRegister2Cmd, kWriteStatusRegister3Cmd};
+constexpr uint8_t kSrReadCmds[] = {kReadStatusRegister1Cmd, kReadStatusRegister2Cmd, kReadStatusRegister3Cmd};
+
+constexpr uint32_t kSrp1Bit = BIT8;   // SRP1, SR2 bit 0
+
+// Bit per register with a bit in mask
+static uint32_t regs_of(const uint32_t mask) {
+  uint32_t regs = 0u;
+  for (size_t i = 0u; i < 3u; i++) {
+    if (0u != ((mask >> (8u * i)) & 0xFFu)) regs |= 1u << i;
+  }
+  return regs;
+}
+
+// Bits of the registers in regs
+static uint32_t mask_of(const uint32_t regs) {
+  uint32_t mask = 0u;
+  for (size_t i = 0u; i < 3u; i++) {
+    if (regs & (1u << i)) mask |= 0xFFu << (8u * i);
+  }
+  return mask;
+}
+
+static uint32_t write_data(const SrWrite& w, const uint32_t target) {
+  return (16u == w.numbits) ? (target & 0xFFFFu) : ((target >> (8u * w.idx0)) & 0xFFu);
+}
+
+// Registers a write changes
+static uint32_t write_regs(const SrWrite& w) {
+  return (16u == w.numbits) ? 3u : (1u << w.idx0);
+}
+
+static bool xmc_restore(const uint8_t caps, const bool non_volatile) {
+  return ! non_volatile && (kSrCapSR2ClearsSR3 | kSrCapSR3) == (caps & (kSrCapSR2ClearsSR3 | kSrCapSR3));
+}
+
+uint32_t sr_update_regs(const uint32_t mask, const uint8_t caps, const bool non_volatile) {
+  uint32_t regs = regs_of(mask & kSrUpdateMaskAll);
+  // A 16-bit 01h write of SR2 carries SR1
+  if ((regs & 2u) && 0u == (caps & kSrCap8bitSR2)) regs |= 1u;
+  // A 16-bit 01h write of SR1 carries SR2
+  if ((regs & 1u) && (caps & kSrCapSR2) && 0u == (caps & kSrCap8bitSR1)) regs |= 2u;
+  if ((regs & 2u) && xmc_restore(caps, non_volatile)) regs |= 4u;
+  return regs;
+}
+
+SpiOpResult sr_read(const uint32_t regs, uint32_t *pStatus) {
+  return spi0_flash_read_status_registers(regs & 7u, pStatus);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Plan
+bool sr_update_plan(SrUpdatePlan *plan, const uint32_t before, const uint32_t value, const uint32_t mask, const uint8_t caps, const bool non_volatile) {
+  memset(plan, 0, sizeof(SrUpdatePlan));
+  const uint32_t m = mask & kSrUpdateMaskAll;
+  plan->non_volatile = non_volatile;
+  plan->target = (before & ~m) | (value & m);
+  const uint32_t changed = (before ^ plan->target) & m;
+  if (0u == changed) return true;
+  if (! non_volatile && 0u == (caps & kSrCapVolatile)) return false;
+
+  const bool c1 = 0u != (changed & 0x0000FFu);
+  const bool c2 = 0u != (changed & 0x00FF00u);
+  const bool c3 = 0u != (changed & 0xFF0000u);
+  if ((c2 && 0u == (caps & kSrCapSR2)) || (c3 && 0u == (caps & kSrCapSR3))) return false;
+
+  bool w1 = false, w2 = false, w16 = false;
+  if (c2) {
+    if (c1 && (caps & kSrCap16bitSR1)) {
+      w16 = true;     // One write for both
+    } else if (caps & kSrCap8bitSR2) {
+      w2 = true;
+    } else if (caps & kSrCap16bitSR1) {
+      w16 = true;     // Carries SR1 as read
+    } else {
+      return false;
+    }
+  }
+  if (c1 && ! w16) {
+    if ((caps & kSrCap8bitSR1) || 0u == (caps & kSrCapSR2)) {
+      w1 = true;
+    } else if (caps & kSrCap16bitSR1) {
+      w16 = true;     // Carries SR2 as read
+    } else {
+      return false;
+    }
+  }
+
+  if (w16) {
+    plan->writes[plan->nwrites++] = {0u, 16u};
+  } else {
+    // SR2 first, unless it sets SRP1
+    const bool sets_srp1 = w2 && 0u != (changed & plan->target & kSrp1Bit);
+    if (w1 && sets_srp1) plan->writes[plan->nwrites++] = {0u, 8u};
+    if (w2) plan->writes[plan->nwrites++] = {1u, 8u};
+    if (w1 && ! sets_srp1) plan->writes[plan->nwrites++] = {0u, 8u};
+  }
+  const bool restore3 = (w2 || w16) && xmc_restore(caps, non_volatile);
+  if (c3 || restore3) plan->writes[plan->nwrites++] = {2u, 8u};
+
+  plan->verify_mask = changed;
+  if (restore3) plan->verify_mask |= 0xFF0000u;
+  plan->verify_regs = regs_of(plan->verify_mask);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Write and verify
+SpiOpResult sr_update_apply(const SrUpdatePlan *plan, uint32_t *pAfter) {
+  if (0u == plan->nwrites) return SPI_RESULT_OK;
+  SpiOpResult ok0 = SPI_RESULT_OK;
+  uint32_t read = 0u;
+  uint32_t status = 0u;
+
+  if (plan->non_volatile) {
+#if SR_WEAR_POLICY
+    for (size_t k = 0u; k < plan->nwrites; k++) {
+      if (! sr_wear_nv_write_allowed(plan->writes[k].idx0)) {
+        DBG_SFU_PRINTF("* SR update: non-volatile write to SR%u refused.\n", plan->writes[k].idx0 + 1u);
+        return SPI_RESULT_ERR;
+      }
+    }
+#endif
+    // Split-phase, each write's closing read verifies a register it changed
+    for (size_t k = 0u; k < plan->nwrites && SPI_RESULT_OK == ok0; k++) {
+      const SrWrite& w = plan->writes[k];
+      const uint32_t regs = write_regs(w) & plan->verify_regs & ~read;
+      const uint32_t verify_idx0 = (regs & 2u) ? 1u : (regs & 1u) ? 0u : (regs & 4u) ? 2u : w.idx0;
+      uint32_t verify = 0u;
+      ok0 = spi0_flash_write_verify_status_register(w.idx0, write_data(w, plan->target), non_volatile_bit, w.numbits, verify_idx0, &verify);
+      if (SPI_RESULT_OK == ok0) {
+        *pAfter = (*pAfter & ~(0xFFu << (8u * verify_idx0))) | ((verify & 0xFFu) << (8u * verify_idx0));
+        read |= 1u << verify_idx0;
+      }
+    }
+    if (SPI_RESULT_OK == ok0 && 0u != (plan->verify_regs & ~read)) {
+      ok0 = sr_read(plan->verify_regs & ~read, &status);
+      if (SPI_RESULT_OK == ok0) {
+        const uint32_t mask = mask_of(plan->verify_regs & ~read);
+        *pAfter = (*pAfter & ~mask) | status;
+      }
+    }
+#if SR_WEAR_POLICY
+    sr_wear_commit();
+#endif
+  } else {
+    // One sequence. A WEL left set by a failed write would make 50h writes
+    // non-volatile on some parts, clear it first. Skipped when the
+    // Status Register shadow knows WEL is clear.
+    Spi0Step steps[kSpi0SeqMaxSteps];
+    size_t n = 0u;
+    if (! SR_SHADOW_SKIP_WRDI()) steps[n++] = {kWriteDisableCmd, 0u, 0u, 0u, 0u};
+    for (size_t k = 0u; k < plan->nwrites; k++) {
+      const SrWrite& w = plan->writes[k];
+      steps[n++] = {kSrWriteCmds[w.idx0], kVolatileWriteEnableCmd, w.numbits, 0u, write_data(w, plan->target)};
+    }
+    const size_t first_read = n;
+    for (size_t i = 0u; i < 3u; i++) {
+      if (plan->verify_regs & (1u << i)) steps[n++] = {kSrReadCmds[i], 0u, 0u, 8u, 0u};
+    }
+    ok0 = spi0_flash_sequence(steps, n);
+    if (SPI_RESULT_OK == ok0) {
+      n = first_read;
+      for (size_t i = 0u; i < 3u; i++) {
+        if (plan->verify_regs & (1u << i)) status |= (steps[n++].data & 0xFFu) << (8u * i);
+      }
+      const uint32_t mask = mask_of(plan->verify_regs);
+      *pAfter = (*pAfter & ~mask) | status;
+    }
+  }
+
+  if (SPI_RESULT_OK != ok0) return ok0;
+  return (0u == ((*pAfter ^ plan->target) & plan->verify_mask)) ? SPI_RESULT_OK : SPI_RESULT_ERR;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Snapshot, plan, apply, and roll back
+SpiOpResult sr_update(SrUpdate *u) {
+  u->before = u->after = 0u;
+  u->read_regs = 0u;
+  u->nwrites = 0u;
+  u->rolled_back = false;
+
+  const uint32_t mask = u->mask & kSrUpdateMaskAll;
+  const uint32_t have = 1u | ((u->caps & kSrCapSR2) ? 2u : 0u) | ((u->caps & kSrCapSR3) ? 4u : 0u);
+  const uint32_t regs = sr_update_regs(mask, u->caps, u->non_volatile);
+  if (0u != (regs & ~have)) return SPI_RESULT_ERR;
+  if (0u == regs) return SPI_RESULT_OK;
+
+  SpiOpResult ok0 = sr_read(regs, &u->before);
+  if (SPI_RESULT_OK != ok0) return ok0;
+  u->read_regs = regs;
+  u->after = u->before;
+
+  SrUpdatePlan plan;
+  if (! sr_update_plan(&plan, u->before, u->value, mask, u->caps, u->non_volatile)) {
+    DBG_SFU_PRINTF("* SR update: no write method for 0x%06X, caps 0x%02X.\n", (plan.target ^ u->before) & mask, u->caps);
+    return SPI_RESULT_ERR;
+  }
+  if (0u == plan.nwrites) return SPI_RESULT_OK;
+
+  u->nwrites = plan.nwrites;
+  ok0 = sr_update_apply(&plan, &u->after);
+  if (SPI_RESULT_OK == ok0 || ! u->rollback) return ok0;
+
+  uint32_t written = 0u;
+  for (size_t k = 0u; k < plan.nwrites; k++) written |= write_regs(plan.writes[k]);
+  if (SPI_RESULT_ERR != ok0) {
+    // A transport failure, the writes may have landed without their verify
+    // reads. Read what the part holds now.
+    uint32_t status = 0u;
+    if (SPI_RESULT_OK != sr_read(written, &status)) {
+      DBG_SFU_PRINTF("* SR update: failed, %d, registers unreadable, NOT rolled back.\n", (int)ok0);
+      return ok0;
+    }
+    u->after = (u->after & ~mask_of(written)) | status;
+  }
+
+  // What was not read back still holds the snapshot, the writes carried it.
+  // Plan from there back to the snapshot for the registers written.
+  SrUpdatePlan undo;
+  if (sr_update_plan(&undo, u->after, u->before, mask_of(written), u->caps, u->non_volatile) && 0u != undo.nwrites) {
+    uint32_t after = u->after;
+    u->rolled_back = (SPI_RESULT_OK == sr_update_apply(&undo, &after));
+  }
+  DBG_SFU_PRINTF("* SR update: failed, %d, 0x%06X read, 0x%06X wanted, %srolled back.\n",
+    (int)ok0, u->after, plan.target, (u->rolled_back) ? "" : "NOT ");
+  return ok0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Capabilities from SFDP
+uint8_t sr_caps_from_sfdp(const SfdpBasicParams *params) {
+  if (nullptr == params || 15u > params->num_dw) return 0u;
+  uint8_t caps = 0u;
+  // JESD216 DW15 Quad Enable Requirements. For 1 and 4 SFDP gives no SR2
+  // read, 35h is assumed.
+  switch (params->qe_requirement) {
+    case 0u:    // No QE bit
+    case 2u:    // QE is SR1 bit 6, one byte register
+    case 3u:    // QE is SR2 bit 7 with 3Eh/3Fh, not used here
+      caps = kSrCap8bitSR1;
+      break;
+    case 1u:    // An 8-bit 01h write clears SR2
+      caps = kSrCapSR2 | kSrCap16bitSR1;
+      break;
+    case 4u:
+    case 5u:
+      caps = kSrCapSR2 | kSrCap8bitSR1 | kSrCap16bitSR1;
+      break;
+    case 6u:
+      caps = kSrCapSR2 | kSrCap8bitSR1 | kSrCap8bitSR2;
+      break;
+    default:
+      return 0u;
+  }
+  if (16u <= params->num_dw && 0u != params->sr1_write_enable) {
+    // DW16 bit 2 volatile with 50h, bit 3 non-volatile and volatile with 50h
+    if (params->sr1_write_enable & (BIT2 | BIT3)) caps |= kSrCapVolatile;
+  } else if (params->volatile_sr_protect && kVolatileWriteEnableCmd == params->volatile_wren_cmd) {
+    caps |= kSrCapVolatile;
+  }
+  return caps;
+}
+
+};  // namespace experimental
@@ -0,0 +1,158 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Status Register update - plan, write, verify, and roll back
+
+  Give the bits wanted across SR1 - SR3 and what the part can write, and
+  sr_update() works out the fewest instructions to get there:
+
+    1. Snapshot. One sequence reads the registers the update touches, and
+       those a write has to carry, eg. SR1 for a 16-bit write of SR2.
+    2. Plan. Only registers with a changed bit are written. SR1 and SR2 both
+       changing is one 16-bit 01h write when the part has it. SR2 alone is a
+       31h write, or a 16-bit 01h write carrying SR1 as read. An 8-bit 01h
+       write is not used on a part where it clears SR2.
+    3. Write and verify. A volatile plan is one sequence: a Write Disable,
+       the 50h writes, and a read of each register with a changed bit. A
+       non-volatile plan sends each write split-phase, interrupts stay on
+       while the part is busy, see spi0_flash_sr_write_begin(). Each write's
+       closing read is one of the verify reads.
+    4. Roll back. When a write or the verify fails, the registers written
+       get their snapshot values back, with the same writes.
+
+  Values and masks are 24 bits, SR1 in bits 7:0, SR2 in 15:8, and SR3 in
+  23:16. Bits outside the mask keep the value read. WIP and WEL, bits 1:0,
+  are never written or compared.
+
+  Write order: SR2 goes before SR1, so a write that clears SRP1 lands before
+  the SR1 write it would block. Except when the SR2 write sets SRP1, then SR1
+  goes first, SRP1:SRP0 = 1:0 locks the registers until power off. SR3 goes
+  last.
+
+  XMC anomaly: on a part with kSrCapSR2ClearsSR3, a volatile write that
+  reaches SR2 also clears the volatile SR3. The plan then includes SR3 in
+  the snapshot, adds a volatile SR3 write of the value read, and verifies it.
+  sr_restore() is the same snapshot and put back, by itself.
+
+  With -DSR_WEAR_POLICY=1, a non-volatile plan is refused, before anything is
+  written, when a register is out of its write budget.
+*/
+#ifndef EXPERIMENTAL_STATUSREGISTERUPDATE_H
+#define EXPERIMENTAL_STATUSREGISTERUPDATE_H
+
+#include "SpiFlashUtils.h"
+#include "SfdpBasic.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+namespace experimental {
+
+// What the part can write
+enum SrCapFlags : uint8_t {
+  kSrCapSR2           = 0x01u,  // SR2, read with 35h
+  kSrCapSR3           = 0x02u,  // SR3, read with 15h, written with 11h
+  kSrCap8bitSR1       = 0x04u,  // 8-bit 01h leaves SR2 alone
+  kSrCap16bitSR1      = 0x08u,  // 16-bit 01h writes SR1 then SR2
+  kSrCap8bitSR2       = 0x10u,  // 31h
+  kSrCapVolatile      = 0x20u,  // 50h, volatile writes
+  kSrCapSR2ClearsSR3  = 0x40u,  // XMC, a volatile write to SR2 clears SR3
+};
+
+constexpr uint32_t kSrUpdateMaskAll = 0xFFFFFCu;  // All but WEL and WIP
+constexpr size_t kSrUpdateMaxWrites = 3u;
+
+struct SrWrite {
+  uint8_t idx0;                 // {0, 1, 2} SR1 - SR3
+  uint8_t numbits;              // 8, or 16 for SR1 and SR2 with 01h
+};
+
+struct SrUpdatePlan {
+  uint32_t target;              // SR1 - SR3 to write
+  uint32_t verify_mask;         // Bits compared after
+  uint8_t  verify_regs;         // Bit per register, read after
+  uint8_t  nwrites;
+  bool     non_volatile;
+  SrWrite  writes[kSrUpdateMaxWrites];
+};
+
+struct SrUpdate {
+  // In
+  uint32_t value;
+  uint32_t mask;
+  uint8_t  caps;                // SrCapFlags
+  bool     non_volatile;
+  bool     rollback;            // Put the snapshot back when the verify fails
+  // Out
+  uint32_t before;              // Snapshot, registers not read are 0
+  uint32_t after;               // Registers read after, the rest as before
+  uint8_t  read_regs;           // Bit per register, in the snapshot
+  uint8_t  nwrites;             // Status Register writes sent, not counting a roll back
+  bool     rolled_back;         // A roll back was written and verified
+};
+
+// Registers the snapshot must read for mask. Bit per register.
+uint32_t sr_update_regs(const uint32_t mask, const uint8_t caps, const bool non_volatile);
+
+// Read the registers in regs, one sequence, into a 24-bit value
+SpiOpResult sr_read(const uint32_t regs, uint32_t *pStatus);
+
+// Plan a move from before to value under mask. Does not touch the flash.
+// Returns false when a changed bit is in a register the part cannot write.
+// A plan with no writes means nothing changes.
+bool sr_update_plan(SrUpdatePlan *plan, const uint32_t before, const uint32_t value, const uint32_t mask, const uint8_t caps, const bool non_volatile);
+
+// Send the plan's writes and verify reads. pAfter holds the snapshot on entry,
+// the registers read replace their byte. SPI_RESULT_ERR when the verify fails.
+SpiOpResult sr_update_apply(const SrUpdatePlan *plan, uint32_t *pAfter);
+
+// Snapshot, plan, write, verify, and roll back. SPI_RESULT_OK when the bits
+// in mask read back as value, including when nothing had to be written.
+// Otherwise the failure, SPI_RESULT_ERR for a verify, or eg. a timeout. After
+// a timeout the registers written are read again before the roll back.
+SpiOpResult sr_update(SrUpdate *u);
+
+// The same, with roll back, for callers that only need the result
+inline
+SpiOpResult sr_update_bits(const uint32_t value, const uint32_t mask, const uint8_t caps, const bool non_volatile) {
+  SrUpdate u = {};
+  u.value = value;
+  u.mask = mask;
+  u.caps = caps;
+  u.non_volatile = non_volatile;
+  u.rollback = true;
+  return sr_update(&u);
+}
+
+// Write back volatile copies of a snapshot, eg. SR3 after the XMC anomaly.
+// Only registers under mask that differ are written.
+inline
+SpiOpResult sr_restore(const uint32_t snapshot, const uint32_t mask, const uint8_t caps) {
+  return sr_update_bits(snapshot, mask, caps, volatile_bit);
+}
+
+// Capabilities from the SFDP Basic Flash Parameter Table, QER in DW15 and the
+// volatile write enable in DW16 or DW1. Returns 0 when the table does not say.
+// SFDP has nothing on SR3, add kSrCapSR3 when the part is known to have it.
+uint8_t sr_caps_from_sfdp(const SfdpBasicParams *params);
+
+};  // namespace experimental
+
+#ifdef __cplusplus
+}
+#endif
+#endif // EXPERIMENTAL_STATUSREGISTERUPDATE_H
@@ -32,116 +32,110 @@ extern "C" {
 // Rely on DBG_SFU_PRINTF from SpiFlashUtils.h
 #define ETS_PRINTF(fmt, ...) DBG_SFU_PRINTF(fmt, ##__VA_ARGS__)
 #include "SFDP.h"
+#include <SfdpBasic.h>
 
 #define NOINLINE __attribute__((noinline))
 
 using namespace experimental;
 
+// Spi0ReadSink - prints each transfer as rows of 4 dwords
+static bool printHexRows(void *, const uint32_t offset, const uint32_t *p, const size_t sz) {
+  for (size_t i = 0; i < sz / sizeof(uint32_t); i++) {
+    if (0u == (i % 4u)) {
+      ETS_PRINTF("\n  0x%02X  ", (offset + i * sizeof(uint32_t)) & 0xFFFu);
+    }
+    ETS_PRINTF(" 0x%08X", p[i]);
+  }
+  return true;
+}
+
+static void printFastRead(const char *name, const SfdpFastRead& fr) {
+  if (0u == fr.cmd) return;
+  ETS_PRINTF("  %-18s %02Xh, %u dummy, %u mode clocks\n", name, fr.cmd, fr.dummy, fr.mode);
+}
+
+static void printBasicParams(const SfdpBasicParams& basic) {
+  ETS_PRINTF("  %-18s 0x%08X, %u\n", "Capacity in Bytes", basic.capacity, basic.capacity);
+  ETS_PRINTF("  %-18s %u\n", "Num dwords decoded", basic.num_dw);
+  ETS_PRINTF("  %-18s %s\n", "Address Bytes", (0u == basic.address_bytes) ? "3" : (1u == basic.address_bytes) ? "3 or 4" : "4");
+  ETS_PRINTF("  %-18s %02Xh\n", "Volatile SR WREN", basic.volatile_wren_cmd);
+  printFastRead("Read 1-1-2", basic.read_1_1_2);
+  printFastRead("Read 1-2-2", basic.read_1_2_2);
+  printFastRead("Read 2-2-2", basic.read_2_2_2);
+  printFastRead("Read 1-1-4", basic.read_1_1_4);
+  printFastRead("Read 1-4-4", basic.read_1_4_4);
+  printFastRead("Read 4-4-4", basic.read_4_4_4);
+  printFastRead("Read 1-1-8", basic.read_1_1_8);
+  printFastRead("Read 1-8-8", basic.read_1_8_8);
+  printFastRead("Read 1S-1D-1D", basic.read_1s_1d_1d);
+  printFastRead("Read 1S-2D-2D", basic.read_1s_2d_2d);
+  printFastRead("Read 1S-4D-4D", basic.read_1s_4d_4d);
+  printFastRead("Read 4S-4D-4D", basic.read_4s_4d_4d);
+  for (size_t i = 0u; i < 4u; i++) {
+    if (0u == basic.erase[i].size) continue;
+    ETS_PRINTF("  Erase Type %u       %02Xh, %u bytes, typ %u ms, max %u ms\n", i + 1u,
+      basic.erase[i].cmd, basic.erase[i].size, basic.erase[i].typ_ms, basic.erase[i].max_ms);
+  }
+  if (16u > basic.num_dw) return;
+
+  ETS_PRINTF("  %-18s %u bytes, typ %u us, max %u us\n", "Page Program", basic.page_size, basic.page_program_typ_us, basic.page_program_max_us);
+  ETS_PRINTF("  %-18s first %u us, next %u us\n", "Byte Program typ", basic.byte_program_first_typ_us, basic.byte_program_next_typ_us);
+  ETS_PRINTF("  %-18s typ %u ms, max %u ms\n", "Chip Erase", basic.chip_erase_typ_ms, basic.chip_erase_max_ms);
+  if (basic.suspend_resume) {
+    ETS_PRINTF("  %-18s program %02Xh/%02Xh, erase %02Xh/%02Xh\n", "Suspend/Resume",
+      basic.program_suspend_cmd, basic.program_resume_cmd, basic.suspend_cmd, basic.resume_cmd);
+    ETS_PRINTF("  %-18s program %u ns, erase %u ns\n", "Suspend latency", basic.program_suspend_latency_ns, basic.erase_suspend_latency_ns);
+  }
+  if (basic.deep_power_down) {
+    ETS_PRINTF("  %-18s enter %02Xh, exit %02Xh, %u ns\n", "Deep Power-Down", basic.dpd_enter_cmd, basic.dpd_exit_cmd, basic.dpd_exit_delay_ns);
+  }
+  ETS_PRINTF("  %-18s %u\n", "QE Requirement", basic.qe_requirement);
+  ETS_PRINTF("  %-18s %s\n", "HOLD/RESET Disable", (basic.hold_reset_disable) ? "yes" : "no");
+  ETS_PRINTF("  %-18s 0x%02X\n", "SR1 Write Enable", basic.sr1_write_enable);
+  ETS_PRINTF("  %-18s 0x%02X\n", "Soft Reset", basic.soft_reset);
+  ETS_PRINTF("  %-18s enter 0x%02X, exit 0x%03X\n", "4-Byte Addressing", basic.enter_4b_addr, basic.exit_4b_addr);
+}
+
+// Filled by printSfdpReport(), see getSfdpSnapshot()
+static SfdpImage sfdp_snapshot;
+static bool sfdp_snapshot_read = false;
+
+const SfdpImage *getSfdpSnapshot() {
+  return (sfdp_snapshot_read) ? &sfdp_snapshot : nullptr;
+}
+
+// All from one read of the SFDP space, 4 transfers of 64 bytes
 void printSfdpReport() {
-// #if 1
-  union SFDP_Hdr {
-    struct {
-      uint32_t signature:32;
-      uint32_t rev_minor:8;
-      uint32_t rev_major:8;
-      uint32_t num_parm_hdrs:8;     // zero based
-      uint32_t access_protocol:8;
-    };
-    uint32_t u32[2];
-  } sfdp_hdr;
-
-  union SFDP_Param {
-    struct {
-      uint32_t id_lsb:8;
-      uint32_t rev_minor:8;
-      uint32_t rev_major:8;
-      uint32_t num_dw:8;          // 1-based
-      uint32_t tbl_ptr:24;
-      uint32_t id_msb:8;
-    };
-    uint32_t u32[2];
-  } sfdp_param;
-
-  union SFDP_Basic_1 {
-    struct {
-      uint32_t erase_size:2;     // 00 & 10=res., 01=4KB erase, 11=64KB erase
-      uint32_t wr_granularity:1; // 0=No, 1=Yes
-      uint32_t wr_en_volatile:2; // 00=N/A, 01=use 50h opcode, 11=use 06h opcode
-      uint32_t unused:3;
-      uint32_t erase_4k_cmd:8;
-      uint32_t fast_read_1_1_2:1; // opcode, address_input, output
-      uint32_t address_bytes:2;
-      uint32_t d_t_r:1; // 1 = device supports some type of double transfer rate clocking
-      uint32_t fast_read_1_2_2:1;
-      uint32_t fast_read_1_4_4:1;
-      uint32_t fast_read_1_1_4:1;
-      uint32_t unused2:9;
-
-      uint32_t capacity:31;
-      uint32_t giga:1;
-    };
-    uint32_t u32[2];
-  } basic_param;
-
-  [[maybe_unused]]
-  union SFDP_Basic_15 {
-    struct {
-      // 15th DWORD - page 40
-      uint32_t ignore:20;
-      uint32_t qe:3;            // QE Quad Enable support - 0 = no QE support, 1-6 many variations
-      uint32_t hold_disable:1;  // Hold/Reset function disable feature available in Extended Status Register
-      uint32_t reserved2:8;
-      // 16th DWORD - page 42
-      uint32_t non_volatile:7;
-      uint32_t reserved:1;
-      uint32_t soft_reset:6;
-      uint32_t exit_4b_addr:10;
-      uint32_t enter_4b_addr:8;
-    };
-    uint32_t u32[2];
-  } basic_param_15;
-
-  constexpr uint32_t kSfdpSignature = 0x50444653u; //'SFDP'
-
-  SpiOpResult ok0;
-
-  size_t sz = sizeof(sfdp_hdr);
-  size_t addr = 0u;
-
-  ok0 = spi0_flash_read_sfdp(addr, &sfdp_hdr.u32[0], sz);
-  if (SPI_RESULT_OK == ok0 && kSfdpSignature == sfdp_hdr.signature) {
+  sfdp_snapshot_read = true;
+  const SfdpImage& img = sfdp_snapshot;
+  if (sfdp_image_read(&sfdp_snapshot)) {
     ETS_PRINTF("SFDP Header\n");
-    ETS_PRINTF("  %-18s 0x%08X\n", "SFDP Signature", sfdp_hdr.signature);
-    ETS_PRINTF("  %-18s %u.%u\n", "Revision", sfdp_hdr.rev_major, sfdp_hdr.rev_minor);
-    ETS_PRINTF("  %-18s 0x%02X\n", "Access Protocol", sfdp_hdr.access_protocol);
-    ETS_PRINTF("  %-18s %d\n", "Num Param hdrs", sfdp_hdr.num_parm_hdrs);
-
-    // size_t addr = 0u;
-    for (size_t i = 0u; i < (sfdp_hdr.num_parm_hdrs + 1u); i++) {
-      addr += sz;
-      sz = sizeof(sfdp_param);
-      ok0 = spi0_flash_read_sfdp(addr, &sfdp_param.u32[0], sz);
-      if (SPI_RESULT_OK == ok0) {
-        ETS_PRINTF("\nParameter Header #%u\n", i + 1);
-        ETS_PRINTF("  %-18s %d\n", "Num dwords", sfdp_param.num_dw);
-        ETS_PRINTF("  %-18s %u.%u\n", "Revision", sfdp_param.rev_major, sfdp_param.rev_minor);
-        ETS_PRINTF("  %-18s 0x%02X.%02X\n", "ID MSB.LSB", sfdp_param.id_msb, sfdp_param.id_lsb);
-        ETS_PRINTF("  %-18s 0x%08X\n", "TBL PTR", sfdp_param.tbl_ptr);
-      }
-      if (0xFFu == sfdp_param.id_msb && 0x00u == sfdp_param.id_lsb) {
+    ETS_PRINTF("  %-18s 0x%08X\n", "SFDP Signature", img.hdr.signature);
+    ETS_PRINTF("  %-18s %u.%u\n", "Revision", img.hdr.rev_major, img.hdr.rev_minor);
+    ETS_PRINTF("  %-18s 0x%02X\n", "Access Protocol", img.hdr.access_protocol);
+    ETS_PRINTF("  %-18s %d\n", "Num Param hdrs", img.hdr.num_parm_hdrs);
+
+    for (size_t i = 0u; i < img.num_params(); i++) {
+      const SfdpParam& param = img.param[i];
+      ETS_PRINTF("\nParameter Header #%u\n", i + 1);
+      ETS_PRINTF("  %-18s %d\n", "Num dwords", param.sz_dw);
+      ETS_PRINTF("  %-18s %u.%u\n", "Revision", param.rev_major, param.rev_minor);
+      ETS_PRINTF("  %-18s 0x%02X.%02X\n", "ID MSB.LSB", param.id_msb, param.id_lsb);
+      ETS_PRINTF("  %-18s 0x%08X\n", "TBL PTR", param.tbl_ptr);
+
+      if (0xFFu == param.id_msb && 0x00u == param.id_lsb) {
         ETS_PRINTF("\nTable #%u of Basic Parameters\n", i + 1);
-        [[maybe_unused]] size_t flash_sz;
-        size_t addr_tbl = sfdp_param.tbl_ptr;
-        size_t sz_tbl = sizeof(basic_param);
-        ok0 = spi0_flash_read_sfdp(addr_tbl, &basic_param.u32[0], sz_tbl);
-        if (basic_param.giga) {
-          flash_sz = 1u << (basic_param.capacity - 3u); // Convert bits to bytes
+        size_t num_dw = 0u;
+        const uint32_t *dw = img.table(i, &num_dw);
+        SfdpBasicParams basic;
+        memset(&basic, 0, sizeof(basic));
+        basic.rev.parm_major = param.rev_major;
+        basic.rev.parm_minor = param.rev_minor;
+        if (decode_sfdp_basic(dw, num_dw, &basic)) {
+          printBasicParams(basic);
         } else {
-          flash_sz = (basic_param.capacity + 1u) / 8u;
+          ETS_PRINTF("  Basic Parameter table too short or outside of the SFDP image\n");
         }
-        ETS_PRINTF("  %-18s 0x%08X, %u\n", "Capacity in Bytes", flash_sz, flash_sz);
-        // TODO: Dump the descibed Parameter table
-        ETS_PRINTF("  TODO: Described more of the Basic Parameter table\n");
       } else {
         ETS_PRINTF("\nTable #%u of Parameters\n", i + 1);
         ETS_PRINTF("  TODO: Descibed Parameter table\n");
@@ -150,24 +144,8 @@ void printSfdpReport() {
   }
 
   ETS_PRINTF("\nRaw dump of SFDP");
-  uint32_t param[4];
-  ok0 = spi0_flash_read_sfdp(0, param, sizeof(param));
-  if (SPI_RESULT_OK == ok0 && kSfdpSignature == param[0]) { //'SFDP' = 50444653h
-    // const char *intro = "SFDP:";
-    for (size_t j = 0; ; ) {
-      // ETS_PRINTF("\n  %-9s  0x%02X  ", intro, 0x10 * j);
-      ETS_PRINTF("\n  0x%02X  ", 0x10 * j);
-      for (size_t i=0; i < 4; i++) {
-        ETS_PRINTF(" 0x%08X", param[i]);
-      }
-      j++;
-      if (j >= 16) break;
-      // intro = "";
-      if (SPI_RESULT_OK != spi0_flash_read_sfdp((j * 16u), param, sizeof(param))) {
-        ETS_PRINTF(" error reading SFDP.");
-        break;
-      }
-    }
+  if (img.valid()) {
+    printHexRows(nullptr, 0u, &img.dw[0], sizeof(SfdpImage));
   } else {
     ETS_PRINTF(" not supported.");
   }
@@ -177,23 +155,9 @@ void printSfdpReport() {
 // SpiOpResult spi0_flash_read_secure_register(uint32_t reg, uint32_t offset,  uint32_t *p, size_t sz)
 void printSecurityRegisters(uint32_t reg) {
   ETS_PRINTF("\nRaw dump of Security Register #%u", reg);
-  uint32_t param[4];
-  SpiOpResult ok0 = spi0_flash_read_secure_register(reg, 0, param, sizeof(param));
-  if (SPI_RESULT_OK == ok0) {
-    for (size_t j = 0; ; ) {
-      ETS_PRINTF("\n  0x%02X  ", 0x10 * j);
-      for (size_t i=0; i < 4; i++) {
-        ETS_PRINTF(" 0x%08X", param[i]);
-      }
-      j++;
-      if (j >= 16) break;
-      if (SPI_RESULT_OK != spi0_flash_read_secure_register(reg, (j * 16u), param, sizeof(param))) {
-        ETS_PRINTF("  error reading Security Register.");
-        break;
-      }
-    }
-  } else {
-    ETS_PRINTF("Read secure register call failed.");
+  SpiOpResult ok0 = spi0_flash_read_secure_register_stream(reg, 0u, 256u, printHexRows, nullptr);
+  if (SPI_RESULT_OK != ok0) {
+    ETS_PRINTF("  error reading Security Register.");
   }
   ETS_PRINTF("\n");
 }
@@ -19,6 +19,8 @@
 #ifndef TESTFLASHQE_SFDP_CPP_H
 #define TESTFLASHQE_SFDP_CPP_H
 
+#include "../SfdpRevInfo.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -26,6 +28,10 @@ extern "C" {
 void printSfdpReport();
 void printSecurityRegisters(uint32_t reg);
 
+// The SFDP image printSfdpReport() read, nullptr before the first report.
+// Inspect it in place, no flash reads.
+const experimental::SfdpImage *getSfdpSnapshot();
+
 #ifdef __cplusplus
 };
 #endif
@@ -33,6 +33,8 @@
 #include <user_interface.h> // system_soft_wdt_feed()
 #include "BootROM_NONOS.h"
 #include <SpiFlashUtils.h>
+#include <StatusRegisterUpdate.h>
+#include <FastGPIO_9_10.h>
 #include "WP_HOLD_Test.h"
 #define PRINTF(a, ...)        printf_P(PSTR(a), ##__VA_ARGS__)
 #define PRINTF_LN(a, ...)     printf_P(PSTR(a "\n"), ##__VA_ARGS__)
@@ -54,29 +56,22 @@
   match the behaviors I saw with the part.
 */
 
-// We need pinMode functionality in IRAM.  GPF is a problem it resides in
-// PROGMEM we have replaced with localGPF.
-// Partial extraction of pinMode from core_esp8266_wiring_digital.cpp -
-//   only intended to handle GPIO9 and GPIO10 with OUTPUT and SPECIAL.
-#define localGPF(p) (*_gpioToFn[(p & 0xF)])
-
-static void IRAM_ATTR pinSpecial(uint32_t pin, uint32_t mode) {
-  volatile uint32_t* const _gpioToFn[16] = { &GPF0, &GPF1, &GPF2, &GPF3, &GPF4, &GPF5, &GPF6, &GPF7, &GPF8, &GPF9, &GPF10, &GPF11, &GPF12, &GPF13, &GPF14, &GPF15 };
-  if (SPECIAL == mode) {
-    GPC(pin) = (GPC(pin) & (0xF << GPCI)); //SOURCE(GPIO) | DRIVER(NORMAL) | INT_TYPE(UNCHANGED) | WAKEUP_ENABLE(DISABLED)
-    GPEC = (1 << pin); //Disable
-    localGPF(pin) = GPFFS(GPFFS_BUS(pin));//Set mode to BUS (RX0, TX0, TX1, SPI, HSPI or CLK depending in the p     40 in)
-    if(pin == 3) {
-      localGPF(pin) |= (1 << GPFPU);//enable pullup on RX
-    }
-  } else
-  if (OUTPUT == mode) {
-    localGPF(pin) = GPFFS(GPFFS_GPIO(pin));//Set mode to GPIO  -
-    GPC(pin) = (GPC(pin) & (0xF << GPCI)); //SOURCE(GPIO) | DRIVER(NORMAL) | INT_TYPE(UNCHANGED) | WAKEUP_ENABLE(DISABLED)
-    GPES = (1 << pin); //Enable
-  } else {
-    panic();
-  }
+// We need pinMode functionality in IRAM. The core's pinMode() and its GPF(p)
+// table are in flash, FastGPIO is inline. Only handles GPIO9 and GPIO10.
+// Returns BIT0 when the pin reads HIGH, and BIT1 when it reads LOW.
+template<uint32_t kPin>
+static inline __attribute__((always_inline))
+uint32_t test_pin_short() {
+  using namespace experimental;
+  FastGPIO<kPin>::set();
+  FastGPIO<kPin>::output();
+  const bool pass1 = FastGPIO<kPin>::read();
+
+  FastGPIO<kPin>::clear();
+  const bool pass2 = ! FastGPIO<kPin>::read();
+
+  FastGPIO<kPin>::special();  // restore default function
+  return ((pass1) ? BIT0 : 0u) | ((pass2) ? BIT1 : 0u);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -87,20 +82,20 @@ static void IRAM_ATTR pinSpecial(uint32_t pin, uint32_t mode) {
 // enough to guard against a flash read. It looks like we don't need the more
 // extream guard of using Cache_Read_Disable_2 / Cache_Read_Enable_2.
 bool IRAM_ATTR test_GPIO_pin_short(uint8_t pin) {
+  if (9u != pin && 10u != pin) {
+    Serial.PRINTF_LN("* GPIO%u not tested, only GPIO9 and GPIO10", pin);
+    return false;
+  }
+
   // Cache_Read_Disable_2();
   uint32_t saved_ps = xt_rsil(15);
   Wait_SPI_Idle(flashchip);
 
-  digitalWrite(pin, HIGH);
-  pinSpecial(pin, OUTPUT);  // private version of pinMode(pin, OUTPUT);  // is in ICACHE
-  bool pass1 = (HIGH == digitalRead(pin));
-
-  digitalWrite(pin, LOW);
-  bool pass2 = (LOW == digitalRead(pin));
-
-  pinSpecial(pin, SPECIAL); // restore default function
+  const uint32_t pass = (9u == pin) ? test_pin_short<9u>() : test_pin_short<10u>();
   xt_wsr_ps(saved_ps);
   // Cache_Read_Enable_2();
+  const bool pass1 = 0u != (pass & BIT0);
+  const bool pass2 = 0u != (pass & BIT1);
 
   Serial.PRINTF_LN("%c GPIO%u digitalWrite %s test %s", (pass1) ? ' ' : '*', pin,
     "HIGH", (pass1) ? "passed" : "failed");
@@ -114,6 +109,18 @@ bool IRAM_ATTR test_GPIO_pin_short(uint8_t pin) {
 }
 
 
+////////////////////////////////////////////////////////////////////////////////
+// Write methods for sr_update(). A use_16_bit_sr1 part writes SR1 and SR2
+// together, the rest use 8-bit writes.
+static uint8_t test_sr_caps(const bool has_8bw_sr2, const bool use_16_bit_sr1, const bool _non_volatile) {
+  using namespace experimental;
+  uint8_t caps = (_non_volatile) ? 0u : (uint8_t)kSrCapVolatile;
+  if (use_16_bit_sr1) return caps | kSrCapSR2 | kSrCap16bitSR1;
+  caps |= kSrCap8bitSR1;
+  if (has_8bw_sr2) caps |= kSrCapSR2 | kSrCap8bitSR2;
+  return caps;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 // For SPI Flash devices that use QE/S9, they may also support bits SRP0 and
@@ -138,35 +145,27 @@ uint32_t test_set_SRP1_SRP0_clear_QE([[maybe_unused]] const uint32_t qe_pos, con
   // Only call for QE/S9 case
   if (9u != qe_pos) panic();
 
+  sr_shadow_invalidate();      // The shadow can't see OTP mode, send the Write Disable
   spi0_flash_write_disable(); // For some devices, EN25Q32C, this clears OTP mode.
   digitalWrite(10u, HIGH);     // ensure /WP is not asserted
   pinMode(10u, OUTPUT);
 
-  uint32_t sr1 = 0u;
-  spi0_flash_read_status_register_1(&sr1);
-
-  if (BIT7 == (BIT7 & sr1)) {
+  // SRP1 must be zero to avoid permanently protected! With 8-bit writes,
+  // sr_update() writes SR2 first, SRP1 is clear before SRP0 is set. No roll
+  // back, the bits that did not take are the result.
+  SrUpdate u = {};
+  u.value = BIT7;
+  u.mask = 0xFFFCu;
+  u.caps = test_sr_caps(true, use_16_bit_sr1, _non_volatile);
+  u.non_volatile = _non_volatile;
+  sr_update(&u);
+  if (BIT7 == (BIT7 & u.before)) {
     Serial.PRINTF_LN("  SRP0 already set.");
   }
-  sr1 = BIT7;   // SRP1 must be zero to avoid permanently protected!
-  if (use_16_bit_sr1) {
-    spi0_flash_write_status_register(/* SR1 */ 0u, sr1, _non_volatile, 16);
-  } else {
-    spi0_flash_write_status_register(/* SR2 */ 1u, 0u, _non_volatile, 8);
-    spi0_flash_write_status_register(/* SR1 */ 0u, sr1, _non_volatile, 8);
-    // Just in case the clearing order was wrong for allowing writes to SR2
-    spi0_flash_write_status_register(/* SR2 */ 1u, 0u, _non_volatile, 8);
-  }
 
   // Verify
-  uint32_t sr21 = 0u, sr2 = 0u;
-  spi0_flash_read_status_register_1(&sr21);
-  sr21 &= 0xFCu;
-
-  spi0_flash_read_status_register_2(&sr2);
-  sr21 |= (sr2 << 8u);
-
-  if (BIT7 == ((BIT8 | BIT7) & sr1)) {  // Expects SRP1:SRP0 = 0:1
+  uint32_t sr21 = u.after & 0xFFFCu;
+  if (BIT7 == ((BIT8 | BIT7) & sr21)) {  // Expects SRP1:SRP0 = 0:1
     sr21 &= ~BIT7;  // Clear expected bits leaving only stuck bits.
   } else {
     sr21 = ~0u;
@@ -193,29 +192,19 @@ uint32_t test_set_SRP1_SRP0_clear_QE([[maybe_unused]] const uint32_t qe_pos, con
 uint32_t test_clear_SRP1_SRP0_QE(const bool has_8bw_sr2, const bool use_16_bit_sr1, const bool _non_volatile) {
   using namespace experimental;
 
-  uint32_t
   spi0_flash_write_disable();
   digitalWrite(10u, HIGH);     // ensure /WP is not asserted
   pinMode(10u, OUTPUT);
 
-  if (use_16_bit_sr1) {
-    spi0_flash_write_status_register(/* SR1 */ 0u, 0u, _non_volatile, 16);
-  } else {
-    spi0_flash_write_status_register(/* SR1 */ 0u, 0u, _non_volatile, 8);
-    if (has_8bw_sr2) {
-      spi0_flash_write_status_register(/* SR2 */ 1u, 0u, _non_volatile, 8);
-      spi0_flash_write_status_register(/* SR1 */ 0u, 0u, _non_volatile, 8);
-    }
-  }
+  SrUpdate u = {};
+  u.value = 0u;
+  u.mask = (has_8bw_sr2 || use_16_bit_sr1) ? 0xFFFCu : 0xFCu;
+  u.caps = test_sr_caps(has_8bw_sr2, use_16_bit_sr1, _non_volatile);
+  u.non_volatile = _non_volatile;
+  sr_update(&u);
 
   // Verify
-  uint32_t sr21 = 0u, sr2 = 0u;
-  spi0_flash_read_status_register_1(&sr21);
-  sr21 &= 0xFCu;
-  if (has_8bw_sr2) {
-    spi0_flash_read_status_register_2(&sr2);
-    sr21 |= (sr2 << 8u);
-  }
+  uint32_t sr21 = u.after & ((has_8bw_sr2) ? 0xFFFCu : 0xFCu);
 
   pinMode(10u, SPECIAL);
   return sr21;
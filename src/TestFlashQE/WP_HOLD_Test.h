@@ -32,7 +32,7 @@ bool testOutputGPIO9(const uint32_t qe_pos, const bool use_16_bit_sr1, const boo
 // Test - turning off pin feature /WP
 bool testOutputGPIO10(const uint32_t qe_pos, const bool use_16_bit_sr1, const bool non_volatile, const bool was_preset);
 
-// Test - GPIO pin shorts
+// Test - GPIO pin shorts, GPIO9 or GPIO10 only. False for any other pin.
 bool test_GPIO_pin_short(uint8_t pin);
 
 #if 0
@@ -0,0 +1,166 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  fpscan.h - find FlashFingerprint records in a byte stream
+
+  Shared by the tools in this folder. Raw 64 byte records and "FFP1:" hex
+  lines are found anywhere in the input, eg. a captured serial log, and passed
+  to a callback after the CRC is checked.
+*/
+#ifndef FPSCAN_H
+#define FPSCAN_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "FlashFingerprint.h"
+
+using namespace experimental;
+
+typedef void (*FpRecordFn)(const FlashFingerprint& fp, void *ctx);
+
+// Records found with a bad CRC, or a known magic and a bad size or version
+static uint64_t fp_bad_records = 0u;
+
+// The core's crc32(), not the zlib one. Table driven for speed.
+static uint32_t fp_crc_table[256];
+
+static void fp_crc32_init() {
+  if (fp_crc_table[1]) return;
+  for (uint32_t i = 0u; i < 256u; i++) {
+    uint32_t crc = i << 24u;
+    for (int k = 0; k < 8; k++) crc = (crc & 0x80000000u) ? (crc << 1u) ^ 0x04c11db7u : (crc << 1u);
+    fp_crc_table[i] = crc;
+  }
+}
+
+static uint32_t fp_crc32(const void *data, size_t length, uint32_t crc = 0xffffffffu) {
+  const uint8_t *p = (const uint8_t *)data;
+  while (length--) crc = (crc << 8u) ^ fp_crc_table[(crc >> 24u) ^ *p++];
+  return crc;
+}
+
+// Records are little-endian
+static uint32_t fp_le32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8u) | ((uint32_t)p[2] << 16u) | ((uint32_t)p[3] << 24u);
+}
+
+static FlashFingerprint fp_decode(const uint8_t *p) {
+  FlashFingerprint fp;
+  fp.magic = fp_le32(p);
+  fp.version = p[4];
+  fp.size = p[5];
+  fp.caps = (uint16_t)(p[6] | (p[7] << 8u));
+  fp.jedec_id = fp_le32(p + 8);
+  fp.sfdp_hash = fp_le32(p + 12);
+  for (size_t i = 0u; i < 4u; i++) fp.sfdp_hdr[i] = fp_le32(p + 16 + 4 * i);
+  for (size_t i = 0u; i < 4u; i++) fp.unique_id[i] = fp_le32(p + 32 + 4 * i);
+  memcpy(fp.sr, p + 48, 3u);
+  fp.reclaim = p[51];
+  fp.reclaim_cycles = fp_le32(p + 52);
+  fp.reclaim_xfers = fp_le32(p + 56);
+  fp.crc = fp_le32(p + 60);
+  return fp;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Stream scanning. Raw records and hex lines are found by the "FFP1" magic,
+// then the byte after tells them apart: ':' for text, the version for raw.
+static int fp_hexval(const uint8_t c) {
+  if ('0' <= c && c <= '9') return c - '0';
+  if ('A' <= c && c <= 'F') return c - 'A' + 10;
+  if ('a' <= c && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+// Returns bytes used at p, 0 when more input is needed, or -1 when p is not a
+// record.
+static long fp_parse_at(const uint8_t *p, const size_t avail, FpRecordFn fn, void *ctx) {
+  constexpr size_t kRawSz = sizeof(FlashFingerprint);
+  constexpr size_t kHexSz = kFlashFingerprintHexSz - 1u;
+  if (avail < 5u) return 0;
+  uint8_t raw[kRawSz];
+  size_t used = 0u;
+  if (':' == p[4]) {
+    if (avail < kHexSz) return 0;
+    for (size_t i = 0u; i < kRawSz; i++) {
+      const int hi = fp_hexval(p[5u + 2u * i]);
+      const int lo = fp_hexval(p[6u + 2u * i]);
+      if (0 > hi || 0 > lo) return -1;
+      raw[i] = (uint8_t)((hi << 4) | lo);
+    }
+    used = kHexSz;
+  } else if (kFlashFingerprintVersion == p[4]) {
+    if (avail < kRawSz) return 0;
+    memcpy(raw, p, kRawSz);
+    used = kRawSz;
+  } else {
+    return -1;
+  }
+  const FlashFingerprint fp = fp_decode(raw);
+  if (kFlashFingerprintMagic != fp.magic || kFlashFingerprintVersion != fp.version ||
+      kRawSz != fp.size || fp_crc32(raw, offsetof(FlashFingerprint, crc)) != fp.crc) {
+    fp_bad_records++;
+    return -1;
+  }
+  fn(fp, ctx);
+  return (long)used;
+}
+
+static void fp_scan(FILE *f, FpRecordFn fn, void *ctx) {
+  fp_crc32_init();
+  constexpr size_t kChunk = 1u << 20u;
+  std::vector<uint8_t> buf(kChunk + kFlashFingerprintHexSz);
+  size_t len = 0u;
+  bool eof = false;
+  while (! eof || len) {
+    if (! eof) {
+      const size_t n = fread(buf.data() + len, 1u, buf.size() - len, f);
+      if (0u == n) eof = true;
+      len += n;
+    }
+    size_t pos = 0u;
+    while (pos < len) {
+      const uint8_t *hit = (const uint8_t *)memchr(buf.data() + pos, 'F', len - pos);
+      if (nullptr == hit) {
+        pos = len;
+        break;
+      }
+      pos = hit - buf.data();
+      const size_t avail = len - pos;
+      if (4u <= avail && 0 != memcmp(hit, "FFP1", 4u)) {
+        pos++;
+        continue;
+      }
+      const long used = (4u <= avail) ? fp_parse_at(hit, avail, fn, ctx) : 0;
+      if (0 > used) {
+        pos++;
+      } else if (0 == used) {
+        if (eof) pos = len;   // Truncated record at the end
+        break;
+      } else {
+        pos += used;
+      }
+    }
+    // Keep a partial record for the next read
+    memmove(buf.data(), buf.data() + pos, len - pos);
+    len -= pos;
+    if (eof && len) len = 0u;
+  }
+}
+
+#endif // FPSCAN_H
@@ -0,0 +1,207 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  fpstat - per-part statistics from flash fingerprint records
+
+  Build from the library root:
+
+    g++ -std=gnu++17 -O2 -Wall -Isrc tools/fingerprint/fpstat.cpp -o fpstat
+
+  Usage:
+
+    fpstat [-c] [file ...]
+
+      -c  CSV output
+
+  Reads each file, or stdin when none or "-" is named, as a stream. Raw 64
+  byte records and "FFP1:" hex lines may be mixed with any other text, eg. a
+  captured serial log. Records with a bad CRC are counted and skipped.
+
+  A module is the JEDEC ID, SFDP hash, and Unique ID. Records for a module
+  already seen are counted as duplicates, only the first is in the per-part
+  counts. Without a Unique ID, only identical records are duplicates. Reclaim
+  cycles and transactions are from every record, each is one boot.
+
+    part    JEDEC ID and SFDP hash
+    mods    modules
+    recs    records, including duplicates
+    ok      reclaim_GPIO_9_10() succeeded, "cache" from a saved recipe
+    fail    reclaim_GPIO_9_10() failed, "n/r" not run
+    cycles  CPU cycles in reclaim_GPIO_9_10(), min / mean / max
+    xfers   flash transactions in reclaim_GPIO_9_10(), mean
+    SR      the most common Status Registers 1, 2, 3 and their share
+    pass    modules where Analyze passed the short circuit, /WP and /HOLD tests
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "fpscan.h"
+
+using namespace experimental;
+
+////////////////////////////////////////////////////////////////////////////////
+// Aggregation
+struct ModuleKey {
+  uint32_t w[6];
+  bool operator==(const ModuleKey& o) const { return 0 == memcmp(w, o.w, sizeof(w)); }
+};
+struct ModuleKeyHash {
+  size_t operator()(const ModuleKey& k) const {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (uint32_t v : k.w) h = (h ^ v) * 0x100000001b3ull;
+    return (size_t)h;
+  }
+};
+
+struct PartStats {
+  uint32_t jedec_id = 0u;
+  uint32_t sfdp_hash = 0u;
+  uint64_t modules = 0u;
+  uint64_t records = 0u;
+  uint64_t reclaim[4] = {};
+  uint64_t timed = 0u;
+  uint64_t cycles_sum = 0u;
+  uint32_t cycles_min = ~0u;
+  uint32_t cycles_max = 0u;
+  uint64_t xfers_sum = 0u;
+  uint64_t pass = 0u;
+  std::unordered_map<uint32_t, uint64_t> sr;
+};
+
+static std::unordered_set<ModuleKey, ModuleKeyHash> modules;
+static std::unordered_map<uint64_t, PartStats> parts;
+static uint64_t total_records = 0u;
+static uint64_t duplicates = 0u;
+
+static void add(const FlashFingerprint& fp, void *) {
+  total_records++;
+  const uint64_t part_key = ((uint64_t)fp.jedec_id << 32u) | fp.sfdp_hash;
+  PartStats& ps = parts[part_key];
+  ps.jedec_id = fp.jedec_id;
+  ps.sfdp_hash = fp.sfdp_hash;
+  ps.records++;
+  if (fp.reclaim_cycles) {
+    ps.timed++;
+    ps.cycles_sum += fp.reclaim_cycles;
+    ps.cycles_min = std::min(ps.cycles_min, fp.reclaim_cycles);
+    ps.cycles_max = std::max(ps.cycles_max, fp.reclaim_cycles);
+    ps.xfers_sum += fp.reclaim_xfers;
+  }
+
+  ModuleKey key;
+  key.w[0] = fp.jedec_id;
+  key.w[1] = fp.sfdp_hash;
+  if (fp.caps & kFpCapUniqueId) {
+    memcpy(&key.w[2], fp.unique_id, sizeof(fp.unique_id));
+  } else {
+    // No identity, only an identical record is a duplicate
+    key.w[2] = fp.crc;
+    key.w[3] = fp.reclaim_cycles;
+    key.w[4] = 0u;
+    key.w[5] = ~0u;
+  }
+  if (! modules.insert(key).second) {
+    duplicates++;
+    return;
+  }
+  ps.modules++;
+  ps.reclaim[(fp.reclaim < 4u) ? fp.reclaim : 0u]++;
+  ps.sr[(uint32_t)fp.sr[0] | ((uint32_t)fp.sr[1] << 8u) | ((uint32_t)fp.sr[2] << 16u)]++;
+  constexpr uint16_t kPassAll = kFpCapAnalyze | kFpCapPassSC | kFpCapPassWP | kFpCapPassHOLD;
+  if (kPassAll == (fp.caps & kPassAll)) ps.pass++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static void print(const bool csv) {
+  std::vector<const PartStats *> list;
+  for (const auto& kv : parts) list.push_back(&kv.second);
+  std::sort(list.begin(), list.end(), [](const PartStats *a, const PartStats *b) {
+    if (a->modules != b->modules) return a->modules > b->modules;
+    if (a->jedec_id != b->jedec_id) return a->jedec_id < b->jedec_id;
+    return a->sfdp_hash < b->sfdp_hash;
+  });
+
+  if (csv) {
+    printf("jedec_id,sfdp_hash,modules,records,ok,cached,failed,not_run,cycles_min,cycles_mean,cycles_max,xfers_mean,sr321,sr321_modules,pass\n");
+  } else {
+    printf("  %-17s %8s %8s %7s %7s %7s %7s %22s %6s %-15s %7s\n",
+      "part", "mods", "recs", "ok", "cache", "fail", "n/r", "cycles", "xfers", "SR", "pass");
+  }
+  for (const PartStats *ps : list) {
+    uint32_t sr = 0u;
+    uint64_t sr_n = 0u;
+    for (const auto& kv : ps->sr) {
+      if (kv.second > sr_n || (kv.second == sr_n && kv.first < sr)) {
+        sr = kv.first;
+        sr_n = kv.second;
+      }
+    }
+    const uint32_t cmin = (ps->timed) ? ps->cycles_min : 0u;
+    const uint32_t cavg = (ps->timed) ? (uint32_t)(ps->cycles_sum / ps->timed) : 0u;
+    const double xavg = (ps->timed) ? (double)ps->xfers_sum / ps->timed : 0.0;
+    if (csv) {
+      printf("0x%06X,0x%08X,%llu,%llu,%llu,%llu,%llu,%llu,%u,%u,%u,%.1f,0x%06X,%llu,%llu\n",
+        ps->jedec_id, ps->sfdp_hash, (unsigned long long)ps->modules, (unsigned long long)ps->records,
+        (unsigned long long)ps->reclaim[kFpReclaimOk], (unsigned long long)ps->reclaim[kFpReclaimCached],
+        (unsigned long long)ps->reclaim[kFpReclaimFailed], (unsigned long long)ps->reclaim[kFpReclaimNotRun],
+        cmin, cavg, ps->cycles_max, xavg, sr, (unsigned long long)sr_n, (unsigned long long)ps->pass);
+    } else {
+      char cycles[32];
+      snprintf(cycles, sizeof(cycles), "%u/%u/%u", cmin, cavg, ps->cycles_max);
+      printf("  %06X %08X   %8llu %8llu %7llu %7llu %7llu %7llu %22s %6.1f %02X %02X %02X %4.0f%% %7llu\n",
+        ps->jedec_id, ps->sfdp_hash, (unsigned long long)ps->modules, (unsigned long long)ps->records,
+        (unsigned long long)ps->reclaim[kFpReclaimOk], (unsigned long long)ps->reclaim[kFpReclaimCached],
+        (unsigned long long)ps->reclaim[kFpReclaimFailed], (unsigned long long)ps->reclaim[kFpReclaimNotRun],
+        cycles, xavg, sr & 0xFFu, (sr >> 8u) & 0xFFu, (sr >> 16u) & 0xFFu,
+        (ps->modules) ? 100.0 * sr_n / ps->modules : 0.0, (unsigned long long)ps->pass);
+    }
+  }
+  fprintf(stderr, "%llu records, %llu modules, %llu duplicates, %llu bad, %zu parts\n",
+    (unsigned long long)total_records, (unsigned long long)modules.size(),
+    (unsigned long long)duplicates, (unsigned long long)fp_bad_records, parts.size());
+}
+
+int main(int argc, char **argv) {
+  bool csv = false;
+  size_t files = 0u;
+  int rc = 0;
+  for (int i = 1; i < argc; i++) {
+    if (0 == strcmp("-c", argv[i])) {
+      csv = true;
+      continue;
+    }
+    files++;
+    if (0 == strcmp("-", argv[i])) {
+      fp_scan(stdin, add, nullptr);
+      continue;
+    }
+    FILE *f = fopen(argv[i], "rb");
+    if (nullptr == f) {
+      perror(argv[i]);
+      rc = 2;
+      continue;
+    }
+    fp_scan(f, add, nullptr);
+    fclose(f);
+  }
+  if (0u == files) fp_scan(stdin, add, nullptr);
+  print(csv);
+  return rc;
+}
@@ -0,0 +1,84 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  vendor_check - check a vendorgen table against its fixture
+
+  Build from the library root, with -I at the folder holding the generated
+  FleetVendor.h and FleetVendorFixture.h:
+
+    g++ -std=gnu++17 -O1 -Wall -Itools/hostsim/include -Itools/hostsim -Isrc -I. \
+      tools/hostsim/hostsim.cpp tools/hostsim/profiles.cpp \
+      tools/fingerprint/vendor_check.cpp src/SpiFlashUtils.cpp src/SpiFlashUtilsQE.cpp \
+      src/ModeDIO_ReclaimGPIOs.cpp src/SpiFlashCost.cpp src/StatusRegisterUpdate.cpp \
+      -o vendor_check
+
+  For each fixture variant, spi_flash_vendor_part_find() is run on the table
+  with that variant's SFDP revision, and the entry found is compared with the
+  entry vendorgen expected. get_sfdp_revision() is replaced here, so no flash
+  model is needed for the lookup. Exits non-zero on a mismatch or when the
+  table is not sorted.
+*/
+#include <Arduino.h>
+#define FLEET_VENDOR_TABLE_ONLY 1
+#include "FleetVendor.h"
+#include "FleetVendorFixture.h"
+#include <SfdpRevInfo.h>
+
+static constexpr bool is_sorted_parts(const SpiFlashVendorPart *t, const size_t n) {
+  for (size_t i = 1u; i < n; i++) {
+    if (spi_flash_vendor_part_key(t[i]) < spi_flash_vendor_part_key(t[i - 1u])) return false;
+  }
+  return true;
+}
+static_assert(is_sorted_parts(kFleetParts, kFleetPartsCount), "kFleetParts must be sorted by vendor, then type");
+
+static const FleetVendorFixture *current = nullptr;
+
+namespace experimental {
+
+// Stand-in for SfdpRevInfo.cpp, returns the current fixture's revision
+SfdpRevInfo get_sfdp_revision() {
+  SfdpRevInfo rev;
+  memset(&rev, 0, sizeof(rev));
+  if (current && (current->parm_major || current->parm_minor || current->sz_dw)) {
+    rev.hdr_major = 1u;
+    rev.parm_major = current->parm_major;
+    rev.parm_minor = current->parm_minor;
+    rev.sz_dw = current->sz_dw;
+    rev.tbl_ptr = 0x30u;
+  }
+  return rev;
+}
+
+};
+
+int main() {
+  size_t fails = 0u;
+  const size_t count = sizeof(kFleetVendorFixture) / sizeof(kFleetVendorFixture[0]);
+  for (size_t i = 0u; i < count; i++) {
+    current = &kFleetVendorFixture[i];
+    SpiFlashVendorPart part;
+    const SpiFlashVendorPart *found = spi_flash_vendor_part_find(kFleetParts, kFleetPartsCount, current->jedec_id, &part);
+    const int entry = (found) ? (int)(found - kFleetParts) : -1;
+    const bool pass = entry == current->entry;
+    if (! pass) fails++;
+    printf("  0x%06X SFDP %u.%02u %2u DW  entry %2d, expected %2d%s\n", current->jedec_id,
+      current->parm_major, current->parm_minor, current->sz_dw, entry, current->entry,
+      (pass) ? "" : "  ** mismatch");
+  }
+  printf("%zu variants, %zu entries, %zu mismatches\n", count, kFleetPartsCount, fails);
+  return (fails) ? 1 : 0;
+}
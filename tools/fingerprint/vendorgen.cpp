@@ -0,0 +1,323 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  vendorgen - spi_flash_vendor_cases() from a database of Analyze results
+
+  Build from the library root:
+
+    g++ -std=gnu++17 -O2 -Wall -Isrc tools/fingerprint/vendorgen.cpp -o vendorgen
+
+  Usage:
+
+    vendorgen [-n modules] [-o FleetVendor.h] [-f FleetVendorFixture.h] [file ...]
+
+      -n  skip variants seen on fewer modules, default 1
+      -o  the table and spi_flash_vendor_cases(), default FleetVendor.h
+      -f  the regression fixture, default FleetVendorFixture.h
+
+  Input is FlashFingerprint records printed by the Analyze script, read like
+  fpstat reads them. Records without kFpCapAnalyze are ignored.
+
+  A variant is a vendor and type byte, with the 1st SFDP parameter table
+  revision and size. Each module's Analyze result picks a QE recipe the same
+  way printReclaimFn() does, or no recipe when the short circuit, /WP, or
+  /HOLD test failed. When all modules of a vendor and type agree, it gets one
+  entry. When they do not, each variant gets an entry with an SFDP guard, see
+  SPI_FLASH_VENDOR_PART_SFDP(). A variant whose modules disagree, or that
+  failed, gets no entry and is reported on stderr.
+
+  The output is a sorted SpiFlashVendorPart table for
+  spi_flash_vendor_table_cases(), and a spi_flash_vendor_cases() that falls
+  back to the built-in parts. Include FleetVendor.h from one file of a Sketch.
+  The fixture lists each variant, and the table entry it must match, for
+  tools/fingerprint/vendor_check.cpp.
+
+  Exits non-zero when no variant has an entry.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "fpscan.h"
+
+// From ModeDIO_ReclaimGPIOs.h and SpiFlashUtilsQE.h, without the Arduino
+// includes they pull in.
+enum : uint8_t {
+  kVendorPartNonVolatile = 0x01u,
+  kVendorPartPreserveSR3 = 0x02u,
+};
+static const char *const kKindName[] = {"None", "S6_8bitSR1", "S9_8bitSR2", "S9_16bitSR1"};
+constexpr uint32_t kVendorXMC = 0x20u;
+
+// A variant as spi_flash_vendor_part_find() sees it
+struct Variant {
+  uint32_t id16;                  // (type << 8) | vendor
+  uint8_t parm_major;
+  uint8_t parm_minor;
+  uint8_t sz_dw;
+  bool operator<(const Variant& o) const {
+    const uint32_t a = ((0xFFu & id16) << 8u) | (id16 >> 8u);
+    const uint32_t b = ((0xFFu & o.id16) << 8u) | (o.id16 >> 8u);
+    if (a != b) return a < b;
+    if (parm_major != o.parm_major) return parm_major < o.parm_major;
+    if (parm_minor != o.parm_minor) return parm_minor < o.parm_minor;
+    return sz_dw < o.sz_dw;
+  }
+};
+
+// kind << 8 | flags, or kNoRecipe
+constexpr uint32_t kNoRecipe = 0xFFFFu;
+
+struct VariantInfo {
+  uint32_t jedec_id = 0u;         // as seen, for comments
+  std::map<uint32_t, uint64_t> recipes;   // recipe -> modules
+  std::set<std::vector<uint32_t>> modules;
+  uint64_t records = 0u;
+  uint32_t recipe = kNoRecipe;    // resolved
+  const char *skip = nullptr;     // why there is no entry
+  int entry = -1;
+};
+
+static std::map<Variant, VariantInfo> variants;
+static uint64_t analyze_records = 0u;
+
+static uint32_t recipe_of(const FlashFingerprint& fp) {
+  constexpr uint16_t kPassAll = kFpCapPassSC | kFpCapPassWP | kFpCapPassHOLD;
+  if (kPassAll != (fp.caps & kPassAll)) return kNoRecipe;
+  uint32_t kind = 0u;
+  if (fp.caps & kFpCapS9) {
+    if (fp.caps & kFpCap16bwSR1) {
+      kind = 3u;
+    } else if (fp.caps & kFpCap8bwSR2) {
+      kind = 2u;
+    } else {
+      return kNoRecipe;
+    }
+  } else if (fp.caps & kFpCapS6) {
+    kind = 1u;
+  }
+  uint32_t flags = (fp.caps & kFpCapVolatile) ? 0u : (uint32_t)kVendorPartNonVolatile;
+  if (kVendorXMC == (0xFFu & fp.jedec_id)) flags |= kVendorPartPreserveSR3;
+  return (kind << 8u) | flags;
+}
+
+static void add(const FlashFingerprint& fp, void *) {
+  if (0u == (fp.caps & kFpCapAnalyze)) return;
+  analyze_records++;
+  Variant v;
+  v.id16 = 0xFFFFu & fp.jedec_id;
+  // SfdpParam, the 1st parameter header. Zero without SFDP, as
+  // get_sfdp_revision() returns.
+  v.parm_minor = (fp.sfdp_hdr[2] >> 8u) & 0xFFu;
+  v.parm_major = (fp.sfdp_hdr[2] >> 16u) & 0xFFu;
+  v.sz_dw = fp.sfdp_hdr[2] >> 24u;
+  VariantInfo& vi = variants[v];
+  vi.jedec_id = fp.jedec_id;
+  vi.records++;
+  std::vector<uint32_t> module(fp.unique_id, fp.unique_id + 4);
+  if (0u == (fp.caps & kFpCapUniqueId)) module.push_back(fp.crc);
+  if (vi.modules.insert(module).second) vi.recipes[recipe_of(fp)]++;
+}
+
+struct Entry {
+  Variant v;
+  uint32_t recipe;
+  bool guard;
+  uint64_t modules;
+  uint32_t jedec_id;
+};
+
+static std::vector<Entry> build(const uint64_t min_modules) {
+  // Resolve each variant
+  for (auto& kv : variants) {
+    VariantInfo& vi = kv.second;
+    if (vi.modules.size() < min_modules) {
+      vi.skip = "too few modules";
+    } else if (1u != vi.recipes.size()) {
+      vi.skip = "modules disagree";
+    } else if (kNoRecipe == vi.recipes.begin()->first) {
+      vi.skip = "Analyze failed";
+    } else {
+      vi.recipe = vi.recipes.begin()->first;
+    }
+  }
+
+  // Group by vendor and type, variants are sorted that way
+  std::vector<Entry> entries;
+  for (auto it = variants.begin(); it != variants.end();) {
+    auto end = it;
+    bool same = true;
+    uint32_t recipe = kNoRecipe;
+    uint64_t modules = 0u;
+    for (; end != variants.end() && end->first.id16 == it->first.id16; ++end) {
+      const VariantInfo& vi = end->second;
+      modules += vi.modules.size();
+      if (kNoRecipe == recipe) recipe = vi.recipe;
+      if (vi.skip || vi.recipe != recipe) same = false;
+    }
+    if (same) {
+      entries.push_back(Entry{it->first, recipe, false, modules, it->second.jedec_id});
+      for (auto v = it; v != end; ++v) v->second.entry = (int)entries.size() - 1;
+    } else {
+      for (auto v = it; v != end; ++v) {
+        if (v->second.skip) continue;
+        entries.push_back(Entry{v->first, v->second.recipe, true, v->second.modules.size(), v->second.jedec_id});
+        v->second.entry = (int)entries.size() - 1;
+      }
+    }
+    it = end;
+  }
+  return entries;
+}
+
+static std::string flags_str(const uint32_t flags) {
+  std::string s;
+  if (flags & kVendorPartNonVolatile) s = "kVendorPartNonVolatile";
+  if (flags & kVendorPartPreserveSR3) s += (s.empty()) ? "kVendorPartPreserveSR3" : " | kVendorPartPreserveSR3";
+  return (s.empty()) ? "0u" : s;
+}
+
+static bool write_table(const char *path, const std::vector<Entry>& entries) {
+  FILE *f = fopen(path, "w");
+  if (nullptr == f) {
+    perror(path);
+    return false;
+  }
+  fprintf(f,
+    "// Generated by tools/fingerprint/vendorgen from %llu Analyze records.\n"
+    "// Do not edit, rerun vendorgen with the new records instead.\n"
+    "//\n"
+    "// Include from one file of a Sketch. Define FLEET_VENDOR_TABLE_ONLY to use\n"
+    "// kFleetParts with your own spi_flash_vendor_cases().\n"
+    "#ifndef FLEET_VENDOR_H\n"
+    "#define FLEET_VENDOR_H\n"
+    "\n"
+    "#include <ModeDIO_ReclaimGPIOs.h>\n"
+    "\n"
+    "static constexpr SpiFlashVendorPart kFleetParts[] PROGMEM = {\n",
+    (unsigned long long)analyze_records);
+  for (const Entry& e : entries) {
+    const uint32_t vendor = 0xFFu & e.v.id16;
+    const uint32_t type = e.v.id16 >> 8u;
+    const char *kind = kKindName[e.recipe >> 8u];
+    const std::string flags = flags_str(0xFFu & e.recipe);
+    fprintf(f, "  // 0x%06X, %llu module%s", e.jedec_id, (unsigned long long)e.modules, (1u == e.modules) ? "" : "s");
+    if (e.guard) {
+      fprintf(f, ", SFDP 1ST Parameter Table Revision: %u.%02u, Size: %u DW\n", e.v.parm_major, e.v.parm_minor, e.v.sz_dw);
+      fprintf(f, "  SPI_FLASH_VENDOR_PART_SFDP(0x%02Xu, 0x%02Xu, %s, %s, %uu, %uu, %uu),\n",
+        vendor, type, kind, flags.c_str(), e.v.parm_major, e.v.parm_minor, e.v.sz_dw);
+    } else {
+      fprintf(f, "\n  SPI_FLASH_VENDOR_PART(0x%02Xu, 0x%02Xu, %s, %s),\n", vendor, type, kind, flags.c_str());
+    }
+  }
+  fprintf(f,
+    "};\n"
+    "constexpr size_t kFleetPartsCount = sizeof(kFleetParts) / sizeof(kFleetParts[0]);\n"
+    "\n"
+    "#ifndef FLEET_VENDOR_TABLE_ONLY\n"
+    "extern \"C\"\n"
+    "bool spi_flash_vendor_cases(uint32_t device) {\n"
+    "  bool success = spi_flash_vendor_table_cases(kFleetParts, kFleetPartsCount, device);\n"
+    "  if (! success) {\n"
+    "    // then try built-in support\n"
+    "    success = __spi_flash_vendor_cases(device);\n"
+    "  }\n"
+    "  return success;\n"
+    "}\n"
+    "#endif\n"
+    "\n"
+    "#endif // FLEET_VENDOR_H\n");
+  return 0 == fclose(f);
+}
+
+static bool write_fixture(const char *path) {
+  FILE *f = fopen(path, "w");
+  if (nullptr == f) {
+    perror(path);
+    return false;
+  }
+  fprintf(f,
+    "// Generated by tools/fingerprint/vendorgen. Each variant seen, and the\n"
+    "// kFleetParts entry it must match, -1 for none. See vendor_check.cpp\n"
+    "#ifndef FLEET_VENDOR_FIXTURE_H\n"
+    "#define FLEET_VENDOR_FIXTURE_H\n"
+    "\n"
+    "struct FleetVendorFixture {\n"
+    "  uint32_t jedec_id;\n"
+    "  uint8_t parm_major;\n"
+    "  uint8_t parm_minor;\n"
+    "  uint8_t sz_dw;\n"
+    "  int8_t entry;\n"
+    "};\n"
+    "\n"
+    "static const FleetVendorFixture kFleetVendorFixture[] = {\n");
+  for (const auto& kv : variants) {
+    fprintf(f, "  {0x%06Xu, %uu, %uu, %uu, %d},", kv.second.jedec_id,
+      kv.first.parm_major, kv.first.parm_minor, kv.first.sz_dw, kv.second.entry);
+    if (kv.second.skip) fprintf(f, "  // %s", kv.second.skip);
+    fprintf(f, "\n");
+  }
+  fprintf(f,
+    "};\n"
+    "\n"
+    "#endif // FLEET_VENDOR_FIXTURE_H\n");
+  return 0 == fclose(f);
+}
+
+int main(int argc, char **argv) {
+  uint64_t min_modules = 1u;
+  const char *out = "FleetVendor.h";
+  const char *fixture = "FleetVendorFixture.h";
+  size_t files = 0u;
+  for (int i = 1; i < argc; i++) {
+    if (0 == strcmp("-n", argv[i]) && (i + 1) < argc) {
+      min_modules = strtoull(argv[++i], nullptr, 0);
+    } else if (0 == strcmp("-o", argv[i]) && (i + 1) < argc) {
+      out = argv[++i];
+    } else if (0 == strcmp("-f", argv[i]) && (i + 1) < argc) {
+      fixture = argv[++i];
+    } else if (0 == strcmp("-", argv[i])) {
+      files++;
+      fp_scan(stdin, add, nullptr);
+    } else {
+      files++;
+      FILE *f = fopen(argv[i], "rb");
+      if (nullptr == f) {
+        perror(argv[i]);
+        return 2;
+      }
+      fp_scan(f, add, nullptr);
+      fclose(f);
+    }
+  }
+  if (0u == files) fp_scan(stdin, add, nullptr);
+
+  const std::vector<Entry> entries = build(min_modules);
+  for (const auto& kv : variants) {
+    if (kv.second.skip) {
+      fprintf(stderr, "0x%06X SFDP %u.%02u %u DW, %zu modules: no entry, %s\n", kv.second.jedec_id,
+        kv.first.parm_major, kv.first.parm_minor, kv.first.sz_dw, kv.second.modules.size(), kv.second.skip);
+    }
+  }
+  fprintf(stderr, "%llu Analyze records, %zu variants, %zu entries, %llu bad\n",
+    (unsigned long long)analyze_records, variants.size(), entries.size(), (unsigned long long)fp_bad_records);
+  if (entries.empty()) return 1;
+  if (! write_table(out, entries) || ! write_fixture(fixture)) return 2;
+  return 0;
+}
@@ -0,0 +1,157 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  fbcmp - compare FlashBench runs side by side
+
+  Build:
+
+    g++ -std=gnu++17 -O2 -Wall tools/flashbench/fbcmp.cpp -o fbcmp
+
+  Usage:
+
+    fbcmp base.log [run.log ...]
+
+  Each file is the captured serial output of one run of the FlashBench
+  example, other output mixed in is skipped. When a file holds more than one
+  run, the last complete one is used.
+
+  The env lines are listed first, then a row for each test. Latency tests
+  show the mean ns, throughput tests the KiB/s. For each run after the first,
+  the change against the first follows, + is worse: more time, or less
+  throughput.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+struct Result {
+  uint32_t n = 0u;
+  uint32_t min_ns = 0u;
+  uint32_t mean_ns = 0u;
+  uint32_t max_ns = 0u;
+  uint32_t sd_ns = 0u;
+  uint32_t kib_s = 0u;
+};
+
+struct Run {
+  std::string name;
+  std::map<std::string, std::string> env;
+  std::map<std::string, Result> results;
+};
+
+// Both in the order first seen
+static std::vector<std::string> env_keys;
+static std::vector<std::string> tests;
+
+static void note(std::vector<std::string>& list, const std::string& key) {
+  for (const std::string& k : list) {
+    if (k == key) return;
+  }
+  list.push_back(key);
+}
+
+static bool load(const char *path, Run& run) {
+  FILE *f = fopen(path, "r");
+  if (nullptr == f) return false;
+  run.name = path;
+  Run cur;
+  bool any = false;
+  char line[512];
+  while (fgets(line, sizeof(line), f)) {
+    const char *p = strstr(line, "FB1 ");
+    if (nullptr == p) continue;
+    p += 4;
+    char key[64], value[64];
+    Result r;
+    if (2 == sscanf(p, "env %63s %63s", key, value)) {
+      // A new run starts with its env lines
+      if (! cur.results.empty()) cur = Run{};
+      cur.env[key] = value;
+      note(env_keys, key);
+    } else if (0 == strncmp(p, "end", 3u)) {
+      run.env = cur.env;
+      run.results = cur.results;
+      any = true;
+    } else if (7 == sscanf(p, "%63s %u %u %u %u %u %u", key, &r.n, &r.min_ns, &r.mean_ns, &r.max_ns, &r.sd_ns, &r.kib_s)) {
+      cur.results[key] = r;
+      note(tests, key);
+    }
+  }
+  fclose(f);
+  return any;
+}
+
+// + is worse
+static double change(const Result& base, const Result& r) {
+  if (base.kib_s && r.kib_s) return 100.0 * ((double)base.kib_s / r.kib_s - 1.0);
+  if (base.mean_ns) return 100.0 * ((double)r.mean_ns / base.mean_ns - 1.0);
+  return 0.0;
+}
+
+int main(int argc, char **argv) {
+  if (2 > argc) {
+    fprintf(stderr, "usage: fbcmp base.log [run.log ...]\n");
+    return 2;
+  }
+  std::vector<Run> runs;
+  for (int i = 1; i < argc; i++) {
+    Run run;
+    if (! load(argv[i], run)) {
+      fprintf(stderr, "fbcmp: no complete FlashBench run in %s\n", argv[i]);
+      return 1;
+    }
+    runs.push_back(run);
+  }
+
+  printf("%-16s", "");
+  for (const Run& run : runs) printf(" %18.18s", run.name.c_str());
+  printf("\n");
+  for (const std::string& k : env_keys) {
+    printf("%-16s", k.c_str());
+    for (const Run& run : runs) {
+      auto it = run.env.find(k);
+      printf(" %18s", (run.env.end() != it) ? it->second.c_str() : "-");
+    }
+    printf("\n");
+  }
+  printf("\n");
+
+  for (const std::string& t : tests) {
+    const auto b = runs[0].results.find(t);
+    const bool rate = (runs[0].results.end() != b && b->second.kib_s);
+    printf("%-16s", t.c_str());
+    for (size_t i = 0u; i < runs.size(); i++) {
+      const auto it = runs[i].results.find(t);
+      if (runs[i].results.end() == it) {
+        printf(" %18s", "-");
+        continue;
+      }
+      char cell[40];
+      const uint32_t v = (rate) ? it->second.kib_s : it->second.mean_ns;
+      if (0u == i || runs[0].results.end() == b) {
+        snprintf(cell, sizeof(cell), "%u %s", v, (rate) ? "KiB/s" : "ns");
+      } else {
+        snprintf(cell, sizeof(cell), "%u %+.1f%%", v, change(b->second, it->second));
+      }
+      printf(" %18s", cell);
+    }
+    printf("\n");
+  }
+  return 0;
+}
@@ -0,0 +1,132 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  cost_sim - per-API cost report, SpiFlashCost.h against the simulator
+
+  Build from the library root:
+
+    g++ -std=gnu++17 -O1 -Wall -Itools/hostsim/include -Isrc -DSPI_FLASH_COST=1 \
+      tools/hostsim/hostsim.cpp tools/hostsim/profiles.cpp \
+      tools/hostsim/cost_sim.cpp src/SpiFlashUtils.cpp src/SpiFlashUtilsQE.cpp \
+      src/SpiFlashCost.cpp -o cost_sim
+
+  Usage:
+
+    cost_sim [-m MHz] [profile]
+
+  Runs each SpiFlashUtils helper once on the part, default "winbond", and
+  prints what spi0_flash_cost recorded next to what the simulator saw.
+
+    txn     transactions, model / simulator
+    clocks  SPI clocks, model / simulator
+    win     iCache disable windows
+    nv      non-volatile writes, each adds tW to the cache-off time
+    bus us  wire time at the SPI clock
+    ovh us  estimated controller overhead, see SPI_FLASH_COST_WINDOW_CYCLES
+    off us  estimated iCache off time, tW from the profile
+
+  The simulator's extra transactions on a non-volatile write are WIP polls,
+  the model leaves those to tW. Exits non-zero when the counts differ by more
+  than that.
+*/
+#include <Arduino.h>
+#include <stdlib.h>
+#include "SpiFlashUtilsQE.h"
+#include "hostsim.h"
+
+#if ! SPI_FLASH_COST
+#error "Build with -DSPI_FLASH_COST=1"
+#endif
+
+using namespace experimental;
+
+static uint32_t mhz = 40u;
+static uint32_t v;
+static uint32_t buf[64];
+
+static bool row(const char *name, void (*fn)()) {
+  hostsim::Measure m;
+  const SpiFlashCost mark = spi0_flash_cost;
+  fn();
+  const SpiFlashCost c = spi0_flash_cost_since(mark);
+  const hostsim::Counters d = m.delta();
+  const SpiCostReport r = spi_flash_cost_report(c, mhz, hostsim::profile().sr_write_us);
+
+  // Anything the model misses, beyond WIP polls, is a bug in the hooks
+  const uint64_t extra = d.transactions - c.xfers;
+  const bool pass = d.transactions >= c.xfers &&
+                    d.bus_bits == c.clocks + extra * kSpiRdsrClocks &&
+                    d.cache_windows == c.windows &&
+                    (0u != c.nv_writes || 0u == extra);
+
+  printf("  %-42s %3u/%-5llu %5u/%-5llu %3u %2u %8.2f %8.2f %9.2f%s\n", name,
+    c.xfers, (unsigned long long)d.transactions, c.clocks, (unsigned long long)d.bus_bits,
+    c.windows, c.nv_writes, r.bus_ns / 1000.0, r.overhead_ns / 1000.0, r.cache_off_ns / 1000.0,
+    (pass) ? "" : "  ** mismatch");
+  return pass;
+}
+
+#define ROW(name, expr) row(name, []() { expr; })
+
+int main(int argc, char **argv) {
+  const char *name = "winbond";
+  for (int i = 1; i < argc; i++) {
+    if (0 == strcmp("-m", argv[i]) && (i + 1) < argc) {
+      mhz = strtoul(argv[++i], nullptr, 0);
+    } else {
+      name = argv[i];
+    }
+  }
+  const hostsim::FlashProfile *p = hostsim::find_profile(name);
+  if (nullptr == p || 0u == mhz) {
+    fprintf(stderr, "Unknown profile or clock: %s %u\n", name, mhz);
+    return 2;
+  }
+  hostsim::config.spi_hz = mhz * 1000000u;
+  hostsim::install(*p);
+  hostsim::bootrom_dio();
+  spi0_flash_cost_reset();
+
+  printf("%s, %u MHz, window %u cycles, transaction %u cycles, tW %u us\n\n",
+    p->part, mhz, SPI_FLASH_COST_WINDOW_CYCLES, SPI_FLASH_COST_XFER_CYCLES, p->sr_write_us);
+  printf("  %-42s %9s %11s %3s %2s %8s %8s %9s\n",
+    "call", "txn", "clocks", "win", "nv", "bus us", "ovh us", "off us");
+
+  bool pass = true;
+  pass = ROW("read_status_register_1", spi0_flash_read_status_register_1(&v)) && pass;
+  pass = ROW("read_status_register_2", spi0_flash_read_status_register_2(&v)) && pass;
+  pass = ROW("read_status_registers_3B", spi0_flash_read_status_registers_3B(&v)) && pass;
+  pass = ROW("verify_status_register_2", verify_status_register_2(kQES9Bit1B)) && pass;
+  pass = ROW("write_status_register_2, volatile", spi0_flash_write_status_register_2(0x02u, volatile_bit)) && pass;
+  pass = ROW("write_status_register_2, non-volatile", spi0_flash_write_status_register_2(0x02u, non_volatile_bit)) && pass;
+  pass = ROW("write_verify_status_register, volatile", spi0_flash_write_verify_status_register(1u, 0x02u, volatile_bit, 8u, 1u, &v)) && pass;
+  pass = ROW("clear_S9_QE_bit__8_bit_sr2_write, nv", clear_S9_QE_bit__8_bit_sr2_write(non_volatile_bit)) && pass;
+  pass = ROW("set_S9_QE_bit__16_bit_sr1_write, nv", set_S9_QE_bit__16_bit_sr1_write(non_volatile_bit)) && pass;
+  pass = ROW("clear_S9_QE_bit__8_bit_sr2_write, volatile", clear_S9_QE_bit__8_bit_sr2_write(volatile_bit)) && pass;
+  pass = ROW("set_S9_QE_bit__8_bit_sr2_write, volatile", set_S9_QE_bit__8_bit_sr2_write(volatile_bit)) && pass;
+  pass = ROW("software_reset, 30 us", spi0_flash_software_reset(30u)) && pass;
+  pass = ROW("read_sfdp, 16 bytes", spi0_flash_read_sfdp(0u, buf, 16u)) && pass;
+  pass = ROW("read_sfdp, 256 bytes", spi0_flash_read_sfdp(0u, buf, 256u)) && pass;
+  pass = ROW("read_unique_id_128", spi0_flash_read_unique_id_128(buf)) && pass;
+  pass = ROW("program_security_register, 16 bytes", spi0_flash_program_security_register(1u, 0u, buf, 16u, nullptr, nullptr)) && pass;
+  pass = ROW("erase_security_register", spi0_flash_erase_security_register(1u, nullptr, nullptr)) && pass;
+  printf("\n  iCache line fill, %u bytes, wire time at %u MHz\n", kICacheLineSz, mhz);
+  static const char *modes[] = {"SLOW", "FAST", "DOUT", "DIO", "QOUT", "QIO"};
+  for (uint32_t m = kSpiIoSlow; m <= kSpiIoQio; m++) {
+    printf("    %-4s %6.3f us\n", modes[m], spi_icache_line_ns((SpiIoMode)m, mhz) / 1000.0);
+  }
+  return (pass) ? 0 : 1;
+}
@@ -0,0 +1,750 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+////////////////////////////////////////////////////////////////////////////////
+// Host SPI0 controller and flash chip simulator, see hostsim.h
+//
+// The BootROM and SDK functions here follow what the comments in
+// BootROM_NONOS.h describe, at the level of flash instructions. Each one that
+// runs from flash on the ESP8266 opens its own iCache disable window.
+#include <Arduino.h>
+#include <user_interface.h>
+#include <coredecls.h>
+// Same linkage as the library, it includes spi_utils.h from inside extern "C"
+extern "C" {
+#include <spi_utils.h>
+}
+#include "BootROM_NONOS.h"
+#include "hostsim.h"
+
+HostSimSpi0 hostsim_spi0;
+HostSimGpio hostsim_gpio;
+static SpiFlashChip flashchip_data;
+SpiFlashChip *flashchip = &flashchip_data;
+HardwareSerial Serial;
+
+namespace hostsim {
+
+Config config;
+
+static Counters cnt;
+static const FlashProfile *cur = nullptr;
+static FlashState fs;
+static uint64_t wip_done_ns = 0u;
+static bool vol_enable = false;   // 50h accepted, next SR write is volatile
+static bool reset_enable = false; // 66h was the last instruction
+static uint64_t reset_done_ns = 0u; // 99h, no response until tRST passes
+static const char *trace_note = nullptr;
+static uint8_t pins[17];
+static uint32_t rtc_mem[192];     // 768 bytes, user blocks start at 64
+static uint64_t cache_off_start = 0u;
+static bool cache_off = false;
+static uint64_t cycle_rem = 0u;   // Sub-ns remainder of advance_cycles()
+static uint32_t gpo = 0u;
+static uint32_t gpe = 0u;
+static GpioDeviceFn gpio_dev = nullptr;
+static void *gpio_dev_ctx = nullptr;
+
+struct Fault {
+  bool armed;
+  uint8_t cmd;
+  uint32_t busy_reads;
+  uint32_t extra_us;
+};
+static Fault fault = {};
+static uint32_t fault_busy_reads = 0u;  // For the SPI0CMD write that ran the transaction
+
+Counters operator-(const Counters& a, const Counters& b) {
+  Counters d;
+  d.transactions = a.transactions - b.transactions;
+  d.bus_bits = a.bus_bits - b.bus_bits;
+  d.cache_windows = a.cache_windows - b.cache_windows;
+  d.cache_off_ns = a.cache_off_ns - b.cache_off_ns;
+  d.max_cache_off_ns = a.max_cache_off_ns;   // not a delta, see reset_peaks()
+  d.status_polls = a.status_polls - b.status_polls;
+  d.nv_writes = a.nv_writes - b.nv_writes;
+  d.v_writes = a.v_writes - b.v_writes;
+  d.ignored_writes = a.ignored_writes - b.ignored_writes;
+  d.gpio_accesses = a.gpio_accesses - b.gpio_accesses;
+  d.gpio_contention = a.gpio_contention - b.gpio_contention;
+  d.time_ns = a.time_ns - b.time_ns;
+  return d;
+}
+
+const Counters& counters() { return cnt; }
+const FlashState& flash_state() { return fs; }
+const FlashProfile& profile() { return *cur; }
+uint8_t pin_mode(const uint8_t pin) { return (pin < 17u) ? pins[pin] : 0u; }
+
+void reset_peaks() {
+  cnt.max_cache_off_ns = 0u;
+}
+
+void inject_fault(const uint8_t cmd, const uint32_t busy_reads, const uint32_t extra_us) {
+  fault = {true, cmd, busy_reads, extra_us};
+}
+
+void advance_ns(const uint64_t ns) {
+  cnt.time_ns += ns;
+  if (fs.wip && cnt.time_ns >= wip_done_ns) {
+    fs.wip = false;
+    fs.wel = false;
+  }
+}
+
+void advance_cycles(const uint32_t cycles) {
+  constexpr uint64_t kMhz = clockCyclesPerMicrosecond();
+  const uint64_t n = 1000u * (uint64_t)cycles + cycle_rem;
+  cycle_rem = n % kMhz;
+  advance_ns(n / kMhz);
+}
+
+static bool has(const uint32_t flag) {
+  return 0u != (cur->flags & flag);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Flash Status Register model
+static void write_status(const uint32_t idx0, const uint8_t *data, const size_t nbytes) {
+  const char *why = nullptr;
+  if (fs.wip) {
+    why = "busy";
+  } else if (! vol_enable && ! fs.wel) {
+    why = "no WEL";
+  } else if (0u == nbytes) {
+    why = "no data";
+  } else if (0u == idx0 && 2u <= nbytes && ! has(kWrite16SR1)) {
+    why = "16-bit";
+  } else if (1u == idx0 && ! (has(kHasSR2) && has(kWrite8SR2))) {
+    why = "no 31h";
+  } else if (2u == idx0 && ! has(kHasSR3)) {
+    why = "no 11h";
+  }
+  if (why) {
+    cnt.ignored_writes++;
+    trace_note = why;
+    return;
+  }
+
+  const bool is_volatile = vol_enable;
+  size_t n = (0u == idx0 && 2u <= nbytes) ? 2u : 1u;
+  if (0u == idx0 && 1u == n && has(kSR1Write8ClearsSR2)) {
+    if (is_volatile) fs.sr_v[1] = 0u; else fs.sr_nv[1] = fs.sr_v[1] = 0u;
+  }
+  for (size_t k = 0u; k < n; k++) {
+    const size_t reg = idx0 + k;
+    const uint8_t mask = cur->sr_write_mask[reg];
+    if (is_volatile) {
+      fs.sr_v[reg] = (fs.sr_v[reg] & ~mask) | (data[k] & mask);
+    } else {
+      fs.sr_nv[reg] = (fs.sr_nv[reg] & ~mask) | (data[k] & mask);
+      fs.sr_v[reg] = fs.sr_nv[reg];
+    }
+  }
+  if (is_volatile) {
+    cnt.v_writes++;
+    vol_enable = false;
+    if (has(kSR2VolClearsSR3) && (1u == idx0 || 2u == n)) fs.sr_v[2] = 0u;
+  } else {
+    cnt.nv_writes++;
+    fs.wip = true;
+    wip_done_ns = cnt.time_ns + 1000u * (uint64_t)cur->sr_write_us;
+  }
+}
+
+// Security Registers. Program and erase times are typical for a W25Q32.
+constexpr uint32_t kSecRegProgramUs = 700u;
+constexpr uint32_t kSecRegEraseUs = 45000u;
+
+static bool sec_reg_writable(const uint32_t reg) {
+  const char *why = nullptr;
+  if (! has(kHasSecReg) || 1u > reg || 3u < reg) {
+    why = "no Security Register";
+  } else if (fs.wip) {
+    why = "busy";
+  } else if (! fs.wel) {
+    why = "no WEL";
+  } else if (fs.sr_nv[1] & (0x08u << (reg - 1u))) {
+    why = "locked";
+  }
+  if (why) {
+    // Ignored, WEL stays as it was
+    cnt.ignored_writes++;
+    trace_note = why;
+    return false;
+  }
+  return true;
+}
+
+// Programs wrap within the 256 byte register, like a page
+static void program_sec_reg(const uint8_t *out, const size_t out_sz) {
+  if (3u > out_sz) return;
+  const uint32_t addr = (out[0] << 16u) | (out[1] << 8u) | out[2];
+  const uint32_t reg = (addr >> 12u) & 0x0Fu;
+  if (! sec_reg_writable(reg)) return;
+  for (size_t i = 3u; i < out_sz; i++) {
+    fs.sec_reg[reg - 1u][(addr + i - 3u) & 0xFFu] &= out[i];
+  }
+  fs.wip = true;
+  wip_done_ns = cnt.time_ns + 1000u * (uint64_t)kSecRegProgramUs;
+}
+
+static void erase_sec_reg(const uint8_t *out, const size_t out_sz) {
+  if (3u > out_sz) return;
+  const uint32_t reg = (out[1] >> 4u) & 0x0Fu;
+  if (! sec_reg_writable(reg)) return;
+  memset(fs.sec_reg[reg - 1u], 0xFF, sizeof(fs.sec_reg[0]));
+  fs.wip = true;
+  wip_done_ns = cnt.time_ns + 1000u * (uint64_t)kSecRegEraseUs;
+}
+
+void lock_security_register(const uint32_t reg) {
+  if (1u <= reg && 3u >= reg) {
+    fs.sr_nv[1] |= 0x08u << (reg - 1u);
+    fs.sr_v[1] |= 0x08u << (reg - 1u);
+  }
+}
+
+static void software_reset() {
+  reset_done_ns = cnt.time_ns + 1000u * (uint64_t)cur->reset_us;
+  fs.wel = false;
+  vol_enable = false;
+  if (has(kResetClearsQE)) fs.sr_nv[1] &= ~0x02u;
+  fs.sr_v[0] = fs.sr_nv[0];
+  fs.sr_v[1] = fs.sr_nv[1];
+  if (! has(kResetKeepsSR3)) fs.sr_v[2] = fs.sr_nv[2];
+}
+
+static uint8_t read_byte(const uint8_t cmd, const uint32_t addr, const size_t i) {
+  switch (cmd) {
+    case 0x05u:
+      return fs.sr_v[0] | ((fs.wel) ? 0x02u : 0u) | ((fs.wip) ? 0x01u : 0u);
+    case 0x35u:
+      return (has(kHasSR2)) ? fs.sr_v[1] : 0xFFu;
+    case 0x15u:
+      return (has(kHasSR3)) ? fs.sr_v[2] : 0xFFu;
+    case 0x9Fu:
+      return (i < 3u) ? (cur->jedec_id >> (8u * i)) & 0xFFu : 0xFFu;
+    case 0x5Au:
+      if (cur->sfdp && addr + i < cur->sfdp_sz) {
+        return (cur->sfdp[(addr + i) / 4u] >> (8u * ((addr + i) % 4u))) & 0xFFu;
+      }
+      return 0xFFu;
+    case 0x4Bu:
+      if (cur->unique_id && addr + i < 16u) return cur->unique_id[addr + i];
+      return 0xFFu;
+    case 0x48u:
+      if (has(kHasSecReg) && 1u <= (addr >> 12u) && 3u >= (addr >> 12u)) {
+        return fs.sec_reg[(addr >> 12u) - 1u][(addr + i) & 0xFFu];
+      }
+      return 0xFFu;
+    default:
+      return 0xFFu;
+  }
+}
+
+// One chip select: instruction, data out, data in. Like the flash, ignores
+// everything but Read Status Register-1 while WIP is set, and everything
+// during tRST. An ignored read sees the bus float high.
+static void transfer(const uint8_t cmd, const uint8_t *out, const uint32_t mosi_bits, uint8_t *in, const uint32_t miso_bits) {
+  const bool faulted = fault.armed && cmd == fault.cmd;
+  const size_t out_sz = mosi_bits / 8u;
+  const size_t in_sz = (miso_bits + 7u) / 8u;
+  uint32_t addr = 0u;
+  if (3u <= out_sz) addr = (out[0] << 16u) | (out[1] << 8u) | out[2];
+
+  if (config.trace) {
+    printf("    %02X", cmd);
+    for (size_t i = 0u; i < out_sz; i++) printf(" %02X", out[i]);
+  }
+  const bool busy = (fs.wip && 0x05u != cmd) || cnt.time_ns < reset_done_ns;
+  trace_note = (busy) ? "busy" : nullptr;
+  if (busy) {
+    for (size_t i = 0u; i < in_sz; i++) in[i] = 0xFFu;
+  } else {
+    if (0x99u != cmd) {
+      switch (cmd) {
+        case 0x06u:
+          fs.wel = true;
+          vol_enable = false;
+          break;
+        case 0x50u:
+          if (has(kVolatileSR)) vol_enable = true;
+          break;
+        case 0x04u:
+          fs.wel = false;
+          vol_enable = false;
+          break;
+        case 0x01u:
+          write_status(0u, out, out_sz);
+          break;
+        case 0x31u:
+          write_status(1u, out, out_sz);
+          break;
+        case 0x11u:
+          write_status(2u, out, out_sz);
+          break;
+        case 0x42u:
+          program_sec_reg(out, out_sz);
+          break;
+        case 0x44u:
+          erase_sec_reg(out, out_sz);
+          break;
+        default:
+          break;
+      }
+    } else if (reset_enable) {
+      software_reset();
+    }
+    reset_enable = (0x66u == cmd);
+    for (size_t i = 0u; i < in_sz; i++) in[i] = read_byte(cmd, addr, i);
+  }
+  if (config.trace) {
+    if (in_sz) printf(" ->");
+    for (size_t i = 0u; i < in_sz; i++) printf(" %02X", in[i]);
+    if (trace_note) printf("  (%s)", trace_note);
+    printf("\n");
+  }
+
+  if (faulted) {
+    fault.armed = false;
+    fault_busy_reads = fault.busy_reads;
+    if (fs.wip) wip_done_ns += 1000u * (uint64_t)fault.extra_us;
+    if (config.trace) printf("    (fault)\n");
+  }
+
+  const uint32_t bits = 8u + mosi_bits + miso_bits;
+  cnt.transactions++;
+  cnt.bus_bits += bits;
+  advance_ns(config.cs_ns + (1000000000ull * bits) / config.spi_hz);
+}
+
+static void transfer_cmd(const uint8_t cmd) {
+  transfer(cmd, nullptr, 0u, nullptr, 0u);
+}
+
+static uint8_t transfer_read8(const uint8_t cmd) {
+  uint8_t v = 0u;
+  transfer(cmd, nullptr, 0u, &v, 8u);
+  return v;
+}
+
+static void cache_disable() {
+  if (cache_off) return;
+  cache_off = true;
+  cache_off_start = cnt.time_ns;
+  cnt.cache_windows++;
+}
+
+static void cache_enable() {
+  if (! cache_off) return;
+  cache_off = false;
+  const uint64_t ns = cnt.time_ns - cache_off_start;
+  cnt.cache_off_ns += ns;
+  if (ns > cnt.max_cache_off_ns) cnt.max_cache_off_ns = ns;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Parts and boots
+void install(const FlashProfile& p) {
+  cur = &p;
+  fault = {};
+  memcpy(fs.sr_nv, p.sr_power_on, sizeof(fs.sr_nv));
+  memset(fs.sec_reg, 0xFF, sizeof(fs.sec_reg));
+  flashchip_data.deviceId = p.jedec_id;
+  flashchip_data.chip_size = 1u << ((p.jedec_id >> 16u) & 0x1Fu);
+  flashchip_data.block_size = 65536u;
+  flashchip_data.sector_size = 4096u;
+  flashchip_data.page_size = 256u;
+  flashchip_data.status_mask = 0xFFFFu;
+  power_on();
+}
+
+static void esp_reset() {
+  memset(&hostsim_spi0, 0, sizeof(hostsim_spi0));
+  memset(pins, 0, sizeof(pins));
+  cache_off = false;
+  gpo = 0u;
+  gpe = 0u;
+  for (uint32_t pin = 0u; pin < 16u; pin++) {
+    hostsim_gpio.ctrl[pin] = 0u;
+    hostsim_gpio.fn[pin] = (6u <= pin && 11u >= pin) ? GPFFS(GPFFS_BUS(pin)) : GPFFS(GPFFS_GPIO(pin));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// GPIO lines
+void gpio_attach(GpioDeviceFn fn, void *ctx) {
+  gpio_dev = fn;
+  gpio_dev_ctx = ctx;
+}
+
+// Drives low: output enabled and the latch at 0, or the device
+static uint32_t gpio_lines() {
+  const uint32_t esp_low = gpe & ~gpo;
+  const uint32_t dev_low = (gpio_dev) ? gpio_dev(esp_low, cnt.time_ns, gpio_dev_ctx) : 0u;
+  if (dev_low & gpe & gpo) cnt.gpio_contention++;
+  return 0xFFFFu & ~(esp_low | dev_low);
+}
+
+void power_on() {
+  memcpy(fs.sr_v, fs.sr_nv, sizeof(fs.sr_v));
+  fs.wel = false;
+  fs.wip = false;
+  vol_enable = false;
+  reset_enable = false;
+  // RTC memory comes up with noise
+  uint32_t x = 0x2545F491u + (uint32_t)cnt.time_ns;
+  for (size_t i = 0u; i < sizeof(rtc_mem) / sizeof(rtc_mem[0]); i++) {
+    x ^= x << 13u; x ^= x >> 17u; x ^= x << 5u;
+    rtc_mem[i] = x;
+  }
+  esp_reset();
+}
+
+void warm_reset() {
+  esp_reset();
+}
+
+void bootrom_dio() {
+  Disable_QMode(flashchip);
+  // Flash mode DIO. The BootROM used 16-bit Status Register writes.
+  SPI0C = SPICDIO | SPICFASTRD | SPICRESANDRES | SPICSHARE | SPICWPR | SPIC2BSE;
+}
+
+};  // namespace hostsim
+
+using namespace hostsim;
+
+uint32_t hostsim_gpio_read(const uint32_t id) {
+  cnt.gpio_accesses++;
+  advance_cycles(config.gpio_cycles);
+  switch (id) {
+    case kHostSimGPO: return gpo;
+    case kHostSimGPE: return gpe;
+    case kHostSimGPI: return gpio_lines();
+    default:          return 0u;    // Set and clear registers read as 0
+  }
+}
+
+void hostsim_gpio_write(const uint32_t id, const uint32_t x) {
+  cnt.gpio_accesses++;
+  advance_cycles(config.gpio_cycles);
+  switch (id) {
+    case kHostSimGPO:  gpo = x & 0xFFFFu; break;
+    case kHostSimGPOS: gpo |= x & 0xFFFFu; break;
+    case kHostSimGPOC: gpo &= ~x; break;
+    case kHostSimGPE:  gpe = x & 0xFFFFu; break;
+    case kHostSimGPES: gpe |= x & 0xFFFFu; break;
+    case kHostSimGPEC: gpe &= ~x; break;
+    default:           return;
+  }
+  gpio_lines();   // The device sees the change now
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// SPI0 user command, runs when SPI0CMD gets SPICMDUSR
+HostSimCmdReg& HostSimCmdReg::operator=(const uint32_t x) {
+  v = x;
+  if (0u == (x & SPICMDUSR)) return *this;
+
+  const uint32_t u = SPI0U;
+  const uint32_t u1 = SPI0U1;
+  const uint8_t cmd = SPI0U2 & 0xFFu;
+  const uint32_t mosi_bits = (u & SPIUMOSI) ? ((u1 >> SPILMOSI) & SPIMMOSI) + 1u : 0u;
+  const uint32_t miso_bits = (u & SPIUMISO) ? ((u1 >> SPILMISO) & SPIMMISO) + 1u : 0u;
+  uint8_t out[64] = {};
+  uint8_t in[64];
+  for (size_t i = 0u; i < (mosi_bits + 7u) / 8u && i < 64u; i++) {
+    out[i] = (hostsim_spi0.w[i / 4u].v >> (8u * (i % 4u))) & 0xFFu;
+  }
+  fault_busy_reads = 0u;
+  transfer(cmd, out, mosi_bits, in, miso_bits);
+  busy_reads = fault_busy_reads;
+  for (size_t i = 0u; i < (miso_bits + 7u) / 8u && i < 64u; i++) {
+    uint32_t& w = hostsim_spi0.w[i / 4u].v;
+    const uint32_t shift = 8u * (i % 4u);
+    w = (w & ~(0xFFu << shift)) | ((uint32_t)in[i] << shift);
+  }
+  v = 0u;   // done
+  return *this;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Core - SPI0Command, same register sequence as core_esp8266_spi_utils.cpp
+namespace experimental {
+SpiOpResult SPI0Command(uint8_t cmd, uint32_t *data, uint32_t mosi_bits, uint32_t miso_bits, uint32_t pre_cmd) {
+  if (mosi_bits > (64u * 8u) || miso_bits > (64u * 8u)) return SPI_RESULT_ERR;
+  if ((mosi_bits || miso_bits) && nullptr == data) return SPI_RESULT_ERR;
+
+  system_soft_wdt_feed();
+  Cache_Read_Disable_2();
+  Wait_SPI_Idle(flashchip);
+  const uint32_t oldSPI0C = SPI0C;
+  const uint32_t oldSPI0U = SPI0U;
+  const uint32_t oldSPI0U2 = SPI0U2;
+
+  uint32_t spic = oldSPI0C;
+  spic &= ~(SPICQIO | SPICDIO | SPICQOUT | SPICDOUT | SPICAHB | SPICFASTRD);
+  spic |= (SPICRESANDRES | SPICSHARE | SPICWPR | SPIC2BSE);
+  SPI0C = spic;
+  const uint32_t spiu2 = ((7u & SPIMCOMMAND) << SPILCOMMAND);
+
+  if (SPI_FLASH_CMD_NOT_USED != pre_cmd) {
+    SPI0U = SPIUCOMMAND;
+    SPI0U1 = 0u;
+    SPI0U2 = spiu2 | (pre_cmd & 0xFFu);
+    SPI0CMD = SPICMDUSR;
+  }
+
+  uint32_t spiu = SPIUCOMMAND;
+  uint32_t spiu1 = 0u;
+  if (mosi_bits) {
+    spiu |= SPIUMOSI;
+    spiu1 |= ((mosi_bits - 1u) & SPIMMOSI) << SPILMOSI;
+  }
+  if (miso_bits) {
+    spiu |= SPIUMISO;
+    spiu1 |= ((miso_bits - 1u) & SPIMMISO) << SPILMISO;
+  }
+  SPI0U = spiu;
+  SPI0U1 = spiu1;
+  SPI0U2 = spiu2 | cmd;
+  for (size_t i = 0u; i < (mosi_bits + 31u) / 32u; i++) hostsim_spi0.w[i] = data[i];
+  SPI0CMD = SPICMDUSR;
+
+  if (miso_bits) {
+    const size_t words = (miso_bits + 31u) / 32u;
+    for (size_t i = 0u; i < words; i++) data[i] = hostsim_spi0.w[i];
+    if (miso_bits % 32u) data[words - 1u] &= ~(0xFFFFFFFFu << (miso_bits % 32u));
+  }
+
+  SPI0U = oldSPI0U;
+  SPI0U2 = oldSPI0U2;
+  SPI0C = oldSPI0C;
+  uint32_t status;
+  SPI_read_status(flashchip, &status);
+  Cache_Read_Enable_2();
+  return SPI_RESULT_OK;
+}
+};  // namespace experimental
+
+////////////////////////////////////////////////////////////////////////////////
+// BootROM and NONOS SDK
+extern "C" {
+
+int SPI_read_status(SpiFlashChip *chip, uint32_t *status) {
+  uint8_t v;
+  do {
+    cnt.status_polls++;
+    v = transfer_read8(0x05u);
+  } while (v & 0x01u);
+  *status = v & chip->status_mask;
+  return 0;
+}
+
+uint32_t Wait_SPI_Idle(SpiFlashChip *fc) {
+  uint32_t status = 0u;
+  SPI_read_status(fc, &status);
+  return (0u != status) ? 1u : 0u;
+}
+
+static void SPI_write_enable(SpiFlashChip *chip) {
+  uint32_t status = 0u;
+  transfer_cmd(0x06u);
+  SPI_read_status(chip, &status);
+}
+
+int SPI_write_status(SpiFlashChip *chip, uint32_t status) {
+  Wait_SPI_Idle(chip);
+  const uint8_t out[2] = {(uint8_t)status, (uint8_t)(status >> 8u)};
+  transfer(0x01u, out, (SPI0C & SPIC2BSE) ? 16u : 8u, nullptr, 0u);
+  Wait_SPI_Idle(chip);
+  return 0;
+}
+
+int Enable_QMode(SpiFlashChip *chip) {
+  Wait_SPI_Idle(chip);
+  SPI0C |= SPIC2BSE;
+  SPI_write_enable(chip);
+  SPI_write_status(chip, BIT9);
+  return 0;
+}
+
+int Disable_QMode(SpiFlashChip *chip) {
+  uint32_t status = 0u;
+  Wait_SPI_Idle(chip);
+  SPI_read_status(chip, &status);
+  SPI0C |= SPIC2BSE;
+  SPI_write_enable(chip);
+  SPI_write_status(chip, status & 0xFCu);
+  return 0;
+}
+
+void Cache_Read_Disable() { cache_disable(); }
+void Cache_Read_Disable_2() { cache_disable(); }
+void Cache_Read_Enable_2() { cache_enable(); }
+void Cache_Read_Enable_New() { cache_enable(); }
+
+uint32_t spi_flash_get_id(void) {
+  Cache_Read_Disable_2();
+  Wait_SPI_Idle(flashchip);
+  uint8_t id[3];
+  transfer(0x9Fu, nullptr, 0u, id, 24u);
+  Cache_Read_Enable_2();
+  return id[0] | (id[1] << 8u) | (id[2] << 16u);
+}
+
+SpiFlashOpResult spi_flash_read_status(uint32_t *status) {
+  Cache_Read_Disable_2();
+  Wait_SPI_Idle(flashchip);
+  SPI_read_status(flashchip, status);
+  Cache_Read_Enable_2();
+  return SPI_FLASH_RESULT_OK;
+}
+
+SpiFlashOpResult spi_flash_write_status(uint32_t status16) {
+  Cache_Read_Disable_2();
+  Wait_SPI_Idle(flashchip);
+  const uint32_t oldSPI0C = SPI0C;
+  SPI0C |= SPIC2BSE;
+  SPI_write_enable(flashchip);
+  SPI_write_status(flashchip, status16);
+  SPI0C = oldSPI0C;
+  Cache_Read_Enable_2();
+  return SPI_FLASH_RESULT_OK;
+}
+
+uint32_t flash_gd25q32c_read_status(uint32_t reg_0idx) {
+  static const uint8_t cmds[] = {0x05u, 0x35u, 0x15u};
+  Cache_Read_Disable_2();
+  Wait_SPI_Idle(flashchip);
+  SPI_write_enable(flashchip);    // BUGBUG in the SDK, kept
+  const uint8_t v = transfer_read8(cmds[reg_0idx % 3u]);
+  Cache_Read_Enable_2();
+  return v;
+}
+
+void flash_gd25q32c_write_status(uint32_t reg_0idx, uint32_t status) {
+  static const uint8_t cmds[] = {0x01u, 0x31u, 0x11u};
+  Cache_Read_Disable_2();
+  Wait_SPI_Idle(flashchip);
+  SPI_write_enable(flashchip);
+  const uint8_t out = status;
+  transfer(cmds[reg_0idx % 3u], &out, 8u, nullptr, 0u);
+  Wait_SPI_Idle(flashchip);
+  Cache_Read_Enable_2();
+}
+
+void system_soft_wdt_feed(void) {}
+
+// Block addresses are 4-byte units, user blocks are 64 - 191
+bool system_rtc_mem_read(uint8_t src_addr, void *des_addr, uint16_t load_size) {
+  if (src_addr > 191u || nullptr == des_addr || src_addr * 4u + load_size > sizeof(rtc_mem)) return false;
+  memcpy(des_addr, &rtc_mem[src_addr], load_size);
+  return true;
+}
+
+bool system_rtc_mem_write(uint8_t des_addr, const void *src_addr, uint16_t save_size) {
+  if (des_addr < 64u || des_addr > 191u || nullptr == src_addr || des_addr * 4u + save_size > sizeof(rtc_mem)) return false;
+  memcpy(&rtc_mem[des_addr], src_addr, save_size);
+  return true;
+}
+
+int umm_info_safe_printf_P(const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vprintf(fmt, ap);
+  va_end(ap);
+  return n;
+}
+
+int ets_uart_printf(const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vprintf(fmt, ap);
+  va_end(ap);
+  return n;
+}
+
+void uart_buff_switch(uint8_t) {}
+uint32_t xt_rsil(uint32_t) { return 0u; }
+void xt_wsr_ps(uint32_t) {}
+
+void ets_delay_us(uint32_t us) { advance_ns(1000ull * us); }
+void delay(unsigned long ms) { advance_ns(1000000ull * ms); }
+unsigned long millis(void) { return cnt.time_ns / 1000000u; }
+unsigned long micros(void) { return cnt.time_ns / 1000u; }
+uint8_t system_get_cpu_freq(void) { return clockCyclesPerMicrosecond(); }
+
+uint32_t esp_get_cycle_count(void) {
+  advance_cycles(config.ccount_cycles);
+  return (uint32_t)(cnt.time_ns * clockCyclesPerMicrosecond() / 1000u);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin < 17u) pins[pin] = mode;
+  if (pin >= 16u) return;
+  const uint32_t bit = 1u << pin;
+  if (SPECIAL == mode) {
+    hostsim_gpio.fn[pin] = GPFFS(GPFFS_BUS(pin));
+    gpe &= ~bit;
+  } else {
+    hostsim_gpio.fn[pin] = GPFFS(GPFFS_GPIO(pin)) | ((INPUT_PULLUP == mode) ? (1u << GPFPU) : 0u);
+    gpe = (OUTPUT == mode) ? (gpe | bit) : (gpe & ~bit);
+  }
+  gpio_lines();
+}
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if (pin >= 16u) return;
+  gpo = (val) ? (gpo | (1u << pin)) : (gpo & ~(1u << pin));
+  gpio_lines();
+}
+int digitalRead(uint8_t pin) {
+  return (pin < 16u) ? (gpio_lines() >> pin) & 1u : 0;
+}
+
+};  // extern "C"
+
+// core_esp8266_features.h crc32, same polynomial and bit order
+uint32_t crc32(const void *data, size_t length, uint32_t crc) {
+  const uint8_t *ldata = (const uint8_t *)data;
+  while (length--) {
+    uint8_t c = *ldata++;
+    for (uint32_t i = 0x80u; i > 0u; i >>= 1u) {
+      bool bit = crc & 0x80000000u;
+      if (c & i) bit = ! bit;
+      crc <<= 1u;
+      if (bit) crc ^= 0x04c11db7u;
+    }
+  }
+  return crc;
+}
+
+int HardwareSerial::printf(const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vprintf(fmt, ap);
+  va_end(ap);
+  return n;
+}
+
+int HardwareSerial::printf_P(const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vprintf(fmt, ap);
+  va_end(ap);
+  return n;
+}
@@ -0,0 +1,156 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Host SPI0 controller and flash chip simulator
+
+  Runs the library on Linux against a simulated SPI0 register block and a
+  simulated flash Status Register model. See reclaim_sim.cpp for the build.
+
+  Time is simulated. Each bus transaction advances the clock by its bit count
+  at spi_hz plus a chip select overhead. ets_delay_us() advances it directly.
+  esp_get_cycle_count() is derived from it at F_CPU, so the library's own
+  cycle measurements show bus and WIP wait time, not host CPU time.
+
+  The flash model keeps a non-volatile and a volatile copy of each Status
+  Register. Reads return the volatile copy. A write after 06h goes to both
+  and sets WIP for sr_write_us. A write after 50h goes to the volatile copy
+  only. Without either, or with a width the part does not accept, the write
+  is ignored and a WEL bit, if set, stays set. That last part is what the
+  BootROM leaves behind on 8-bit only parts.
+*/
+#ifndef HOSTSIM_H
+#define HOSTSIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace hostsim {
+
+// Part behaviour flags
+enum : uint32_t {
+  kHasSR2         = 1u << 0,    // 35h, 31h
+  kHasSR3         = 1u << 1,    // 15h, 11h
+  kWrite16SR1     = 1u << 2,    // Accepts 16-bit 01h, SR1 then SR2
+  kWrite8SR2      = 1u << 3,    // Accepts 8-bit 31h
+  kVolatileSR     = 1u << 4,    // Supports 50h
+  kSR2VolClearsSR3 = 1u << 5,   // XMC, volatile write to SR2 clears SR3
+  kResetClearsQE  = 1u << 6,    // Mystery 0xD8, 66h 99h clears non-volatile QE
+  kResetKeepsSR3  = 1u << 7,    // XMC, 66h 99h does not reload SR3
+  kSR1Write8ClearsSR2 = 1u << 8,  // Legacy Winbond, 8-bit 01h clears SR2
+  kHasSecReg      = 1u << 9,    // Security Registers 1 - 3, 42h 44h 48h, LB1 - LB3 at SR2 bits 3 - 5
+};
+
+struct FlashProfile {
+  const char *name;
+  const char *part;
+  uint32_t jedec_id;            // As spi_flash_get_id() returns it, 0xCCTTVV
+  uint32_t flags;
+  uint8_t  sr_power_on[3];      // Non-volatile SR1 - SR3 on a new part
+  uint8_t  sr_write_mask[3];    // Writable bits, excludes WIP, WEL and OTP bits
+  uint32_t sr_write_us;         // Non-volatile Status Register write, tW
+  uint32_t reset_us;            // 66h 99h, tRST
+  const uint32_t *sfdp;         // SFDP image, nullptr when not supported
+  size_t   sfdp_sz;             // bytes
+  const uint8_t *unique_id;     // 16 bytes, nullptr when not supported
+  bool     expect_reclaim;      // Expected reclaim_GPIO_9_10() result with the built-in table
+};
+
+// Vendor profiles, see profiles.cpp
+extern const FlashProfile kProfiles[];
+extern const size_t kNumProfiles;
+const FlashProfile *find_profile(const char *name);
+
+struct Counters {
+  uint64_t transactions;        // Chip select assertions, a prefix instruction is one
+  uint64_t bus_bits;            // Instruction, data out, and data in bits
+  uint64_t cache_windows;       // iCache disable/enable pairs
+  uint64_t cache_off_ns;        // Time with the iCache off
+  uint64_t max_cache_off_ns;    // Longest single window
+  uint64_t status_polls;        // BootROM status reads, incl. WIP spins
+  uint64_t nv_writes;           // Accepted non-volatile Status Register writes
+  uint64_t v_writes;            // Accepted volatile Status Register writes
+  uint64_t ignored_writes;      // Status Register writes the part ignored
+  uint64_t gpio_accesses;       // GPO, GPE, and GPI register reads and writes
+  uint64_t gpio_contention;     // A device pulled low a line the ESP8266 drove high
+  uint64_t time_ns;
+};
+
+Counters operator-(const Counters& a, const Counters& b);
+
+struct Config {
+  uint32_t spi_hz = 40000000u;  // SPI0 bus clock
+  uint32_t cs_ns = 100u;        // Per transaction overhead, chip select and setup
+  bool trace = false;           // Print each flash instruction
+  // CPU cycles each call takes, so busy-wait loops see time pass. Zero
+  // leaves the time to the flash model alone.
+  uint32_t ccount_cycles = 0u;  // esp_get_cycle_count()
+  uint32_t gpio_cycles = 0u;    // GPO, GPE, and GPI register access
+};
+
+extern Config config;
+
+// Part state, for checks after a run
+struct FlashState {
+  uint8_t sr_nv[3];
+  uint8_t sr_v[3];
+  bool wel;
+  bool wip;
+  uint8_t sec_reg[3][256];      // Security Registers 1 - 3
+};
+
+const Counters& counters();
+const FlashState& flash_state();
+const FlashProfile& profile();
+uint8_t pin_mode(uint8_t pin);
+
+// Insert a new part, all Status Registers at their power-on values
+void install(const FlashProfile& p);
+// Power cycle: volatile copies reload, RTC memory is lost
+void power_on();
+// ESP8266 reset or deep-sleep wake, the flash keeps power
+void warm_reset();
+// BootROM's DIO flash mode setup, Disable_QMode() and the SPI0 mode bits
+void bootrom_dio();
+// Set lock bit LB1 - LB3 for Security Register reg {1, 2, 3}, for good
+void lock_security_register(const uint32_t reg);
+void advance_ns(const uint64_t ns);
+void advance_cycles(const uint32_t cycles);
+
+// A device on open-drain GPIO lines, with pull-ups. Called on each GPIO
+// register access with the lines the ESP8266 drives low and the time.
+// Returns the lines the device drives low. GPI reads the lines neither side
+// drives low.
+typedef uint32_t (*GpioDeviceFn)(const uint32_t esp_low, const uint64_t ns, void *ctx);
+void gpio_attach(GpioDeviceFn fn, void *ctx);
+// Restart max_cache_off_ns
+void reset_peaks();
+// Fault injection for the next transaction sending cmd. It still reaches the
+// part, then SPI0CMD reads busy for busy_reads more reads, and a write it
+// starts holds WIP for extra_us longer. Cleared by install().
+void inject_fault(const uint8_t cmd, const uint32_t busy_reads, const uint32_t extra_us);
+
+// Counter deltas for one call
+class Measure {
+public:
+  Measure() : start_((reset_peaks(), counters())) {}
+  Counters delta() const { return counters() - start_; }
+private:
+  Counters start_;
+};
+
+};  // namespace hostsim
+
+#endif // HOSTSIM_H
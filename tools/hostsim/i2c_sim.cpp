@@ -0,0 +1,439 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  i2c_sim - I2cBus_9_10 against a simulated I2C device and timing checker
+
+  Build from the library root:
+
+    g++ -std=gnu++17 -O1 -Wall -Itools/hostsim/include -Itools/hostsim -Isrc \
+      tools/hostsim/hostsim.cpp tools/hostsim/profiles.cpp \
+      tools/hostsim/i2c_sim.cpp src/I2cBus_9_10.cpp src/SpiFlashUtils.cpp \
+      src/SpiFlashUtilsQE.cpp src/SfdpRevInfo.cpp src/SfdpBasic.cpp \
+      src/ModeDIO_ReclaimGPIOs.cpp src/SpiFlashCost.cpp \
+      src/StatusRegisterUpdate.cpp -o i2c_sim
+
+  Usage:
+
+    i2c_sim [-c cycles] [-g cycles]
+
+      -c  CPU cycles for each esp_get_cycle_count(), default 1
+      -g  CPU cycles for each GPIO register access, default 4
+
+  A 24C02 style device, 256 byte registers at address 0x50, sits on GPIO10
+  SDA and GPIO9 SCL. It watches every edge, and checks each SCL low and high
+  time, data setup, START and STOP setup and hold, and bus free time against
+  the I2C specification minimums for the mode. With a stretch time, it holds
+  SCL low after each ACK.
+
+  For each mode, with and without clock stretching, a register write, a read
+  back, a batched transaction, and a probe of an absent address are run. Then
+  a stretch past the limit, and a bus stuck with SDA low. Prints the SCL rate
+  reached, the shortest of each timing, and the payload rate. Exits non-zero
+  on a failure.
+
+  The time between register accesses is only what -c and -g give, the code
+  in between is free. A rate here is an upper bound for the ESP8266.
+*/
+#include <Arduino.h>
+#include <stdlib.h>
+#include "ModeDIO_ReclaimGPIOs.h"
+#include "I2cBus_9_10.h"
+#include "hostsim.h"
+
+using namespace experimental;
+using namespace hostsim;
+
+constexpr uint32_t kSda = 1u << 10u;
+constexpr uint32_t kScl = 1u << 9u;
+constexpr uint8_t kDevAddr = 0x50u;
+
+// I2C specification minimums, ns
+struct I2cSpec {
+  const char *name;
+  uint32_t hz;
+  uint32_t low;         // tLOW
+  uint32_t high;        // tHIGH
+  uint32_t su_sta;      // tSU;STA
+  uint32_t hd_sta;      // tHD;STA
+  uint32_t su_sto;      // tSU;STO
+  uint32_t buf;         // tBUF
+  uint32_t su_dat;      // tSU;DAT
+};
+
+static const I2cSpec kSpecs[] = {
+  {"Sm",  kI2cStandardHz, 4700u, 4000u, 4700u, 4000u, 4000u, 4700u, 250u},
+  {"Fm",  kI2cFastHz,     1300u,  600u,  600u,  600u,  600u, 1300u, 100u},
+  {"Fm+", kI2cFastPlusHz,  500u,  260u,  260u,  260u,  260u,  500u,  50u},
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Simulated device
+struct Device {
+  uint8_t  mem[256];
+  uint8_t  ptr;
+  uint64_t stretch_ns;          // Hold SCL low after each ACK
+  uint32_t stuck_clocks;        // Hold SDA low for this many SCL clocks
+
+  // Protocol
+  enum : uint8_t { kIdle, kAddr, kWrite, kRead, kDone } st;
+  bool     prev_scl, prev_sda;
+  bool     sda_low;             // The device drives SDA low
+  bool     in_ack;              // 9th clock
+  bool     first;               // Next written byte is the register address
+  bool     master_ack;
+  uint32_t bits;
+  uint32_t shift;
+  uint64_t stretch_until;
+
+  // Timing, ns
+  uint64_t t_scl_rise, t_scl_fall, t_sda, t_start, t_stop;
+  bool     repeated;            // The START was a repeated START
+  bool     hd_sta_pending;
+  uint64_t min_low, min_high, min_su_sta, min_hd_sta, min_su_sto, min_buf, min_su_dat;
+  uint32_t starts, stops, bytes, glitches;
+};
+
+static Device dev;
+
+static void device_reset_timing() {
+  dev.min_low = dev.min_high = dev.min_su_sta = dev.min_hd_sta = ~0ull;
+  dev.min_su_sto = dev.min_buf = dev.min_su_dat = ~0ull;
+  dev.starts = dev.stops = dev.bytes = dev.glitches = 0u;
+}
+
+static void device_init(const uint64_t stretch_ns) {
+  memset(&dev, 0, sizeof(dev));
+  for (size_t i = 0u; i < sizeof(dev.mem); i++) dev.mem[i] = (uint8_t)(i * 7u + 1u);
+  dev.stretch_ns = stretch_ns;
+  dev.st = Device::kIdle;
+  dev.prev_scl = dev.prev_sda = true;
+  dev.t_stop = 0u;
+  device_reset_timing();
+}
+
+static void min_of(uint64_t& m, const uint64_t v) {
+  if (v < m) m = v;
+}
+
+// Put the next bit of the byte being read on SDA
+static void drive_read_bit() {
+  dev.sda_low = 0u == (dev.shift & (0x80u >> dev.bits));
+}
+
+static void scl_rose(const bool sda, const uint64_t ns) {
+  min_of(dev.min_low, ns - dev.t_scl_fall);
+  min_of(dev.min_su_dat, ns - dev.t_sda);
+  dev.t_scl_rise = ns;
+  if (dev.stuck_clocks) {
+    dev.stuck_clocks--;
+    if (0u == dev.stuck_clocks) dev.sda_low = false;
+    return;
+  }
+  if (Device::kIdle == dev.st || Device::kDone == dev.st) return;
+  if (dev.in_ack) {
+    if (Device::kRead == dev.st) dev.master_ack = ! sda;
+    return;
+  }
+  if (Device::kRead != dev.st) dev.shift = (dev.shift << 1u) | ((sda) ? 1u : 0u);
+  dev.bits++;
+}
+
+static void load_read_byte() {
+  dev.shift = dev.mem[dev.ptr++];
+  dev.bits = 0u;
+  drive_read_bit();
+}
+
+static void scl_fell(const uint64_t ns) {
+  min_of(dev.min_high, ns - dev.t_scl_rise);
+  dev.t_scl_fall = ns;
+  if (dev.hd_sta_pending) {
+    min_of(dev.min_hd_sta, ns - dev.t_start);
+    dev.hd_sta_pending = false;
+  }
+  if (dev.stuck_clocks || Device::kIdle == dev.st || Device::kDone == dev.st) return;
+
+  if (dev.in_ack) {
+    // End of the 9th clock
+    dev.in_ack = false;
+    dev.sda_low = false;
+    if (dev.stretch_ns) dev.stretch_until = ns + dev.stretch_ns;
+    if (Device::kRead == dev.st) {
+      if (dev.master_ack || 0u == dev.bytes) {
+        load_read_byte();
+      } else {
+        dev.st = Device::kDone;
+      }
+    } else {
+      dev.bits = 0u;
+      dev.shift = 0u;
+    }
+    return;
+  }
+  if (8u > dev.bits) {
+    if (Device::kRead == dev.st) drive_read_bit();
+    return;
+  }
+
+  // 8 bits done
+  dev.in_ack = true;
+  if (Device::kRead == dev.st) {
+    dev.sda_low = false;    // The master ACKs
+    dev.bytes++;
+    return;
+  }
+  if (Device::kAddr == dev.st) {
+    if (kDevAddr != (dev.shift >> 1u)) {
+      dev.st = Device::kIdle;
+      dev.in_ack = false;
+      return;
+    }
+    dev.sda_low = true;
+    if (dev.shift & 1u) {
+      dev.st = Device::kRead;
+      dev.bytes = 0u;     // Address ACK, the data follows
+      dev.master_ack = false;
+    } else {
+      dev.st = Device::kWrite;
+      dev.first = true;
+    }
+    return;
+  }
+  // kWrite
+  if (dev.first) {
+    dev.ptr = dev.shift;
+    dev.first = false;
+  } else {
+    dev.mem[dev.ptr++] = dev.shift;
+  }
+  dev.bytes++;
+  dev.sda_low = true;
+}
+
+static uint32_t device_fn(const uint32_t esp_low, const uint64_t ns, void *) {
+  uint32_t dev_low = ((dev.sda_low) ? kSda : 0u) | ((ns < dev.stretch_until) ? kScl : 0u);
+  const uint32_t lines = ~(esp_low | dev_low);
+  const bool scl = lines & kScl;
+  const bool sda = lines & kSda;
+
+  if (sda != dev.prev_sda) {
+    if (scl && dev.prev_scl) {
+      if (! sda) {
+        // START
+        // A repeated START follows the first SCL rise of a byte
+        if (Device::kIdle != dev.st && Device::kDone != dev.st && (1u < dev.bits || dev.in_ack)) dev.glitches++;
+        dev.repeated = dev.t_stop < dev.t_scl_rise && 0u != dev.starts && dev.st != Device::kIdle;
+        if (dev.repeated) {
+          min_of(dev.min_su_sta, ns - dev.t_scl_rise);
+        } else if (dev.starts) {
+          min_of(dev.min_buf, ns - dev.t_stop);
+        }
+        dev.starts++;
+        dev.t_start = ns;
+        dev.hd_sta_pending = true;
+        dev.st = Device::kAddr;
+        dev.bits = 0u;
+        dev.shift = 0u;
+        dev.in_ack = false;
+        dev.sda_low = false;
+      } else {
+        // STOP
+        if (Device::kIdle != dev.st && Device::kDone != dev.st && (1u < dev.bits || dev.in_ack)) dev.glitches++;
+        min_of(dev.min_su_sto, ns - dev.t_scl_rise);
+        dev.stops++;
+        dev.t_stop = ns;
+        dev.st = Device::kIdle;
+        dev.sda_low = false;
+      }
+    } else {
+      dev.t_sda = ns;
+    }
+  }
+  if (scl != dev.prev_scl) {
+    if (scl) {
+      scl_rose(sda, ns);
+    } else {
+      scl_fell(ns);
+    }
+  }
+
+  dev_low = ((dev.sda_low) ? kSda : 0u) | ((ns < dev.stretch_until) ? kScl : 0u);
+  const uint32_t after = ~(esp_low | dev_low);
+  if (((after & kSda) != 0u) != dev.prev_sda && ! (after & kScl)) dev.t_sda = ns;
+  dev.prev_scl = after & kScl;
+  dev.prev_sda = after & kSda;
+  return dev_low;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static const char *result_name(const I2cResult r) {
+  switch (r) {
+    case kI2cOk:        return "ok";
+    case kI2cNackAddr:  return "nack addr";
+    case kI2cNackData:  return "nack data";
+    case kI2cTimeout:   return "timeout";
+    case kI2cBusError:  return "bus error";
+    case kI2cNotReady:  return "not ready";
+    default:            return "?";
+  }
+}
+
+static size_t fails = 0u;
+
+static void check(const bool pass, const char *what, const char *mode) {
+  if (pass) return;
+  fails++;
+  printf("  ** %s: %s\n", mode, what);
+}
+
+static void check_result(const I2cResult r, const I2cResult expect, const char *what, const char *mode) {
+  if (r == expect) return;
+  fails++;
+  printf("  ** %s: %s returned %s, expected %s\n", mode, what, result_name(r), result_name(expect));
+}
+
+static double us(const uint64_t ns) {
+  return (~0ull == ns) ? 0.0 : ns / 1000.0;
+}
+
+static void run_mode(const I2cSpec& spec, const uint64_t stretch_ns) {
+  device_init(stretch_ns);
+  I2cBus bus;
+  if (! i2c_bus_begin(&bus, 10u, spec.hz)) {
+    check(false, "i2c_bus_begin() failed", spec.name);
+    return;
+  }
+
+  uint8_t out[16];
+  uint8_t in[16];
+  for (size_t i = 0u; i < sizeof(out); i++) out[i] = (uint8_t)(0xA5u ^ (i * 13u));
+
+  // Write and read back, timed for the payload rate
+  const uint64_t t0 = counters().time_ns;
+  I2cResult r = i2c_bus_write_reg(&bus, kDevAddr, 0x10u, out, sizeof(out));
+  check_result(r, kI2cOk, "write_reg", spec.name);
+  r = i2c_bus_read_reg(&bus, kDevAddr, 0x10u, in, sizeof(in));
+  check_result(r, kI2cOk, "read_reg", spec.name);
+  const uint64_t t_rw = counters().time_ns - t0;
+  check(0 == memcmp(out, dev.mem + 0x10u, sizeof(out)), "device memory differs", spec.name);
+  check(0 == memcmp(out, in, sizeof(in)), "read back differs", spec.name);
+
+  // Batched: two writes and two reads, one STOP
+  uint8_t a[2] = {0x11u, 0x22u};
+  uint8_t b[1] = {0x33u};
+  uint8_t ra[2] = {};
+  uint8_t rb[3] = {};
+  I2cXfer batch[] = {
+    {kDevAddr, 0x40u, kI2cXferWrite, sizeof(a), a},
+    {kDevAddr, 0x80u, kI2cXferWrite, sizeof(b), b},
+    {kDevAddr, 0x40u, kI2cXferRead, sizeof(ra), ra},
+    {kDevAddr, 0x7Fu, kI2cXferRead, sizeof(rb), rb},
+  };
+  const uint32_t stops = dev.stops;
+  size_t done = 0u;
+  r = i2c_bus_xfer(&bus, batch, 4u, &done);
+  check_result(r, kI2cOk, "xfer", spec.name);
+  check(4u == done, "xfer steps done", spec.name);
+  check(1u == dev.stops - stops, "xfer sent more than one STOP", spec.name);
+  check(0x11u == ra[0] && 0x22u == ra[1], "xfer read 0x40", spec.name);
+  check(dev.mem[0x7Fu] == rb[0] && 0x33u == rb[1] && dev.mem[0x81u] == rb[2], "xfer read 0x7F", spec.name);
+
+  r = i2c_bus_probe(&bus, kDevAddr + 1u);
+  check_result(r, kI2cNackAddr, "probe absent", spec.name);
+  r = i2c_bus_probe(&bus, kDevAddr);
+  check_result(r, kI2cOk, "probe", spec.name);
+
+  check(0u == dev.glitches, "START or STOP inside a byte", spec.name);
+  check(0u == counters().gpio_contention, "line contention", spec.name);
+  check(dev.min_low >= spec.low, "tLOW", spec.name);
+  check(dev.min_high >= spec.high, "tHIGH", spec.name);
+  check(dev.min_su_sta >= spec.su_sta, "tSU;STA", spec.name);
+  check(dev.min_hd_sta >= spec.hd_sta, "tHD;STA", spec.name);
+  check(dev.min_su_sto >= spec.su_sto, "tSU;STO", spec.name);
+  check(dev.min_buf >= spec.buf, "tBUF", spec.name);
+  check(dev.min_su_dat >= spec.su_dat, "tSU;DAT", spec.name);
+
+  // write_reg: addr, reg, 16 data. read_reg: addr, reg, addr, 16 data.
+  const double bits = 9.0 * (2u + sizeof(out) + 3u + sizeof(in));
+  printf("  %-4s %7.1f %6.0f %6.2f %6.2f %6.2f %6.2f %6.2f %6.2f %6.3f %8.0f %5u %4u\n",
+    spec.name, stretch_ns / 1000.0, bits * 1e6 / t_rw,
+    us(dev.min_low), us(dev.min_high), us(dev.min_su_sta), us(dev.min_hd_sta),
+    us(dev.min_su_sto), us(dev.min_buf), us(dev.min_su_dat),
+    (sizeof(out) + sizeof(in)) * 1e9 / t_rw, bus.stats.stretches, bus.stats.late);
+  i2c_bus_end(&bus);
+}
+
+static void run_faults() {
+  I2cBus bus;
+
+  // A stretch past the limit
+  device_init(1000000u);
+  i2c_bus_begin(&bus, 10u, kI2cFastHz);
+  i2c_bus_set_stretch_limit(&bus, 100u);
+  uint8_t v = 0x5Au;
+  I2cResult r = i2c_bus_write_reg(&bus, kDevAddr, 0u, &v, 1u);
+  check_result(r, kI2cTimeout, "stretch limit", "fault");
+  advance_ns(2000000u);
+  check(i2c_bus_recover(&bus), "recover after timeout", "fault");
+  i2c_bus_end(&bus);
+
+  // A device holding SDA low, eg. after a reset in the middle of a read
+  device_init(0u);
+  i2c_bus_begin(&bus, 10u, kI2cFastHz);
+  dev.sda_low = true;
+  dev.prev_sda = false;
+  dev.stuck_clocks = 5u;
+  r = i2c_bus_probe(&bus, kDevAddr);
+  check_result(r, kI2cBusError, "probe with SDA stuck", "fault");
+  check(i2c_bus_recover(&bus), "recover with SDA stuck", "fault");
+  r = i2c_bus_probe(&bus, kDevAddr);
+  check_result(r, kI2cOk, "probe after recover", "fault");
+  i2c_bus_end(&bus);
+  printf("  faults: stretch timeout, recover, stuck SDA, recover\n");
+}
+
+int main(int argc, char **argv) {
+  config.ccount_cycles = 1u;
+  config.gpio_cycles = 4u;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (0 == strcmp("-c", argv[i])) config.ccount_cycles = atoi(argv[i + 1]);
+    else if (0 == strcmp("-g", argv[i])) config.gpio_cycles = atoi(argv[i + 1]);
+  }
+
+  install(*find_profile("winbond"));
+  bootrom_dio();
+  if (! reclaim_GPIO_9_10()) {
+    printf("reclaim_GPIO_9_10() failed\n");
+    return 2;
+  }
+  gpio_attach(device_fn, nullptr);
+
+  I2cBus bus;
+  check(! i2c_bus_begin(&bus, 8u, kI2cStandardHz), "begin accepted GPIO8", "setup");
+
+  printf("CPU %u MHz, esp_get_cycle_count() %u cycles, GPIO access %u cycles\n\n",
+    (uint32_t)clockCyclesPerMicrosecond(), config.ccount_cycles, config.gpio_cycles);
+  printf("  %-4s %7s %6s %6s %6s %6s %6s %6s %6s %6s %8s %5s %4s\n",
+    "mode", "str us", "kHz", "tLOW", "tHIGH", "SU;STA", "HD;STA", "SU;STO", "tBUF", "SU;DAT", "B/s", "str", "late");
+  for (const I2cSpec& spec : kSpecs) {
+    run_mode(spec, 0u);
+    run_mode(spec, 20000u);
+  }
+  run_faults();
+
+  printf("%zu failures\n", fails);
+  return (fails) ? 1 : 0;
+}
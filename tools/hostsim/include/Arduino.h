@@ -0,0 +1,86 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+// Host build - the parts of the core's Arduino.h used by the library
+#ifndef HOSTSIM_ARDUINO_H
+#define HOSTSIM_ARDUINO_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <esp8266_peri.h>
+#include <spi_flash.h>
+#include <spi_vendors.h>
+
+// The library is for DIO and DOUT builds
+#if !defined(FLASHMODE_DIO) && !defined(FLASHMODE_DOUT)
+#define FLASHMODE_DIO 1
+#endif
+
+#ifndef F_CPU
+#define F_CPU 80000000L
+#endif
+
+#define IRAM_ATTR
+#define ICACHE_RAM_ATTR
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define memcpy_P memcpy
+#define strlen_P strlen
+#define snprintf_P snprintf
+#define WDT_FEED() do {} while (false)
+
+#define INPUT       0x00
+#define INPUT_PULLUP 0x02
+#define OUTPUT      0x01
+#define SPECIAL     0xF8
+#define LOW         0x0
+#define HIGH        0x1
+
+#define clockCyclesPerMicrosecond() (F_CPU / 1000000L)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+void delay(unsigned long ms);
+unsigned long millis(void);
+unsigned long micros(void);
+
+void ets_delay_us(uint32_t us);
+int ets_uart_printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+void uart_buff_switch(uint8_t uart_no);
+uint32_t xt_rsil(uint32_t level);
+void xt_wsr_ps(uint32_t ps);
+uint32_t esp_get_cycle_count(void);
+#ifdef __cplusplus
+}
+
+struct HardwareSerial {
+  int printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+  int printf_P(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+};
+extern HardwareSerial Serial;
+#endif
+
+#endif // HOSTSIM_ARDUINO_H
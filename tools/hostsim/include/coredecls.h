@@ -0,0 +1,25 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+// Host build - core coredecls.h, the parts the library uses
+#ifndef HOSTSIM_COREDECLS_H
+#define HOSTSIM_COREDECLS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+uint32_t crc32(const void *data, size_t length, uint32_t crc = 0xffffffff);
+
+#endif // HOSTSIM_COREDECLS_H
@@ -0,0 +1,206 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Host build - simulated SPI0 register block
+
+  Stands in for the SPI0 part of the core's esp8266_peri.h. The registers are
+  plain words in hostsim_spi0, except SPI0CMD. Writing SPICMDUSR to SPI0CMD runs
+  the user transaction described by SPI0U, SPI0U1, SPI0U2, and W0 - W15 against
+  the simulated flash. The transaction completes at once; reading SPI0CMD
+  afterward shows the controller idle.
+*/
+#ifndef HOSTSIM_ESP8266_PERI_H
+#define HOSTSIM_ESP8266_PERI_H
+
+#include <stdint.h>
+
+#define BIT0  0x00000001u
+#define BIT1  0x00000002u
+#define BIT2  0x00000004u
+#define BIT3  0x00000008u
+#define BIT4  0x00000010u
+#define BIT5  0x00000020u
+#define BIT6  0x00000040u
+#define BIT7  0x00000080u
+#define BIT8  0x00000100u
+#define BIT9  0x00000200u
+#define BIT10 0x00000400u
+#define BIT11 0x00000800u
+#define BIT12 0x00001000u
+#define BIT13 0x00002000u
+#define BIT14 0x00004000u
+#define BIT15 0x00008000u
+#define BIT16 0x00010000u
+#define BIT17 0x00020000u
+#define BIT18 0x00040000u
+#define BIT19 0x00080000u
+#define BIT20 0x00100000u
+#define BIT21 0x00200000u
+#define BIT22 0x00400000u
+#define BIT23 0x00800000u
+#define BIT24 0x01000000u
+#define BIT25 0x02000000u
+#define BIT26 0x04000000u
+#define BIT27 0x08000000u
+#define BIT28 0x10000000u
+#define BIT29 0x20000000u
+#define BIT30 0x40000000u
+#define BIT31 0x80000000u
+
+// SPI0CMD
+#define SPICMDREAD  BIT31 // SPI_FLASH_READ
+#define SPICMDWREN  BIT30 // SPI_FLASH_WREN
+#define SPICMDRDSR  BIT27 // SPI_FLASH_RDSR
+#define SPICMDUSR   BIT18 // SPI_USR
+
+// SPI0C
+#define SPICWPR     BIT21 // SPI_WP_REG
+#define SPICQIO     BIT24 // SPI_QIO_MODE
+#define SPICDIO     BIT23 // SPI_DIO_MODE
+#define SPIC2BSE    BIT22 // SPI_WRSR_2B
+#define SPICQOUT    BIT20 // SPI_QOUT_MODE
+#define SPICDOUT    BIT14 // SPI_DOUT_MODE
+#define SPICRESANDRES BIT15 // SPI_RESANDRES
+#define SPICSHARE   BIT16 // SPI_SHARE_BUS
+#define SPICAHB     BIT16 // Same bit as SPICSHARE in the core
+#define SPICFASTRD  BIT13 // SPI_FASTRD_MODE
+
+// SPI0U
+#define SPIUCOMMAND BIT31 // COMMAND enable
+#define SPIUADDR    BIT30 // ADDRESS enable
+#define SPIUDUMMY   BIT29 // DUMMY enable
+#define SPIUMISO    BIT28 // MISO enable
+#define SPIUMOSI    BIT27 // MOSI enable
+#define SPIUCSSETUP BIT5  // CS setup time
+
+// SPI0U1
+#define SPILMOSI    17    // MOSI BitLength Shift
+#define SPIMMOSI    0x1FF // MOSI BitLength Mask
+#define SPILMISO    8     // MISO BitLength Shift
+#define SPIMMISO    0x1FF // MISO BitLength Mask
+
+// SPI0U2
+#define SPILCOMMAND 28    // COMMAND BitLength Shift
+#define SPIMCOMMAND 0xF   // COMMAND BitLength Mask
+
+#ifdef __cplusplus
+struct HostSimReg {
+  uint32_t v;
+  operator uint32_t() const { return v; }
+  HostSimReg& operator=(const uint32_t x) { v = x; return *this; }
+  HostSimReg& operator|=(const uint32_t x) { v |= x; return *this; }
+  HostSimReg& operator&=(const uint32_t x) { v &= x; return *this; }
+};
+
+// Writing SPICMDUSR runs the user transaction. busy_reads, from
+// hostsim::inject_fault(), keeps SPICMDUSR reading set after it ran.
+struct HostSimCmdReg {
+  uint32_t v;
+  mutable uint32_t busy_reads;
+  operator uint32_t() const { return (busy_reads && busy_reads--) ? (v | SPICMDUSR) : v; }
+  HostSimCmdReg& operator=(const uint32_t x);
+};
+
+struct HostSimSpi0 {
+  HostSimCmdReg cmd;
+  HostSimReg addr;
+  HostSimReg ctrl;              // SPI0C
+  HostSimReg user;              // SPI0U
+  HostSimReg user1;             // SPI0U1
+  HostSimReg user2;             // SPI0U2
+  HostSimReg w[16];             // W0 - W15
+};
+
+extern HostSimSpi0 hostsim_spi0;
+
+#define SPI0CMD hostsim_spi0.cmd
+#define SPI0A   hostsim_spi0.addr
+#define SPI0C   hostsim_spi0.ctrl
+#define SPI0U   hostsim_spi0.user
+#define SPI0U1  hostsim_spi0.user1
+#define SPI0U2  hostsim_spi0.user2
+#define SPI0W0  hostsim_spi0.w[0]
+#define SPI0W1  hostsim_spi0.w[1]
+#define SPI0W2  hostsim_spi0.w[2]
+#define SPI0W3  hostsim_spi0.w[3]
+#define SPI0W(p) hostsim_spi0.w[(p) & 0xFu]
+
+// GPIO. The output, enable, and input registers go through the simulator,
+// where a device on the lines can see each change, see gpio_attach() in
+// hostsim.h. GPC and GPF are plain words.
+enum HostSimGpioId : uint32_t {
+  kHostSimGPO = 0u,
+  kHostSimGPOS,
+  kHostSimGPOC,
+  kHostSimGPE,
+  kHostSimGPES,
+  kHostSimGPEC,
+  kHostSimGPI,
+};
+
+uint32_t hostsim_gpio_read(const uint32_t id);
+void hostsim_gpio_write(const uint32_t id, const uint32_t x);
+
+template<uint32_t kId>
+struct HostSimGpioReg {
+  operator uint32_t() const { return hostsim_gpio_read(kId); }
+  HostSimGpioReg& operator=(const uint32_t x) { hostsim_gpio_write(kId, x); return *this; }
+  HostSimGpioReg& operator|=(const uint32_t x) { hostsim_gpio_write(kId, hostsim_gpio_read(kId) | x); return *this; }
+  HostSimGpioReg& operator&=(const uint32_t x) { hostsim_gpio_write(kId, hostsim_gpio_read(kId) & x); return *this; }
+  HostSimGpioReg& operator^=(const uint32_t x) { hostsim_gpio_write(kId, hostsim_gpio_read(kId) ^ x); return *this; }
+};
+
+struct HostSimGpio {
+  HostSimGpioReg<kHostSimGPO>  out;
+  HostSimGpioReg<kHostSimGPOS> out_set;
+  HostSimGpioReg<kHostSimGPOC> out_clear;
+  HostSimGpioReg<kHostSimGPE>  enable;
+  HostSimGpioReg<kHostSimGPES> enable_set;
+  HostSimGpioReg<kHostSimGPEC> enable_clear;
+  HostSimGpioReg<kHostSimGPI>  in;
+  HostSimReg ctrl[16];          // GPC(p)
+  HostSimReg fn[16];            // GPF(p)
+};
+
+extern HostSimGpio hostsim_gpio;
+
+#define GPO     hostsim_gpio.out
+#define GPOS    hostsim_gpio.out_set
+#define GPOC    hostsim_gpio.out_clear
+#define GPE     hostsim_gpio.enable
+#define GPES    hostsim_gpio.enable_set
+#define GPEC    hostsim_gpio.enable_clear
+#define GPI     hostsim_gpio.in
+#define GPC(p)  hostsim_gpio.ctrl[(p) & 0xFu]
+#define GPF(p)  hostsim_gpio.fn[(p) & 0xFu]
+#define GPF9    hostsim_gpio.fn[9]
+#define GPF10   hostsim_gpio.fn[10]
+#endif
+
+// GPC
+#define GPCI    7   // INT_TYPE (3bits) 0:disable,1:rising,2:falling,3:change,4:low,5:high
+#define GPCD    2   // DRIVER 0:normal,1:open drain
+
+// GPF
+#define GPFPU   7   // Pullup
+#define GPFFS0  4   // Function Select bit 0
+#define GPFFS1  5   // Function Select bit 1
+#define GPFFS2  8   // Function Select bit 2
+#define GPFFS(f) (((((f) & 4) != 0) << GPFFS2) | ((((f) & 2) != 0) << GPFFS1) | ((((f) & 1) != 0) << GPFFS0))
+#define GPFFS_GPIO(p) (((p)==0||(p)==2||(p)==4||(p)==5)?0:((p)==16)?1:3)
+#define GPFFS_BUS(p) (((p)==1||(p)==3)?0:((p)==2||(p)==12||(p)==13||(p)==14||(p)==15)?2:((p)==0)?4:1)
+
+#endif // HOSTSIM_ESP8266_PERI_H
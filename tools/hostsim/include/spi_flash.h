@@ -0,0 +1,47 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+// Host build - NONOS SDK spi_flash.h, the parts the library uses
+#ifndef HOSTSIM_SPI_FLASH_H
+#define HOSTSIM_SPI_FLASH_H
+
+#include <stdint.h>
+
+typedef enum {
+  SPI_FLASH_RESULT_OK,
+  SPI_FLASH_RESULT_ERR,
+  SPI_FLASH_RESULT_TIMEOUT
+} SpiFlashOpResult;
+
+typedef struct {
+  uint32_t deviceId;
+  uint32_t chip_size;
+  uint32_t block_size;
+  uint32_t sector_size;
+  uint32_t page_size;
+  uint32_t status_mask;
+} SpiFlashChip;
+
+#define SPI_FLASH_SEC_SIZE 4096
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+uint32_t spi_flash_get_id(void);
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOSTSIM_SPI_FLASH_H
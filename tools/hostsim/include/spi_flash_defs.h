@@ -0,0 +1,28 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+// Host build - core spi_flash_defs.h
+#ifndef HOSTSIM_SPI_FLASH_DEFS_H
+#define HOSTSIM_SPI_FLASH_DEFS_H
+
+#define SPI_FLASH_SR3_XMC_DRV_25  1
+#define SPI_FLASH_SR3_XMC_DRV_50  0
+#define SPI_FLASH_SR3_XMC_DRV_75  2
+#define SPI_FLASH_SR3_XMC_DRV_100 3
+
+#define SPI_FLASH_SR3_XMC_DRV_S 5
+#define SPI_FLASH_SR3_XMC_DRV_MASK 0x03
+
+#endif // HOSTSIM_SPI_FLASH_DEFS_H
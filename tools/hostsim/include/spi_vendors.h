@@ -0,0 +1,53 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+// Host build - core spi_vendors.h
+#ifndef HOSTSIM_SPI_VENDORS_H
+#define HOSTSIM_SPI_VENDORS_H
+
+#define SPI_FLASH_VENDOR_ALLIANCE    0x52
+#define SPI_FLASH_VENDOR_AMD         0x01
+#define SPI_FLASH_VENDOR_AMIC        0x37
+#define SPI_FLASH_VENDOR_ATMEL       0x1F
+#define SPI_FLASH_VENDOR_BRIGHT      0xAD
+#define SPI_FLASH_VENDOR_CATALYST    0x31
+#define SPI_FLASH_VENDOR_EON         0x1C
+#define SPI_FLASH_VENDOR_ESMT        0x8C
+#define SPI_FLASH_VENDOR_EXCEL       0x4A
+#define SPI_FLASH_VENDOR_FIDELIX     0xF8
+#define SPI_FLASH_VENDOR_FUJITSU     0x04
+#define SPI_FLASH_VENDOR_GIGADEVICE  0xC8
+#define SPI_FLASH_VENDOR_HYUNDAI     0xAD
+#define SPI_FLASH_VENDOR_INTEL       0x89
+#define SPI_FLASH_VENDOR_ISSI        0xD5
+#define SPI_FLASH_VENDOR_MACRONIX    0xC2
+#define SPI_FLASH_VENDOR_NANTRONICS  0xD5
+#define SPI_FLASH_VENDOR_PMC         0x9D
+#define SPI_FLASH_VENDOR_PUYA        0x85
+#define SPI_FLASH_VENDOR_SANYO       0x62
+#define SPI_FLASH_VENDOR_SHARP       0xB0
+#define SPI_FLASH_VENDOR_SPANSION    0x01
+#define SPI_FLASH_VENDOR_SST         0xBF
+#define SPI_FLASH_VENDOR_ST          0x20
+#define SPI_FLASH_VENDOR_SYNCMOS_MVC 0x40
+#define SPI_FLASH_VENDOR_TENX        0x5E
+#define SPI_FLASH_VENDOR_TI          0x97
+#define SPI_FLASH_VENDOR_TI_OLD      0x01
+#define SPI_FLASH_VENDOR_WINBOND     0xDA
+#define SPI_FLASH_VENDOR_WINBOND_NEX 0xEF
+#define SPI_FLASH_VENDOR_XMC         0x20
+#define SPI_FLASH_VENDOR_UNKNOWN     0xFF
+
+#endif // HOSTSIM_SPI_VENDORS_H
@@ -0,0 +1,34 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+// Host build - NONOS SDK user_interface.h, the parts the library uses
+#ifndef HOSTSIM_USER_INTERFACE_H
+#define HOSTSIM_USER_INTERFACE_H
+
+#include <stdint.h>
+#include <esp8266_undocumented.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void system_soft_wdt_feed(void);
+bool system_rtc_mem_read(uint8_t src_addr, void *des_addr, uint16_t load_size);
+bool system_rtc_mem_write(uint8_t des_addr, const void *src_addr, uint16_t save_size);
+uint8_t system_get_cpu_freq(void);
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOSTSIM_USER_INTERFACE_H
@@ -0,0 +1,155 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+////////////////////////////////////////////////////////////////////////////////
+// Vendor profiles for the host simulator
+//
+// Behaviour follows the notes in ModeDIO_ReclaimGPIOs.cpp and
+// FlashChipId_D8.h. The SFDP headers match the revision, pointer, and size
+// recorded there. The Basic Flash Parameter Tables are representative, the
+// 0xD8 one is from the dump in FlashChipId_D8.h, the others are shaped like
+// it with each part's capacity. They are not dumps of those parts.
+#include <string.h>
+#include "hostsim.h"
+
+namespace hostsim {
+
+struct SfdpImage {
+  uint32_t dw[48];
+};
+
+// SFDP header, one parameter header, and the BFPT at ptr. Unused space reads
+// as erased.
+static constexpr SfdpImage make_sfdp(const uint32_t major, const uint32_t minor, const uint32_t ptr, const uint32_t *bfpt, const uint32_t num_dw) {
+  SfdpImage img{};
+  for (auto& v : img.dw) v = 0xFFFFFFFFu;
+  img.dw[0] = 0x50444653u;                                // "SFDP"
+  img.dw[1] = 0xFF000000u | (major << 8u) | minor;        // NPH 0
+  img.dw[2] = (num_dw << 24u) | (major << 16u) | (minor << 8u);
+  img.dw[3] = 0xFF000000u | ptr;
+  for (uint32_t i = 0u; i < num_dw; i++) img.dw[ptr / 4u + i] = bfpt[i];
+  return img;
+}
+
+// Winbond W25Q32FV, JESD216 rev 1.0 table. capacity is DW2, bits - 1.
+static constexpr uint32_t kBfpt9[] = {
+  0xFFF920E5u, 0x01FFFFFFu, 0x6B08EB44u, 0xBB423B08u, 0xFFFFFFFEu,
+  0xFF00FFFFu, 0xFF00FFFFu, 0x520F200Cu, 0xFF00D810u,
+};
+
+static constexpr uint32_t kBfpt9_8Mbit[] = {
+  0xFFF920E5u, 0x007FFFFFu, 0x6B08EB44u, 0xBB423B08u, 0xFFFFFFFEu,
+  0xFF00FFFFu, 0xFF00FFFFu, 0x520F200Cu, 0xFF00D810u,
+};
+
+// Mystery 0xD8 25Q32ET, from FlashChipId_D8.h
+static constexpr uint32_t kBfpt16[] = {
+  0xFFF120E5u, 0x01FFFFFFu, 0x6B08EB44u, 0xBB423B08u, 0xFFFFFFEEu,
+  0xFF00FFFFu, 0xFF00FFFFu, 0x520F200Cu, 0xFF00D810u, 0xFEBD4A24u,
+  0x42152782u, 0x331662ECu, 0x757A757Au, 0x5CD5B304u, 0x00640600u,
+  0x00001008u,
+};
+
+static constexpr uint32_t kBfpt16_8Mbit[] = {
+  0xFFF120E5u, 0x007FFFFFu, 0x6B08EB44u, 0xBB423B08u, 0xFFFFFFEEu,
+  0xFF00FFFFu, 0xFF00FFFFu, 0x520F200Cu, 0xFF00D810u, 0xFEBD4A24u,
+  0x42152782u, 0x331662ECu, 0x757A757Au, 0x5CD5B304u, 0x00640600u,
+  0x00001008u,
+};
+
+static constexpr SfdpImage kSfdpWinbond = make_sfdp(1u, 0u, 0x80u, kBfpt9, 9u);
+static constexpr SfdpImage kSfdp100_32Mbit = make_sfdp(1u, 0u, 0x30u, kBfpt9, 9u);
+static constexpr SfdpImage kSfdp100_8Mbit = make_sfdp(1u, 0u, 0x30u, kBfpt9_8Mbit, 9u);
+static constexpr SfdpImage kSfdp106_32Mbit = make_sfdp(1u, 6u, 0x30u, kBfpt16, 16u);
+static constexpr SfdpImage kSfdp106_8Mbit = make_sfdp(1u, 6u, 0x30u, kBfpt16_8Mbit, 16u);
+
+static constexpr uint8_t kUniqueId[16] = {
+  0xD1u, 0x64u, 0x2Cu, 0x8Bu, 0x13u, 0x2Au, 0x4Fu, 0x22u,
+  0x0Bu, 0x17u, 0x39u, 0x85u, 0x6Cu, 0xE0u, 0x41u, 0x9Au,
+};
+
+// Only the first 64 bits are programmed
+static constexpr uint8_t kUniqueIdD8[16] = {
+  0x5Au, 0x37u, 0x30u, 0x31u, 0x08u, 0x1Cu, 0x14u, 0x4Eu,
+  0xFFu, 0xFFu, 0xFFu, 0xFFu, 0xFFu, 0xFFu, 0xFFu, 0xFFu,
+};
+
+#define SFDP_IMAGE(img) (img).dw, sizeof((img).dw)
+
+// SR2 bits: SRL S8, QE S9, CMP S14. LB1-LB3 are OTP, not writable here.
+// SR3 bits: WPS S18, DRV1:DRV0 S22:S21.
+constexpr uint32_t kS9Part = kHasSR2 | kHasSR3 | kWrite8SR2 | kVolatileSR;
+
+const FlashProfile kProfiles[] = {
+  {
+    "winbond", "Winbond W25Q32FV", 0x1640EFu,
+    kS9Part | kWrite16SR1 | kHasSecReg,
+    {0x00u, 0x00u, 0x60u}, {0xFCu, 0x43u, 0x64u}, 10000u, 30u,
+    SFDP_IMAGE(kSfdpWinbond), kUniqueId, true
+  },
+  {
+    // 8-bit Status Register writes only. The BootROM's 16-bit write leaves
+    // WEL set.
+    "gigadevice", "GigaDevice GD25Q32C", 0x1640C8u,
+    kS9Part | kHasSecReg,
+    {0x00u, 0x00u, 0x60u}, {0xFCu, 0x43u, 0x64u}, 5000u, 30u,
+    SFDP_IMAGE(kSfdp100_32Mbit), kUniqueId, true
+  },
+  {
+    // Volatile write to SR2 clears SR3. 66h 99h reloads QE, not SR3.
+    "xmc", "XMC XM25QH32B", 0x164020u,
+    kS9Part | kWrite16SR1 | kSR2VolClearsSR3 | kResetKeepsSR3 | kHasSecReg,
+    {0x00u, 0x00u, 0x60u}, {0xFCu, 0x43u, 0x64u}, 5000u, 30u,
+    SFDP_IMAGE(kSfdp100_32Mbit), kUniqueId, true
+  },
+  {
+    // One Status Register, WPDis at S6, no 50h. No built-in handler, a
+    // Sketch must supply one. 35h and 15h read back as 0xFF.
+    "eon", "EON EN25Q32C", 0x16301Cu,
+    0u,
+    {0x00u, 0x00u, 0x00u}, {0xFCu, 0x00u, 0x00u}, 10000u, 30u,
+    SFDP_IMAGE(kSfdp100_32Mbit), nullptr, false
+  },
+  {
+    // 8-bit writes only, 66h 99h clears the non-volatile QE bit
+    "mystery-d8", "25Q32ET, vendor 0xD8", 0x1640D8u,
+    kS9Part | kResetClearsQE,
+    {0x00u, 0x00u, 0x20u}, {0xFCu, 0x43u, 0x64u}, 5000u, 30u,
+    SFDP_IMAGE(kSfdp106_32Mbit), kUniqueIdD8, true
+  },
+  {
+    "puya", "Puya P25Q80H", 0x146085u,
+    kS9Part | kWrite16SR1,
+    {0x00u, 0x00u, 0x00u}, {0xFCu, 0x43u, 0x64u}, 8000u, 30u,
+    SFDP_IMAGE(kSfdp100_8Mbit), kUniqueId, true
+  },
+  {
+    "zbit", "Zbit ZB25VQ80AT", 0x14605Eu,
+    kS9Part | kWrite16SR1,
+    {0x00u, 0x00u, 0x00u}, {0xFCu, 0x43u, 0x64u}, 8000u, 30u,
+    SFDP_IMAGE(kSfdp106_8Mbit), kUniqueId, true
+  },
+};
+
+const size_t kNumProfiles = sizeof(kProfiles) / sizeof(kProfiles[0]);
+
+const FlashProfile *find_profile(const char *name) {
+  for (size_t i = 0u; i < kNumProfiles; i++) {
+    if (0 == strcmp(name, kProfiles[i].name)) return &kProfiles[i];
+  }
+  return nullptr;
+}
+
+};  // namespace hostsim
@@ -0,0 +1,172 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  reclaim_sim - run reclaim_GPIO_9_10() against simulated flash parts
+
+  Build from the library root:
+
+    g++ -std=gnu++17 -O1 -Wall -Itools/hostsim/include -Isrc \
+      [-DRECLAIM_RECIPE_CACHE=1] [-DRECLAIM_TIMELINE=1] [-DDEBUG_FLASH_QE=1] \
+      [-DSPI_FLASH_TRACE=1] [-DDEBUG_FLASH_QE_DEFERRED=1] [-DSR_SHADOW=1] \
+      tools/hostsim/hostsim.cpp tools/hostsim/profiles.cpp \
+      tools/hostsim/reclaim_sim.cpp src/SpiFlashUtils.cpp src/SpiFlashUtilsQE.cpp \
+      src/SfdpRevInfo.cpp src/SfdpBasic.cpp src/ModeDIO_ReclaimGPIOs.cpp \
+      src/SpiFlashCost.cpp src/SpiFlashTrace.cpp src/SpiFlashLog.cpp \
+      src/StatusRegisterUpdate.cpp -o reclaim_sim
+
+  Usage:
+
+    reclaim_sim [-t] [-d] [-l] [profile ...]
+
+      -t  trace each flash instruction
+      -d  print a SpiFlashTrace.h dump after each boot, for tools/spitrace.
+          Needs -DSPI_FLASH_TRACE=1. With DEBUG_FLASH_QE_DEFERRED, also a
+          SpiFlashLog.h dump, for tools/sfulog.
+      -l  list the profiles
+
+  With no profile named, all are run. For each part: a power-on boot, then a
+  warm reset boot. Each boot runs the BootROM's DIO Status Register write,
+  then reclaim_GPIO_9_10(). The counters are for reclaim_GPIO_9_10() only.
+
+    txn     flash transactions, a prefix instruction is one
+    bits    bus bits, instruction + data out + data in
+    win     iCache disable windows
+    off us  time with the iCache off, total and longest window
+    polls   Read Status Register-1 polls, includes WIP spins
+    nv/v    accepted non-volatile and volatile Status Register writes
+    ign     Status Register writes the part ignored
+    us      simulated time
+
+  With -DDEBUG_FLASH_QE=1 -DDEBUG_FLASH_QE_DEFERRED=1, the debug messages
+  are printed from the log after each boot, as a Sketch would from setup().
+
+  Exits non-zero when a result differs from the profile's expected result,
+  QE is not set after a success, WEL is left set, or an XMC Status Register-3
+  is not restored.
+*/
+#include <Arduino.h>
+#include "ModeDIO_ReclaimGPIOs.h"
+#include "hostsim.h"
+
+using namespace hostsim;
+
+static bool dump_trace = false;
+
+static void print_trace_dump() {
+#if SPI_FLASH_TRACE
+  char line[experimental::kSpiTraceLineSz];
+  for (size_t i = 0u; experimental::spi_flash_trace_line(i, line, sizeof(line)); i++) printf("%s\n", line);
+#endif
+}
+
+static void print_deferred_log() {
+#if DEBUG_FLASH_QE && DEBUG_FLASH_QE_DEFERRED
+  char msg[160];
+  for (size_t i = 0u; experimental::sfu_log_format(i, msg, sizeof(msg)); i++) fputs(msg, stdout);
+  if (dump_trace) {
+    char line[experimental::kSfuLogLineSz];
+    for (size_t i = 0u; experimental::sfu_log_line(i, line, sizeof(line)); i++) printf("%s\n", line);
+  }
+#endif
+}
+
+static bool qe_is_set() {
+  const FlashState& fs = flash_state();
+  if (profile().flags & kHasSR2) return 0u != (fs.sr_v[1] & 0x02u);
+  return 0u != (fs.sr_v[0] & 0x40u);
+}
+
+static bool run_boot(const char *boot) {
+  if (config.trace) printf("  %s %s boot, BootROM:\n", profile().name, boot);
+  bootrom_dio();
+  if (config.trace) printf("  reclaim_GPIO_9_10():\n");
+  const bool wel_after_rom = flash_state().wel;
+  const bool stale = is_GPIO_9_10_reclaimed();
+#if SPI_FLASH_TRACE
+  experimental::spi_flash_trace_reset();
+#endif
+  Measure m;
+  const bool ok = reclaim_GPIO_9_10();
+  const Counters d = m.delta();
+  const FlashState& fs = flash_state();
+
+  const char *fail = nullptr;
+  if (ok != profile().expect_reclaim) {
+    fail = "unexpected result";
+  } else if (ok && ! qe_is_set()) {
+    fail = "QE not set";
+  } else if (ok && (INPUT != pin_mode(9u) || INPUT != pin_mode(10u))) {
+    fail = "pinMode not set";
+  } else if (stale || ok != is_GPIO_9_10_reclaimed()) {
+    fail = "is_GPIO_9_10_reclaimed() wrong";
+  } else if (fs.wel) {
+    fail = "WEL left set";
+  } else if ((profile().flags & kSR2VolClearsSR3) && fs.sr_v[2] != fs.sr_nv[2]) {
+    fail = "SR3 not restored";
+  }
+
+  printf("  %-11s %-5s %-4s %4llu %6llu %3llu %8.1f %8.1f %5llu %2llu/%-2llu %3llu %9.1f  SR %02X %02X %02X%s%s%s\n",
+    profile().name, boot, (ok) ? "yes" : "no",
+    (unsigned long long)d.transactions, (unsigned long long)d.bus_bits,
+    (unsigned long long)d.cache_windows, d.cache_off_ns / 1000.0, d.max_cache_off_ns / 1000.0,
+    (unsigned long long)d.status_polls, (unsigned long long)d.nv_writes,
+    (unsigned long long)d.v_writes, (unsigned long long)d.ignored_writes, d.time_ns / 1000.0,
+    fs.sr_v[0], fs.sr_v[1], fs.sr_v[2],
+    (wel_after_rom) ? "  ROM left WEL" : "",
+    (fail) ? "  ** " : "", (fail) ? fail : "");
+  print_deferred_log();
+  if (dump_trace) print_trace_dump();
+  return nullptr == fail;
+}
+
+static bool run_profile(const FlashProfile& p) {
+  install(p);
+  bool pass = run_boot("cold");
+  warm_reset();
+  pass = run_boot("warm") && pass;
+  return pass;
+}
+
+int main(int argc, char **argv) {
+  const FlashProfile *selected[16];
+  size_t count = 0u;
+  for (int i = 1; i < argc; i++) {
+    if (0 == strcmp("-t", argv[i])) {
+      config.trace = true;
+    } else if (0 == strcmp("-d", argv[i])) {
+      dump_trace = true;
+    } else if (0 == strcmp("-l", argv[i])) {
+      for (size_t k = 0u; k < kNumProfiles; k++) {
+        printf("  %-11s %-22s 0x%06X\n", kProfiles[k].name, kProfiles[k].part, kProfiles[k].jedec_id);
+      }
+      return 0;
+    } else if (const FlashProfile *p = find_profile(argv[i])) {
+      if (count < 16u) selected[count++] = p;
+    } else {
+      fprintf(stderr, "Unknown profile: %s\n", argv[i]);
+      return 2;
+    }
+  }
+  if (0u == count) {
+    for (size_t k = 0u; k < kNumProfiles && k < 16u; k++) selected[count++] = &kProfiles[k];
+  }
+
+  printf("  %-11s %-5s %-4s %4s %6s %3s %8s %8s %5s %5s %3s %9s\n",
+    "part", "boot", "ok", "txn", "bits", "win", "off us", "max us", "polls", "nv/v", "ign", "us");
+  bool pass = true;
+  for (size_t i = 0u; i < count; i++) pass = run_profile(*selected[i]) && pass;
+  return (pass) ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  secreg_sim - SecurityRegisterStore.h against simulated flash parts
+
+  Build from the library root:
+
+    g++ -std=gnu++17 -O1 -Wall -Itools/hostsim/include -Isrc \
+      tools/hostsim/hostsim.cpp tools/hostsim/profiles.cpp \
+      tools/hostsim/secreg_sim.cpp src/SecurityRegisterStore.cpp \
+      src/SpiFlashUtils.cpp src/SpiFlashUtilsQE.cpp -o secreg_sim
+
+  Usage:
+
+    secreg_sim [-t]
+
+      -t  trace each flash instruction
+
+  On each profile with Security Registers, from a new part:
+
+    open      a blank register opens, the first put formats it.
+    put       find returns what was put, an unchanged put writes nothing.
+    compact   puts until the register is erased and rewritten, then a reopen
+              finds the newest value of each tag.
+    fail      a put over a programmed byte fails its read back, the store is
+              read again, and a reopen still finds the earlier records.
+    locked    a put to a locked register is refused and writes nothing.
+
+  Prints each failed check. Exits non-zero when any fails.
+*/
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+#include "SecurityRegisterStore.h"
+#include "hostsim.h"
+
+using namespace experimental;
+
+static uint32_t checks = 0u;
+static uint32_t failed = 0u;
+static const char *part = "";
+
+static void check(const char *group, const char *name, const bool pass) {
+  checks++;
+  if (pass) return;
+  failed++;
+  printf("  ** %s %s: %s\n", part, group, name);
+}
+
+static bool holds(const SecRegStore *st, const uint8_t tag, const uint32_t v) {
+  uint32_t got = ~v;
+  return sec_reg_store_get(st, tag, &got, sizeof(got)) && v == got;
+}
+
+static const uint8_t *sec_reg(const uint32_t reg) {
+  return hostsim::flash_state().sec_reg[reg - 1u];
+}
+
+static void open_put_checks() {
+  SecRegStore st;
+  check("open", "blank register opens", sec_reg_store_open(&st, 1u));
+  check("open", "state blank", kSecRegStoreBlank == st.state);
+  check("open", "nothing found", nullptr == sec_reg_store_find(&st, kSecRegTagUser, nullptr));
+
+  const uint32_t a = 0x11111111u;
+  check("put", "first put", SPI_RESULT_OK == sec_reg_store_put(&st, kSecRegTagUser, &a, sizeof(a)));
+  check("put", "state ready", kSecRegStoreReady == st.state);
+  size_t sz = 0u;
+  const void *p = sec_reg_store_find(&st, kSecRegTagUser, &sz);
+  check("put", "find", nullptr != p && sizeof(a) == sz && 0 == memcmp(p, &a, sz));
+
+  const uint16_t used = st.used;
+  hostsim::Measure m;
+  check("put", "same data", SPI_RESULT_OK == sec_reg_store_put(&st, kSecRegTagUser, &a, sizeof(a)));
+  check("put", "same data, nothing written", used == st.used && 0u == m.delta().transactions);
+
+  SecRegStore st2;
+  check("put", "reopen", sec_reg_store_open(&st2, 1u) && kSecRegStoreReady == st2.state);
+  check("put", "reopen, find", holds(&st2, kSecRegTagUser, a));
+}
+
+static void compact_checks() {
+  SecRegStore st;
+  sec_reg_store_open(&st, 1u);
+  const uint32_t a = 0x11111111u;
+  bool compacted = false;
+  bool ok = true;
+  uint32_t v = 0u;
+  for (uint32_t i = 0u; i < 40u && ok; i++) {
+    const uint16_t used = st.used;
+    v = 0xC0DE0000u + i;
+    ok = SPI_RESULT_OK == sec_reg_store_put(&st, kSecRegTagUser + 1u, &v, sizeof(v));
+    if (st.used < used) compacted = true;
+  }
+  check("compact", "puts", ok);
+  check("compact", "register erased and rewritten", compacted);
+  check("compact", "newest value", holds(&st, kSecRegTagUser + 1u, v));
+
+  SecRegStore st2;
+  check("compact", "reopen", sec_reg_store_open(&st2, 1u) && kSecRegStoreReady == st2.state);
+  check("compact", "reopen, newest value", holds(&st2, kSecRegTagUser + 1u, v));
+  check("compact", "reopen, other tag kept", holds(&st2, kSecRegTagUser, a));
+}
+
+static void fail_checks() {
+  SecRegStore st;
+  sec_reg_store_open(&st, 1u);
+  const uint32_t a = 0x11111111u;
+  const uint32_t b = 0x22222222u;
+  if (sec_reg_store_free(&st) < 2u * sizeof(b)) sec_reg_store_format(&st);
+  sec_reg_store_put(&st, kSecRegTagUser, &a, sizeof(a));
+
+  // A byte in the space the next record goes to, programmed behind the
+  // store's back. Page program can't set it back to 1.
+  hostsim::FlashState& fs = const_cast<hostsim::FlashState&>(hostsim::flash_state());
+  fs.sec_reg[0][st.used + 5u] = 0x00u;
+  const uint16_t used = st.used;
+  check("fail", "put fails", SPI_RESULT_OK != sec_reg_store_put(&st, kSecRegTagUser + 2u, &b, sizeof(b)));
+  check("fail", "store read again", kSecRegStoreReady == st.state && used < st.used);
+  check("fail", "bad record not found", nullptr == sec_reg_store_find(&st, kSecRegTagUser + 2u, nullptr));
+  check("fail", "earlier record kept", holds(&st, kSecRegTagUser, a));
+
+  SecRegStore st2;
+  check("fail", "reopen", sec_reg_store_open(&st2, 1u) && kSecRegStoreReady == st2.state);
+  check("fail", "reopen, earlier record kept", holds(&st2, kSecRegTagUser, a));
+  check("fail", "retry", SPI_RESULT_OK == sec_reg_store_put(&st2, kSecRegTagUser + 2u, &b, sizeof(b)));
+  check("fail", "retry, find", holds(&st2, kSecRegTagUser + 2u, b));
+}
+
+static void locked_checks() {
+  SecRegStore st;
+  sec_reg_store_open(&st, 2u);
+  const uint32_t a = 0x11111111u;
+  sec_reg_store_put(&st, kSecRegTagUser, &a, sizeof(a));
+
+  hostsim::lock_security_register(2u);
+  uint8_t before[kSecurityRegisterSz];
+  memcpy(before, sec_reg(2u), sizeof(before));
+  const uint32_t b = 0x22222222u;
+  check("locked", "put refused", SPI_RESULT_ERR == sec_reg_store_put(&st, kSecRegTagUser, &b, sizeof(b)));
+  check("locked", "format refused", SPI_RESULT_ERR == sec_reg_store_format(&st));
+  check("locked", "register unchanged", 0 == memcmp(before, sec_reg(2u), sizeof(before)));
+  check("locked", "old record kept", holds(&st, kSecRegTagUser, a));
+}
+
+int main(int argc, char **argv) {
+  hostsim::config.trace = (1 < argc && 0 == strcmp(argv[1], "-t"));
+  for (size_t i = 0u; i < hostsim::kNumProfiles; i++) {
+    const hostsim::FlashProfile& p = hostsim::kProfiles[i];
+    if (0u == (p.flags & hostsim::kHasSecReg)) continue;
+    part = p.name;
+    hostsim::install(p);
+    hostsim::power_on();
+    open_put_checks();
+    compact_checks();
+    fail_checks();
+    locked_checks();
+  }
+  printf("%u checks, %u failed\n", checks, failed);
+  return (0u == failed) ? 0 : 1;
+}
@@ -0,0 +1,182 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  shadow_sim - the Status Register shadow against simulated flash parts
+
+  Build from the library root:
+
+    g++ -std=gnu++17 -O1 -Wall -Itools/hostsim/include -Isrc -DSR_SHADOW=1 \
+      [-DSR_SHADOW_FORCE_VERIFY=1] \
+      tools/hostsim/hostsim.cpp tools/hostsim/profiles.cpp \
+      tools/hostsim/shadow_sim.cpp src/SpiFlashUtils.cpp src/SpiFlashUtilsQE.cpp \
+      src/SfdpRevInfo.cpp src/SfdpBasic.cpp src/ModeDIO_ReclaimGPIOs.cpp \
+      src/SpiFlashCost.cpp src/StatusRegisterUpdate.cpp -o shadow_sim
+
+  Usage:
+
+    shadow_sim [profile ...]
+
+  With no profile named, all are run. Each part boots, runs
+  reclaim_GPIO_9_10(), then a mix of reads, volatile and non-volatile writes,
+  sr_update(), Write Enable and Disable, 50h, a software reset, and a warm
+  reset. After each step every library read of SR1 - SR3 is compared with the
+  simulated part.
+
+  The workload runs twice, with force verify, then without unless built with
+  SR_SHADOW_FORCE_VERIFY.
+
+    txn     flash transactions
+    win     iCache disable windows
+    rd      Status Register reads the shadow answered
+    wrdi    Write Disables not sent, WEL known clear
+    reads   Status Register reads sent
+    mism    force verify mismatches, a read that differed from the shadow
+    wrong   library reads that differed from the part
+
+  Exits non-zero on any mismatch or wrong read.
+*/
+#include <Arduino.h>
+#include <stdio.h>
+#include "SpiFlashUtilsQE.h"
+#include "StatusRegisterUpdate.h"
+#include "ModeDIO_ReclaimGPIOs.h"
+#include "hostsim.h"
+
+#if ! SR_SHADOW
+#error "Build with -DSR_SHADOW=1"
+#endif
+
+using namespace experimental;
+
+static uint32_t wrong = 0u;
+
+// The part's register as the library should read it
+static uint8_t part_sr(const uint32_t idx0) {
+  const hostsim::FlashState& fs = hostsim::flash_state();
+  const uint32_t flags = hostsim::profile().flags;
+  if (0u == idx0) return fs.sr_v[0] | ((fs.wel) ? 0x02u : 0u) | ((fs.wip) ? 0x01u : 0u);
+  if (1u == idx0) return (flags & hostsim::kHasSR2) ? fs.sr_v[1] : 0xFFu;
+  return (flags & hostsim::kHasSR3) ? fs.sr_v[2] : 0xFFu;
+}
+
+static void compare(const char *step, const uint32_t idx0, const uint32_t v) {
+  if ((v & 0xFFu) == part_sr(idx0)) return;
+  wrong++;
+  printf("  ** after %s: SR%u read 0x%02X, part 0x%02X\n", step, idx0 + 1u, v & 0xFFu, part_sr(idx0));
+}
+
+static void read_all(const char *step) {
+  uint32_t v;
+  spi0_flash_read_status_register_1(&v);
+  compare(step, 0u, v);
+  spi0_flash_read_status_register_2(&v);
+  compare(step, 1u, v);
+  spi0_flash_read_status_register_3(&v);
+  compare(step, 2u, v);
+  spi0_flash_read_status_registers_3B(&v);
+  compare(step, 0u, v);
+  compare(step, 1u, v >> 8u);
+  compare(step, 2u, v >> 16u);
+}
+
+static void workload() {
+  constexpr uint8_t kCaps = kSrCapSR2 | kSrCap16bitSR1 | kSrCapVolatile;
+  uint32_t v, verify;
+
+  hostsim::bootrom_dio();
+  reclaim_GPIO_9_10();
+  read_all("reclaim");
+  read_all("reclaim, again");
+  is_QE();
+  is_QE();
+
+  spi0_flash_read_status_register_2(&v);
+  spi0_flash_write_status_register_2(v ^ 0x02u, volatile_bit);
+  read_all("SR2 volatile");
+  spi0_flash_write_status_register_2(v, volatile_bit);
+  read_all("SR2 volatile, back");
+  spi0_flash_write_status_register_1(0x04u, volatile_bit);
+  read_all("SR1 volatile");
+  spi0_flash_write_status_register_1(0x00u, volatile_bit);
+  read_all("SR1 volatile, back");
+  spi0_flash_write_status_registers_2B(0x0200u, volatile_bit);
+  read_all("16-bit volatile");
+  sr_update_bits(0x0000u, 0x0200u, kCaps, volatile_bit);
+  read_all("sr_update");
+  sr_update_bits(0x0200u, 0x0200u, kCaps, volatile_bit);
+  read_all("sr_update, back");
+
+  spi0_flash_read_status_register_1(&v);
+  spi0_flash_write_verify_status_register(0u, v & 0xFCu, non_volatile_bit, 8u, 0u, &verify);
+  read_all("SR1 non-volatile");
+  spi0_flash_write_enable();
+  read_all("06h");
+  spi0_flash_write_disable();
+  read_all("04h");
+  spi0_flash_write_volatile_enable();
+  read_all("50h");
+  spi0_flash_write_status_register_3(0x20u, volatile_bit);
+  read_all("SR3 volatile");
+  spi0_flash_software_reset(50u);
+  read_all("66h 99h");
+
+  // The shadow can't see the BootROM, the Sketch clears it
+  hostsim::warm_reset();
+  hostsim::bootrom_dio();
+  sr_shadow_invalidate();
+  read_all("warm reset");
+}
+
+static bool run(const hostsim::FlashProfile& p, const bool force_verify) {
+  hostsim::install(p);
+  sr_shadow_invalidate();
+  sr_shadow_counters_reset();
+  sr_shadow_force_verify(force_verify);
+  wrong = 0u;
+
+  hostsim::Measure m;
+  workload();
+  const hostsim::Counters d = m.delta();
+  const SrShadowCounters *c = sr_shadow_counters();
+  const bool pass = 0u == c->mismatches && 0u == wrong;
+  printf("  %-11s %-7s %5llu %3llu %5u %4u %5u %4u %5u%s\n", p.name, (force_verify) ? "verify" : "shadow",
+    (unsigned long long)d.transactions, (unsigned long long)d.cache_windows,
+    c->reads_elided, c->wrdi_elided, c->reads, c->mismatches, wrong,
+    (pass) ? "" : "  ** FAIL");
+  return pass;
+}
+
+int main(int argc, char **argv) {
+  printf("  %-11s %-7s %5s %3s %5s %4s %5s %4s %5s\n", "part", "mode", "txn", "win", "rd", "wrdi", "reads", "mism", "wrong");
+  bool pass = true;
+  bool any = false;
+  for (size_t i = 0u; i < hostsim::kNumProfiles; i++) {
+    const hostsim::FlashProfile& p = hostsim::kProfiles[i];
+    bool named = (argc < 2);
+    for (int k = 1; k < argc; k++) {
+      if (0 == strcmp(argv[k], p.name)) named = true;
+    }
+    if (! named) continue;
+    any = true;
+    pass = run(p, true) && pass;
+    if (! SR_SHADOW_FORCE_VERIFY) pass = run(p, false) && pass;
+  }
+  if (! any) {
+    fprintf(stderr, "Unknown profile\n");
+    return 2;
+  }
+  return (pass) ? 0 : 1;
+}
@@ -0,0 +1,282 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  sr_update_sim - StatusRegisterUpdate.h against simulated flash parts
+
+  Build from the library root:
+
+    g++ -std=gnu++17 -O1 -Wall -Itools/hostsim/include -Isrc [-DSR_SHADOW=1] \
+      tools/hostsim/hostsim.cpp tools/hostsim/profiles.cpp \
+      tools/hostsim/sr_update_sim.cpp src/SpiFlashUtils.cpp \
+      src/SpiFlashUtilsQE.cpp src/StatusRegisterUpdate.cpp -o sr_update_sim
+
+  Usage:
+
+    sr_update_sim [-t]
+
+      -t  trace each flash instruction
+
+  Three groups of checks:
+
+    plan    sr_update_plan(), no flash: which writes, their order, and what
+            is verified, for each write method.
+    caps    sr_caps_from_sfdp() for each JESD216 QER code and the DW16 and
+            DW1 volatile write methods.
+    update  sr_update() on the winbond, gigadevice, and xmc profiles: the XMC
+            Status Register-3 restore, a bit the part won't take rolled back,
+            non-volatile writes split, and a roll back after a write that
+            landed but failed in transport, a stuck SPI0CMD or a write past
+            its timeout, see hostsim::inject_fault().
+
+  Prints each failed check. Exits non-zero when any fails.
+*/
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+#include "StatusRegisterUpdate.h"
+#include "hostsim.h"
+
+using namespace experimental;
+
+static uint32_t checks = 0u;
+static uint32_t failed = 0u;
+
+static void check(const char *group, const char *name, const bool pass) {
+  checks++;
+  if (pass) return;
+  failed++;
+  printf("  ** %s: %s\n", group, name);
+}
+
+static bool writes_are(const SrUpdatePlan& p, const size_t n, const SrWrite *w) {
+  if (n != p.nwrites) return false;
+  for (size_t k = 0u; k < n; k++) {
+    if (w[k].idx0 != p.writes[k].idx0 || w[k].numbits != p.writes[k].numbits) return false;
+  }
+  return true;
+}
+
+// The write methods of the profiles
+constexpr uint8_t kCapsGigaDevice = kSrCapSR2 | kSrCapSR3 | kSrCap8bitSR1 | kSrCap8bitSR2 | kSrCapVolatile;
+constexpr uint8_t kCapsWinbond = kCapsGigaDevice | kSrCap16bitSR1;
+constexpr uint8_t kCapsXmc = kCapsWinbond | kSrCapSR2ClearsSR3;
+// A legacy part, no 31h, an 8-bit 01h clears SR2
+constexpr uint8_t kCaps16Only = kSrCapSR2 | kSrCap16bitSR1 | kSrCapVolatile;
+
+constexpr uint32_t kQE = BIT9;
+constexpr uint32_t kSrp0 = BIT7;
+constexpr uint32_t kSrp1 = BIT8;
+
+////////////////////////////////////////////////////////////////////////////////
+static void plan_checks() {
+  const char *g = "plan";
+  SrUpdatePlan p;
+
+  check(g, "no change, no writes", sr_update_plan(&p, kQE, kQE, kQE, kCapsWinbond, false) && 0u == p.nwrites);
+
+  {
+    const SrWrite w[] = {{1u, 8u}};
+    check(g, "SR2 with 31h", sr_update_plan(&p, 0u, kQE, kQE, kCapsWinbond, false) &&
+      writes_are(p, 1u, w) && 2u == p.verify_regs && kQE == p.verify_mask && kQE == p.target);
+  }
+  {
+    const SrWrite w[] = {{0u, 16u}};
+    check(g, "SR2 with 16-bit 01h carries SR1", sr_update_plan(&p, 0x1Cu, kQE, kQE, kCaps16Only, false) &&
+      writes_are(p, 1u, w) && (0x1Cu | kQE) == p.target && 2u == p.verify_regs);
+    check(g, "SR1 and SR2 in one 16-bit 01h", sr_update_plan(&p, 0u, 0x1Cu | kQE, 0x1Cu | kQE, kCapsWinbond, false) &&
+      writes_are(p, 1u, w) && 3u == p.verify_regs);
+    check(g, "SR1 on a 16-bit only part carries SR2", sr_update_plan(&p, kQE, 0x04u, 0x04u, kCaps16Only, false) &&
+      writes_are(p, 1u, w) && (kQE | 0x04u) == p.target);
+  }
+  {
+    const SrWrite w[] = {{1u, 8u}, {0u, 8u}};
+    check(g, "SR2 before SR1", sr_update_plan(&p, kSrp1, kSrp0, kSrp0 | kSrp1, kCapsGigaDevice, false) &&
+      writes_are(p, 2u, w));
+  }
+  {
+    const SrWrite w[] = {{0u, 8u}, {1u, 8u}};
+    check(g, "SR1 first when SR2 sets SRP1", sr_update_plan(&p, kSrp0, kSrp1, kSrp0 | kSrp1, kCapsGigaDevice, false) &&
+      writes_are(p, 2u, w));
+  }
+  {
+    const SrWrite w[] = {{1u, 8u}, {2u, 8u}};
+    check(g, "XMC volatile SR2 restores SR3", sr_update_plan(&p, 0x600000u, kQE, kQE, kCapsXmc, false) &&
+      writes_are(p, 2u, w) && 6u == p.verify_regs && (0xFF0000u | kQE) == p.verify_mask && (0x600000u | kQE) == p.target);
+    check(g, "XMC SR3 in the snapshot", 6u == sr_update_regs(kQE, kCapsXmc, false));
+  }
+  {
+    const SrWrite w[] = {{1u, 8u}};
+    check(g, "XMC non-volatile SR2, no SR3 write", sr_update_plan(&p, 0x600000u, kQE, kQE, kCapsXmc, true) &&
+      writes_are(p, 1u, w) && p.non_volatile && 2u == sr_update_regs(kQE, kCapsXmc, true));
+  }
+  {
+    const SrWrite w[] = {{1u, 8u}, {2u, 8u}};
+    check(g, "SR3 written last", sr_update_plan(&p, 0u, 0x200000u | kQE, 0x200000u | kQE, kCapsGigaDevice, false) &&
+      writes_are(p, 2u, w));
+  }
+  check(g, "WEL and WIP never written", sr_update_plan(&p, 0u, 0x03u, 0x03u, kCapsWinbond, false) && 0u == p.nwrites);
+  check(g, "volatile needs 50h", ! sr_update_plan(&p, 0u, kQE, kQE, kCapsWinbond & ~kSrCapVolatile, false));
+  check(g, "SR3 needs kSrCapSR3", ! sr_update_plan(&p, 0u, 0x200000u, 0x200000u, kCaps16Only, false));
+  check(g, "SR2 needs a write method", ! sr_update_plan(&p, 0u, kQE, kQE, kSrCapSR2 | kSrCap8bitSR1 | kSrCapVolatile, false));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static uint8_t caps_for(const uint8_t num_dw, const uint8_t qer, const uint8_t sr1_write_enable, const bool volatile_sr_protect, const uint8_t volatile_wren_cmd) {
+  SfdpBasicParams params;
+  memset(&params, 0, sizeof(params));
+  params.num_dw = num_dw;
+  params.qe_requirement = qer;
+  params.sr1_write_enable = sr1_write_enable;
+  params.volatile_sr_protect = volatile_sr_protect;
+  params.volatile_wren_cmd = volatile_wren_cmd;
+  return sr_caps_from_sfdp(&params);
+}
+
+static void caps_checks() {
+  const char *g = "caps";
+  check(g, "nullptr", 0u == sr_caps_from_sfdp(nullptr));
+  check(g, "no DW15", 0u == caps_for(14u, 6u, 0u, false, 0u));
+
+  constexpr uint8_t kAll8 = kSrCapSR2 | kSrCap8bitSR1 | kSrCap8bitSR2;
+  const uint8_t want[8] = {
+    kSrCap8bitSR1,                                    // 0, no QE bit
+    kSrCapSR2 | kSrCap16bitSR1,                       // 1, 8-bit 01h clears SR2
+    kSrCap8bitSR1,                                    // 2, QE in SR1
+    kSrCap8bitSR1,                                    // 3, 3Eh/3Fh
+    kSrCapSR2 | kSrCap8bitSR1 | kSrCap16bitSR1,       // 4
+    kSrCapSR2 | kSrCap8bitSR1 | kSrCap16bitSR1,       // 5
+    kAll8,                                            // 6, 31h
+    0u,                                               // 7, reserved
+  };
+  for (uint8_t qer = 0u; qer < 8u; qer++) {
+    char name[32];
+    snprintf(name, sizeof(name), "QER %u", qer);
+    check(g, name, want[qer] == caps_for(15u, qer, 0u, false, 0u));
+  }
+
+  check(g, "DW16 volatile 50h", (kAll8 | kSrCapVolatile) == caps_for(16u, 6u, BIT2, false, 0u));
+  check(g, "DW16 non-volatile and volatile 50h", (kAll8 | kSrCapVolatile) == caps_for(16u, 6u, BIT3, false, 0u));
+  check(g, "DW16 non-volatile only", kAll8 == caps_for(16u, 6u, BIT0, true, kVolatileWriteEnableCmd));
+  check(g, "DW1 volatile 50h, no DW16", (kAll8 | kSrCapVolatile) == caps_for(15u, 6u, 0u, true, kVolatileWriteEnableCmd));
+  check(g, "DW1 volatile 06h", kAll8 == caps_for(15u, 6u, 0u, true, kWriteEnableCmd));
+  check(g, "DW16 empty, DW1 decides", (kAll8 | kSrCapVolatile) == caps_for(16u, 6u, 0u, true, kVolatileWriteEnableCmd));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static void boot(const char *name) {
+  hostsim::install(*hostsim::find_profile(name));
+  hostsim::bootrom_dio();
+  sr_shadow_invalidate();
+}
+
+static uint32_t flash_sr() {
+  const hostsim::FlashState& fs = hostsim::flash_state();
+  return fs.sr_v[0] | (fs.sr_v[1] << 8u) | (fs.sr_v[2] << 16u);
+}
+
+static uint32_t flash_sr_nv() {
+  const hostsim::FlashState& fs = hostsim::flash_state();
+  return fs.sr_nv[0] | (fs.sr_nv[1] << 8u) | (fs.sr_nv[2] << 16u);
+}
+
+static SrUpdate update_for(const uint32_t value, const uint32_t mask, const uint8_t caps, const bool non_volatile) {
+  SrUpdate u = {};
+  u.value = value;
+  u.mask = mask;
+  u.caps = caps;
+  u.non_volatile = non_volatile;
+  u.rollback = true;
+  return u;
+}
+
+static void update_checks() {
+  const char *g = "update";
+  SrUpdate u;
+  SpiOpResult ok0;
+
+  boot("xmc");
+  u = update_for(kQE, kQE, kCapsXmc, false);
+  ok0 = sr_update(&u);
+  check(g, "xmc volatile QE, SR3 kept", SPI_RESULT_OK == ok0 && 2u == u.nwrites &&
+    (0x600000u | kQE) == (flash_sr() & 0xFFFFFCu) && 0u == (flash_sr_nv() & kQE));
+
+  boot("winbond");
+  u = update_for(kQE, kQE, kCapsWinbond, false);
+  ok0 = sr_update(&u);
+  check(g, "winbond volatile QE", SPI_RESULT_OK == ok0 && 1u == u.nwrites && 0u != (flash_sr() & kQE));
+  ok0 = sr_update(&u);
+  check(g, "winbond QE already set, no writes", SPI_RESULT_OK == ok0 && 0u == u.nwrites);
+
+  // SR2 bit 2 is not writable on the profile
+  boot("winbond");
+  u = update_for(kQE | BIT10, kQE | BIT10, kCapsWinbond, false);
+  ok0 = sr_update(&u);
+  check(g, "stuck bit rolled back", SPI_RESULT_ERR == ok0 && u.rolled_back && 0u == (flash_sr() & 0xFF00u));
+
+  u = update_for(kQE, kQE, kCapsWinbond & ~kSrCapVolatile, false);
+  hostsim::Measure m0;
+  ok0 = sr_update(&u);
+  check(g, "volatile refused without 50h", SPI_RESULT_ERR == ok0 && 0u == m0.delta().v_writes && 0u == m0.delta().nv_writes);
+
+  boot("gigadevice");
+  u = update_for(0x04u | kQE, 0x04u | kQE, kCapsGigaDevice, true);
+  hostsim::Measure m1;
+  ok0 = sr_update(&u);
+  check(g, "gigadevice non-volatile split", SPI_RESULT_OK == ok0 && 2u == u.nwrites &&
+    2u == m1.delta().nv_writes && (0x04u | kQE) == (flash_sr_nv() & 0xFFFCu));
+
+  // The write reaches the part, then the sequence times out before its verify read
+  boot("winbond");
+  hostsim::inject_fault(kWriteStatusRegister2Cmd, 1000u, 0u);
+  u = update_for(kQE, kQE, kCapsWinbond, false);
+  ok0 = sr_update(&u);
+  check(g, "volatile timeout rolled back", SPI_RESULT_TIMEOUT == ok0 && u.rolled_back &&
+    0u != (u.after & kQE) && 0u == (flash_sr() & kQE));
+
+  boot("winbond");
+  hostsim::inject_fault(kWriteStatusRegister2Cmd, 1000u, 0u);
+  u = update_for(kQE, kQE, kCapsWinbond, false);
+  u.rollback = false;
+  ok0 = sr_update(&u);
+  check(g, "volatile timeout, no roll back", SPI_RESULT_TIMEOUT == ok0 && ! u.rolled_back && 0u != (flash_sr() & kQE));
+
+  // The non-volatile write outlasts its timeout
+  boot("gigadevice");
+  hostsim::inject_fault(kWriteStatusRegister2Cmd, 0u, 2u * kSpi0SrWriteTimeoutMaxUs);
+  u = update_for(kQE, kQE, kCapsGigaDevice, true);
+  ok0 = sr_update(&u);
+  check(g, "non-volatile timeout rolled back", SPI_RESULT_TIMEOUT == ok0 && u.rolled_back &&
+    0u == (flash_sr_nv() & kQE) && ! hostsim::flash_state().wel);
+
+  // The second of two non-volatile writes times out, both are undone
+  boot("gigadevice");
+  hostsim::inject_fault(kWriteStatusRegister1Cmd, 0u, 2u * kSpi0SrWriteTimeoutMaxUs);
+  u = update_for(0x04u | kQE, 0x04u | kQE, kCapsGigaDevice, true);
+  ok0 = sr_update(&u);
+  check(g, "second non-volatile write timeout rolled back", SPI_RESULT_TIMEOUT == ok0 && u.rolled_back &&
+    0u == (flash_sr_nv() & 0xFFFCu));
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    if (0 == strcmp("-t", argv[i])) hostsim::config.trace = true;
+  }
+  plan_checks();
+  caps_checks();
+  update_checks();
+  printf("%u checks, %u failed\n", checks, failed);
+  return (0u == failed) ? 0 : 1;
+}
@@ -0,0 +1,353 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  sfulog - print deferred DBG_SFU_PRINTF logs from their dumps
+
+  Build from the library root:
+
+    g++ -std=gnu++17 -O2 -Wall -Isrc tools/sfulog/sfulog.cpp -o sfulog
+
+  Usage:
+
+    sfulog [-t] sketch.ino.elf [file ...]
+
+      -t  start each message with its time, in us from the first
+
+  Reads each file, or stdin when none or "-" is named. Dumps are found
+  anywhere in the input, as "SFL1:" and "SFE1:" hex lines mixed with other
+  output, eg. a captured serial log, or as raw bytes. See src/SpiFlashLog.h.
+
+  The message IDs are the format string addresses. The strings, and the
+  literals passed for %s, are read from the .elf of the build that made the
+  dump. The Arduino IDE leaves it in the build folder, "Sketch > Export
+  Compiled Binary" copies it next to the Sketch. A dump from another build
+  prints garbage or "<fmt 0x...>", there is no way to tell them apart.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "SpiFlashLog.h"
+
+using namespace experimental;
+
+static bool show_time = false;
+static uint64_t bad_dumps = 0u;
+static uint64_t dumps = 0u;
+
+// The core's crc32(), not the zlib one
+static uint32_t crc32_core(const void *data, size_t length, uint32_t crc = 0xffffffffu) {
+  const uint8_t *p = (const uint8_t *)data;
+  while (length--) {
+    const uint8_t c = *p++;
+    for (uint32_t i = 0x80u; i > 0u; i >>= 1u) {
+      bool bit = crc & 0x80000000u;
+      if (c & i) bit = ! bit;
+      crc <<= 1u;
+      if (bit) crc ^= 0x04c11db7u;
+    }
+  }
+  return crc;
+}
+
+// Dumps and the .elf are little-endian
+static uint64_t le(const uint8_t *p, const size_t n) {
+  uint64_t v = 0u;
+  for (size_t i = n; i > 0u; i--) v = (v << 8u) | p[i - 1u];
+  return v;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The .elf, only the allocated sections with contents
+struct Section {
+  uint64_t addr;
+  uint64_t size;
+  uint64_t offset;
+};
+
+static std::vector<uint8_t> elf;
+static std::vector<Section> sections;
+
+static bool load_elf(const char *path) {
+  FILE *f = fopen(path, "rb");
+  if (nullptr == f) return false;
+  uint8_t chunk[65536];
+  size_t n;
+  while (0u < (n = fread(chunk, 1u, sizeof(chunk), f))) elf.insert(elf.end(), chunk, chunk + n);
+  fclose(f);
+
+  if (64u > elf.size() || 0 != memcmp(elf.data(), "\x7f" "ELF", 4u) || 1u != elf[5]) return false;
+  const bool is64 = (2u == elf[4]);
+  const size_t aw = (is64) ? 8u : 4u;
+  const uint64_t shoff = le(&elf[(is64) ? 0x28u : 0x20u], aw);
+  const size_t shentsize = le(&elf[(is64) ? 0x3Au : 0x2Eu], 2u);
+  const size_t shnum = le(&elf[(is64) ? 0x3Cu : 0x30u], 2u);
+  for (size_t i = 0u; i < shnum; i++) {
+    const uint64_t sh = shoff + i * shentsize;
+    if (sh + shentsize > elf.size()) return false;
+    const uint8_t *s = &elf[sh];
+    const uint32_t type = le(s + 4u, 4u);
+    const uint64_t flags = le(s + 8u, aw);
+    Section sec;
+    sec.addr = le(s + 8u + aw, aw);
+    sec.offset = le(s + 8u + 2u * aw, aw);
+    sec.size = le(s + 8u + 3u * aw, aw);
+    // SHT_NOBITS 8, SHF_ALLOC 2
+    if (8u == type || 0u == (flags & 2u) || 0u == sec.addr) continue;
+    if (sec.offset + sec.size > elf.size()) continue;
+    sections.push_back(sec);
+  }
+  return ! sections.empty();
+}
+
+// The string at addr, nullptr when it is not in the .elf
+static const char *elf_string(const uint64_t addr) {
+  for (const Section& sec : sections) {
+    if (sec.addr <= addr && addr < sec.addr + sec.size) {
+      const char *s = (const char *)&elf[sec.offset + (addr - sec.addr)];
+      const size_t max = sec.size - (addr - sec.addr);
+      return (memchr(s, '\0', max)) ? s : nullptr;
+    }
+  }
+  return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Formatting, ints are 32 bits as on the ESP8266
+static std::string format(const char *fmt, const std::vector<uint64_t>& args) {
+  std::string out;
+  size_t next = 0u;
+  auto arg = [&]() -> uint64_t { return (next < args.size()) ? args[next++] : 0u; };
+  char buf[256];
+  for (const char *p = fmt; *p; p++) {
+    if ('%' != *p) {
+      out += *p;
+      continue;
+    }
+    std::string spec = "%";
+    p++;
+    while (*p && strchr("-+ #0", *p)) spec += *p++;
+    if ('*' == *p) {
+      spec += std::to_string((int32_t)arg());
+      p++;
+    }
+    while (*p && ('.' == *p || ('0' <= *p && '9' >= *p))) spec += *p++;
+    while (*p && strchr("hlLqjzt", *p)) p++;
+    if ('\0' == *p) break;
+    const char conv = *p;
+    switch (conv) {
+      case '%':
+        out += '%';
+        continue;
+      case 'd': case 'i': case 'c':
+        snprintf(buf, sizeof(buf), (spec + conv).c_str(), (int32_t)arg());
+        break;
+      case 'u': case 'x': case 'X': case 'o':
+        snprintf(buf, sizeof(buf), (spec + conv).c_str(), (uint32_t)arg());
+        break;
+      case 'p':
+        snprintf(buf, sizeof(buf), "0x%08llx", (unsigned long long)arg());
+        break;
+      case 's': {
+        const uint64_t a = arg();
+        const char *s = elf_string(a);
+        char missing[24];
+        snprintf(missing, sizeof(missing), "<str 0x%08llx>", (unsigned long long)a);
+        snprintf(buf, sizeof(buf), (spec + 's').c_str(), (s) ? s : missing);
+        break;
+      }
+      default:
+        snprintf(buf, sizeof(buf), "<%%%c>", conv);
+        break;
+    }
+    out += buf;
+  }
+  return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Scanning
+static int hexval(const uint8_t c) {
+  if ('0' <= c && c <= '9') return c - '0';
+  if ('A' <= c && c <= 'F') return c - 'A' + 10;
+  if ('a' <= c && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+// Hex digits up to the end of the line, at most max bytes
+static size_t unhex(const uint8_t *p, const uint8_t *end, uint8_t *out, const size_t max) {
+  size_t n = 0u;
+  while (n < max && p + 2 <= end) {
+    const int hi = hexval(p[0]);
+    const int lo = hexval(p[1]);
+    if (0 > hi || 0 > lo) break;
+    out[n++] = (uint8_t)((hi << 4) | lo);
+    p += 2;
+  }
+  return n;
+}
+
+static const uint8_t *find(const uint8_t *p, const uint8_t *end, const char *tag) {
+  while (p + 4 <= end) {
+    const uint8_t *hit = (const uint8_t *)memchr(p, tag[0], end - p);
+    if (nullptr == hit || hit + 4 > end) return nullptr;
+    if (0 == memcmp(hit, tag, 4u)) return hit;
+    p = hit + 1;
+  }
+  return nullptr;
+}
+
+struct Hdr {
+  uint32_t magic;
+  uint8_t version, size, word_size, cpu_mhz;
+  uint32_t entries, words, dropped, crc;
+};
+
+static Hdr decode_hdr(const uint8_t *p) {
+  Hdr h;
+  h.magic = le(p, 4u);
+  h.version = p[4];
+  h.size = p[5];
+  h.word_size = p[6];
+  h.cpu_mhz = p[7];
+  h.entries = le(p + 8, 4u);
+  h.words = le(p + 12, 4u);
+  h.dropped = le(p + 16, 4u);
+  h.crc = le(p + 20, 4u);
+  return h;
+}
+
+static void print_dump(const Hdr& h, const std::vector<uint8_t>& words) {
+  const double mhz = (h.cpu_mhz) ? h.cpu_mhz : 80.0;
+  const size_t ws = h.word_size;
+  dumps++;
+  printf("log %llu: %u messages, %u dropped, CPU %u MHz\n", (unsigned long long)dumps, h.entries, h.dropped, h.cpu_mhz);
+  size_t at = 0u;
+  uint32_t t0 = 0u;
+  for (uint32_t i = 0u; i < h.entries && (at + kSfuLogEntryHdr) * ws <= words.size(); i++) {
+    const uint8_t *w = &words[at * ws];
+    const uint64_t fmt = le(w + kSfuLogFmt * ws, ws);
+    const uint32_t cycles = le(w + kSfuLogCycles * ws, ws);
+    const size_t n = le(w + kSfuLogNargs * ws, ws);
+    if ((at + kSfuLogEntryHdr + n) * ws > words.size()) break;
+    std::vector<uint64_t> args;
+    for (size_t k = 0u; k < n; k++) args.push_back(le(w + (kSfuLogEntryHdr + k) * ws, ws));
+    at += kSfuLogEntryHdr + n;
+
+    if (0u == i) t0 = cycles;
+    if (show_time) printf("%10.1f ", (double)(cycles - t0) / mhz);
+    const char *s = elf_string(fmt);
+    if (s) {
+      fputs(format(s, args).c_str(), stdout);
+    } else {
+      printf("<fmt 0x%08llx>\n", (unsigned long long)fmt);
+    }
+  }
+}
+
+// Parses the dump at p. Returns where to continue.
+static const uint8_t *parse_at(const uint8_t *p, const uint8_t *end) {
+  uint8_t raw[sizeof(SfuLogDumpHdr)];
+  const bool text = (p + 5 <= end && ':' == p[4]);
+  const uint8_t *q;
+  if (text) {
+    if (sizeof(raw) != unhex(p + 5, end, raw, sizeof(raw))) return p + 1;
+    q = p + 5 + 2u * sizeof(raw);
+  } else {
+    if ((size_t)(end - p) < sizeof(raw)) return p + 1;
+    memcpy(raw, p, sizeof(raw));
+    q = p + sizeof(raw);
+  }
+  const Hdr h = decode_hdr(raw);
+  if (kSfuLogMagic != h.magic || kSfuLogVersion != h.version || sizeof(SfuLogDumpHdr) != h.size ||
+      (4u != h.word_size && 8u != h.word_size)) return p + 1;
+
+  const size_t bytes = (size_t)h.words * h.word_size;
+  std::vector<uint8_t> words;
+  if (text) {
+    for (uint32_t i = 0u; i < h.entries; i++) {
+      const uint8_t *e = find(q, end, "SFE1");
+      const uint8_t *next = find(q, end, "SFL1");
+      if (nullptr == e || (next && next < e) || e + 5 > end || ':' != e[4]) break;
+      uint8_t rec[kSfuLogEntryMaxSz * 2u];
+      const size_t n = unhex(e + 5, end, rec, sizeof(rec));
+      words.insert(words.end(), rec, rec + n);
+      q = e + 5 + 2u * n;
+    }
+  } else if ((size_t)(end - q) >= bytes) {
+    words.assign(q, q + bytes);
+    q += bytes;
+  }
+  uint32_t crc = crc32_core(raw, offsetof(SfuLogDumpHdr, crc));
+  if (words.size() == bytes && bytes) crc = crc32_core(words.data(), bytes, crc);
+  if (words.size() != bytes || crc != h.crc) {
+    bad_dumps++;
+    fprintf(stderr, "sfulog: log with %u messages, %s, skipped\n", h.entries,
+      (words.size() != bytes) ? "entries missing" : "bad CRC");
+    return q;
+  }
+  print_dump(h, words);
+  return q;
+}
+
+static void scan(FILE *f) {
+  std::vector<uint8_t> buf;
+  uint8_t chunk[65536];
+  size_t n;
+  while (0u < (n = fread(chunk, 1u, sizeof(chunk), f))) buf.insert(buf.end(), chunk, chunk + n);
+
+  const uint8_t *p = buf.data();
+  const uint8_t *end = p + buf.size();
+  while (nullptr != (p = find(p, end, "SFL1"))) {
+    p = parse_at(p, end);
+  }
+}
+
+int main(int argc, char **argv) {
+  const char *elf_path = nullptr;
+  int files = 0;
+  for (int i = 1; i < argc; i++) {
+    if (0 == strcmp("-t", argv[i])) {
+      show_time = true;
+    } else if (nullptr == elf_path) {
+      elf_path = argv[i];
+      if (! load_elf(elf_path)) {
+        fprintf(stderr, "sfulog: cannot read %s as an .elf\n", elf_path);
+        return 2;
+      }
+    } else if (0 == strcmp("-", argv[i])) {
+      scan(stdin);
+      files++;
+    } else {
+      FILE *f = fopen(argv[i], "rb");
+      if (nullptr == f) {
+        fprintf(stderr, "sfulog: cannot open %s\n", argv[i]);
+        return 2;
+      }
+      scan(f);
+      fclose(f);
+      files++;
+    }
+  }
+  if (nullptr == elf_path) {
+    fprintf(stderr, "usage: sfulog [-t] sketch.ino.elf [file ...]\n");
+    return 2;
+  }
+  if (0 == files) scan(stdin);
+  if (0u == dumps && 0u == bad_dumps) fprintf(stderr, "sfulog: no logs found\n");
+  return (bad_dumps) ? 1 : 0;
+}
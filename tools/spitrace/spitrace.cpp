@@ -0,0 +1,306 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  spitrace - decode SPI0 flash trace dumps into timelines
+
+  Build from the library root:
+
+    g++ -std=gnu++17 -O2 -Wall -Isrc tools/spitrace/spitrace.cpp -o spitrace
+
+  Usage:
+
+    spitrace [-s] [file ...]
+
+      -s  counters only, no timeline
+
+  Reads each file, or stdin when none or "-" is named. Dumps are found
+  anywhere in the input, as "SFT1:" and "SFR1:" hex lines mixed with other
+  output, eg. a captured serial log, or as raw bytes. A dump with a bad CRC,
+  or missing records, is reported and skipped. See src/SpiFlashTrace.h.
+
+  Timeline columns:
+
+    #       record number since the trace was reset
+    t us    start, from the first record of the dump
+    dur us  start to end. For a WIP end, from when the write went out.
+    kind    cmd, sdk, step, pair, wip>, wip<
+    pre     prefix instruction
+    cmd     instruction, and its name
+    out     first data word sent. For a WIP end, the status polls.
+    in      first data word back
+    bits    data bits out/in
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "SpiFlashTrace.h"
+
+using namespace experimental;
+
+static bool summary_only = false;
+static uint64_t bad_dumps = 0u;
+static uint64_t dumps = 0u;
+
+// The core's crc32(), not the zlib one
+static uint32_t crc32_core(const void *data, size_t length, uint32_t crc = 0xffffffffu) {
+  const uint8_t *p = (const uint8_t *)data;
+  while (length--) {
+    const uint8_t c = *p++;
+    for (uint32_t i = 0x80u; i > 0u; i >>= 1u) {
+      bool bit = crc & 0x80000000u;
+      if (c & i) bit = ! bit;
+      crc <<= 1u;
+      if (bit) crc ^= 0x04c11db7u;
+    }
+  }
+  return crc;
+}
+
+// Dumps are little-endian
+static uint32_t le32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8u) | ((uint32_t)p[2] << 16u) | ((uint32_t)p[3] << 24u);
+}
+
+static uint16_t le16(const uint8_t *p) {
+  return (uint16_t)(p[0] | (p[1] << 8u));
+}
+
+static SpiTraceCounters decode_counters(const uint8_t *p) {
+  SpiTraceCounters c;
+  c.records = le32(p);
+  c.failures = le32(p + 4);
+  c.wel_left_set = le32(p + 8);
+  c.windows = le32(p + 12);
+  c.cache_off_cycles = (uint64_t)le32(p + 16) | ((uint64_t)le32(p + 20) << 32u);
+  return c;
+}
+
+static SpiTraceDumpHdr decode_hdr(const uint8_t *p) {
+  SpiTraceDumpHdr h;
+  h.magic = le32(p);
+  h.version = p[4];
+  h.size = p[5];
+  h.rec_size = p[6];
+  h.cpu_mhz = p[7];
+  h.first = le32(p + 8);
+  h.count = le32(p + 12);
+  h.counters = decode_counters(p + 16);
+  h.rsvd = le32(p + 40);
+  h.crc = le32(p + 44);
+  return h;
+}
+
+static SpiTraceRecord decode_rec(const uint8_t *p) {
+  SpiTraceRecord r;
+  r.start = le32(p);
+  r.end = le32(p + 4);
+  r.out = le32(p + 8);
+  r.in = le32(p + 12);
+  r.cmd = p[16];
+  r.pre_cmd = p[17];
+  r.kind = p[18];
+  r.result = p[19];
+  r.mosi_bits = le16(p + 20);
+  r.miso_bits = le16(p + 22);
+  return r;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Printing
+static const char *cmd_name(const uint8_t cmd) {
+  switch (cmd) {
+    case 0x01u: return "WRSR1";
+    case 0x02u: return "PP";
+    case 0x03u: return "READ";
+    case 0x04u: return "WRDI";
+    case 0x05u: return "RDSR1";
+    case 0x06u: return "WREN";
+    case 0x11u: return "WRSR3";
+    case 0x15u: return "RDSR3";
+    case 0x20u: return "SE4K";
+    case 0x31u: return "WRSR2";
+    case 0x35u: return "RDSR2";
+    case 0x3Au: return "OTP";
+    case 0x42u: return "PRSCUR";
+    case 0x44u: return "ERSCUR";
+    case 0x48u: return "RDSCUR";
+    case 0x4Bu: return "RDUID";
+    case 0x50u: return "VWREN";
+    case 0x5Au: return "RDSFDP";
+    case 0x60u: return "CE";
+    case 0x66u: return "RSTEN";
+    case 0x99u: return "RST";
+    case 0x9Fu: return "RDID";
+    case 0xABu: return "RES";
+    case 0xB9u: return "DP";
+    default:    return "?";
+  }
+}
+
+static const char *kind_name(const uint8_t kind) {
+  static const char *names[] = {"cmd", "sdk", "step", "pair", "wip>", "wip<"};
+  return (kSpiTraceKinds > kind) ? names[kind] : "?";
+}
+
+static const char *result_name(const uint8_t result) {
+  static const char *names[] = {"ok", "err", "timeout"};
+  return (3u > result) ? names[result] : "?";
+}
+
+static void print_dump(const SpiTraceDumpHdr& h, const std::vector<SpiTraceRecord>& recs) {
+  const double mhz = (h.cpu_mhz) ? h.cpu_mhz : 80.0;
+  const SpiTraceCounters& c = h.counters;
+  dumps++;
+  printf("dump %llu: %u of %u records, CPU %u MHz\n", (unsigned long long)dumps, h.count, c.records, h.cpu_mhz);
+  printf("  failures %u, WEL left set %u, windows %u, iCache off %.1f us\n",
+    c.failures, c.wel_left_set, c.windows, (double)c.cache_off_cycles / mhz);
+  if (summary_only || recs.empty()) return;
+
+  printf("  %8s %10s %8s %-5s %3s %3s %-7s %8s %8s %7s %s\n",
+    "#", "t us", "dur us", "kind", "pre", "cmd", "", "out", "in", "bits", "result");
+  const uint32_t t0 = recs[0].start;
+  for (size_t i = 0u; i < recs.size(); i++) {
+    const SpiTraceRecord& r = recs[i];
+    char pre[4] = "-";
+    if (r.pre_cmd) snprintf(pre, sizeof(pre), "%02X", r.pre_cmd);
+    char out[12] = "-";
+    if (r.mosi_bits || kSpiTraceWipEnd == r.kind) snprintf(out, sizeof(out), "%08X", r.out);
+    char in[12] = "-";
+    if (r.miso_bits) snprintf(in, sizeof(in), "%08X", r.in);
+    printf("  %8u %10.1f %8.1f %-5s %3s  %02X %-7s %8s %8s %3u/%-3u %s\n",
+      h.first + (uint32_t)i, (double)(int32_t)(r.start - t0) / mhz, (double)(r.end - r.start) / mhz,
+      kind_name(r.kind), pre, r.cmd, cmd_name(r.cmd), out, in, r.mosi_bits, r.miso_bits,
+      result_name(r.result));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Scanning
+static int hexval(const uint8_t c) {
+  if ('0' <= c && c <= '9') return c - '0';
+  if ('A' <= c && c <= 'F') return c - 'A' + 10;
+  if ('a' <= c && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+static bool unhex(const uint8_t *p, const size_t avail, uint8_t *out, const size_t n) {
+  if (avail < 2u * n) return false;
+  for (size_t i = 0u; i < n; i++) {
+    const int hi = hexval(p[2u * i]);
+    const int lo = hexval(p[2u * i + 1u]);
+    if (0 > hi || 0 > lo) return false;
+    out[i] = (uint8_t)((hi << 4) | lo);
+  }
+  return true;
+}
+
+static const uint8_t *find(const uint8_t *p, const uint8_t *end, const char *tag) {
+  while (p + 4 <= end) {
+    const uint8_t *hit = (const uint8_t *)memchr(p, tag[0], end - p);
+    if (nullptr == hit || hit + 4 > end) return nullptr;
+    if (0 == memcmp(hit, tag, 4u)) return hit;
+    p = hit + 1;
+  }
+  return nullptr;
+}
+
+static bool header_ok(const SpiTraceDumpHdr& h) {
+  return kSpiTraceMagic == h.magic && kSpiTraceVersion == h.version &&
+         sizeof(SpiTraceDumpHdr) == h.size && sizeof(SpiTraceRecord) == h.rec_size;
+}
+
+// Parses the dump at p. Returns where to continue.
+static const uint8_t *parse_at(const uint8_t *p, const uint8_t *end) {
+  uint8_t raw[sizeof(SpiTraceDumpHdr)];
+  const bool text = (p + 5 <= end && ':' == p[4]);
+  const uint8_t *q;
+  if (text) {
+    if (! unhex(p + 5, end - (p + 5), raw, sizeof(raw))) return p + 1;
+    q = p + 5 + 2u * sizeof(raw);
+  } else {
+    if ((size_t)(end - p) < sizeof(raw)) return p + 1;
+    memcpy(raw, p, sizeof(raw));
+    q = p + sizeof(raw);
+  }
+  const SpiTraceDumpHdr h = decode_hdr(raw);
+  if (! header_ok(h)) return p + 1;
+
+  uint32_t crc = crc32_core(raw, offsetof(SpiTraceDumpHdr, crc));
+  std::vector<SpiTraceRecord> recs;
+  for (uint32_t i = 0u; i < h.count; i++) {
+    uint8_t rec[sizeof(SpiTraceRecord)];
+    if (text) {
+      const uint8_t *r = find(q, end, "SFR1");
+      // A new dump before this one is complete
+      const uint8_t *next = find(q, end, "SFT1");
+      if (nullptr == r || (next && next < r) || r + 5 > end || ':' != r[4] ||
+          ! unhex(r + 5, end - (r + 5), rec, sizeof(rec))) break;
+      q = r + 5 + 2u * sizeof(rec);
+    } else {
+      if ((size_t)(end - q) < sizeof(rec)) break;
+      memcpy(rec, q, sizeof(rec));
+      q += sizeof(rec);
+    }
+    crc = crc32_core(rec, sizeof(rec), crc);
+    recs.push_back(decode_rec(rec));
+  }
+  if (recs.size() != h.count || crc != h.crc) {
+    bad_dumps++;
+    fprintf(stderr, "spitrace: dump with %u records, %s, skipped\n", h.count,
+      (recs.size() != h.count) ? "records missing" : "bad CRC");
+    return q;
+  }
+  print_dump(h, recs);
+  return q;
+}
+
+static void scan(FILE *f) {
+  std::vector<uint8_t> buf;
+  uint8_t chunk[65536];
+  size_t n;
+  while (0u < (n = fread(chunk, 1u, sizeof(chunk), f))) buf.insert(buf.end(), chunk, chunk + n);
+
+  const uint8_t *p = buf.data();
+  const uint8_t *end = p + buf.size();
+  while (nullptr != (p = find(p, end, "SFT1"))) {
+    p = parse_at(p, end);
+  }
+}
+
+int main(int argc, char **argv) {
+  int files = 0;
+  for (int i = 1; i < argc; i++) {
+    if (0 == strcmp("-s", argv[i])) {
+      summary_only = true;
+    } else if (0 == strcmp("-", argv[i])) {
+      scan(stdin);
+      files++;
+    } else {
+      FILE *f = fopen(argv[i], "rb");
+      if (nullptr == f) {
+        fprintf(stderr, "spitrace: cannot open %s\n", argv[i]);
+        return 2;
+      }
+      scan(f);
+      fclose(f);
+      files++;
+    }
+  }
+  if (0 == files) scan(stdin);
+  if (0u == dumps && 0u == bad_dumps) fprintf(stderr, "spitrace: no dumps found\n");
+  return (bad_dumps) ? 1 : 0;
+}